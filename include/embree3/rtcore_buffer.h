@@ -27,7 +27,9 @@ enum RTCBufferType
   RTC_BUFFER_TYPE_VERTEX_CREASE_WEIGHT = 21,
   RTC_BUFFER_TYPE_HOLE                 = 22,
 
-  RTC_BUFFER_TYPE_FLAGS = 32
+  RTC_BUFFER_TYPE_FLAGS = 32,
+
+  RTC_BUFFER_TYPE_OPACITY_MICROMASK = 33
 };
 
 /* Opaque buffer type */
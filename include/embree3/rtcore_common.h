@@ -170,9 +170,10 @@ struct RTC_ALIGN(16) RTCLinearBounds
 /* Intersection context flags */
 enum RTCIntersectContextFlags
 {
-  RTC_INTERSECT_CONTEXT_FLAG_NONE       = 0,
-  RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT = (0 << 0), // optimize for incoherent rays
-  RTC_INTERSECT_CONTEXT_FLAG_COHERENT   = (1 << 0)  // optimize for coherent rays
+  RTC_INTERSECT_CONTEXT_FLAG_NONE         = 0,
+  RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT   = (0 << 0), // optimize for incoherent rays
+  RTC_INTERSECT_CONTEXT_FLAG_COHERENT     = (1 << 0), // optimize for coherent rays
+  RTC_INTERSECT_CONTEXT_FLAG_BATCH_FILTER = (1 << 1)  // invoke filter functions once for all candidate hits of a leaf
 };
 
 /* Arguments for RTCFilterFunctionN */
@@ -322,5 +323,68 @@ struct RTC_ALIGN(16) RTCPointQueryFunctionArguments
 };
 
 typedef bool (*RTCPointQueryFunction)(struct RTCPointQueryFunctionArguments* args);
+
+/* Result of a closest point query */
+struct RTC_ALIGN(16) RTCClosestPointResult
+{
+  // closest point on the surface in world space
+  float x;
+  float y;
+  float z;
+
+  // barycentric u/v coordinates of the closest point
+  float u;
+  float v;
+
+  // primitive and geometry ID of the closest primitive
+  unsigned int primID;
+  unsigned int geomID;
+
+  // instance IDs of the closest primitive
+  unsigned int instID[RTC_MAX_INSTANCE_LEVEL_COUNT];
+};
+
+/* Point found by a nearest points query */
+struct RTCNearestPoint
+{
+  // distance of the point to the query location
+  float distance;
+
+  // primitive and geometry ID of the point
+  unsigned int primID;
+  unsigned int geomID;
+
+  // instance IDs of the point
+  unsigned int instID[RTC_MAX_INSTANCE_LEVEL_COUNT];
+};
+
+/* Box query structure */
+struct RTC_ALIGN(16) RTCBoxQuery
+{
+  // lower corner of the box
+  float lower_x;
+  float lower_y;
+  float lower_z;
+
+  // time of the query for motion blur
+  float time;
+
+  // upper corner of the box
+  float upper_x;
+  float upper_y;
+  float upper_z;
+  float align0;
+};
+
+/* Primitive found by a box query */
+struct RTCBoxQueryHit
+{
+  // primitive and geometry ID of the primitive
+  unsigned int primID;
+  unsigned int geomID;
+
+  // instance IDs of the primitive
+  unsigned int instID[RTC_MAX_INSTANCE_LEVEL_COUNT];
+};
   
 RTC_NAMESPACE_END
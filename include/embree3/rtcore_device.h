@@ -48,7 +48,17 @@ enum RTCDeviceProperty
 
   RTC_DEVICE_PROPERTY_TASKING_SYSTEM        = 128,
   RTC_DEVICE_PROPERTY_JOIN_COMMIT_SUPPORTED = 129,
-  RTC_DEVICE_PROPERTY_PARALLEL_COMMIT_SUPPORTED = 130
+  RTC_DEVICE_PROPERTY_PARALLEL_COMMIT_SUPPORTED = 130,
+
+  RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_SIZE     = 160,
+  RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MAX_SIZE = 161,
+  RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_HITS     = 162,
+  RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MISSES   = 163,
+  RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_FLUSHES  = 164,
+
+  RTC_DEVICE_PROPERTY_DISPLACEMENT_CACHE_SIZE     = 165,
+
+  RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES    = 166
 };
 
 /* Gets a device property. */
@@ -68,6 +68,14 @@ enum RTCCurveFlags
   RTC_CURVE_FLAG_NEIGHBOR_RIGHT = (1 << 1)  // right segment exists
 };
 
+/* Opacity states of the cells of an opacity micromask */
+enum RTCOpacityState
+{
+  RTC_OPACITY_STATE_TRANSPARENT = 0, // hits are rejected without invoking the filter
+  RTC_OPACITY_STATE_OPAQUE      = 1, // hits are accepted without invoking the geometry filter
+  RTC_OPACITY_STATE_UNKNOWN     = 2  // hits are passed to the filter
+};
+
 /* Arguments for RTCBoundsFunction */
 struct RTCBoundsFunctionArguments
 {
@@ -131,6 +139,25 @@ struct RTCDisplacementFunctionNArguments
 /* Displacement mapping callback function */
 typedef void (*RTCDisplacementFunctionN)(const struct RTCDisplacementFunctionNArguments* args);
 
+/* Arguments for RTCEdgeLevelFunctionN */
+struct RTCEdgeLevelFunctionNArguments
+{
+  void* geometryUserPtr;
+  RTCGeometry geometry;
+  const unsigned int* edgeID;
+  const float* v0_x;
+  const float* v0_y;
+  const float* v0_z;
+  const float* v1_x;
+  const float* v1_y;
+  const float* v1_z;
+  float* level;
+  unsigned int N;
+};
+
+/* Edge level callback function */
+typedef void (*RTCEdgeLevelFunctionN)(const struct RTCEdgeLevelFunctionNArguments* args);
+
 /* Creates a new geometry of specified type. */
 RTC_API RTCGeometry rtcNewGeometry(RTCDevice device, enum RTCGeometryType type);
 
@@ -245,9 +272,21 @@ RTC_API void rtcSetGeometrySubdivisionMode(RTCGeometry geometry, unsigned int to
 /* Binds a vertex attribute to a topology of the geometry. */
 RTC_API void rtcSetGeometryVertexAttributeTopology(RTCGeometry geometry, unsigned int vertexAttributeID, unsigned int topologyID);
 
+/* Sets a subdivision surface with identical connectivity to copy the half edge structures from. */
+RTC_API void rtcSetGeometryTopologySource(RTCGeometry geometry, RTCGeometry source);
+
 /* Sets the displacement callback function of a subdivision surface. */
 RTC_API void rtcSetGeometryDisplacementFunction(RTCGeometry geometry, RTCDisplacementFunctionN displacement);
 
+/* Writes the displacement cache of a subdivision surface to a file. */
+RTC_API void rtcSaveGeometryDisplacementCache(RTCGeometry geometry, const char* filename, unsigned int displacementID);
+
+/* Adds the grids of a file to the displacement cache of a subdivision surface, returns false if the file does not match the geometry. */
+RTC_API bool rtcLoadGeometryDisplacementCache(RTCGeometry geometry, const char* filename, unsigned int displacementID);
+
+/* Sets the edge level callback function of a subdivision surface. */
+RTC_API void rtcSetGeometryEdgeLevelFunction(RTCGeometry geometry, RTCEdgeLevelFunctionN edgeLevel);
+
 /* Returns the first half edge of a face. */
 RTC_API unsigned int rtcGetGeometryFirstHalfEdge(RTCGeometry geometry, unsigned int faceID);
 
@@ -370,6 +409,28 @@ struct RTCInterpolateNArguments
 /* Interpolates vertex data to an array of u/v locations. */
 RTC_API void rtcInterpolateN(const struct RTCInterpolateNArguments* args);
 
+/* Arguments for rtcInterpolateGrid */
+struct RTCInterpolateGridArguments
+{
+  RTCGeometry geometry;
+  unsigned int primID;
+  unsigned int subPatchID;
+  unsigned int width;
+  unsigned int height;
+  enum RTCBufferType bufferType;
+  unsigned int bufferSlot;
+  float* P;
+  float* dPdu;
+  float* dPdv;
+  float* ddPdudu;
+  float* ddPdvdv;
+  float* ddPdudv;
+  unsigned int valueCount;
+};
+
+/* Interpolates vertex data to a regular grid of u/v locations over a subdivision patch. */
+RTC_API void rtcInterpolateGrid(const struct RTCInterpolateGridArguments* args);
+
 /* RTCGrid primitive for grid mesh */
 struct RTCGrid
 {
@@ -212,6 +212,68 @@ struct RTCRayHitNp
   struct RTCHitNp hit;
 };
 
+/* Tile of coherent camera rays that share a common origin. The ray
+   through pixel (x,y) has direction dir + x*du + y*dv. */
+struct RTC_ALIGN(16) RTCRayTile
+{
+  float org_x;         // x coordinate of common ray origin
+  float org_y;         // y coordinate of common ray origin
+  float org_z;         // z coordinate of common ray origin
+  float tnear;         // start of all ray segments
+
+  float dir_x;         // x coordinate of direction through pixel (0,0)
+  float dir_y;         // y coordinate of direction through pixel (0,0)
+  float dir_z;         // z coordinate of direction through pixel (0,0)
+  float time;          // time of all rays for motion blur
+
+  float du_x;          // x coordinate of direction step along image x
+  float du_y;          // y coordinate of direction step along image x
+  float du_z;          // z coordinate of direction step along image x
+  float tfar;          // end of all ray segments
+
+  float dv_x;          // x coordinate of direction step along image y
+  float dv_y;          // y coordinate of direction step along image y
+  float dv_z;          // z coordinate of direction step along image y
+  unsigned int mask;   // ray mask of all rays
+
+  unsigned int x0;     // first pixel of the tile along image x
+  unsigned int y0;     // first pixel of the tile along image y
+  unsigned int width;  // number of pixels of the tile along image x
+  unsigned int height; // number of pixels of the tile along image y
+};
+
+/* Stream of rays in SOA layout that share a common origin */
+struct RTCRaySharedOrigin
+{
+  float org_x;        // x coordinate of common ray origin
+  float org_y;        // y coordinate of common ray origin
+  float org_z;        // z coordinate of common ray origin
+  float tnear;        // start of all ray segments
+  float time;         // time of all rays for motion blur
+  unsigned int mask;  // ray mask of all rays
+
+  float* dir_x;       // x coordinates of ray directions
+  float* dir_y;       // y coordinates of ray directions
+  float* dir_z;       // z coordinates of ray directions
+  float* tfar;        // ends of ray segments, set to -inf if occluded
+};
+
+/* Stream of rays in SOA layout that share a common direction */
+struct RTCRaySharedDirection
+{
+  float dir_x;        // x coordinate of common ray direction
+  float dir_y;        // y coordinate of common ray direction
+  float dir_z;        // z coordinate of common ray direction
+  float time;         // time of all rays for motion blur
+  unsigned int mask;  // ray mask of all rays
+
+  float* org_x;       // x coordinates of ray origins
+  float* org_y;       // y coordinates of ray origins
+  float* org_z;       // z coordinates of ray origins
+  float* tnear;       // starts of ray segments
+  float* tfar;        // ends of ray segments, set to hit distance or -inf if occluded
+};
+
 struct RTCRayN;
 struct RTCHitN;
 struct RTCRayHitN;
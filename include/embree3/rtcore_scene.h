@@ -13,6 +13,10 @@ struct RTCRayHit4;
 struct RTCRayHit8;
 struct RTCRayHit16;
 struct RTCRayHitNp;
+struct RTCHitNp;
+struct RTCRayTile;
+struct RTCRaySharedOrigin;
+struct RTCRaySharedDirection;
 
 /* Scene flags */
 enum RTCSceneFlags
@@ -95,6 +99,24 @@ RTC_API bool rtcPointQuery8(const int* valid, RTCScene scene, struct RTCPointQue
 /* Perform a closest point query with a packet of 4 points with the scene. */
 RTC_API bool rtcPointQuery16(const int* valid, RTCScene scene, struct RTCPointQuery16* query, struct RTCPointQueryContext* context, RTCPointQueryFunction queryFunc, void** userPtr);
 
+/* Perform closest point queries with a stream of M points with the scene. */
+RTC_API bool rtcPointQuery1M(RTCScene scene, struct RTCPointQuery* query, unsigned int M, size_t byteStride, struct RTCPointQueryContext* context, RTCPointQueryFunction queryFunc, void** userPtr);
+
+/* Finds the closest point on the triangle, quad, and grid geometries of the scene. */
+RTC_API bool rtcClosestPoint(RTCScene scene, struct RTCPointQuery* query, struct RTCPointQueryContext* context, struct RTCClosestPointResult* result);
+
+/* Finds the k nearest points of the point geometries of the scene, sorted by increasing distance. */
+RTC_API unsigned int rtcNearestPoints(RTCScene scene, struct RTCPointQuery* query, struct RTCPointQueryContext* context, unsigned int k, struct RTCNearestPoint* points);
+
+/* Finds the k nearest points for a batch of M point queries. */
+RTC_API void rtcNearestPoints1M(RTCScene scene, struct RTCPointQuery* query, unsigned int M, size_t byteStride, struct RTCPointQueryContext* context, unsigned int k, struct RTCNearestPoint* points, unsigned int* numPoints);
+
+/* Finds the primitives whose bounds overlap the box of the query and returns their number. */
+RTC_API unsigned int rtcBoxQuery(RTCScene scene, struct RTCBoxQuery* query, struct RTCPointQueryContext* context, unsigned int maxHits, struct RTCBoxQueryHit* hits);
+
+/* Performs a batch of M box queries. */
+RTC_API void rtcBoxQuery1M(RTCScene scene, struct RTCBoxQuery* query, unsigned int M, size_t byteStride, struct RTCPointQueryContext* context, unsigned int maxHits, struct RTCBoxQueryHit* hits, unsigned int* numHits);
+
 /* Intersects a single ray with the scene. */
 RTC_API void rtcIntersect1(RTCScene scene, struct RTCIntersectContext* context, struct RTCRayHit* rayhit);
 
@@ -119,6 +141,12 @@ RTC_API void rtcIntersectNM(RTCScene scene, struct RTCIntersectContext* context,
 /* Intersects a stream of M ray packets of size N in SOA format with the scene. */
 RTC_API void rtcIntersectNp(RTCScene scene, struct RTCIntersectContext* context, const struct RTCRayHitNp* rayhit, unsigned int N);
 
+/* Intersects a tile of coherent camera rays with the scene. */
+RTC_API void rtcIntersectTile(RTCScene scene, struct RTCIntersectContext* context, const struct RTCRayTile* tile, struct RTCRayHit* rayhit, size_t byteStride);
+
+/* Intersects a stream of rays with common direction with the scene. */
+RTC_API void rtcIntersectSharedDirection(RTCScene scene, struct RTCIntersectContext* context, const struct RTCRaySharedDirection* rays, const struct RTCHitNp* hits, unsigned int N);
+
 /* Tests a single ray for occlusion with the scene. */
 RTC_API void rtcOccluded1(RTCScene scene, struct RTCIntersectContext* context, struct RTCRay* ray);
 
@@ -143,13 +171,63 @@ RTC_API void rtcOccludedNM(RTCScene scene, struct RTCIntersectContext* context,
 /* Tests a stream of M ray packets of size N in SOA format for occlusion with the scene. */
 RTC_API void rtcOccludedNp(RTCScene scene, struct RTCIntersectContext* context, const struct RTCRayNp* ray, unsigned int N);
 
+/* Tests a stream of rays with common origin for occlusion with the scene. */
+RTC_API void rtcOccludedSharedOrigin(RTCScene scene, struct RTCIntersectContext* context, const struct RTCRaySharedOrigin* rays, unsigned int N);
+
+/* Tests a stream of rays with common direction for occlusion with the scene. */
+RTC_API void rtcOccludedSharedDirection(RTCScene scene, struct RTCIntersectContext* context, const struct RTCRaySharedDirection* rays, unsigned int N);
+
+/* Tests the visibility between all pairs of two point sets and writes the result into a bit matrix. */
+RTC_API void rtcOccludedMatrix(RTCScene scene, struct RTCIntersectContext* context, const float* points0, unsigned int N, const float* points1, unsigned int M, size_t byteStride, float epsilon, unsigned int* visibility);
+
 /*! collision callback */
 struct RTCCollision { unsigned int geomID0; unsigned int primID0; unsigned int geomID1; unsigned int primID1; };
 typedef void (*RTCCollideFunc) (void* userPtr, struct RTCCollision* collisions, unsigned int num_collisions);
 
 /*! Performs collision detection of two scenes */
 RTC_API void rtcCollide (RTCScene scene0, RTCScene scene1, RTCCollideFunc callback, void* userPtr);
- 
+
+/*! collision flags */
+enum RTCCollideFlags
+{
+  RTC_COLLIDE_FLAG_NONE                   = 0,
+  RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE  = (1 << 0),
+  RTC_COLLIDE_FLAG_SELF_COLLISION         = (1 << 1)
+};
+
+/*! Performs collision detection of two scenes and writes all colliding primitive pairs into a single array */
+RTC_API unsigned int rtcCollideBuffered (RTCScene scene0, RTCScene scene1, enum RTCCollideFlags flags, struct RTCCollision* collisions, unsigned int maxCollisions);
+
+/* Opaque collision cache type */
+typedef struct RTCCollisionCacheTy* RTCCollisionCache;
+
+/*! Creates a new collision cache that keeps the traversal front of collision queries between two scenes */
+RTC_API RTCCollisionCache rtcNewCollisionCache (RTCScene scene0, RTCScene scene1);
+
+/*! Retains the collision cache (increments the reference count). */
+RTC_API void rtcRetainCollisionCache (RTCCollisionCache cache);
+
+/*! Releases the collision cache (decrements the reference count). */
+RTC_API void rtcReleaseCollisionCache (RTCCollisionCache cache);
+
+/*! Performs collision detection of the two scenes of the cache starting from the traversal front of the last query */
+RTC_API void rtcCollideCached (RTCCollisionCache cache, RTCCollideFunc callback, void* userPtr);
+
+/*! Performs collision detection of the two scenes of the cache starting from the traversal front of the last query and writes all colliding primitive pairs into a single array */
+RTC_API unsigned int rtcCollideCachedBuffered (RTCCollisionCache cache, enum RTCCollideFlags flags, struct RTCCollision* collisions, unsigned int maxCollisions);
+
+/*! continuous collision, time is the time of first contact */
+struct RTCContinuousCollision { unsigned int geomID0; unsigned int primID0; unsigned int geomID1; unsigned int primID1; float time; };
+
+/*! Performs continuous collision detection of two moving scenes over the time range [time0,time1] and writes all colliding primitive pairs into a single array */
+RTC_API unsigned int rtcCollideContinuous (RTCScene scene0, RTCScene scene1, float time0, float time1, enum RTCCollideFlags flags, struct RTCContinuousCollision* collisions, unsigned int maxCollisions);
+
+/*! closest pair of primitives of two scenes, p0 and p1 are the closest points on the primitives */
+struct RTCClosestPair { unsigned int geomID0; unsigned int primID0; unsigned int geomID1; unsigned int primID1; float distance; float p0[3]; float p1[3]; };
+
+/*! Finds the closest pair of primitives of two scenes that are less than maxDistance apart, returns false if there is no such pair */
+RTC_API bool rtcClosestPair (RTCScene scene0, RTCScene scene1, float maxDistance, struct RTCClosestPair* result);
+
 #if defined(__cplusplus)
 
 /* Helper for easily combining scene flags */
@@ -157,6 +235,11 @@ inline RTCSceneFlags operator|(RTCSceneFlags a, RTCSceneFlags b) {
   return (RTCSceneFlags)((size_t)a | (size_t)b);
 }
 
+/* Helper for easily combining collide flags */
+inline RTCCollideFlags operator|(RTCCollideFlags a, RTCCollideFlags b) {
+  return (RTCCollideFlags)((size_t)a | (size_t)b);
+}
+
 #endif
 
 RTC_NAMESPACE_END
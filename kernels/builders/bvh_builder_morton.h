@@ -171,6 +171,31 @@ namespace embree
 
 #endif
 
+      /*! sorts N points along a Morton curve, the x coordinate is the least significant,
+       *  afterwards prims[i].index is the index of the i'th point in Morton order */
+      template<typename GetPoint>
+      static void sortPoints(size_t N, const GetPoint& getPoint, std::vector<BuildPrim>& prims)
+      {
+        const BBox3fa bounds = parallel_reduce(size_t(0), N, size_t(4096), BBox3fa(empty), [&] (const range<size_t>& r) -> BBox3fa {
+            BBox3fa b(empty);
+            for (size_t i = r.begin(); i < r.end(); i++) b.extend(getPoint(i));
+            return b;
+          }, [] (const BBox3fa& a, const BBox3fa& b) { return merge(a, b); });
+
+        /* the mapping bins box centroids scaled by 2 */
+        const MortonCodeMapping mapping(BBox3fa(2.0f*bounds.lower,2.0f*bounds.upper));
+
+        std::vector<BuildPrim> tmp(N);
+        prims.resize(N);
+        parallel_for(size_t(0), N, size_t(4096), [&] (const range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+              prims[i].code = mapping.code(BBox3fa(getPoint(i)));
+              prims[i].index = (unsigned int)i;
+            }
+          });
+        radix_sort_u32(prims.data(), tmp.data(), N);
+      }
+
       template<
         typename ReductionTy,
         typename Allocator,
@@ -23,6 +23,8 @@
 namespace embree
 {
   DECLARE_SYMBOL2(Accel::Collider,BVH4ColliderUserGeom);
+  DECLARE_SYMBOL2(Accel::Collider,BVH4ColliderTriangle);
+  DECLARE_SYMBOL2(Accel::Collider,BVH4ColliderContinuous);
 
   DECLARE_ISA_FUNCTION(VirtualCurveIntersector*,VirtualCurveIntersector4i,void);
   DECLARE_ISA_FUNCTION(VirtualCurveIntersector*,VirtualCurveIntersector8i,void);
@@ -253,6 +255,8 @@ namespace embree
   BVH4Factory::BVH4Factory(int bfeatures, int ifeatures)
   {
     SELECT_SYMBOL_DEFAULT_AVX_AVX2(ifeatures,BVH4ColliderUserGeom);
+    SELECT_SYMBOL_DEFAULT_AVX_AVX2(ifeatures,BVH4ColliderTriangle);
+    SELECT_SYMBOL_DEFAULT_AVX_AVX2(ifeatures,BVH4ColliderContinuous);
 
     selectBuilders(bfeatures);
     selectIntersectors(ifeatures);
@@ -584,6 +588,7 @@ namespace embree
     intersectors.intersectorN_filter    = BVH4Triangle4IntersectorStreamMoeller();
     intersectors.intersectorN_nofilter  = BVH4Triangle4IntersectorStreamMoellerNoFilter();
 #endif
+    intersectors.collider      = BVH4ColliderTriangle();
     return intersectors;
   }
 
@@ -599,6 +604,7 @@ namespace embree
     intersectors.intersector16 = BVH4Triangle4vIntersector16HybridPluecker();
     intersectors.intersectorN  = BVH4Triangle4vIntersectorStreamPluecker();
 #endif
+    intersectors.collider      = BVH4ColliderTriangle();
     return intersectors;
   }
 
@@ -616,6 +622,7 @@ namespace embree
       intersectors.intersector16 = BVH4Triangle4iIntersector16HybridMoeller();
       intersectors.intersectorN  = BVH4Triangle4iIntersectorStreamMoeller();
 #endif
+      intersectors.collider      = BVH4ColliderTriangle();
       return intersectors;
     }
     case IntersectVariant::ROBUST:
@@ -629,6 +636,7 @@ namespace embree
       intersectors.intersector16 = BVH4Triangle4iIntersector16HybridPluecker();
       intersectors.intersectorN  = BVH4Triangle4iIntersectorStreamPluecker();
 #endif
+      intersectors.collider      = BVH4ColliderTriangle();
       return intersectors;
     }
     }
@@ -649,6 +657,7 @@ namespace embree
       intersectors.intersector16 = BVH4Triangle4vMBIntersector16HybridMoeller();
       intersectors.intersectorN  = BVH4IntersectorStreamPacketFallback();
 #endif
+      intersectors.collider      = BVH4ColliderContinuous();
       return intersectors;
     }
     case IntersectVariant::ROBUST:
@@ -662,6 +671,7 @@ namespace embree
       intersectors.intersector16 = BVH4Triangle4vMBIntersector16HybridPluecker();
       intersectors.intersectorN  = BVH4IntersectorStreamPacketFallback();
 #endif
+      intersectors.collider      = BVH4ColliderContinuous();
       return intersectors;
     }
     }
@@ -682,6 +692,7 @@ namespace embree
       intersectors.intersector16 = BVH4Triangle4iMBIntersector16HybridMoeller();
       intersectors.intersectorN  = BVH4IntersectorStreamPacketFallback();
 #endif
+      intersectors.collider      = BVH4ColliderContinuous();
       return intersectors;
     }
     case IntersectVariant::ROBUST:
@@ -695,6 +706,7 @@ namespace embree
       intersectors.intersector16 = BVH4Triangle4iMBIntersector16HybridPluecker();
       intersectors.intersectorN  = BVH4IntersectorStreamPacketFallback();
 #endif
+      intersectors.collider      = BVH4ColliderContinuous();
       return intersectors;
     }
     }
@@ -846,6 +858,7 @@ namespace embree
     intersectors.intersector16 = BVH4VirtualMBIntersector16Chunk();
     intersectors.intersectorN  = BVH4IntersectorStreamPacketFallback();
 #endif
+    intersectors.collider      = BVH4ColliderContinuous();
     return intersectors;
   }
 
@@ -27,6 +27,8 @@
 namespace embree
 {
   DECLARE_SYMBOL2(Accel::Collider,BVH8ColliderUserGeom);
+  DECLARE_SYMBOL2(Accel::Collider,BVH8ColliderTriangle);
+  DECLARE_SYMBOL2(Accel::Collider,BVH8ColliderContinuous);
   
   DECLARE_ISA_FUNCTION(VirtualCurveIntersector*,VirtualCurveIntersector8v,void);
   DECLARE_ISA_FUNCTION(VirtualCurveIntersector*,VirtualCurveIntersector8iMB,void);
@@ -228,6 +230,8 @@ namespace embree
   BVH8Factory::BVH8Factory(int bfeatures, int ifeatures)
   {
     SELECT_SYMBOL_INIT_AVX(ifeatures,BVH8ColliderUserGeom);
+    SELECT_SYMBOL_INIT_AVX(ifeatures,BVH8ColliderTriangle);
+    SELECT_SYMBOL_INIT_AVX(ifeatures,BVH8ColliderContinuous);
     
     selectBuilders(bfeatures);
     selectIntersectors(ifeatures);
@@ -535,6 +539,7 @@ namespace embree
     intersectors.intersectorN_filter    = BVH8Triangle4IntersectorStreamMoeller();
     intersectors.intersectorN_nofilter  = BVH8Triangle4IntersectorStreamMoellerNoFilter();
 #endif
+    intersectors.collider      = BVH8ColliderTriangle();
     return intersectors;
   }
 
@@ -556,6 +561,7 @@ namespace embree
     intersectors.intersector16   = BVH8Triangle4vIntersector16HybridPluecker();
     intersectors.intersectorN    = BVH8Triangle4vIntersectorStreamPluecker();
 #endif
+    intersectors.collider      = BVH8ColliderTriangle();
     return intersectors;
   }
 
@@ -573,6 +579,7 @@ namespace embree
       intersectors.intersector16 = BVH8Triangle4iIntersector16HybridMoeller();
       intersectors.intersectorN  = BVH8Triangle4iIntersectorStreamMoeller();
 #endif
+      intersectors.collider      = BVH8ColliderTriangle();
       return intersectors;
     }
     case IntersectVariant::ROBUST:
@@ -586,6 +593,7 @@ namespace embree
       intersectors.intersector16 = BVH8Triangle4iIntersector16HybridPluecker();
       intersectors.intersectorN  = BVH8Triangle4iIntersectorStreamPluecker();
 #endif
+      intersectors.collider      = BVH8ColliderTriangle();
       return intersectors;
     }
     }
@@ -606,6 +614,7 @@ namespace embree
       intersectors.intersector16 = BVH8Triangle4vMBIntersector16HybridMoeller();
       intersectors.intersectorN  = BVH8IntersectorStreamPacketFallback();
 #endif
+      intersectors.collider      = BVH8ColliderContinuous();
       return intersectors;
     }
     case IntersectVariant::ROBUST:
@@ -619,6 +628,7 @@ namespace embree
       intersectors.intersector16 = BVH8Triangle4vMBIntersector16HybridPluecker();
       intersectors.intersectorN  = BVH8IntersectorStreamPacketFallback();
 #endif
+      intersectors.collider      = BVH8ColliderContinuous();
       return intersectors;
     }
     }
@@ -639,6 +649,7 @@ namespace embree
       intersectors.intersector16 = BVH8Triangle4iMBIntersector16HybridMoeller();
       intersectors.intersectorN  = BVH8IntersectorStreamPacketFallback();
 #endif
+      intersectors.collider      = BVH8ColliderContinuous();
       return intersectors;
     }
     case IntersectVariant::ROBUST:
@@ -652,6 +663,7 @@ namespace embree
       intersectors.intersector16 = BVH8Triangle4iMBIntersector16HybridPluecker();
       intersectors.intersectorN  = BVH8IntersectorStreamPacketFallback();
 #endif
+      intersectors.collider      = BVH8ColliderContinuous();
       return intersectors;
     }
     }
@@ -811,6 +823,7 @@ namespace embree
     intersectors.intersector16 = BVH8VirtualMBIntersector16Chunk();
     intersectors.intersectorN  = BVH8IntersectorStreamPacketFallback();
 #endif
+    intersectors.collider      = BVH8ColliderContinuous();
     return intersectors;
   }
 
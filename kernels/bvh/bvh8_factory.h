@@ -75,6 +75,8 @@ namespace embree
 
   private:
     DEFINE_SYMBOL2(Accel::Collider,BVH8ColliderUserGeom);
+    DEFINE_SYMBOL2(Accel::Collider,BVH8ColliderTriangle);
+    DEFINE_SYMBOL2(Accel::Collider,BVH8ColliderContinuous);
     
     DEFINE_SYMBOL2(Accel::Intersector1,BVH8OBBVirtualCurveIntersector1);
     DEFINE_SYMBOL2(Accel::Intersector1,BVH8OBBVirtualCurveIntersector1MB);
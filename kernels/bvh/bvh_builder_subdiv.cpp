@@ -28,7 +28,7 @@ namespace embree
     typedef FastAllocator::CachedAllocator Allocator;
 
     template<int N>
-    struct BVHNSubdivPatch1BuilderSAH : public Builder
+    struct BVHNSubdivPatch1BuilderSAH : public Builder, public BVHNRefitter<N>::LeafBoundsInterface
     {
       ALIGNED_STRUCT_(64);
 
@@ -38,9 +38,11 @@ namespace embree
       BVH* bvh;
       Scene* scene;
       mvector<PrimRef> prims;
+      mvector<size_t> leaves;                     //!< grid leaves in creation order
+      std::vector<unsigned int> topologyVersions; //!< topology version of each subdiv mesh at the last build
             
       BVHNSubdivPatch1BuilderSAH (BVH* bvh, Scene* scene)
-        : bvh(bvh), scene(scene), prims(scene->device,0) {}
+        : bvh(bvh), scene(scene), prims(scene->device,0), leaves(scene->device,0) {}
 
 #define SUBGRID 9
 
@@ -74,8 +76,128 @@ namespace embree
         return NN;
       }
 
-      void build() 
+      __forceinline static unsigned updateEager(SubdivPatch1Base& patch, Scene* scene, const size_t* leaves, std::atomic<bool>& failed)
+      {
+        unsigned NN = 0;
+        const unsigned x0 = 0, x1 = patch.grid_u_res-1;
+        const unsigned y0 = 0, y1 = patch.grid_v_res-1;
+        
+        for (unsigned y=y0; y<y1; y+=SUBGRID-1)
+        {
+          for (unsigned x=x0; x<x1; x+=SUBGRID-1) 
+          {
+            const unsigned lx0 = x, lx1 = min(lx0+SUBGRID-1,x1);
+            const unsigned ly0 = y, ly1 = min(ly0+SUBGRID-1,y1);
+            size_t num; GridSOA* leaf = (GridSOA*) NodeRef(*leaves).leaf(num); leaves++;
+            if (!GridSOA::update(leaf,&patch,1,lx0,lx1,ly0,ly1,scene)) failed = true;
+            NN++;
+          }
+        }
+        return NN;
+      }
+
+      virtual const BBox3fa leafBounds (NodeRef& ref) const
+      {
+        if (unlikely(ref == BVH::emptyNode)) return empty;
+        size_t num; GridSOA* leaf = (GridSOA*) ref.leaf(num);
+        return leaf->bounds();
+      }
+
+      /* the grids can get updated in place if only vertex positions changed since the last build */
+      bool positionsOnlyChanged()
+      {
+        if (leaves.size() == 0 || bvh->root == BVH::emptyNode)
+          return false;
+        
+        Scene::Iterator<SubdivMesh> iter(scene);
+        if (iter.size() != topologyVersions.size())
+          return false;
+        
+        for (size_t i=0; i<iter.size(); i++) {
+          SubdivMesh* mesh = iter.at(i);
+          if ((mesh ? mesh->getTopologyVersion() : 0) != topologyVersions[i])
+            return false;
+        }
+        return true;
+      }
+
+      void storeTopologyVersions()
+      {
+        Scene::Iterator<SubdivMesh> iter(scene);
+        topologyVersions.resize(iter.size());
+        for (size_t i=0; i<iter.size(); i++) {
+          SubdivMesh* mesh = iter.at(i);
+          topologyVersions[i] = mesh ? mesh->getTopologyVersion() : 0;
+        }
+      }
+
+      /* reevaluates all grids in place and refits the BVH over the grids, returns false if the grids do not match or compressed grids do not fit anymore */
+      bool update()
+      {
+        ParallelForForPrefixSumState<PrimInfo> pstate;
+        Scene::Iterator<SubdivMesh> iter(scene);
+        pstate.init(iter,size_t(1024));
+
+        PrimInfo pinfo = parallel_for_for_prefix_sum0( pstate, iter, PrimInfo(empty), [&](SubdivMesh* mesh, const range<size_t>& r, size_t k, size_t /*geomID*/) -> PrimInfo
+        { 
+          size_t p = 0;
+          size_t g = 0;
+          for (size_t f=r.begin(); f!=r.end(); ++f) {          
+            if (!mesh->valid(f)) continue;
+            patch_eval_subdivision(mesh->getHalfEdge(0,f),[&](const Vec2f uv[4], const int subdiv[4], const float edge_level[4], int subPatch)
+            {
+              float level[4]; SubdivPatch1Base::computeEdgeLevels(edge_level,subdiv,level);
+              Vec2i grid = SubdivPatch1Base::computeGridSize(level);
+              g+=getNumEagerLeaves(grid.x,grid.y);
+              p++;
+            });
+          }
+          return PrimInfo(p,g,empty);
+        }, [](const PrimInfo& a, const PrimInfo& b) -> PrimInfo { return PrimInfo(a.begin+b.begin,a.end+b.end,empty); });
+        if (pinfo.end != leaves.size())
+          return false;
+
+        double t0 = bvh->preBuild(TOSTRING(isa) "::BVH" + toString(N) + "SubdivPatch1RefitSAH");
+        
+        std::atomic<bool> failed(false);
+        parallel_for_for_prefix_sum1( pstate, iter, PrimInfo(empty), [&](SubdivMesh* mesh, const range<size_t>& r, size_t k, size_t geomID, const PrimInfo& base) -> PrimInfo
+        {
+          PrimInfo s(empty);
+          for (size_t f=r.begin(); f!=r.end(); ++f) {
+            if (!mesh->valid(f)) continue;
+            
+            patch_eval_subdivision(mesh->getHalfEdge(0,f),[&](const Vec2f uv[4], const int subdiv[4], const float edge_level[4], int subPatch)
+            {
+              SubdivPatch1Base patch(unsigned(geomID),unsigned(f),subPatch,mesh,0,uv,edge_level,subdiv,VSIZEX);
+              s.end += updateEager(patch,scene,&leaves[base.end+s.end],failed);
+              s.begin++;
+            });
+          }
+          return s;
+        }, [](const PrimInfo& a, const PrimInfo& b) -> PrimInfo { return PrimInfo(a.begin+b.begin,a.end+b.end,empty); });
+        if (failed)
+          return false;
+
+        BVHNRefitter<N> refitter(bvh,*this);
+        refitter.refit();
+        bvh->postBuild(t0);
+        scene->device->subdiv_grid_updates += leaves.size();
+        return true;
+      }
+
+      void build()
+      {
+        if (positionsOnlyChanged() && update())
+          return;
+
+        rebuild();
+        storeTopologyVersions();
+      }
+
+      void rebuild() 
       {
+        leaves.clear();
+
         /* skip build for empty scene */
         const size_t numPrimitives = scene->getNumPrimitives(SubdivMesh::geom_type,false);
         if (numPrimitives == 0) {
@@ -149,6 +271,16 @@ namespace embree
         }, [](const PrimInfo& a, const PrimInfo& b) -> PrimInfo { return PrimInfo::merge(a, b); });
 
         PrimInfo pinfo(0,pinfo3.end,pinfo3);
+
+        /* remember the grids in creation order for in place updates, as the BVH build reorders the primitives */
+        if (!scene->isStaticAccel())
+        {
+          leaves.resize(prims.size());
+          parallel_for( size_t(0), prims.size(), size_t(4096), [&](const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++)
+              leaves[i] = prims[i].ID();
+          });
+        }
         
         auto createLeaf = [&] (const PrimRef* prims, const range<size_t>& range, Allocator alloc) -> NodeRef {
           assert(range.size() == 1);
@@ -179,6 +311,8 @@ namespace embree
 
       void clear() {
         prims.clear();
+        leaves.clear();
+        topologyVersions.clear();
       }
     };
 
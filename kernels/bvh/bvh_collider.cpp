@@ -3,6 +3,7 @@
 
 #include "bvh_collider.h"
 #include "../geometry/triangle_triangle_intersector.h"
+#include "../geometry/closest_point.h"
 
 namespace embree
 { 
@@ -21,19 +22,6 @@ namespace embree
     CSTAT(std::atomic<size_t> bvh_collide_prim_intersections5(0));
     CSTAT(std::atomic<size_t> bvh_collide_prim_intersections(0));
 
-    struct Collision
-    {
-      __forceinline Collision() {}
-
-      __forceinline Collision (unsigned geomID0, unsigned primID0, unsigned geomID1, unsigned primID1)
-        : geomID0(geomID0), primID0(primID0), geomID1(geomID1), primID1(primID1) {}
-
-      unsigned geomID0;
-      unsigned primID0;
-      unsigned geomID1;
-      unsigned primID1;
-    };
-    
     template<int N>
     __forceinline size_t overlap(const BBox3fa& box0, const typename BVHN<N>::AABBNode& node1)
     {
@@ -106,41 +94,129 @@ namespace embree
       
       return TriangleTriangleIntersector::intersect_triangle_triangle(a0,a1,a2,b0,b1,b2);
     }
+
+    /* tests if two triangles of the same mesh share a vertex */
+    bool share_vertex (Scene* scene, unsigned geomID, unsigned primID0, unsigned primID1)
+    {
+      const TriangleMesh* mesh = scene->get<TriangleMesh>(geomID);
+      const TriangleMesh::Triangle& tri0 = mesh->triangle(primID0);
+      const TriangleMesh::Triangle& tri1 = mesh->triangle(primID1);
+      const vint4 t0(tri0.v[0],tri0.v[1],tri0.v[2],tri0.v[2]);
+      return any(vint4(tri1.v[0]) == t0) || any(vint4(tri1.v[1]) == t0) || any(vint4(tri1.v[2]) == t0);
+    }
+
+    /* tests if the bounds of two triangles overlap */
+    bool overlap_triangle_bounds (Scene* scene0, unsigned geomID0, unsigned primID0, Scene* scene1, unsigned geomID1, unsigned primID1)
+    {
+      const TriangleMesh* mesh0 = scene0->get<TriangleMesh>(geomID0);
+      const TriangleMesh* mesh1 = scene1->get<TriangleMesh>(geomID1);
+      const TriangleMesh::Triangle& tri0 = mesh0->triangle(primID0);
+      const TriangleMesh::Triangle& tri1 = mesh1->triangle(primID1);
+      const BBox3fa bounds0 = merge(BBox3fa(mesh0->vertex(tri0.v[0])),BBox3fa(mesh0->vertex(tri0.v[1])),BBox3fa(mesh0->vertex(tri0.v[2])));
+      const BBox3fa bounds1 = merge(BBox3fa(mesh1->vertex(tri1.v[0])),BBox3fa(mesh1->vertex(tri1.v[1])),BBox3fa(mesh1->vertex(tri1.v[2])));
+      return conjoint(bounds0,bounds1);
+    }
     
     template<int N>
-    __forceinline void BVHNColliderUserGeom<N>::processLeaf(NodeRef node0, NodeRef node1)
+    __forceinline void BVHNColliderUserGeom<N>::processLeaf(NodeRef node0, NodeRef node1, CollisionStream& stream)
     {
-      Collision collisions[16];
-      size_t num_collisions = 0;
-
       size_t N0; Object* leaf0 = (Object*) node0.leaf(N0);
       size_t N1; Object* leaf1 = (Object*) node1.leaf(N1);
+      const bool sameLeaf = this->selfCollision && node0 == node1;
       for (size_t i=0; i<N0; i++) {
-        for (size_t j=0; j<N1; j++) {
+        for (size_t j=sameLeaf ? i+1 : 0; j<N1; j++) {
           const unsigned geomID0 = leaf0[i].geomID();
           const unsigned primID0 = leaf0[i].primID();
           const unsigned geomID1 = leaf1[j].geomID();
           const unsigned primID1 = leaf1[j].primID();
           if (this->scene0 == this->scene1 && geomID0 == geomID1 && primID0 == primID1) continue;
-          collisions[num_collisions++] = Collision(geomID0,primID0,geomID1,primID1);
-          if (num_collisions == 16) {
-            this->callback(this->userPtr,(RTCCollision*)&collisions,num_collisions);
-            num_collisions = 0;
-          }
+          stream.add(geomID0,primID0,geomID1,primID1);
         }
       }
-      if (num_collisions)
-        this->callback(this->userPtr,(RTCCollision*)&collisions,num_collisions);
+      stream.flush();
+    }
+
+    template<int N>
+    typename BVHNColliderTriangle<N>::LeafType BVHNColliderTriangle<N>::leafType(const BVH* bvh)
+    {
+      if (bvh->primTy == &Triangle4v::type) return TRIANGLE4V;
+      if (bvh->primTy == &Triangle4i::type) return TRIANGLE4I;
+      assert(bvh->primTy == &Triangle4::type);
+      return TRIANGLE4;
+    }
+
+    template<typename Primitive, typename NodeRef, typename Func>
+    __forceinline void foreachTriangleInLeaf(NodeRef node, const Func& func)
+    {
+      size_t num; const Primitive* prims = (const Primitive*) node.leaf(num);
+      for (size_t i=0; i<num; i++)
+        for (size_t j=0; j<prims[i].size(); j++)
+          func(prims[i].geomID(j),prims[i].primID(j));
+    }
+
+    template<int N>
+    template<typename Func>
+    __forceinline void BVHNColliderTriangle<N>::foreachTriangle(LeafType type, NodeRef node, const Func& func)
+    {
+      switch (type) {
+      case TRIANGLE4 : foreachTriangleInLeaf<Triangle4> (node,func); break;
+      case TRIANGLE4V: foreachTriangleInLeaf<Triangle4v>(node,func); break;
+      case TRIANGLE4I: foreachTriangleInLeaf<Triangle4i>(node,func); break;
+      }
     }
 
     template<int N>
-    void BVHNCollider<N>::collide_recurse(NodeRef ref0, const BBox3fa& bounds0, NodeRef ref1, const BBox3fa& bounds1, size_t depth0, size_t depth1)
+    __forceinline void BVHNColliderTriangle<N>::processLeaf(NodeRef node0, NodeRef node1, CollisionStream& stream)
+    {
+      const bool narrowPhase = this->flags & RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE;
+
+      /* in self collision mode a leaf only collides each pair of its triangles once */
+      const bool sameLeaf = this->selfCollision && node0 == node1;
+      size_t index0 = 0;
+      foreachTriangle(type0, node0, [&] (unsigned geomID0, unsigned primID0) {
+          size_t index1 = 0;
+          foreachTriangle(type1, node1, [&] (unsigned geomID1, unsigned primID1)
+          {
+            if (sameLeaf && index1++ <= index0) return;
+            if (narrowPhase) {
+              if (!intersect_triangle_triangle(this->scene0,geomID0,primID0,this->scene1,geomID1,primID1)) return;
+            } else {
+              if (this->scene0 == this->scene1 && geomID0 == geomID1 && primID0 == primID1) return;
+              if (this->selfCollision && geomID0 == geomID1 && share_vertex(this->scene0,geomID0,primID0,primID1)) return;
+              if (!overlap_triangle_bounds(this->scene0,geomID0,primID0,this->scene1,geomID1,primID1)) return;
+            }
+            stream.add(geomID0,primID0,geomID1,primID1);
+          });
+          index0++;
+        });
+      stream.flush();
+    }
+
+    /* merges the collision buffers into a single contiguous array */
+    static size_t mergeCollisions(const std::vector<std::vector<RTCCollision>>& buffers, RTCCollision* collisions, size_t maxCollisions)
+    {
+      size_t numCollisions = 0;
+      std::vector<size_t> offsets(buffers.size());
+      for (size_t i=0; i<buffers.size(); i++) {
+        offsets[i] = numCollisions;
+        numCollisions += buffers[i].size();
+      }
+      parallel_for(buffers.size(), [&] ( size_t i ) {
+          if (offsets[i] >= maxCollisions) return;
+          const size_t num = min(buffers[i].size(),maxCollisions-offsets[i]);
+          std::copy(buffers[i].begin(),buffers[i].begin()+num,collisions+offsets[i]);
+        });
+      return numCollisions;
+    }
+
+    template<int N>
+    void BVHNCollider<N>::collide_recurse(NodeRef ref0, const BBox3fa& bounds0, NodeRef ref1, const BBox3fa& bounds1, size_t depth0, size_t depth1, CollisionStream& stream)
     {
       CSTAT(bvh_collide_traversal_steps++);
       if (unlikely(ref0.isLeaf())) {
         if (unlikely(ref1.isLeaf())) {
           CSTAT(bvh_collide_leaf_pairs++);
-          processLeaf(ref0,ref1);
+          processLeaf(ref0,ref1,stream);
           return;
         } else goto recurse_node1;
         
@@ -169,7 +245,7 @@ namespace embree
           parallel_for(size_t(N), [&] ( size_t i ) {
               if (mask & ( 1 << i)) {
                 BVHN<N>::prefetch(node0->child(i),BVH_FLAG_ALIGNED_NODE);
-                collide_recurse(node0->child(i),node0->bounds(i),ref1,bounds1,depth0+1,depth1);
+                collide_recurse(node0->child(i),node0->bounds(i),ref1,bounds1,depth0+1,depth1,stream);
               }
             });
         } 
@@ -178,7 +254,7 @@ namespace embree
         {
           for (size_t m=mask, i=bsf(m); m!=0; m=btc(m,i), i=bsf(m)) {
             BVHN<N>::prefetch(node0->child(i),BVH_FLAG_ALIGNED_NODE);
-            collide_recurse(node0->child(i),node0->bounds(i),ref1,bounds1,depth0+1,depth1);
+            collide_recurse(node0->child(i),node0->bounds(i),ref1,bounds1,depth0+1,depth1,stream);
           }
         }
         return;
@@ -196,7 +272,7 @@ namespace embree
           parallel_for(size_t(N), [&] ( size_t i ) {
               if (mask & ( 1 << i)) {
                 BVHN<N>::prefetch(node1->child(i),BVH_FLAG_ALIGNED_NODE);
-                collide_recurse(ref0,bounds0,node1->child(i),node1->bounds(i),depth0,depth1+1);
+                collide_recurse(ref0,bounds0,node1->child(i),node1->bounds(i),depth0,depth1+1,stream);
               }
             });
         }
@@ -205,16 +281,59 @@ namespace embree
         {
           for (size_t m=mask, i=bsf(m); m!=0; m=btc(m,i), i=bsf(m)) {
             BVHN<N>::prefetch(node1->child(i),BVH_FLAG_ALIGNED_NODE);
-            collide_recurse(ref0,bounds0,node1->child(i),node1->bounds(i),depth0,depth1+1);
+            collide_recurse(ref0,bounds0,node1->child(i),node1->bounds(i),depth0,depth1+1,stream);
           }
         }
         return;
       }
     }
 
+    template<int N>
+    void BVHNCollider<N>::collide_self_recurse(NodeRef ref, size_t depth, CollisionStream& stream)
+    {
+      CSTAT(bvh_collide_traversal_steps++);
+      if (unlikely(ref.isLeaf())) {
+        CSTAT(bvh_collide_leaf_pairs++);
+        processLeaf(ref,ref,stream);
+        return;
+      }
+
+      /* the subtrees of two different children are disjoint, thus
+       * colliding each pair of children once reports each pair of
+       * primitives once */
+      AABBNode* node = ref.getAABBNode();
+      for (size_t i=0; i<N && node->child(i) != BVH::emptyNode; i++)
+      {
+        BVHN<N>::prefetch(node->child(i),BVH_FLAG_ALIGNED_NODE);
+        collide_self_recurse(node->child(i),depth+1,stream);
+        for (size_t j=i+1; j<N && node->child(j) != BVH::emptyNode; j++) {
+          if (conjoint(node->bounds(i),node->bounds(j)))
+            collide_recurse(node->child(i),node->bounds(i),node->child(j),node->bounds(j),depth+1,depth+1,stream);
+        }
+      }
+    }
+
     template<int N>
     void BVHNCollider<N>::split(const CollideJob& job, jobvector& jobs)
     {
+      if (unlikely(isSelfJob(job)))
+      {
+        if (job.ref0.isLeaf()) {
+          jobs.push_back(job);
+          return;
+        }
+        const AABBNode* node = job.ref0.getAABBNode();
+        for (size_t i=0; i<N && node->child(i) != BVH::emptyNode; i++)
+        {
+          jobs.push_back(CollideJob(node->child(i),node->bounds(i),job.depth0+1,node->child(i),node->bounds(i),job.depth1+1));
+          for (size_t j=i+1; j<N && node->child(j) != BVH::emptyNode; j++) {
+            if (conjoint(node->bounds(i),node->bounds(j)))
+              jobs.push_back(CollideJob(node->child(i),node->bounds(i),job.depth0+1,node->child(j),node->bounds(j),job.depth1+1));
+          }
+        }
+        return;
+      }
+
       if (unlikely(job.ref0.isLeaf())) {
         if (unlikely(job.ref1.isLeaf())) {
           jobs.push_back(job);
@@ -255,8 +374,10 @@ namespace embree
     }
     
     template<int N>
-    void BVHNCollider<N>::collide_recurse_entry(NodeRef ref0, const BBox3fa& bounds0, NodeRef ref1, const BBox3fa& bounds1)
+    size_t BVHNCollider<N>::collide_recurse_entry(NodeRef ref0, const BBox3fa& bounds0, NodeRef ref1, const BBox3fa& bounds1,
+                                                  RTCCollision* collisions, size_t maxCollisions)
     {
+      size_t numCollisions = 0;
       CSTAT(bvh_collide_traversal_steps = 0);
       CSTAT(bvh_collide_leaf_pairs = 0);
       CSTAT(bvh_collide_leaf_iterations = 0);
@@ -267,9 +388,11 @@ namespace embree
       CSTAT(bvh_collide_prim_intersections5 = 0);
       CSTAT(bvh_collide_prim_intersections = 0);
 #if 0
-      collide_recurse(ref0,bounds0,ref1,bounds1,0,0);
+      CollisionStream stream(callback,userPtr);
+      collide_recurse(ref0,bounds0,ref1,bounds1,0,0,stream);
 #else
       const int M = 2048;
+      const size_t S = selfCollision ? N*(N+1)/2 : 8; // maximal number of jobs a job splits into
       jobvector jobs[2];
       jobs[0].reserve(M);
       jobs[1].reserve(M);
@@ -278,13 +401,13 @@ namespace embree
       int target = 1;
 
       /* try to split job until job list is full */
-      while (jobs[source].size()+8 <= M)
+      while (jobs[source].size()+S <= M)
       {
         for (size_t i=0; i<jobs[source].size(); i++)
         {
           const CollideJob& job = jobs[source][i];
           size_t remaining = jobs[source].size()-i;
-          if (jobs[target].size()+remaining+8 > M) {
+          if (jobs[target].size()+remaining+S > M) {
             jobs[target].push_back(job);
           } else {
             split(job,jobs[target]);
@@ -300,12 +423,29 @@ namespace embree
       }
 
       /* parallel processing of all jobs */
-      parallel_for(size_t(jobs[source].size()), [&] ( size_t i ) {
-          CollideJob& j = jobs[source][i];
-          collide_recurse(j.ref0,j.bounds0,j.ref1,j.bounds1,j.depth0,j.depth1);
-        });
-      
-      
+      const size_t numJobs = jobs[source].size();
+      if (callback)
+      {
+        parallel_for(numJobs, [&] ( size_t i ) {
+            CollideJob& j = jobs[source][i];
+            CollisionStream stream(callback,userPtr);
+            if (isSelfJob(j)) collide_self_recurse(j.ref0,j.depth0,stream);
+            else collide_recurse(j.ref0,j.bounds0,j.ref1,j.bounds1,j.depth0,j.depth1,stream);
+          });
+      }
+      else
+      {
+        /* each job writes into its own buffer, thus no synchronization is required */
+        std::vector<std::vector<RTCCollision>> buffers(numJobs);
+        parallel_for(numJobs, [&] ( size_t i ) {
+            CollideJob& j = jobs[source][i];
+            CollisionStream stream(&buffers[i]);
+            if (isSelfJob(j)) collide_self_recurse(j.ref0,j.depth0,stream);
+            else collide_recurse(j.ref0,j.bounds0,j.ref1,j.bounds1,j.depth0,j.depth1,stream);
+          });
+
+        numCollisions = mergeCollisions(buffers,collisions,maxCollisions);
+      }
 #endif
       CSTAT(PRINT(bvh_collide_traversal_steps));
       CSTAT(PRINT(bvh_collide_leaf_pairs));
@@ -316,8 +456,171 @@ namespace embree
       CSTAT(PRINT(bvh_collide_prim_intersections4));
       CSTAT(PRINT(bvh_collide_prim_intersections5));
       CSTAT(PRINT(bvh_collide_prim_intersections));
+      return numCollisions;
     }
    
+    template<int N>
+    CollisionCache::Stamp BVHNCollider<N>::stamp(const BVH* bvh)
+    {
+      /* the two level builder directly uses the BVH of a single geometry as root */
+      for (const BVH* object : bvh->objects)
+        if (object && object->root == bvh->root)
+          return CollisionCache::Stamp(bvh->root,object->alloc.getGeneration());
+
+      return CollisionCache::Stamp(bvh->root,bvh->alloc.getGeneration());
+    }
+
+    template<int N>
+    __forceinline typename BVHNCollider<N>::NodeRef BVHNCollider<N>::frontNode(const BVH* bvh, size_t parent, unsigned slot, BBox3fa& bounds)
+    {
+      if (parent == 0) {
+        bounds = bvh->bounds.bounds();
+        return bvh->root;
+      }
+      const AABBNode* node = NodeRef(parent).getAABBNode();
+      bounds = node->bounds(slot);
+      return node->child(slot);
+    }
+
+    template<int N>
+    void BVHNCollider<N>::refine_front(const BVH* bvh0, const BVH* bvh1, std::vector<FrontEntry>& front)
+    {
+      const size_t M = 2048;
+
+      /* open overlapping node pairs until there is enough parallel work */
+      while (front.size() < M)
+      {
+        std::vector<FrontEntry> next;
+        next.reserve(M);
+        bool opened = false;
+        
+        for (size_t i=0; i<front.size(); i++)
+        {
+          const FrontEntry& entry = front[i];
+          BBox3fa bounds0; NodeRef ref0 = frontNode(bvh0,entry.parent0,entry.slot0,bounds0);
+          BBox3fa bounds1; NodeRef ref1 = frontNode(bvh1,entry.parent1,entry.slot1,bounds1);
+          const size_t remaining = front.size()-i;
+          
+          if ((ref0.isLeaf() && ref1.isLeaf()) || !conjoint(bounds0,bounds1) || next.size()+remaining+N > M) {
+            next.push_back(entry);
+            continue;
+          }
+
+          opened = true;
+          if (ref1.isLeaf() || (!ref0.isLeaf() && area(bounds0) > area(bounds1))) {
+            const AABBNode* node0 = ref0.getAABBNode();
+            for (size_t j=0; j<N && node0->child(j) != BVH::emptyNode; j++)
+              next.push_back(FrontEntry(ref0,unsigned(j),entry.parent1,entry.slot1));
+          } else {
+            const AABBNode* node1 = ref1.getAABBNode();
+            for (size_t j=0; j<N && node1->child(j) != BVH::emptyNode; j++)
+              next.push_back(FrontEntry(entry.parent0,entry.slot0,ref1,unsigned(j)));
+          }
+        }
+
+        front.swap(next);
+        if (!opened) break;
+      }
+    }
+
+    template<int N>
+    void BVHNCollider<N>::collide_front(const BVH* bvh0, const BVH* bvh1, const FrontEntry& entry, std::vector<FrontEntry>& front, CollisionStream& stream)
+    {
+      BBox3fa bounds0; NodeRef ref0 = frontNode(bvh0,entry.parent0,entry.slot0,bounds0);
+      BBox3fa bounds1; NodeRef ref1 = frontNode(bvh1,entry.parent1,entry.slot1,bounds1);
+
+      /* empty nodes never collide as the topology of the BVHs stays the same */
+      if (ref0 == BVH::emptyNode || ref1 == BVH::emptyNode)
+        return;
+
+      /* non-overlapping pairs stay in the front */
+      if (!conjoint(bounds0,bounds1)) {
+        front.push_back(entry);
+        return;
+      }
+      
+      if (ref0.isLeaf() && ref1.isLeaf()) {
+        processLeaf(ref0,ref1,stream);
+        front.push_back(entry);
+        return;
+      }
+
+      if (ref1.isLeaf() || (!ref0.isLeaf() && area(bounds0) > area(bounds1)))
+      {
+        const AABBNode* node0 = ref0.getAABBNode();
+        const size_t mask = overlap<N>(bounds1,*node0);
+        for (size_t i=0; i<N && node0->child(i) != BVH::emptyNode; i++)
+        {
+          const FrontEntry child(ref0,unsigned(i),entry.parent1,entry.slot1);
+          if (mask & (size_t(1) << i)) collide_front(bvh0,bvh1,child,front,stream);
+          else front.push_back(child);
+        }
+      }
+      else
+      {
+        const AABBNode* node1 = ref1.getAABBNode();
+        const size_t mask = overlap<N>(bounds0,*node1);
+        for (size_t i=0; i<N && node1->child(i) != BVH::emptyNode; i++)
+        {
+          const FrontEntry child(entry.parent0,entry.slot0,ref1,unsigned(i));
+          if (mask & (size_t(1) << i)) collide_front(bvh0,bvh1,child,front,stream);
+          else front.push_back(child);
+        }
+      }
+    }
+
+    template<int N>
+    size_t BVHNCollider<N>::collide_cached(const BVH* bvh0, const BVH* bvh1, CollisionCache* cache, RTCCollision* collisions, size_t maxCollisions)
+    {
+      std::vector<CollisionCache::Block>& blocks = cache->blocks;
+      
+      /* restart from the roots if one of the BVHs got rebuilt */
+      const CollisionCache::Stamp stamp0 = stamp(bvh0);
+      const CollisionCache::Stamp stamp1 = stamp(bvh1);
+      if (!(stamp0 == cache->stamp0) || !(stamp1 == cache->stamp1) || blocks.empty())
+      {
+        cache->reset();
+        cache->stamp0 = stamp0;
+        cache->stamp1 = stamp1;
+        std::vector<FrontEntry> front(1,FrontEntry(0,0,0,0));
+        refine_front(bvh0,bvh1,front);
+        blocks.reserve(front.size());
+        for (const FrontEntry& entry : front)
+          blocks.push_back(CollisionCache::Block(entry));
+      }
+
+      /* parallel processing of the blocks, each block writes into its own buffer */
+      const size_t numBlocks = blocks.size();
+      std::vector<std::vector<RTCCollision>> buffers(callback ? 0 : numBlocks);
+      parallel_for(numBlocks, [&] ( size_t i ) {
+          CollisionCache::Block& block = blocks[i];
+          CollisionStream stream = callback ? CollisionStream(callback,userPtr) : CollisionStream(&buffers[i]);
+
+          /* the front below a node pair that does not overlap anymore collapses into the node pair */
+          BBox3fa bounds0; NodeRef ref0 = frontNode(bvh0,block.entry.parent0,block.entry.slot0,bounds0);
+          BBox3fa bounds1; NodeRef ref1 = frontNode(bvh1,block.entry.parent1,block.entry.slot1,bounds1);
+          if (ref0 == BVH::emptyNode || ref1 == BVH::emptyNode || !conjoint(bounds0,bounds1)) {
+            block.front.clear();
+            return;
+          }
+
+          /* the front only moves down during traversal, thus traverse from the node
+           * pair again if the front got much larger than a fresh one */
+          const bool restart = block.front.empty() || block.front.size() > 4*block.fullFrontSize;
+          if (restart) block.front.assign(1,block.entry);
+
+          std::vector<FrontEntry> front;
+          front.reserve(block.front.size());
+          for (const FrontEntry& entry : block.front)
+            collide_front(bvh0,bvh1,entry,front,stream);
+          block.front.swap(front);
+          if (restart) block.fullFrontSize = block.front.size();
+        });
+
+      if (callback) return 0;
+      return mergeCollisions(buffers,collisions,maxCollisions);
+    }
+
     template<int N>
     void BVHNColliderUserGeom<N>::collide(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, RTCCollideFunc callback, void* userPtr)
     { 
@@ -325,6 +628,606 @@ namespace embree
         collide_recurse_entry(bvh0->root,bvh0->bounds.bounds(),bvh1->root,bvh1->bounds.bounds());
     }
 
+    template<int N>
+    size_t BVHNColliderUserGeom<N>::collideBuffered(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions)
+    {
+      return BVHNColliderUserGeom<N>(bvh0->scene,bvh1->scene,flags).
+        collide_recurse_entry(bvh0->root,bvh0->bounds.bounds(),bvh1->root,bvh1->bounds.bounds(),collisions,maxCollisions);
+    }
+
+    template<int N>
+    size_t BVHNColliderUserGeom<N>::collideCached(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, CollisionCache* cache, RTCCollideFunc callback, void* userPtr,
+                                                  RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions)
+    {
+      if (callback)
+        return BVHNColliderUserGeom<N>(bvh0->scene,bvh1->scene,callback,userPtr).collide_cached(bvh0,bvh1,cache);
+      else
+        return BVHNColliderUserGeom<N>(bvh0->scene,bvh1->scene,flags).collide_cached(bvh0,bvh1,cache,collisions,maxCollisions);
+    }
+
+    template<int N>
+    void BVHNColliderTriangle<N>::collide(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, RTCCollideFunc callback, void* userPtr)
+    {
+      BVHNColliderTriangle<N>(bvh0,bvh1,callback,userPtr).
+        collide_recurse_entry(bvh0->root,bvh0->bounds.bounds(),bvh1->root,bvh1->bounds.bounds());
+    }
+
+    template<int N>
+    size_t BVHNColliderTriangle<N>::collideBuffered(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions)
+    {
+      return BVHNColliderTriangle<N>(bvh0,bvh1,flags).
+        collide_recurse_entry(bvh0->root,bvh0->bounds.bounds(),bvh1->root,bvh1->bounds.bounds(),collisions,maxCollisions);
+    }
+
+    template<int N>
+    size_t BVHNColliderTriangle<N>::collideCached(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, CollisionCache* cache, RTCCollideFunc callback, void* userPtr,
+                                                  RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions)
+    {
+      if (callback)
+        return BVHNColliderTriangle<N>(bvh0,bvh1,callback,userPtr).collide_cached(bvh0,bvh1,cache);
+      else
+        return BVHNColliderTriangle<N>(bvh0,bvh1,flags).collide_cached(bvh0,bvh1,cache,collisions,maxCollisions);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /// Continuous Collision Detection
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<int N>
+    size_t BVHNColliderUserGeom<N>::collideContinuous(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float time0, float time1, RTCCollideFlags flags,
+                                                      RTCContinuousCollision* collisions, size_t maxCollisions)
+    {
+      return BVHNColliderContinuous<N>::collideContinuous(bvh0,bvh1,time0,time1,flags,collisions,maxCollisions);
+    }
+
+    template<int N>
+    size_t BVHNColliderTriangle<N>::collideContinuous(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float time0, float time1, RTCCollideFlags flags,
+                                                      RTCContinuousCollision* collisions, size_t maxCollisions)
+    {
+      return BVHNColliderContinuous<N>::collideContinuous(bvh0,bvh1,time0,time1,flags,collisions,maxCollisions);
+    }
+
+    /* bounds of a primitive swept over a time range, geometries do not move outside their own time range */
+    template<typename Geometry>
+    __forceinline BBox3fa sweptBounds(const Geometry* geom, unsigned primID, const BBox1f& time_range)
+    {
+      if (geom->numTimeSteps == 1) return geom->bounds(primID);
+      auto boundsAt = [&] (float time) {
+        float ftime; const int itime = geom->timeSegment(time,ftime);
+        return lerp(geom->bounds(primID,itime),geom->bounds(primID,itime+1),clamp(ftime,0.0f,1.0f));
+      };
+      BBox3fa bounds = merge(boundsAt(time_range.lower),boundsAt(time_range.upper));
+      for (unsigned itime=1; itime+1<geom->numTimeSteps; itime++) {
+        const float time = geom->timeStep(itime);
+        if (time > time_range.lower && time < time_range.upper) bounds.extend(geom->bounds(primID,itime));
+      }
+      return bounds;
+    }
+
+    /* position of a vertex of a triangle mesh at some time */
+    __forceinline Vec3fa vertexAt(const TriangleMesh* mesh, unsigned v, float time)
+    {
+      if (mesh->numTimeSteps == 1) return mesh->vertex(v);
+      float ftime; const int itime = mesh->timeSegment(time,ftime);
+      return lerp(mesh->vertex(v,itime),mesh->vertex(v,itime+1),clamp(ftime,0.0f,1.0f));
+    }
+
+    /* finds the roots of the cubic polynomial k0 + k1*s + k2*s^2 + k3*s^3 in [0,1] in increasing order */
+    static size_t cubicRoots(const float k[4], float roots[4])
+    {
+      auto f = [&] (float s) { return ((k[3]*s + k[2])*s + k[1])*s + k[0]; };
+
+      /* the critical points split [0,1] into intervals where the polynomial is monotonic */
+      float split[4]; size_t numSplits = 0;
+      split[numSplits++] = 0.0f;
+      const float a = 3.0f*k[3], b = 2.0f*k[2], c = k[1];
+      if (a != 0.0f) {
+        const float D = b*b-4.0f*a*c;
+        if (D >= 0.0f) {
+          const float q = sqrt(D);
+          const float s0 = (-b-q)/(2.0f*a), s1 = (-b+q)/(2.0f*a);
+          if (min(s0,s1) > 0.0f && min(s0,s1) < 1.0f) split[numSplits++] = min(s0,s1);
+          if (max(s0,s1) > 0.0f && max(s0,s1) < 1.0f && s0 != s1) split[numSplits++] = max(s0,s1);
+        }
+      } else if (b != 0.0f) {
+        const float s0 = -c/b;
+        if (s0 > 0.0f && s0 < 1.0f) split[numSplits++] = s0;
+      }
+      split[numSplits++] = 1.0f;
+
+      /* bisect each interval with a sign change */
+      size_t numRoots = 0;
+      for (size_t i=0; i+1<numSplits; i++)
+      {
+        float lower = split[i], upper = split[i+1];
+        const float flower = f(lower), fupper = f(upper);
+        if (flower == 0.0f) { roots[numRoots++] = lower; continue; }
+        if ((flower < 0.0f) == (fupper < 0.0f) || fupper == 0.0f) continue;
+        for (size_t j=0; j<32; j++) {
+          const float center = 0.5f*(lower+upper);
+          if ((f(center) < 0.0f) == (flower < 0.0f)) lower = center;
+          else upper = center;
+        }
+        roots[numRoots++] = 0.5f*(lower+upper);
+      }
+      if (f(1.0f) == 0.0f) roots[numRoots++] = 1.0f;
+      return numRoots;
+    }
+
+    /* coefficients of dot(cross(a(s),b(s)),c(s)) for vectors moving linearly from a to a+da, b to b+db, and c to c+dc */
+    __forceinline void tripleProductCoefficients(const Vec3fa& a, const Vec3fa& da, const Vec3fa& b, const Vec3fa& db, const Vec3fa& c, const Vec3fa& dc, float k[4])
+    {
+      const Vec3fa n0 = cross(a,b);
+      const Vec3fa n1 = cross(a,db) + cross(da,b);
+      const Vec3fa n2 = cross(da,db);
+      k[0] = dot(n0,c);
+      k[1] = dot(n0,dc) + dot(n1,c);
+      k[2] = dot(n1,dc) + dot(n2,c);
+      k[3] = dot(n2,dc);
+    }
+
+    /* tests if a point in the plane of a triangle lies inside the triangle */
+    __forceinline bool pointInTriangle(const Vec3fa& p, const Vec3fa& a, const Vec3fa& b, const Vec3fa& c)
+    {
+      const float eps = 1E-4f;
+      const Vec3fa n = cross(b-a,c-a);
+      const float nn = dot(n,n);
+      if (nn == 0.0f) return false;
+      const float u = dot(cross(c-b,p-b),n)/nn;
+      const float v = dot(cross(a-c,p-c),n)/nn;
+      return u >= -eps && v >= -eps && u+v <= 1.0f+eps;
+    }
+
+    /* tests if two coplanar edges cross */
+    __forceinline bool edgesCross(const Vec3fa& p0, const Vec3fa& p1, const Vec3fa& q0, const Vec3fa& q1)
+    {
+      const float eps = 1E-4f;
+      const Vec3fa d0 = p1-p0, d1 = q1-q0, w = q0-p0;
+      const Vec3fa n = cross(d0,d1);
+      const float nn = dot(n,n);
+      if (nn <= 1E-12f*dot(d0,d0)*dot(d1,d1)) return false; // parallel edges touch in a vertex face contact
+      const float s = dot(cross(w,d1),n)/nn;
+      const float t = dot(cross(w,d0),n)/nn;
+      return s >= -eps && s <= 1.0f+eps && t >= -eps && t <= 1.0f+eps;
+    }
+
+    /* finds the first time in [0,1] a vertex p touches the triangle q, all vertices move linearly from their position at 0 to their position at 1 */
+    static bool vertexFaceContact(const Vec3fa p[2], const Vec3fa q0[2], const Vec3fa q1[2], const Vec3fa q2[2], float& s_hit)
+    {
+      float k[4], roots[4];
+      tripleProductCoefficients(q1[0]-q0[0],(q1[1]-q0[1])-(q1[0]-q0[0]),
+                                q2[0]-q0[0],(q2[1]-q0[1])-(q2[0]-q0[0]),
+                                p [0]-q0[0],(p [1]-q0[1])-(p [0]-q0[0]),k);
+      const size_t numRoots = cubicRoots(k,roots);
+      for (size_t i=0; i<numRoots && roots[i] < s_hit; i++) {
+        const float s = roots[i];
+        if (pointInTriangle(lerp(p[0],p[1],s),lerp(q0[0],q0[1],s),lerp(q1[0],q1[1],s),lerp(q2[0],q2[1],s))) {
+          s_hit = s;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /* finds the first time in [0,1] the edges p and q touch, all vertices move linearly from their position at 0 to their position at 1 */
+    static bool edgeEdgeContact(const Vec3fa p0[2], const Vec3fa p1[2], const Vec3fa q0[2], const Vec3fa q1[2], float& s_hit)
+    {
+      float k[4], roots[4];
+      tripleProductCoefficients(p1[0]-p0[0],(p1[1]-p0[1])-(p1[0]-p0[0]),
+                                q1[0]-q0[0],(q1[1]-q0[1])-(q1[0]-q0[0]),
+                                q0[0]-p0[0],(q0[1]-p0[1])-(q0[0]-p0[0]),k);
+      const size_t numRoots = cubicRoots(k,roots);
+      for (size_t i=0; i<numRoots && roots[i] < s_hit; i++) {
+        const float s = roots[i];
+        if (edgesCross(lerp(p0[0],p0[1],s),lerp(p1[0],p1[1],s),lerp(q0[0],q0[1],s),lerp(q1[0],q1[1],s))) {
+          s_hit = s;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    template<int N>
+    typename BVHNColliderContinuous<N>::LeafType BVHNColliderContinuous<N>::leafType(const BVH* bvh)
+    {
+      if (bvh->primTy == &Triangle4::type) return TRIANGLE4;
+      if (bvh->primTy == &Triangle4v::type) return TRIANGLE4V;
+      if (bvh->primTy == &Triangle4i::type) return TRIANGLE4I;
+      if (bvh->primTy == &Triangle4vMB::type) return TRIANGLE4VMB;
+      assert(bvh->primTy == &Object::type);
+      return OBJECT;
+    }
+
+    template<int N>
+    template<typename Func>
+    __forceinline void BVHNColliderContinuous<N>::foreachPrimitive(LeafType type, NodeRef node, const Func& func)
+    {
+      switch (type) {
+      case TRIANGLE4   : foreachTriangleInLeaf<Triangle4>   (node,func); break;
+      case TRIANGLE4V  : foreachTriangleInLeaf<Triangle4v>  (node,func); break;
+      case TRIANGLE4I  : foreachTriangleInLeaf<Triangle4i>  (node,func); break;
+      case TRIANGLE4VMB: foreachTriangleInLeaf<Triangle4vMB>(node,func); break;
+      case OBJECT: {
+        size_t num; const Object* prims = (const Object*) node.leaf(num);
+        for (size_t i=0; i<num; i++) func(prims[i].geomID(),prims[i].primID());
+        break;
+      }
+      }
+    }
+
+    template<int N>
+    __forceinline bool BVHNColliderContinuous<N>::getChild(NodeRef ref, size_t i, NodeRef& child, BBox3fa& bounds) const
+    {
+      if (ref.isAABBNode())
+      {
+        const typename BVH::AABBNode* node = ref.getAABBNode();
+        child = node->child(i);
+        bounds = node->bounds(i);
+        return child != BVH::emptyNode;
+      }
+
+      const typename BVH::AABBNodeMB* node = ref.getAABBNodeMB();
+      child = node->child(i);
+      if (child == BVH::emptyNode) return false;
+      BBox1f dt = time_range;
+      if (ref.isAABBNodeMB4D()) {
+        dt = intersect(dt,ref.getAABBNodeMB4D()->timeRange(i));
+        if (dt.lower > dt.upper) { bounds = empty; return true; } // child does not overlap any other node
+      }
+      bounds = merge(node->bounds(i,dt.lower),node->bounds(i,dt.upper));
+      return true;
+    }
+
+    template<int N>
+    __forceinline BBox3fa BVHNColliderContinuous<N>::primBounds(Scene* scene, LeafType type, unsigned geomID, unsigned primID) const
+    {
+      if (type == OBJECT) return sweptBounds(scene->get<AccelSet>(geomID),primID,time_range);
+      else                return sweptBounds(scene->get<TriangleMesh>(geomID),primID,time_range);
+    }
+
+    template<int N>
+    bool BVHNColliderContinuous<N>::timeOfImpact(unsigned geomID0, unsigned primID0, unsigned geomID1, unsigned primID1, float& time) const
+    {
+      const TriangleMesh* mesh0 = scene0->get<TriangleMesh>(geomID0);
+      const TriangleMesh* mesh1 = scene1->get<TriangleMesh>(geomID1);
+      const TriangleMesh::Triangle& tri0 = mesh0->triangle(primID0);
+      const TriangleMesh::Triangle& tri1 = mesh1->triangle(primID1);
+
+      /* the vertices move linearly between the time steps of both meshes */
+      float times[2*RTC_MAX_TIME_STEP_COUNT+2]; size_t numTimes = 0;
+      times[numTimes++] = time_range.lower;
+      for (const TriangleMesh* mesh : { mesh0, mesh1 })
+        for (unsigned itime=1; itime+1<mesh->numTimeSteps; itime++) {
+          const float t = mesh->timeStep(itime);
+          if (t > time_range.lower && t < time_range.upper) times[numTimes++] = t;
+        }
+      times[numTimes++] = time_range.upper;
+      std::sort(times,times+numTimes);
+
+      for (size_t i=0; i+1<numTimes; i++)
+      {
+        if (i > 0 && times[i] == times[i-1]) continue;
+        const float t0 = times[i], t1 = times[i+1];
+        Vec3fa a[3][2], b[3][2];
+        for (size_t j=0; j<3; j++) {
+          a[j][0] = vertexAt(mesh0,tri0.v[j],t0); a[j][1] = vertexAt(mesh0,tri0.v[j],t1);
+          b[j][0] = vertexAt(mesh1,tri1.v[j],t0); b[j][1] = vertexAt(mesh1,tri1.v[j],t1);
+        }
+
+        /* the triangles already intersect at the start of the segment */
+        if (TriangleTriangleIntersector::intersect_triangle_triangle(a[0][0],a[1][0],a[2][0],b[0][0],b[1][0],b[2][0])) {
+          time = t0;
+          return true;
+        }
+
+        /* otherwise the first contact is a vertex touching a face or an edge touching an edge */
+        float s = inf; bool hit = false;
+        for (size_t j=0; j<3; j++) {
+          hit |= vertexFaceContact(a[j],b[0],b[1],b[2],s);
+          hit |= vertexFaceContact(b[j],a[0],a[1],a[2],s);
+          for (size_t k=0; k<3; k++)
+            hit |= edgeEdgeContact(a[j],a[(j+1)%3],b[k],b[(k+1)%3],s);
+        }
+        if (hit) {
+          time = t0 + s*(t1-t0);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    template<int N>
+    void BVHNColliderContinuous<N>::processLeaf(NodeRef node0, NodeRef node1, std::vector<RTCContinuousCollision>& collisions)
+    {
+      const bool narrowPhase = flags & RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE;
+      foreachPrimitive(type0, node0, [&] (unsigned geomID0, unsigned primID0)
+      {
+        const BBox3fa bounds0 = primBounds(scene0,type0,geomID0,primID0);
+        foreachPrimitive(type1, node1, [&] (unsigned geomID1, unsigned primID1)
+        {
+          if (scene0 == scene1 && geomID0 == geomID1 && primID0 == primID1) return;
+          if (!conjoint(bounds0,primBounds(scene1,type1,geomID1,primID1))) return;
+          float time = time_range.lower;
+          if (narrowPhase || (flags & RTC_COLLIDE_FLAG_SELF_COLLISION)) {
+            if (type0 != OBJECT && scene0 == scene1 && geomID0 == geomID1 && share_vertex(scene0,geomID0,primID0,primID1)) return;
+          }
+          if (narrowPhase && !timeOfImpact(geomID0,primID0,geomID1,primID1,time)) return;
+          const RTCContinuousCollision collision = { geomID0, primID0, geomID1, primID1, time };
+          collisions.push_back(collision);
+        });
+      });
+    }
+
+    template<int N>
+    void BVHNColliderContinuous<N>::collide_recurse(NodeRef ref0, const BBox3fa& bounds0, NodeRef ref1, const BBox3fa& bounds1,
+                                                    std::vector<RTCContinuousCollision>& collisions)
+    {
+      if (ref0.isLeaf() && ref1.isLeaf()) {
+        processLeaf(ref0,ref1,collisions);
+        return;
+      }
+
+      /* descend into the larger node */
+      NodeRef child; BBox3fa bounds;
+      if (ref1.isLeaf() || (!ref0.isLeaf() && area(bounds0) > area(bounds1))) {
+        for (size_t i=0; i<N && getChild(ref0,i,child,bounds); i++)
+          if (conjoint(bounds,bounds1)) collide_recurse(child,bounds,ref1,bounds1,collisions);
+      } else {
+        for (size_t i=0; i<N && getChild(ref1,i,child,bounds); i++)
+          if (conjoint(bounds0,bounds)) collide_recurse(ref0,bounds0,child,bounds,collisions);
+      }
+    }
+
+    template<int N>
+    void BVHNColliderContinuous<N>::split(const CollideJob& job, std::vector<CollideJob>& jobs)
+    {
+      if (job.ref0.isLeaf() && job.ref1.isLeaf()) {
+        jobs.push_back(job);
+        return;
+      }
+
+      NodeRef child; BBox3fa bounds;
+      if (job.ref1.isLeaf() || (!job.ref0.isLeaf() && area(job.bounds0) > area(job.bounds1))) {
+        for (size_t i=0; i<N && getChild(job.ref0,i,child,bounds); i++)
+          if (conjoint(bounds,job.bounds1)) jobs.push_back(CollideJob(child,bounds,job.ref1,job.bounds1));
+      } else {
+        for (size_t i=0; i<N && getChild(job.ref1,i,child,bounds); i++)
+          if (conjoint(job.bounds0,bounds)) jobs.push_back(CollideJob(job.ref0,job.bounds0,child,bounds));
+      }
+    }
+
+    template<int N>
+    size_t BVHNColliderContinuous<N>::collideContinuous(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float time0, float time1, RTCCollideFlags flags,
+                                                        RTCContinuousCollision* collisions, size_t maxCollisions)
+    {
+      if (bvh0->root == BVH::emptyNode || bvh1->root == BVH::emptyNode) return 0;
+      BVHNColliderContinuous<N> collider(bvh0,bvh1,time0,time1,flags);
+      const BBox3fa bounds0 = merge(bvh0->bounds.interpolate(time0),bvh0->bounds.interpolate(time1));
+      const BBox3fa bounds1 = merge(bvh1->bounds.interpolate(time0),bvh1->bounds.interpolate(time1));
+      if (!conjoint(bounds0,bounds1)) return 0;
+
+      /* split into jobs until there are enough for parallel processing */
+      const size_t M = 2048;
+      std::vector<CollideJob> jobs, next;
+      jobs.push_back(CollideJob(bvh0->root,bounds0,bvh1->root,bounds1));
+      while (jobs.size() < M/N)
+      {
+        next.clear();
+        for (const CollideJob& job : jobs) collider.split(job,next);
+        if (next.size() == jobs.size()) break;
+        jobs.swap(next);
+      }
+
+      /* each job writes into its own buffer, thus no synchronization is required */
+      std::vector<std::vector<RTCContinuousCollision>> buffers(jobs.size());
+      parallel_for(jobs.size(), [&] ( size_t i ) {
+          const CollideJob& j = jobs[i];
+          collider.collide_recurse(j.ref0,j.bounds0,j.ref1,j.bounds1,buffers[i]);
+        });
+
+      std::vector<RTCContinuousCollision> result;
+      for (const std::vector<RTCContinuousCollision>& buffer : buffers)
+        result.insert(result.end(),buffer.begin(),buffer.end());
+
+      /* in self collision mode each unordered pair is reported once */
+      if (flags & RTC_COLLIDE_FLAG_SELF_COLLISION) {
+        for (RTCContinuousCollision& c : result)
+          if (std::make_pair(c.geomID1,c.primID1) < std::make_pair(c.geomID0,c.primID0)) {
+            std::swap(c.geomID0,c.geomID1);
+            std::swap(c.primID0,c.primID1);
+          }
+      }
+
+      /* node time splits of motion blur BVHs can reach the same primitive pair multiple times */
+      auto key = [] (const RTCContinuousCollision& c) { return std::make_tuple(c.geomID0,c.primID0,c.geomID1,c.primID1); };
+      std::sort(result.begin(),result.end(),[&] (const RTCContinuousCollision& a, const RTCContinuousCollision& b) {
+          return key(a) < key(b) || (key(a) == key(b) && a.time < b.time);
+        });
+      result.erase(std::unique(result.begin(),result.end(),[&] (const RTCContinuousCollision& a, const RTCContinuousCollision& b) {
+            return key(a) == key(b);
+          }),result.end());
+
+      std::copy(result.begin(),result.begin()+min(result.size(),maxCollisions),collisions);
+      return result.size();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /// Closest Pair Query
+    ////////////////////////////////////////////////////////////////////////////////
+
+    /* squared distance between two boxes */
+    __forceinline float distance2(const BBox3fa& a, const BBox3fa& b)
+    {
+      const Vec3fa d = max(max(a.lower-b.upper,b.lower-a.upper),Vec3fa(zero));
+      return dot(d,d);
+    }
+
+    /* closest points of two segments, see Christer Ericson, Real-Time Collision Detection, 5.1.9 */
+    static float closestPointsSegmentSegment(const Vec3fa& p0, const Vec3fa& p1, const Vec3fa& q0, const Vec3fa& q1, Vec3fa& c0, Vec3fa& c1)
+    {
+      const Vec3fa d0 = p1-p0, d1 = q1-q0, r = p0-q0;
+      const float a = dot(d0,d0), e = dot(d1,d1), f = dot(d1,r);
+      float s = 0.0f, t = 0.0f;
+      if (a == 0.0f) {
+        if (e != 0.0f) t = clamp(f/e,0.0f,1.0f);
+      } else {
+        const float c = dot(d0,r);
+        if (e == 0.0f) {
+          s = clamp(-c/a,0.0f,1.0f);
+        } else {
+          const float b = dot(d0,d1);
+          const float denom = a*e-b*b;
+          s = denom != 0.0f ? clamp((b*f-c*e)/denom,0.0f,1.0f) : 0.0f;
+          t = (b*s+f)/e;
+          if (t < 0.0f)      { t = 0.0f; s = clamp(-c/a,0.0f,1.0f); }
+          else if (t > 1.0f) { t = 1.0f; s = clamp((b-c)/a,0.0f,1.0f); }
+        }
+      }
+      c0 = p0 + s*d0;
+      c1 = q0 + t*d1;
+      return dot(c1-c0,c1-c0);
+    }
+
+    /* closest points of the vertices of triangle a to triangle b */
+    __forceinline float closestPointsVerticesTriangle(const Vec3fa a[3], const Vec3fa b[3], Vec3fa& c0, Vec3fa& c1)
+    {
+      const Vec3vf4 p(vfloat4(a[0].x,a[1].x,a[2].x,a[2].x),vfloat4(a[0].y,a[1].y,a[2].y,a[2].y),vfloat4(a[0].z,a[1].z,a[2].z,a[2].z));
+      auto bcast = [] (const Vec3fa& v) { return Vec3vf4(vfloat4(v.x),vfloat4(v.y),vfloat4(v.z)); };
+      vfloat4 u, v;
+      const Vec3vf4 q = closestPointTriangle<4>(p,bcast(b[0]),bcast(b[1]),bcast(b[2]),u,v);
+      const vfloat4 d2 = dot(q-p,q-p);
+      const vboolf4 valid = d2 == d2; // degenerate triangles produce NaNs
+      if (none(valid)) return inf;
+      const size_t i = select_min(valid,d2);
+      c0 = Vec3fa(p.x[i],p.y[i],p.z[i]);
+      c1 = Vec3fa(q.x[i],q.y[i],q.z[i]);
+      return d2[i];
+    }
+
+    /* point where an edge crosses a triangle */
+    __forceinline bool edgeTriangleCrossing(const Vec3fa& p0, const Vec3fa& p1, const Vec3fa b[3], Vec3fa& hit)
+    {
+      const Vec3fa n = cross(b[1]-b[0],b[2]-b[0]);
+      const float d0 = dot(n,p0-b[0]), d1 = dot(n,p1-b[0]);
+      if ((d0 < 0.0f) == (d1 < 0.0f) || d0 == d1) return false;
+      hit = lerp(p0,p1,d0/(d0-d1));
+      return pointInTriangle(hit,b[0],b[1],b[2]);
+    }
+
+    /* squared distance and closest points of two triangles */
+    static float closestPointsTriangleTriangle(const Vec3fa a[3], const Vec3fa b[3], Vec3fa& c0, Vec3fa& c1)
+    {
+      /* the closest points of disjoint triangles are a vertex and a face or two edges */
+      float d2 = closestPointsVerticesTriangle(a,b,c0,c1);
+      Vec3fa p0, p1;
+      float e2 = closestPointsVerticesTriangle(b,a,p1,p0);
+      if (e2 < d2) { d2 = e2; c0 = p0; c1 = p1; }
+      for (size_t i=0; i<3; i++) {
+        for (size_t j=0; j<3; j++) {
+          e2 = closestPointsSegmentSegment(a[i],a[(i+1)%3],b[j],b[(j+1)%3],p0,p1);
+          if (e2 < d2) { d2 = e2; c0 = p0; c1 = p1; }
+        }
+      }
+      if (d2 == 0.0f || !TriangleTriangleIntersector::intersect_triangle_triangle(a[0],a[1],a[2],b[0],b[1],b[2]))
+        return d2;
+
+      /* intersecting triangles touch where an edge of one crosses the other */
+      for (size_t i=0; i<3; i++) {
+        if (edgeTriangleCrossing(a[i],a[(i+1)%3],b,p0) || edgeTriangleCrossing(b[i],b[(i+1)%3],a,p0)) {
+          c0 = c1 = p0;
+          break;
+        }
+      }
+      return 0.0f;
+    }
+
+    template<int N>
+    bool BVHNColliderUserGeom<N>::closestPair(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float maxDistance, RTCClosestPair* result) {
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"closest pair queries require triangle meshes");
+    }
+
+    template<int N>
+    bool BVHNColliderTriangle<N>::closestPair(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float maxDistance, RTCClosestPair* result)
+    {
+      struct NodePair
+      {
+        NodeRef ref0; BBox3fa bounds0;
+        NodeRef ref1; BBox3fa bounds1;
+        float dist2;
+
+        /* orders the heap to return the closest node pair first */
+        __forceinline bool operator< (const NodePair& other) const { return dist2 > other.dist2; }
+      };
+
+      if (bvh0->root == BVH::emptyNode || bvh1->root == BVH::emptyNode) return false;
+      Scene* scene0 = bvh0->scene;
+      Scene* scene1 = bvh1->scene;
+      const LeafType type0 = leafType(bvh0);
+      const LeafType type1 = leafType(bvh1);
+
+      auto triangle = [] (Scene* scene, unsigned geomID, unsigned primID, Vec3fa v[3]) {
+        const TriangleMesh* mesh = scene->get<TriangleMesh>(geomID);
+        const TriangleMesh::Triangle& tri = mesh->triangle(primID);
+        v[0] = mesh->vertex(tri.v[0]); v[1] = mesh->vertex(tri.v[1]); v[2] = mesh->vertex(tri.v[2]);
+      };
+
+      /* node pairs get processed closest first, until the closest pair is closer than all remaining node pairs */
+      float best = maxDistance*maxDistance;
+      bool found = false;
+      std::priority_queue<NodePair> queue;
+      const BBox3fa rootBounds0 = bvh0->bounds.bounds();
+      const BBox3fa rootBounds1 = bvh1->bounds.bounds();
+      queue.push(NodePair { bvh0->root, rootBounds0, bvh1->root, rootBounds1, distance2(rootBounds0,rootBounds1) });
+      while (!queue.empty())
+      {
+        const NodePair pair = queue.top(); queue.pop();
+        if (pair.dist2 >= best) break;
+
+        if (pair.ref0.isLeaf() && pair.ref1.isLeaf())
+        {
+          foreachTriangle(type0, pair.ref0, [&] (unsigned geomID0, unsigned primID0) {
+              Vec3fa a[3]; triangle(scene0,geomID0,primID0,a);
+              const BBox3fa bounds0 = merge(BBox3fa(a[0]),BBox3fa(a[1]),BBox3fa(a[2]));
+              foreachTriangle(type1, pair.ref1, [&] (unsigned geomID1, unsigned primID1)
+              {
+                /* a scene is always in contact with itself through identical and neighboring triangles */
+                if (scene0 == scene1 && geomID0 == geomID1 && (primID0 == primID1 || share_vertex(scene0,geomID0,primID0,primID1))) return;
+                Vec3fa b[3]; triangle(scene1,geomID1,primID1,b);
+                if (distance2(bounds0,merge(BBox3fa(b[0]),BBox3fa(b[1]),BBox3fa(b[2]))) >= best) return;
+                Vec3fa c0, c1;
+                const float d2 = closestPointsTriangleTriangle(a,b,c0,c1);
+                if (d2 >= best) return;
+                best = d2;
+                found = true;
+                result->geomID0 = geomID0; result->primID0 = primID0;
+                result->geomID1 = geomID1; result->primID1 = primID1;
+                result->p0[0] = c0.x; result->p0[1] = c0.y; result->p0[2] = c0.z;
+                result->p1[0] = c1.x; result->p1[1] = c1.y; result->p1[2] = c1.z;
+              });
+            });
+          continue;
+        }
+
+        /* descend into the larger node */
+        if (pair.ref1.isLeaf() || (!pair.ref0.isLeaf() && area(pair.bounds0) > area(pair.bounds1))) {
+          const AABBNode* node = pair.ref0.getAABBNode();
+          for (size_t i=0; i<N && node->child(i) != BVH::emptyNode; i++) {
+            const float d2 = distance2(node->bounds(i),pair.bounds1);
+            if (d2 < best) queue.push(NodePair { node->child(i), node->bounds(i), pair.ref1, pair.bounds1, d2 });
+          }
+        } else {
+          const AABBNode* node = pair.ref1.getAABBNode();
+          for (size_t i=0; i<N && node->child(i) != BVH::emptyNode; i++) {
+            const float d2 = distance2(pair.bounds0,node->bounds(i));
+            if (d2 < best) queue.push(NodePair { pair.ref0, pair.bounds0, node->child(i), node->bounds(i), d2 });
+          }
+        }
+      }
+
+      if (found) result->distance = sqrt(best);
+      return found;
+    }
+
 #if defined (EMBREE_LOWEST_ISA)
     struct collision_regression_test : public RegressionTest
     {
@@ -367,9 +1270,14 @@ namespace embree
     ////////////////////////////////////////////////////////////////////////////////
 
     DEFINE_COLLIDER(BVH4ColliderUserGeom,BVHNColliderUserGeom<4>);
+    DEFINE_COLLIDER(BVH4ColliderTriangle,BVHNColliderTriangle<4>);
+
+    DEFINE_CONTINUOUS_COLLIDER(BVH4ColliderContinuous,BVHNColliderContinuous<4>);
 
 #if defined(__AVX__)
     DEFINE_COLLIDER(BVH8ColliderUserGeom,BVHNColliderUserGeom<8>);
+    DEFINE_COLLIDER(BVH8ColliderTriangle,BVHNColliderTriangle<8>);
+    DEFINE_CONTINUOUS_COLLIDER(BVH8ColliderContinuous,BVHNColliderContinuous<8>);
 #endif
   }
 }
@@ -4,13 +4,54 @@
 #pragma once
 
 #include "bvh.h"
+#include "../geometry/triangle.h"
 #include "../geometry/trianglev.h"
+#include "../geometry/trianglei.h"
+#include "../geometry/trianglev_mb.h"
 #include "../geometry/object.h"
+#include "../common/collision_cache.h"
 
 namespace embree
 {
   namespace isa
   {
+    /*! Collects the collisions found for one collide job and
+     *  either passes them in batches to the user callback or appends
+     *  them to the buffer of the job. */
+    struct CollisionStream
+    {
+      __forceinline CollisionStream (RTCCollideFunc callback, void* userPtr)
+        : callback(callback), userPtr(userPtr), buffer(nullptr), num(0) {}
+
+      __forceinline CollisionStream (std::vector<RTCCollision>* buffer)
+        : callback(nullptr), userPtr(nullptr), buffer(buffer), num(0) {}
+
+      __forceinline void add (unsigned geomID0, unsigned primID0, unsigned geomID1, unsigned primID1)
+      {
+        const RTCCollision collision = { geomID0, primID0, geomID1, primID1 };
+        if (buffer) {
+          buffer->push_back(collision);
+          return;
+        }
+        collisions[num++] = collision;
+        if (num == 16) flush();
+      }
+
+      __forceinline void flush ()
+      {
+        if (num == 0) return;
+        callback(userPtr,collisions,(unsigned)num);
+        num = 0;
+      }
+
+    private:
+      RTCCollideFunc callback;
+      void* userPtr;
+      std::vector<RTCCollision>* buffer;
+      RTCCollision collisions[16];
+      size_t num;
+    };
+
     template<int N>
       class BVHNCollider
     {
@@ -37,21 +78,52 @@ namespace embree
       typedef vector_t<CollideJob, aligned_allocator<CollideJob,16>> jobvector;
 
       void split(const CollideJob& job, jobvector& jobs);
+
+      /*! in self collision mode a job of a node with itself collides the subtree of the node with itself */
+      __forceinline bool isSelfJob(const CollideJob& job) const {
+        return selfCollision && job.ref0 == job.ref1;
+      }
+
+      typedef CollisionCache::FrontEntry FrontEntry;
+
+      static CollisionCache::Stamp stamp(const BVH* bvh);
+      static NodeRef frontNode(const BVH* bvh, size_t parent, unsigned slot, BBox3fa& bounds);
+      static void refine_front(const BVH* bvh0, const BVH* bvh1, std::vector<FrontEntry>& front);
       
     public:
       __forceinline BVHNCollider (Scene* scene0, Scene* scene1, RTCCollideFunc callback, void* userPtr)
-        : scene0(scene0), scene1(scene1), callback(callback), userPtr(userPtr) {}
+        : scene0(scene0), scene1(scene1), callback(callback), userPtr(userPtr), flags(RTC_COLLIDE_FLAG_NONE), selfCollision(false) {}
+
+      __forceinline BVHNCollider (Scene* scene0, Scene* scene1, RTCCollideFlags flags)
+        : scene0(scene0), scene1(scene1), callback(nullptr), userPtr(nullptr), flags(flags),
+          selfCollision((flags & RTC_COLLIDE_FLAG_SELF_COLLISION) && scene0 == scene1) {}
 
     public:
-      virtual void processLeaf(NodeRef leaf0, NodeRef leaf1) = 0;
-      void collide_recurse(NodeRef node0, const BBox3fa& bounds0, NodeRef node1, const BBox3fa& bounds1, size_t depth0, size_t depth1);
-      void collide_recurse_entry(NodeRef node0, const BBox3fa& bounds0, NodeRef node1, const BBox3fa& bounds1);
+      virtual void processLeaf(NodeRef leaf0, NodeRef leaf1, CollisionStream& stream) = 0;
+      void collide_recurse(NodeRef node0, const BBox3fa& bounds0, NodeRef node1, const BBox3fa& bounds1, size_t depth0, size_t depth1, CollisionStream& stream);
+
+      /*! collides the subtree of a node with itself, each pair of children is only visited once */
+      void collide_self_recurse(NodeRef node, size_t depth, CollisionStream& stream);
+
+      /*! collides both BVHs and passes the collisions to the callback, or if no callback is set writes
+       *  up to maxCollisions collisions into the collisions array, returns the total number of collisions found */
+      size_t collide_recurse_entry(NodeRef node0, const BBox3fa& bounds0, NodeRef node1, const BBox3fa& bounds1,
+                                   RTCCollision* collisions = nullptr, size_t maxCollisions = 0);
+
+      /*! traverses the BVHs below one entry of the front and appends the node pairs where the traversal stopped to the new front */
+      void collide_front(const BVH* bvh0, const BVH* bvh1, const FrontEntry& entry, std::vector<FrontEntry>& front, CollisionStream& stream);
+
+      /*! continues the traversal from the front cached from the last call, or from the roots if the
+       *  BVHs got rebuilt, reports collisions like collide_recurse_entry, and stores the new front */
+      size_t collide_cached(const BVH* bvh0, const BVH* bvh1, CollisionCache* cache, RTCCollision* collisions = nullptr, size_t maxCollisions = 0);
     
     protected:
       Scene* scene0;
       Scene* scene1;
       RTCCollideFunc callback;
       void* userPtr;
+      RTCCollideFlags flags;
+      bool selfCollision;   //!< each unordered pair of primitives of the scene is reported once
     };
 
     template<int N>
@@ -64,9 +136,118 @@ namespace embree
       __forceinline BVHNColliderUserGeom (Scene* scene0, Scene* scene1, RTCCollideFunc callback, void* userPtr)
         : BVHNCollider<N>(scene0,scene1,callback,userPtr) {}
 
-      virtual void processLeaf(NodeRef leaf0, NodeRef leaf1);
+      __forceinline BVHNColliderUserGeom (Scene* scene0, Scene* scene1, RTCCollideFlags flags)
+        : BVHNCollider<N>(scene0,scene1,flags) {}
+
+      virtual void processLeaf(NodeRef leaf0, NodeRef leaf1, CollisionStream& stream);
     public:
       static void collide(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, RTCCollideFunc callback, void* userPtr);
+      static size_t collideBuffered(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions);
+      static size_t collideCached(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, CollisionCache* cache, RTCCollideFunc callback, void* userPtr,
+                                  RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions);
+      static size_t collideContinuous(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float time0, float time1, RTCCollideFlags flags,
+                                      RTCContinuousCollision* collisions, size_t maxCollisions);
+      static bool closestPair(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float maxDistance, RTCClosestPair* result);
+    };
+
+    template<int N>
+      class BVHNColliderTriangle : public BVHNCollider<N>
+    {
+      typedef BVHN<N> BVH;
+      typedef typename BVH::NodeRef NodeRef;
+      typedef typename BVH::AABBNode AABBNode;
+
+      /*! triangle leaf layouts supported by the collider */
+      enum LeafType { TRIANGLE4, TRIANGLE4V, TRIANGLE4I };
+
+      static LeafType leafType(const BVH* bvh);
+
+      template<typename Func>
+        static void foreachTriangle(LeafType type, NodeRef leaf, const Func& func);
+
+      __forceinline BVHNColliderTriangle (BVH* bvh0, BVH* bvh1, RTCCollideFunc callback, void* userPtr)
+        : BVHNCollider<N>(bvh0->scene,bvh1->scene,callback,userPtr), type0(leafType(bvh0)), type1(leafType(bvh1)) {}
+
+      __forceinline BVHNColliderTriangle (BVH* bvh0, BVH* bvh1, RTCCollideFlags flags)
+        : BVHNCollider<N>(bvh0->scene,bvh1->scene,flags), type0(leafType(bvh0)), type1(leafType(bvh1)) {}
+
+      virtual void processLeaf(NodeRef leaf0, NodeRef leaf1, CollisionStream& stream);
+    public:
+      static void collide(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, RTCCollideFunc callback, void* userPtr);
+      static size_t collideBuffered(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions);
+      static size_t collideCached(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, CollisionCache* cache, RTCCollideFunc callback, void* userPtr,
+                                  RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions);
+      static size_t collideContinuous(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float time0, float time1, RTCCollideFlags flags,
+                                      RTCContinuousCollision* collisions, size_t maxCollisions);
+
+      /*! finds the closest pair of triangles through a branch and bound traversal of both BVHs ordered by node pair distance */
+      static bool closestPair(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float maxDistance, RTCClosestPair* result);
+
+    private:
+      LeafType type0;
+      LeafType type1;
+    };
+
+    /*! Collides the motion of two scenes over a time range. Works on
+     *  static and motion blur BVHs of triangle meshes and user
+     *  geometries, and tests the bounds of nodes and primitives swept
+     *  over the time range. */
+    template<int N>
+      class BVHNColliderContinuous
+    {
+      typedef BVHN<N> BVH;
+      typedef typename BVH::NodeRef NodeRef;
+
+      /*! leaf layouts supported by the continuous collider */
+      enum LeafType { TRIANGLE4, TRIANGLE4V, TRIANGLE4I, TRIANGLE4VMB, OBJECT };
+
+      struct CollideJob
+      {
+        CollideJob () {}
+
+        CollideJob (NodeRef ref0, const BBox3fa& bounds0, NodeRef ref1, const BBox3fa& bounds1)
+        : ref0(ref0), bounds0(bounds0), ref1(ref1), bounds1(bounds1) {}
+
+        NodeRef ref0;
+        BBox3fa bounds0;
+        NodeRef ref1;
+        BBox3fa bounds1;
+      };
+
+      static LeafType leafType(const BVH* bvh);
+
+      template<typename Func>
+        static void foreachPrimitive(LeafType type, NodeRef leaf, const Func& func);
+
+      __forceinline BVHNColliderContinuous (BVH* bvh0, BVH* bvh1, float time0, float time1, RTCCollideFlags flags)
+        : scene0(bvh0->scene), scene1(bvh1->scene), time_range(time0,time1), flags(flags),
+          type0(leafType(bvh0)), type1(leafType(bvh1)) {}
+
+      /*! gets the i'th child of a node and its bounds swept over the time range, the bounds are empty for
+       *  children that do not exist during the time range, returns false for empty child slots */
+      bool getChild(NodeRef ref, size_t i, NodeRef& child, BBox3fa& bounds) const;
+
+      /*! bounds of a primitive swept over the time range */
+      BBox3fa primBounds(Scene* scene, LeafType type, unsigned geomID, unsigned primID) const;
+
+      /*! finds the first time the two triangles touch during the time range */
+      bool timeOfImpact(unsigned geomID0, unsigned primID0, unsigned geomID1, unsigned primID1, float& time) const;
+
+      void processLeaf(NodeRef leaf0, NodeRef leaf1, std::vector<RTCContinuousCollision>& collisions);
+      void split(const CollideJob& job, std::vector<CollideJob>& jobs);
+      void collide_recurse(NodeRef ref0, const BBox3fa& bounds0, NodeRef ref1, const BBox3fa& bounds1, std::vector<RTCContinuousCollision>& collisions);
+
+    public:
+      static size_t collideContinuous(BVH* __restrict__ bvh0, BVH* __restrict__ bvh1, float time0, float time1, RTCCollideFlags flags,
+                                      RTCContinuousCollision* collisions, size_t maxCollisions);
+
+    private:
+      Scene* scene0;
+      Scene* scene1;
+      BBox1f time_range;
+      RTCCollideFlags flags;
+      LeafType type0;
+      LeafType type1;
     };
   }
 }
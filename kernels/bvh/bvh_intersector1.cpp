@@ -196,7 +196,7 @@ namespace embree
     }
 
     template<int N, int types, bool robust, typename PrimitiveIntersector1>
-    struct PointQueryDispatch
+    struct PointQueryTraversal
     {
       typedef typename PrimitiveIntersector1::Precalculations Precalculations;
       typedef typename PrimitiveIntersector1::Primitive Primitive;
@@ -227,6 +227,10 @@ namespace embree
 
         /* load the point query into SIMD registers */
         TravPointQuery<N> tquery(query->p, context->query_radius);
+        if (unlikely(context->boxQuery && context->userContext->instStackSize > 0)) {
+          const AffineSpace3fa inst2world = AffineSpace3fa_load_unaligned((AffineSpace3fa*)context->userContext->inst2world[context->userContext->instStackSize-1]);
+          tquery.setInstanceBox(inst2world.l, 0.5f*context->boxQuery->bounds.size());
+        }
 
         /* initialize the node traverser */
         BVHNNodeTraverser1Hit<N,types> nodeTraverser;
@@ -295,12 +299,21 @@ namespace embree
       }
     };
 
-    /* disable point queries for not yet supported geometry types */
+    template<int N, int types, bool robust, typename PrimitiveIntersector1>
+    struct PointQueryDispatch : public PointQueryTraversal<N, types, robust, PrimitiveIntersector1> {};
+
+    /* curves do not support point queries, point geometries are only traversed by nearest points and box queries */
     template<int N, int types, bool robust>
-    struct PointQueryDispatch<N, types, robust, VirtualCurveIntersector1> {
-      static __forceinline bool pointQuery(const Accel::Intersectors* This, PointQuery* query, PointQueryContext* context) { return false; }
+    struct PointQueryDispatch<N, types, robust, VirtualCurveIntersector1>
+    {
+      static __forceinline bool pointQuery(const Accel::Intersectors* This, PointQuery* query, PointQueryContext* context)
+      {
+        if (!context->nearestPoints && !context->boxQuery) return false;
+        return PointQueryTraversal<N, types, robust, VirtualCurveIntersector1>::pointQuery(This, query, context);
+      }
     };
-    
+
+    /* disable point queries for not yet supported geometry types */
     template<int N, int types, bool robust>
     struct PointQueryDispatch<N, types, robust, SubdivPatch1Intersector1> {
       static __forceinline bool pointQuery(const Accel::Intersectors* This, PointQuery* query, PointQueryContext* context) { return false; }
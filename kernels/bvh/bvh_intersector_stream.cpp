@@ -40,8 +40,8 @@ namespace embree
       if (bvh->root == BVH::emptyNode)
         return;
       
-      // Only the coherent code path is implemented
-      assert(context->isCoherent());
+      // Only the coherent code path is implemented, rays with a common direction are always coherent
+      assert(context->isCoherent() || context->sharedDirection);
       intersectCoherent(This, (RayHitK<VSIZEL>**)inputPackets, numOctantRays, context);
     }
 
@@ -52,7 +52,7 @@ namespace embree
                                                                                                             size_t numOctantRays,
                                                                                                             IntersectContext* context)
     {
-      assert(context->isCoherent());
+      assert(context->isCoherent() || context->sharedDirection);
 
       BVH* __restrict__ bvh = (BVH*) This->ptr;
       __aligned(64) StackItemMaskCoherent stack[stackSizeSingle];  // stack of nodes
@@ -62,7 +62,9 @@ namespace embree
       __aligned(64) Frustum<robust> frustum;
 
       bool commonOctant = true;
-      const size_t m_active = initPacketsAndFrustum((RayK<K>**)inputPackets, numOctantRays, packets, frustum, commonOctant);
+      const size_t m_active = context->sharedDirection
+        ? initPacketsAndFrustum((RayK<K>**)inputPackets, numOctantRays, *context->sharedDirection, packets, frustum)
+        : initPacketsAndFrustum((RayK<K>**)inputPackets, numOctantRays, packets, frustum, commonOctant);
       if (unlikely(m_active == 0)) return;
 
       /* case of non-common origin */
@@ -164,7 +166,7 @@ namespace embree
       if (bvh->root == BVH::emptyNode)
         return;
       
-      if (unlikely(context->isCoherent()))
+      if (unlikely(context->isCoherent() || context->sharedDirection))
         occludedCoherent(This, (RayK<VSIZEL>**)inputPackets, numOctantRays, context);
       else
         occludedIncoherent(This, (RayK<VSIZEX>**)inputPackets, numOctantRays, context);
@@ -177,7 +179,7 @@ namespace embree
                                                                                                         size_t numOctantRays,
                                                                                                         IntersectContext* context)
     {
-      assert(context->isCoherent());
+      assert(context->isCoherent() || context->sharedDirection);
 
       BVH* __restrict__ bvh = (BVH*)This->ptr;
       __aligned(64) StackItemMaskCoherent stack[stackSizeSingle];  // stack of nodes
@@ -188,7 +190,9 @@ namespace embree
       __aligned(64) Frustum<robust> frustum;
 
       bool commonOctant = true;
-      size_t m_active = initPacketsAndFrustum(inputPackets, numOctantRays, packets, frustum, commonOctant);
+      size_t m_active = context->sharedDirection
+        ? initPacketsAndFrustum(inputPackets, numOctantRays, *context->sharedDirection, packets, frustum)
+        : initPacketsAndFrustum(inputPackets, numOctantRays, packets, frustum, commonOctant);
 
       /* valid rays */
       if (unlikely(m_active == 0)) return;
@@ -101,6 +101,62 @@ namespace embree
         return m_active;
       }
 
+      /* rays with a common direction share the reciprocal direction, the octant, and the near/far child order */
+      template<int K>
+      __forceinline static size_t initPacketsAndFrustum(RayK<K>** inputPackets, size_t numOctantRays, const SharedRayDirection& shared,
+                                                        TravRayKStream<K, robust>* packets, Frustum<robust>& frustum)
+      {
+        const size_t numPackets = (numOctantRays+K-1)/K;
+        const Vec3fa rdir = robust ? shared.rdir_robust : shared.rdir;
+
+        Vec3vf<K> tmp_min_org(pos_inf);
+        Vec3vf<K> tmp_max_org(neg_inf);
+        vfloat<K> tmp_min_dist(pos_inf);
+        vfloat<K> tmp_max_dist(neg_inf);
+
+        size_t m_active = 0;
+        for (size_t i = 0; i < numPackets; i++)
+        {
+          const vfloat<K> tnear = inputPackets[i]->tnear();
+          const vfloat<K> tfar  = inputPackets[i]->tfar;
+          vbool<K> m_valid = (tnear <= tfar) & (tnear >= 0.0f);
+
+#if defined(EMBREE_IGNORE_INVALID_RAYS)
+          m_valid &= inputPackets[i]->valid();
+#endif
+
+          m_active |= (size_t)movemask(m_valid) << (i*K);
+
+          vfloat<K> packet_min_dist = max(tnear, 0.0f);
+          vfloat<K> packet_max_dist = select(m_valid, tfar, neg_inf);
+          tmp_min_dist = min(tmp_min_dist, packet_min_dist);
+          tmp_max_dist = max(tmp_max_dist, packet_max_dist);
+
+          const Vec3vf<K>& org = inputPackets[i]->org;
+          new (&packets[i]) TravRayKStream<K, robust>(org, rdir, packet_min_dist, packet_max_dist);
+
+          tmp_min_org = min(tmp_min_org, select(m_valid, org, Vec3vf<K>(pos_inf)));
+          tmp_max_org = max(tmp_max_org, select(m_valid, org, Vec3vf<K>(neg_inf)));
+        }
+
+        m_active &= (numOctantRays == (8 * sizeof(size_t))) ? (size_t)-1 : (((size_t)1 << numOctantRays)-1);
+
+        const Vec3fa reduced_min_origin(reduce_min(tmp_min_org.x),
+                                        reduce_min(tmp_min_org.y),
+                                        reduce_min(tmp_min_org.z));
+
+        const Vec3fa reduced_max_origin(reduce_max(tmp_max_org.x),
+                                        reduce_max(tmp_max_org.y),
+                                        reduce_max(tmp_max_org.z));
+
+        frustum.init(reduced_min_origin, reduced_max_origin,
+                     rdir, rdir,
+                     reduce_min(tmp_min_dist), reduce_max(tmp_max_dist),
+                     N);
+
+        return m_active;
+      }
+
       template<int K>
       __forceinline static size_t intersectAABBNodePacket(size_t m_active,
                                                              const TravRayKStream<K,robust>* packets,
@@ -3,6 +3,8 @@
 
 #include "bvh_intersector_stream_filters.h"
 #include "bvh_intersector_stream.h"
+#include "../builders/bvh_builder_morton.h"
+
 
 namespace embree
 {
@@ -592,6 +594,207 @@ namespace embree
     }
 
 
+    /* sorts the ray origins spatially in a frame aligned with the common
+     * ray direction, such that neighboring rays in the sorted order pass
+     * through the same part of the scene */
+    static void sortSharedDirection(const RTCRaySharedDirection* rayN, size_t N, std::vector<BVHBuilderMorton::BuildPrim>& keys)
+    {
+      const LinearSpace3fa space = frame(normalize(Vec3fa(rayN->dir_x, rayN->dir_y, rayN->dir_z))).transposed();
+
+      /* the lateral coordinates are more significant than the coordinate along the ray direction */
+      BVHBuilderMorton::sortPoints(N, [&] (size_t i) -> Vec3fa {
+          const Vec3fa org = xfmVector(space, Vec3fa(rayN->org_x[i], rayN->org_y[i], rayN->org_z[i]));
+          return Vec3fa(org.z, org.y, org.x);
+        }, keys);
+    }
+
+    template<int K, bool intersect>
+    __noinline void RayStreamFilter::filterSharedDirection(Scene* scene, const RTCRaySharedDirection* rayN, const RTCHitNp* hitN, size_t N, IntersectContext* context)
+    {
+      /* direction dependent data is set up once for the whole stream, the
+       * traversal takes the reciprocal direction and the near/far child
+       * order from the context instead of computing it per ray */
+      const Vec3fa shared_dir(rayN->dir_x, rayN->dir_y, rayN->dir_z);
+      const SharedRayDirection sharedDirection(shared_dir);
+      const Vec3vf<K> dir(shared_dir);
+      const vfloat<K> time(rayN->time);
+      const vint<K> mask(rayN->mask);
+
+      /* sort larger streams spatially, smaller streams are traced in input order */
+      std::vector<BVHBuilderMorton::BuildPrim> keys;
+      if (N > MAX_INTERNAL_STREAM_SIZE)
+        sortSharedDirection(rayN, N, keys);
+
+      __aligned(64) unsigned int rayIDs[MAX_INTERNAL_STREAM_SIZE];
+      __aligned(64) RayTypeK<K, intersect> rays[MAX_INTERNAL_STREAM_SIZE / K];
+      __aligned(64) RayTypeK<K, intersect>* rayPtrs[MAX_INTERNAL_STREAM_SIZE / K];
+
+      for (size_t i = 0; i < N; i += MAX_INTERNAL_STREAM_SIZE)
+      {
+        const size_t size = min(N - i, MAX_INTERNAL_STREAM_SIZE);
+        for (size_t j = 0; j < MAX_INTERNAL_STREAM_SIZE; j++)
+          rayIDs[j] = (j < size) ? (keys.empty() ? unsigned(i+j) : keys[i+j].index) : 0;
+
+        /* gather origins and ray segments, the direction is shared */
+        for (size_t j = 0; j < size; j += K)
+        {
+          const vint<K> vj = vint<K>(int(j)) + vint<K>(step);
+          const vbool<K> valid = vj < vint<K>(int(size));
+          const vint<K> offset = *(vint<K>*)&rayIDs[j] * int(sizeof(float));
+          const vfloat<K> tnear = vfloat<K>::template gather<1>(valid, rayN->tnear, offset);
+          const vfloat<K> tfar  = vfloat<K>::template gather<1>(valid, rayN->tfar,  offset);
+
+          RayTypeK<K, intersect>& ray = rays[j/K];
+          ray.org.x   = vfloat<K>::template gather<1>(valid, rayN->org_x, offset);
+          ray.org.y   = vfloat<K>::template gather<1>(valid, rayN->org_y, offset);
+          ray.org.z   = vfloat<K>::template gather<1>(valid, rayN->org_z, offset);
+          ray.dir     = dir;
+          ray.tnear() = select(valid, tnear, zero);
+          ray.tfar    = select(valid, tfar, neg_inf);
+          ray.time()  = time;
+          ray.mask    = mask;
+          ray.id      = *(vint<K>*)&rayIDs[j];
+          ray.flags   = zero;
+          if (intersect)
+          {
+            RayHitK<K>& rayhit = (RayHitK<K>&) ray;
+            rayhit.geomID = RTC_INVALID_GEOMETRY_ID;
+            for (unsigned l = 0; l < RTC_MAX_INSTANCE_LEVEL_COUNT; ++l)
+              rayhit.instID[l] = RTC_INVALID_GEOMETRY_ID;
+          }
+          rayPtrs[j/K] = &ray;
+        }
+
+        /* rays with a common direction are always traced as coherent stream */
+        context->sharedDirection = &sharedDirection;
+        scene->intersectors.intersectN(rayPtrs, size, context);
+        context->sharedDirection = nullptr;
+
+        /* scatter the results */
+        for (size_t j = 0; j < size; j += K)
+        {
+          const vint<K> vj = vint<K>(int(j)) + vint<K>(step);
+          const vint<K> offset = *(vint<K>*)&rayIDs[j] * int(sizeof(float));
+          vbool<K> valid = vj < vint<K>(int(size));
+
+          if (intersect)
+          {
+            const RayHitK<K>& ray = (const RayHitK<K>&) rays[j/K];
+            valid &= ray.geomID != vuint<K>(RTC_INVALID_GEOMETRY_ID);
+            if (none(valid)) continue;
+
+            size_t valid_bits = movemask(valid);
+            while (valid_bits != 0)
+            {
+              const size_t k = bscf(valid_bits);
+              const size_t id = rayIDs[j+k];
+              rayN->tfar[id] = ray.tfar[k];
+              if (likely(hitN->Ng_x)) hitN->Ng_x[id] = ray.Ng.x[k];
+              if (likely(hitN->Ng_y)) hitN->Ng_y[id] = ray.Ng.y[k];
+              if (likely(hitN->Ng_z)) hitN->Ng_z[id] = ray.Ng.z[k];
+              hitN->u[id] = ray.u[k];
+              hitN->v[id] = ray.v[k];
+              hitN->primID[id] = ray.primID[k];
+              hitN->geomID[id] = ray.geomID[k];
+              if (likely(hitN->instID[0])) {
+                hitN->instID[0][id] = ray.instID[0][k];
+#if (RTC_MAX_INSTANCE_LEVEL_COUNT > 1)
+                for (unsigned l = 1; l < RTC_MAX_INSTANCE_LEVEL_COUNT && ray.instID[l-1][k] != RTC_INVALID_GEOMETRY_ID; ++l)
+                  hitN->instID[l][id] = ray.instID[l][k];
+#endif
+              }
+            }
+          }
+          else
+          {
+            vfloat<K>::template scatter<1>(valid, rayN->tfar, offset, rays[j/K].tfar);
+          }
+        }
+      }
+    }
+
+    template<int K>
+    __noinline void RayStreamFilter::filterTile(Scene* scene, const RTCRayTile* tile, RTCRayHit* _rayN, size_t stride, IntersectContext* context)
+    {
+      /* the tile is traced in sub-tiles of MAX_INTERNAL_STREAM_SIZE rays, with
+       * sub-tile rows of at least one full ray packet of K rays */
+      static const unsigned int SUBTILE_SHIFT_X = (K > 8) ? 4 : 3;
+      static const unsigned int SUBTILE_SIZE_X = 1 << SUBTILE_SHIFT_X;
+      static const unsigned int SUBTILE_SIZE_Y = MAX_INTERNAL_STREAM_SIZE / SUBTILE_SIZE_X;
+
+      const Vec3vf<K> org(tile->org_x, tile->org_y, tile->org_z);
+      const Vec3vf<K> dir(tile->dir_x, tile->dir_y, tile->dir_z);
+      const Vec3vf<K> du (tile->du_x,  tile->du_y,  tile->du_z);
+      const Vec3vf<K> dv (tile->dv_x,  tile->dv_y,  tile->dv_z);
+      const vfloat<K> tnear(tile->tnear);
+      const vfloat<K> tfar (tile->tfar);
+      const vfloat<K> time (tile->time);
+      const vint<K>   mask (tile->mask);
+
+      __aligned(64) RayHitK<K> rays[MAX_INTERNAL_STREAM_SIZE / K];
+      __aligned(64) RayHitK<K>* rayPtrs[MAX_INTERNAL_STREAM_SIZE / K];
+
+      for (unsigned int y = 0; y < tile->height; y += SUBTILE_SIZE_Y)
+      {
+        const unsigned int sizeY = min(tile->height - y, SUBTILE_SIZE_Y);
+
+        for (unsigned int x = 0; x < tile->width; x += SUBTILE_SIZE_X)
+        {
+          const unsigned int sizeX = min(tile->width - x, SUBTILE_SIZE_X);
+          const size_t size = sizeY * SUBTILE_SIZE_X;
+
+          /* generate SOA rays directly from the tile description */
+          for (size_t j = 0; j < size; j += K)
+          {
+            const vint<K> vj = vint<K>(int(j)) + vint<K>(step);
+            const vint<K> vx = vj & int(SUBTILE_SIZE_X-1);
+            const vint<K> vy = vj >> int(SUBTILE_SHIFT_X);
+            const vbool<K> valid = (vx < vint<K>(int(sizeX))) & (vy < vint<K>(int(sizeY)));
+            const vfloat<K> px = vfloat<K>(vx + int(tile->x0 + x));
+            const vfloat<K> py = vfloat<K>(vy + int(tile->y0 + y));
+            const Vec3vf<K> D = madd(py, dv, madd(px, du, dir));
+
+            RayHitK<K>& ray = rays[j/K];
+            ray.org = org;
+            ray.dir = D;
+            ray.tnear() = select(valid, tnear, zero);
+            ray.tfar = select(valid, tfar, neg_inf);
+            ray.time() = time;
+            ray.mask = mask;
+            ray.id = zero;
+            ray.flags = zero;
+            ray.geomID = RTC_INVALID_GEOMETRY_ID;
+            for (unsigned l = 0; l < RTC_MAX_INSTANCE_LEVEL_COUNT; ++l)
+              ray.instID[l] = RTC_INVALID_GEOMETRY_ID;
+            rayPtrs[j/K] = &ray;
+          }
+
+          /* trace the sub-tile as coherent stream or as packets */
+          if (likely(context->isCoherent()))
+            scene->intersectors.intersectN(rayPtrs, size, context);
+          else
+          {
+            for (size_t j = 0; j < size; j += K)
+            {
+              const vbool<K> valid = rays[j/K].tnear() <= rays[j/K].tfar;
+              scene->intersectors.intersect(valid, rays[j/K], context);
+            }
+          }
+
+          /* write the rays and hits of valid pixels */
+          for (unsigned int py = 0; py < sizeY; py++)
+          {
+            for (unsigned int px = 0; px < sizeX; px++)
+            {
+              const size_t j = py * SUBTILE_SIZE_X + px;
+              const size_t offset = ((y + py) * size_t(tile->width) + (x + px)) * stride;
+              rays[j/K].get(j%K, *(RayHit*)((char*)_rayN + offset));
+            }
+          }
+        }
+      }
+    }
+
     void RayStreamFilter::intersectAOS(Scene* scene, RTCRayHit* _rayN, size_t N, size_t stride, IntersectContext* context) {
       if (unlikely(context->isCoherent()))
         filterAOS<VSIZEL, true>(scene, _rayN, N, stride, context);
@@ -648,10 +851,25 @@ namespace embree
         filterSOP<VSIZEX, false>(scene, _rayN, N, context);
     }
 
+    void RayStreamFilter::intersectSharedDirection(Scene* scene, const RTCRaySharedDirection* _rayN, const RTCHitNp* _hitN, size_t N, IntersectContext* context) {
+      filterSharedDirection<VSIZEL, true>(scene, _rayN, _hitN, N, context);
+    }
+
+    void RayStreamFilter::occludedSharedDirection(Scene* scene, const RTCRaySharedDirection* _rayN, size_t N, IntersectContext* context) {
+      filterSharedDirection<VSIZEL, false>(scene, _rayN, nullptr, N, context);
+    }
+
+    void RayStreamFilter::intersectTile(Scene* scene, const RTCRayTile* tile, RTCRayHit* _rayN, size_t stride, IntersectContext* context) {
+      if (unlikely(context->isCoherent()))
+        filterTile<VSIZEL>(scene, tile, _rayN, stride, context);
+      else
+        filterTile<VSIZEX>(scene, tile, _rayN, stride, context);
+    }
+
 
     RayStreamFilterFuncs rayStreamFilterFuncs() {
-      return RayStreamFilterFuncs(RayStreamFilter::intersectAOS, RayStreamFilter::intersectAOP, RayStreamFilter::intersectSOA, RayStreamFilter::intersectSOP,
-                                  RayStreamFilter::occludedAOS,  RayStreamFilter::occludedAOP,  RayStreamFilter::occludedSOA,  RayStreamFilter::occludedSOP);
+      return RayStreamFilterFuncs(RayStreamFilter::intersectAOS, RayStreamFilter::intersectAOP, RayStreamFilter::intersectSOA, RayStreamFilter::intersectSOP, RayStreamFilter::intersectTile, RayStreamFilter::intersectSharedDirection,
+                                  RayStreamFilter::occludedAOS,  RayStreamFilter::occludedAOP,  RayStreamFilter::occludedSOA,  RayStreamFilter::occludedSOP,  RayStreamFilter::occludedSharedDirection);
     }
   };
 };
@@ -18,11 +18,14 @@ namespace embree
       static void intersectAOP(Scene* scene, RTCRayHit** rays, size_t N, IntersectContext* context);
       static void intersectSOA(Scene* scene, char* rays, size_t N, size_t numPackets, size_t stride, IntersectContext* context);
       static void intersectSOP(Scene* scene, const RTCRayHitNp* rays, size_t N, IntersectContext* context);
+      static void intersectTile(Scene* scene, const RTCRayTile* tile, RTCRayHit* rays, size_t stride, IntersectContext* context);
+      static void intersectSharedDirection(Scene* scene, const RTCRaySharedDirection* rays, const RTCHitNp* hits, size_t N, IntersectContext* context);
 
       static void occludedAOS(Scene* scene, RTCRay* rays, size_t N, size_t stride, IntersectContext* context);
       static void occludedAOP(Scene* scene, RTCRay** rays, size_t N, IntersectContext* context);
       static void occludedSOA(Scene* scene, char* rays, size_t N, size_t numPackets, size_t stride, IntersectContext* context);
       static void occludedSOP(Scene* scene, const RTCRayNp* rays, size_t N, IntersectContext* context);
+      static void occludedSharedDirection(Scene* scene, const RTCRaySharedDirection* rays, size_t N, IntersectContext* context);
 
     private:
       template<int K, bool intersect>
@@ -36,6 +39,12 @@ namespace embree
 
       template<int K, bool intersect>
       static void filterSOP(Scene* scene, const void* rays, size_t N, IntersectContext* context);
+
+      template<int K, bool intersect>
+      static void filterSharedDirection(Scene* scene, const RTCRaySharedDirection* rays, const RTCHitNp* hits, size_t N, IntersectContext* context);
+
+      template<int K>
+      static void filterTile(Scene* scene, const RTCRayTile* tile, RTCRayHit* rays, size_t stride, IntersectContext* context);
     };
   }
 };
@@ -184,6 +184,20 @@ namespace embree
       {
         org = Vec3vf<N>(query_org.x, query_org.y, query_org.z);
         rad = Vec3vf<N>(query_rad.x, query_rad.y, query_rad.z);
+        instanceBox = false;
+      }
+
+      /*! Box queries report primitives whose world space bounds overlap
+       *  the box. Inside of rotated instances these bounds are larger than
+       *  the instance space bounds, thus the nodes get tested with their
+       *  world space bounds against the half extent of the world space box. */
+      __forceinline void setInstanceBox(const LinearSpace3fa& inst2world, const Vec3fa& box_rad)
+      {
+        xfm = LinearSpace3<Vec3vf<N>>(Vec3vf<N>(inst2world.vx.x, inst2world.vx.y, inst2world.vx.z),
+                                      Vec3vf<N>(inst2world.vy.x, inst2world.vy.y, inst2world.vy.z),
+                                      Vec3vf<N>(inst2world.vz.x, inst2world.vz.y, inst2world.vz.z));
+        wrad = Vec3vf<N>(box_rad.x, box_rad.y, box_rad.z);
+        instanceBox = true;
       }
 
       __forceinline vfloat<N> const& tfar() const {
@@ -191,6 +205,9 @@ namespace embree
       }
 
       Vec3vf<N> org, rad;
+      LinearSpace3<Vec3vf<N>> xfm;  //!< linear part of the instance to world transformation of box queries
+      Vec3vf<N> wrad;               //!< half extent of the world space box of box queries
+      bool instanceBox;             //!< if set, nodes are tested with their world space bounds
     };
     
     //////////////////////////////////////////////////////////////////////////////////////
@@ -306,11 +323,39 @@ namespace embree
       return mask;
     }
 
+    template<int N>
+    __forceinline size_t pointQueryInstanceBoxMask(
+      const TravPointQuery<N>& query, vfloat<N>& dist, vfloat<N> const& minX, vfloat<N> const& maxX, 
+      vfloat<N> const& minY, vfloat<N> const& maxY, vfloat<N> const& minZ, vfloat<N> const& maxZ)
+    {
+      /* the query origin is the box center in instance space, thus the world space
+       * offset of the node center to the box center is the transformed offset */
+      const vfloat<N> cX = 0.5f*(minX+maxX) - query.org.x, hX = 0.5f*(maxX-minX);
+      const vfloat<N> cY = 0.5f*(minY+maxY) - query.org.y, hY = 0.5f*(maxY-minY);
+      const vfloat<N> cZ = 0.5f*(minZ+maxZ) - query.org.z, hZ = 0.5f*(maxZ-minZ);
+      const LinearSpace3<Vec3vf<N>>& m = query.xfm;
+      const vfloat<N> dX = abs(madd(m.vx.x,cX,madd(m.vy.x,cY,m.vz.x*cZ)));
+      const vfloat<N> dY = abs(madd(m.vx.y,cX,madd(m.vy.y,cY,m.vz.y*cZ)));
+      const vfloat<N> dZ = abs(madd(m.vx.z,cX,madd(m.vy.z,cY,m.vz.z*cZ)));
+      const vfloat<N> rX = madd(abs(m.vx.x),hX,madd(abs(m.vy.x),hY,madd(abs(m.vz.x),hZ,query.wrad.x)));
+      const vfloat<N> rY = madd(abs(m.vx.y),hX,madd(abs(m.vy.y),hY,madd(abs(m.vz.y),hZ,query.wrad.y)));
+      const vfloat<N> rZ = madd(abs(m.vx.z),hX,madd(abs(m.vy.z),hY,madd(abs(m.vz.z),hZ,query.wrad.z)));
+      const vbool<N> valid = minX <= maxX;
+      const vbool<N> vmask = (dX <= rX) & (dY <= rY) & (dZ <= rZ);
+
+      /* the instance space distance does not bound the world space overlap */
+      dist = vfloat<N>(0.0f);
+      return movemask(vmask) & movemask(valid);
+    }
+
     template<int N>
     __forceinline size_t pointQueryAABBDistAndMask(
       const TravPointQuery<N>& query, vfloat<N>& dist, vfloat<N> const& minX, vfloat<N> const& maxX, 
       vfloat<N> const& minY, vfloat<N> const& maxY, vfloat<N> const& minZ, vfloat<N> const& maxZ)
     {
+      if (unlikely(query.instanceBox))
+        return pointQueryInstanceBoxMask(query, dist, minX, maxX, minY, maxY, minZ, maxZ);
+
       const vfloat<N> vX = min(max(query.org.x, minX), maxX) - query.org.x;
       const vfloat<N> vY = min(max(query.org.y, minY), maxY) - query.org.y;
       const vfloat<N> vZ = min(max(query.org.z, minZ), maxZ) - query.org.z;
@@ -29,6 +29,19 @@ namespace embree
         tfar = ray_tfar;
       }
 
+      /* the reciprocal direction is shared by all rays */
+      __forceinline TravRayKStream(const Vec3vf<K>& ray_org, const Vec3fa& ray_rdir, const vfloat<K>& ray_tnear, const vfloat<K>& ray_tfar)
+      {
+        rdir = Vec3vf<K>(ray_rdir);
+#if defined(__aarch64__)
+        neg_org_rdir = -(ray_org * rdir);
+#else
+        org_rdir = ray_org * rdir;
+#endif
+        tnear = ray_tnear;
+        tfar = ray_tfar;
+      }
+
       __forceinline void init(const Vec3vf<K>& ray_org, const Vec3vf<K>& ray_dir)
       {
         rdir = rcp_safe(ray_dir);
@@ -65,6 +78,15 @@ namespace embree
         tfar = ray_tfar;
       }
 
+      /* the reciprocal direction is shared by all rays */
+      __forceinline TravRayKStream(const Vec3vf<K>& ray_org, const Vec3fa& ray_rdir, const vfloat<K>& ray_tnear, const vfloat<K>& ray_tfar)
+      {
+        rdir = Vec3vf<K>(ray_rdir);
+        org = ray_org;
+        tnear = ray_tnear;
+        tfar = ray_tfar;
+      }
+
       __forceinline void init(const Vec3vf<K>& ray_org, const Vec3vf<K>& ray_dir)
       {
         rdir = vfloat<K>(1.0f)/(zero_fix(ray_dir));
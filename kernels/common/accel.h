@@ -11,6 +11,7 @@
 namespace embree
 {
   class Scene;
+  class CollisionCache;
 
   /*! Base class for the acceleration structure data. */
   class AccelData : public RefCount 
@@ -65,6 +66,20 @@ namespace embree
     /*! Type of collide function */
     typedef void (*CollideFunc)(void* bvh0, void* bvh1, RTCCollideFunc callback, void* userPtr);
 
+    /*! Type of collide function writing all collisions into a buffer */
+    typedef size_t (*CollideBufferedFunc)(void* bvh0, void* bvh1, RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions);
+
+    /*! Type of collide function continuing from the traversal front stored in a collision cache */
+    typedef size_t (*CollideCachedFunc)(void* bvh0, void* bvh1, CollisionCache* cache, RTCCollideFunc callback, void* userPtr,
+                                        RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions);
+
+    /*! Type of collide function testing the motion of both scenes over a time range */
+    typedef size_t (*CollideContinuousFunc)(void* bvh0, void* bvh1, float time0, float time1, RTCCollideFlags flags,
+                                            RTCContinuousCollision* collisions, size_t maxCollisions);
+
+    /*! Type of function finding the closest pair of primitives of two scenes */
+    typedef bool (*ClosestPairFunc)(void* bvh0, void* bvh1, float maxDistance, RTCClosestPair* result);
+
     /*! Type of point query function */
     typedef bool(*PointQueryFunc)(Intersectors* This,          /*!< this pointer to accel */
                                   PointQuery* query,        /*!< point query for lookup */
@@ -133,15 +148,22 @@ namespace embree
     struct Collider
     {
       Collider (ErrorFunc error = nullptr) 
-      : collide((CollideFunc)error), name(nullptr) {}
+      : collide((CollideFunc)error), collideBuffered((CollideBufferedFunc)error), collideCached((CollideCachedFunc)error),
+        collideContinuous((CollideContinuousFunc)error), closestPair((ClosestPairFunc)error), name(nullptr) {}
 
-      Collider (CollideFunc collide, const char* name)
-      : collide(collide), name(name) {}
+      Collider (CollideFunc collide, CollideBufferedFunc collideBuffered, CollideCachedFunc collideCached,
+                CollideContinuousFunc collideContinuous, ClosestPairFunc closestPair, const char* name)
+      : collide(collide), collideBuffered(collideBuffered), collideCached(collideCached), collideContinuous(collideContinuous),
+        closestPair(closestPair), name(name) {}
 
       operator bool() const { return name; }
 
     public:
       CollideFunc collide;  
+      CollideBufferedFunc collideBuffered;
+      CollideCachedFunc collideCached;
+      CollideContinuousFunc collideContinuous;
+      ClosestPairFunc closestPair;
       const char* name;
     };
     
@@ -301,6 +323,34 @@ namespace embree
         collider.collide(scene0->intersectors.ptr,scene1->intersectors.ptr,callback,userPtr);
       }
 
+      /*! collides two scenes, writes up to maxCollisions collisions into a buffer, and returns the number of collisions found */
+      __forceinline size_t collide (Accel* scene0, Accel* scene1, RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions) {
+        assert(collider.collideBuffered);
+        return collider.collideBuffered(scene0->intersectors.ptr,scene1->intersectors.ptr,flags,collisions,maxCollisions);
+      }
+
+      /*! collides two scenes starting from the traversal front stored in the cache, and either passes the collisions
+       *  to the callback, or writes up to maxCollisions collisions into a buffer and returns the number of collisions found */
+      __forceinline size_t collide (Accel* scene0, Accel* scene1, CollisionCache* cache, RTCCollideFunc callback, void* userPtr,
+                                    RTCCollideFlags flags, RTCCollision* collisions, size_t maxCollisions) {
+        assert(collider.collideCached);
+        return collider.collideCached(scene0->intersectors.ptr,scene1->intersectors.ptr,cache,callback,userPtr,flags,collisions,maxCollisions);
+      }
+
+      /*! collides the motion of two scenes over the time range [time0,time1], writes up to maxCollisions collisions
+       *  into a buffer, and returns the number of collisions found */
+      __forceinline size_t collide (Accel* scene0, Accel* scene1, float time0, float time1, RTCCollideFlags flags,
+                                    RTCContinuousCollision* collisions, size_t maxCollisions) {
+        assert(collider.collideContinuous);
+        return collider.collideContinuous(scene0->intersectors.ptr,scene1->intersectors.ptr,time0,time1,flags,collisions,maxCollisions);
+      }
+
+      /*! finds the closest pair of primitives of two scenes that are less than maxDistance apart */
+      __forceinline bool closestPair (Accel* scene0, Accel* scene1, float maxDistance, RTCClosestPair* result) {
+        assert(collider.closestPair);
+        return collider.closestPair(scene0->intersectors.ptr,scene1->intersectors.ptr,maxDistance,result);
+      }
+
       /*! Intersects a single ray with the scene. */
       __forceinline void intersect (RTCRayHit& ray, IntersectContext* context) {
         assert(intersector1.intersect);
@@ -475,6 +525,18 @@ namespace embree
 #define DEFINE_COLLIDER(symbol,collider)                                \
   Accel::Collider symbol() {                                            \
     return Accel::Collider((Accel::CollideFunc)collider::collide,       \
+                           (Accel::CollideBufferedFunc)collider::collideBuffered, \
+                           (Accel::CollideCachedFunc)collider::collideCached, \
+                           (Accel::CollideContinuousFunc)collider::collideContinuous, \
+                           (Accel::ClosestPairFunc)collider::closestPair, \
+                           TOSTRING(isa) "::" TOSTRING(symbol));        \
+  }
+
+#define DEFINE_CONTINUOUS_COLLIDER(symbol,collider)                     \
+  Accel::Collider symbol() {                                            \
+    return Accel::Collider(nullptr,nullptr,nullptr,                     \
+                           (Accel::CollideContinuousFunc)collider::collideContinuous, \
+                           nullptr,                                     \
                            TOSTRING(isa) "::" TOSTRING(symbol));        \
   }
 
@@ -519,37 +581,43 @@ namespace embree
   typedef void (*intersectStreamAOP_func)(Scene* scene, RTCRayHit** _rayN, const size_t N, IntersectContext* context);
   typedef void (*intersectStreamSOA_func)(Scene* scene, char* rayN, const size_t N, const size_t streams, const size_t stream_offset, IntersectContext* context);
   typedef void (*intersectStreamSOP_func)(Scene* scene, const RTCRayHitNp* rayN, const size_t N, IntersectContext* context);
+  typedef void (*intersectStreamTile_func)(Scene* scene, const RTCRayTile* tile, RTCRayHit* rayhit, const size_t stride, IntersectContext* context);
+  typedef void (*intersectStreamSharedDirection_func)(Scene* scene, const RTCRaySharedDirection* rayN, const RTCHitNp* hitN, const size_t N, IntersectContext* context);
 
   typedef void (*occludedStreamAOS_func)(Scene* scene, RTCRay*  _rayN, const size_t N, const size_t stride, IntersectContext* context);
   typedef void (*occludedStreamAOP_func)(Scene* scene, RTCRay** _rayN, const size_t N, IntersectContext* context);
   typedef void (*occludedStreamSOA_func)(Scene* scene, char* rayN, const size_t N, const size_t streams, const size_t stream_offset, IntersectContext* context);
   typedef void (*occludedStreamSOP_func)(Scene* scene, const RTCRayNp* rayN, const size_t N, IntersectContext* context);
+  typedef void (*occludedStreamSharedDirection_func)(Scene* scene, const RTCRaySharedDirection* rayN, const size_t N, IntersectContext* context);
 
   struct RayStreamFilterFuncs
   {
     RayStreamFilterFuncs()
-    : intersectAOS(nullptr), intersectAOP(nullptr), intersectSOA(nullptr), intersectSOP(nullptr),
-      occludedAOS(nullptr),  occludedAOP(nullptr),  occludedSOA(nullptr),  occludedSOP(nullptr) {}
+    : intersectAOS(nullptr), intersectAOP(nullptr), intersectSOA(nullptr), intersectSOP(nullptr), intersectTile(nullptr), intersectSharedDirection(nullptr),
+      occludedAOS(nullptr),  occludedAOP(nullptr),  occludedSOA(nullptr),  occludedSOP(nullptr),  occludedSharedDirection(nullptr) {}
 
     RayStreamFilterFuncs(void (*ptr) ())
-    : intersectAOS((intersectStreamAOS_func) ptr), intersectAOP((intersectStreamAOP_func) ptr), intersectSOA((intersectStreamSOA_func) ptr), intersectSOP((intersectStreamSOP_func) ptr),
-      occludedAOS((occludedStreamAOS_func) ptr),   occludedAOP((occludedStreamAOP_func) ptr),   occludedSOA((occludedStreamSOA_func) ptr),   occludedSOP((occludedStreamSOP_func) ptr) {}
+    : intersectAOS((intersectStreamAOS_func) ptr), intersectAOP((intersectStreamAOP_func) ptr), intersectSOA((intersectStreamSOA_func) ptr), intersectSOP((intersectStreamSOP_func) ptr), intersectTile((intersectStreamTile_func) ptr), intersectSharedDirection((intersectStreamSharedDirection_func) ptr),
+      occludedAOS((occludedStreamAOS_func) ptr),   occludedAOP((occludedStreamAOP_func) ptr),   occludedSOA((occludedStreamSOA_func) ptr),   occludedSOP((occludedStreamSOP_func) ptr), occludedSharedDirection((occludedStreamSharedDirection_func) ptr) {}
 
-    RayStreamFilterFuncs(intersectStreamAOS_func intersectAOS, intersectStreamAOP_func intersectAOP, intersectStreamSOA_func intersectSOA, intersectStreamSOP_func intersectSOP,
-                         occludedStreamAOS_func  occludedAOS,  occludedStreamAOP_func  occludedAOP,  occludedStreamSOA_func  occludedSOA,  occludedStreamSOP_func  occludedSOP)
-    : intersectAOS(intersectAOS), intersectAOP(intersectAOP), intersectSOA(intersectSOA), intersectSOP(intersectSOP),
-      occludedAOS(occludedAOS),   occludedAOP(occludedAOP),   occludedSOA(occludedSOA),   occludedSOP(occludedSOP) {}
+    RayStreamFilterFuncs(intersectStreamAOS_func intersectAOS, intersectStreamAOP_func intersectAOP, intersectStreamSOA_func intersectSOA, intersectStreamSOP_func intersectSOP, intersectStreamTile_func intersectTile, intersectStreamSharedDirection_func intersectSharedDirection,
+                         occludedStreamAOS_func  occludedAOS,  occludedStreamAOP_func  occludedAOP,  occludedStreamSOA_func  occludedSOA,  occludedStreamSOP_func  occludedSOP,  occludedStreamSharedDirection_func occludedSharedDirection)
+    : intersectAOS(intersectAOS), intersectAOP(intersectAOP), intersectSOA(intersectSOA), intersectSOP(intersectSOP), intersectTile(intersectTile), intersectSharedDirection(intersectSharedDirection),
+      occludedAOS(occludedAOS),   occludedAOP(occludedAOP),   occludedSOA(occludedSOA),   occludedSOP(occludedSOP),   occludedSharedDirection(occludedSharedDirection) {}
 
   public:
     intersectStreamAOS_func intersectAOS;
     intersectStreamAOP_func intersectAOP;
     intersectStreamSOA_func intersectSOA;
     intersectStreamSOP_func intersectSOP;
+    intersectStreamTile_func intersectTile;
+    intersectStreamSharedDirection_func intersectSharedDirection;
 
     occludedStreamAOS_func occludedAOS;
     occludedStreamAOP_func occludedAOP;
     occludedStreamSOA_func occludedSOA;
     occludedStreamSOP_func occludedSOP;
+    occludedStreamSharedDirection_func occludedSharedDirection;
   }; 
 
   typedef RayStreamFilterFuncs (*RayStreamFilterFuncsType)();
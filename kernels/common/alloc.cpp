@@ -12,6 +12,7 @@ namespace embree
   __thread FastAllocator::ThreadLocal2* FastAllocator::thread_local_allocator2 = nullptr;
   SpinLock FastAllocator::s_thread_local_allocators_lock;
   std::vector<std::unique_ptr<FastAllocator::ThreadLocal2>> FastAllocator::s_thread_local_allocators;
+  std::atomic<size_t> FastAllocator::s_generation(1);
    
   struct fast_allocator_regression_test : public RegressionTest
   {
@@ -186,7 +186,7 @@ namespace embree
     FastAllocator (Device* device, bool osAllocation) 
       : device(device), slotMask(0), usedBlocks(nullptr), freeBlocks(nullptr), use_single_mode(false), defaultBlockSize(PAGE_SIZE), estimatedSize(0),
         growSize(PAGE_SIZE), maxGrowSize(maxAllocationSize), log2_grow_size_scale(0), bytesUsed(0), bytesFree(0), bytesWasted(0), atype(osAllocation ? EMBREE_OS_MALLOC : ALIGNED_MALLOC),
-        primrefarray(device,0)
+        primrefarray(device,0), generation(s_generation++)
     {
       for (size_t i=0; i<MAX_THREAD_USED_BLOCK_SLOTS; i++)
       {
@@ -205,6 +205,11 @@ namespace embree
       return device;
     }
 
+    /*! returns a globally unique number that changes whenever the allocated memory gets reused or freed */
+    size_t getGeneration() const {
+      return generation;
+    }
+
     void share(mvector<PrimRef>& primrefarray_i) {
       primrefarray = std::move(primrefarray_i);
     }
@@ -408,6 +413,7 @@ namespace embree
     void init(size_t bytesAllocate, size_t bytesReserve, size_t bytesEstimate)
     {
       internal_fix_used_blocks();
+      generation = s_generation++;
       /* distribute the allocation to multiple thread block slots */
       slotMask = MAX_THREAD_USED_BLOCK_SLOTS-1; // FIXME: remove
       if (usedBlocks.load() || freeBlocks.load()) { reset(); return; }
@@ -421,6 +427,7 @@ namespace embree
     void init_estimate(size_t bytesEstimate)
     {
       internal_fix_used_blocks();
+      generation = s_generation++;
       if (usedBlocks.load() || freeBlocks.load()) { reset(); return; }
       /* single allocator mode ? */
       estimatedSize = bytesEstimate;
@@ -443,6 +450,7 @@ namespace embree
     void reset ()
     {
       internal_fix_used_blocks();
+      generation = s_generation++;
 
       bytesUsed.store(0);
       bytesFree.store(0);
@@ -475,6 +483,7 @@ namespace embree
     __forceinline void clear()
     {
       cleanup();
+      generation = s_generation++;
       bytesUsed.store(0);
       bytesFree.store(0);
       bytesWasted.store(0);
@@ -998,5 +1007,7 @@ namespace embree
     std::vector<ThreadLocal2*> thread_local_allocators;
     AllocationType atype;
     mvector<PrimRef> primrefarray;     //!< primrefarray used to allocate nodes
+    size_t generation;                 //!< changes whenever the allocated memory gets reused or freed
+    static std::atomic<size_t> s_generation;
   };
 }
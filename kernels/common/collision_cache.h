@@ -0,0 +1,87 @@
+// Copyright 2009-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "default.h"
+#include "scene.h"
+
+namespace embree
+{
+  /*! Persistent state of collision queries between two scenes. Caches
+   *  the front of the dual BVH traversal, i.e. the node pairs at which
+   *  the last traversal stopped, such that the next query after a
+   *  refit of the BVHs continues from there instead of from the
+   *  roots. */
+  class CollisionCache : public RefCount
+  {
+  public:
+
+    /*! A node is identified through its parent node and its slot in
+     *  the parent, as the bounds of a node are stored in the parent. */
+    struct FrontEntry
+    {
+      __forceinline FrontEntry () {}
+
+      __forceinline FrontEntry (size_t parent0, unsigned slot0, size_t parent1, unsigned slot1)
+        : parent0(parent0), parent1(parent1), slot0(slot0), slot1(slot1) {}
+
+      size_t parent0;  //!< parent of the node of the first BVH, 0 for the root
+      size_t parent1;  //!< parent of the node of the second BVH, 0 for the root
+      unsigned slot0;  //!< child slot of the node of the first BVH
+      unsigned slot1;  //!< child slot of the node of the second BVH
+    };
+
+    /*! Identifies the node memory of a BVH. The stamp changes whenever
+     *  the BVH gets rebuilt, but stays the same for a refit. */
+    struct Stamp
+    {
+      __forceinline Stamp ()
+        : root(0), generation(0) {}
+
+      __forceinline Stamp (size_t root, size_t generation)
+        : root(root), generation(generation) {}
+
+      __forceinline bool operator== (const Stamp& other) const {
+        return root == other.root && generation == other.generation;
+      }
+
+      size_t root;        //!< root node of the BVH
+      size_t generation;  //!< generation of the allocator holding the nodes
+    };
+
+    /*! The front is split into blocks that get processed in parallel.
+     *  Each block covers the node pair of its root entry, and stores
+     *  the part of the front below that pair. */
+    struct Block
+    {
+      __forceinline Block () : fullFrontSize(0) {}
+
+      __forceinline Block (const FrontEntry& entry)
+        : entry(entry), fullFrontSize(0) {}
+
+      FrontEntry entry;               //!< node pair covered by the block
+      std::vector<FrontEntry> front;  //!< front below the node pair, empty to traverse from the node pair
+      size_t fullFrontSize;           //!< front size after the last traversal from the node pair
+    };
+
+  public:
+    CollisionCache (Scene* scene0, Scene* scene1)
+      : scene0(scene0), scene1(scene1) {}
+
+    /*! invalidates the cached front */
+    void reset()
+    {
+      stamp0 = Stamp();
+      stamp1 = Stamp();
+      blocks.clear();
+    }
+
+  public:
+    Ref<Scene> scene0;              //!< first scene to collide
+    Ref<Scene> scene1;              //!< second scene to collide
+    Stamp stamp0;                   //!< BVH of the first scene the front was built for
+    Stamp stamp1;                   //!< BVH of the second scene the front was built for
+    std::vector<Block> blocks;      //!< blocks of the front where the last traversal stopped
+  };
+}
@@ -11,11 +11,21 @@ namespace embree
 {
   class Scene;
 
+  /*! reciprocal direction of a stream of rays with a common direction, set up once by the stream filter */
+  struct SharedRayDirection
+  {
+    __forceinline SharedRayDirection(const Vec3fa& dir)
+      : rdir(rcp_safe(dir)), rdir_robust(Vec3fa(1.0f)/zero_fix(dir)) {}
+
+    Vec3fa rdir;         //!< reciprocal direction for fast traversal
+    Vec3fa rdir_robust;  //!< reciprocal direction for robust traversal
+  };
+
   struct IntersectContext
   {
   public:
     __forceinline IntersectContext(Scene* scene, RTCIntersectContext* user_context)
-      : scene(scene), user(user_context) {}
+      : scene(scene), user(user_context), sharedDirection(nullptr) {}
 
     __forceinline bool hasContextFilter() const {
       return user->filter != nullptr;
@@ -28,10 +38,15 @@ namespace embree
     __forceinline bool isIncoherent() const {
       return embree::isIncoherent(user->flags);
     }
+
+    __forceinline bool isBatchFilter() const {
+      return (user->flags & RTC_INTERSECT_CONTEXT_FLAG_BATCH_FILTER) != 0;
+    }
     
   public:
     Scene* scene;
     RTCIntersectContext* user;
+    const SharedRayDirection* sharedDirection; //!< direction of all rays traced as stream, or nullptr
   };
 
   template<int M, typename Geometry>
@@ -87,12 +102,15 @@ namespace embree
       , primID(RTC_INVALID_GEOMETRY_ID)
       , geomID(RTC_INVALID_GEOMETRY_ID)
       , query_radius(query_ws->radius)
+      , closestPoint(nullptr)
+      , nearestPoints(nullptr)
+      , boxQuery(nullptr)
     { 
       if (query_type == POINT_QUERY_TYPE_AABB) {
         assert(similarityScale == 0.f);
         updateAABB();
       }
-      if (userContext->instStackSize == 0) {
+      if (userContext->instStackSize == 0 && query_type == POINT_QUERY_TYPE_SPHERE) {
         assert(similarityScale == 1.f);
       }
     }
@@ -100,6 +118,22 @@ namespace embree
   public:
     __forceinline void updateAABB() 
     {
+      /* box queries keep the extent of the world space box, inside of
+       * instances the traversal tests the nodes in world space instead,
+       * as the instance space box does not bound world space overlaps */
+      if (boxQuery)
+      {
+        const Vec3fa half = 0.5f * boxQuery->bounds.size();
+        if (userContext->instStackSize == 0) {
+          query_radius = half;
+          return;
+        }
+        const AffineSpace3fa m = AffineSpace3fa_load_unaligned((AffineSpace3fa*)userContext->world2inst[userContext->instStackSize-1]);
+        const BBox3fa bbox = xfmBounds(m, BBox3fa(-half, half));
+        query_radius = 0.5f * (bbox.upper - bbox.lower);
+        return;
+      }
+
       if (likely(query_ws->radius == (float)inf || userContext->instStackSize == 0)) {
         query_radius = Vec3fa(query_ws->radius);
         return;
@@ -126,6 +160,10 @@ public:
     unsigned int geomID;
 
     Vec3fa query_radius;  // used if the query is converted to an AABB internally
+
+    RTCClosestPointResult* closestPoint; // if set, the closest point on triangles, quads, and grids is computed internally
+    NearestPointsHeap* nearestPoints;    // if set, the k nearest points of point geometries are collected internally
+    BoxQueryHits* boxQuery;              // if set, the primitives overlapping a box are collected internally
   };
 }
 
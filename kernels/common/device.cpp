@@ -34,9 +34,11 @@ namespace embree
 
   static MutexSys g_mutex;
   static std::map<Device*,size_t> g_cache_size_map;
+  static std::map<Device*,size_t> g_cache_max_size_map;
   static std::map<Device*,size_t> g_num_threads_map;
 
   Device::Device (const char* cfg)
+    : subdiv_grid_updates(0)
   {
     /* check that CPU supports lowest ISA */
     if (!hasISA(ISA)) {
@@ -97,6 +99,7 @@ namespace embree
     
     /*! set tessellation cache size */
     setCacheSize( State::tessellation_cache_size );
+    setCacheMaxSize( State::tessellation_cache_max_size );
 
     /*! enable some floating point exceptions to catch bugs */
     if (State::float_exceptions)
@@ -138,6 +141,7 @@ namespace embree
   Device::~Device ()
   {
     setCacheSize(0);
+    setCacheMaxSize(0);
     exitTaskingSystem();
   }
 
@@ -353,6 +357,20 @@ namespace embree
 #endif
   }
 
+  void Device::setCacheMaxSize(size_t bytes)
+  {
+#if defined(EMBREE_GEOMETRY_SUBDIVISION)
+    Lock<MutexSys> lock(g_mutex);
+    if (bytes == 0) g_cache_max_size_map.erase(this);
+    else            g_cache_max_size_map[this] = bytes;
+
+    size_t maxCacheMaxSize = 0;
+    for (std::map<Device*,size_t>::iterator i=g_cache_max_size_map.begin(); i!= g_cache_max_size_map.end(); i++)
+      maxCacheMaxSize = max(maxCacheMaxSize, (*i).second);
+    resizeTessellationCacheMaxSize(maxCacheMaxSize);
+#endif
+  }
+
   void Device::initTaskingSystem(size_t numThreads) 
   {
     Lock<MutexSys> lock(g_mutex);
@@ -401,6 +419,41 @@ namespace embree
     case 1000003: debug_int3 = val; return;
     }
 
+    /* documented properties */
+    switch (prop)
+    {
+#if defined(EMBREE_GEOMETRY_SUBDIVISION)
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_SIZE:
+      State::tessellation_cache_size = val;
+      setCacheSize(val);
+      return;
+
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MAX_SIZE:
+      State::tessellation_cache_max_size = val;
+      setCacheMaxSize(val);
+      return;
+
+    /* setting any of the counters resets all statistics */
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_HITS:
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MISSES:
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_FLUSHES:
+      if (val != 0) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "tessellation cache statistics can only be reset to 0");
+      SharedLazyTessellationCache::sharedLazyTessellationCache.resetStats();
+      return;
+
+    /* used by subdivision geometries committed afterwards */
+    case RTC_DEVICE_PROPERTY_DISPLACEMENT_CACHE_SIZE:
+      State::displacement_cache_size = val;
+      return;
+
+    case RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES:
+      if (val != 0) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "subdivision grid update counter can only be reset to 0");
+      subdiv_grid_updates = 0;
+      return;
+#endif
+    default: break;
+    }
+
     throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "unknown writable property");
   }
 
@@ -554,6 +607,24 @@ namespace embree
     case RTC_DEVICE_PROPERTY_PARALLEL_COMMIT_SUPPORTED: return 0;
 #endif
 
+#if defined(EMBREE_GEOMETRY_SUBDIVISION)
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_SIZE:     return SharedLazyTessellationCache::sharedLazyTessellationCache.getSize();
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MAX_SIZE: return State::tessellation_cache_max_size;
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_HITS:     return SharedLazyTessellationCache::sharedLazyTessellationCache.getHits();
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MISSES:   return SharedLazyTessellationCache::sharedLazyTessellationCache.getMisses();
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_FLUSHES:  return SharedLazyTessellationCache::sharedLazyTessellationCache.getFlushes();
+    case RTC_DEVICE_PROPERTY_DISPLACEMENT_CACHE_SIZE:     return State::displacement_cache_size;
+    case RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES:    return subdiv_grid_updates;
+#else
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_SIZE:     return 0;
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MAX_SIZE: return 0;
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_HITS:     return 0;
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MISSES:   return 0;
+    case RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_FLUSHES:  return 0;
+    case RTC_DEVICE_PROPERTY_DISPLACEMENT_CACHE_SIZE:     return 0;
+    case RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES:    return 0;
+#endif
+
     default: throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "unknown readable property"); break;
     };
   }
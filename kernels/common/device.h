@@ -48,6 +48,9 @@ namespace embree
     /*! sets the size of the software cache. */
     void setCacheSize(size_t bytes);
 
+    /*! sets the size up to which the tessellation cache grows automatically */
+    void setCacheMaxSize(size_t bytes);
+
     /*! sets a property */
     void setProperty(const RTCDeviceProperty prop, ssize_t val);
 
@@ -81,5 +84,8 @@ namespace embree
     
     /* ray streams filter */
     RayStreamFilterFuncs rayStreamFilters;
+
+    /* number of subdivision grids updated in place instead of being rebuilt */
+    std::atomic<size_t> subdiv_grid_updates;
   };
 }
@@ -231,6 +231,12 @@ namespace embree
   bool Geometry::pointQuery(PointQuery* query, PointQueryContext* context)
   {
     assert(context->primID < size());
+
+    /* only triangle, quad, and grid geometries are considered by closest point queries,
+       only point geometries by nearest points queries, and box queries are handled by
+       the primitive intersectors */
+    if (context->closestPoint || context->nearestPoints || context->boxQuery)
+      return false;
    
     RTCPointQueryFunctionArguments args;
     args.query           = (RTCPointQuery*)context->query_ws;
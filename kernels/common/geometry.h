@@ -374,6 +374,11 @@ namespace embree
     /*! interpolates user data to the specified u/v locations */
     virtual void interpolateN(const RTCInterpolateNArguments* const args);
 
+    /*! interpolates user data to a regular grid of u/v locations over a patch */
+    virtual void interpolateGrid(const RTCInterpolateGridArguments* const args) {
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
+    }
+
     /* point query api */
     bool pointQuery(PointQuery* query, PointQueryContext* context);
 
@@ -387,11 +392,31 @@ namespace embree
       throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
     }
 
+    /*! Sets the geometry to copy the half edge structures from */
+    virtual void setTopologySource(Geometry* source) {
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
+    }
+
     /*! Set displacement function. */
     virtual void setDisplacementFunction (RTCDisplacementFunctionN filter) {
       throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
     }
 
+    /*! Set edge level function. */
+    virtual void setEdgeLevelFunction (RTCEdgeLevelFunctionN func) {
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
+    }
+
+    /*! Writes the displaced grid positions to a file. */
+    virtual void saveDisplacementCache (const char* fileName, unsigned int displacementID) {
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
+    }
+
+    /*! Reads the displaced grid positions from a file, returns false if the file does not match the geometry. */
+    virtual bool loadDisplacementCache (const char* fileName, unsigned int displacementID) {
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
+    }
+
     virtual unsigned int getFirstHalfEdge(unsigned int faceID) {
       throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
     }
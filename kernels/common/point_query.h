@@ -122,6 +122,95 @@ namespace embree
   typedef PointQueryK<16> PointQuery16;
   struct PointQueryN;
 
+  /* Bounded max-heap that collects the k nearest points found by a
+   * nearest points query. The farthest point found so far is at the
+   * front, such that it can be replaced in O(log k). */
+  struct NearestPointsHeap
+  {
+    __forceinline NearestPointsHeap(RTCNearestPoint* points, unsigned int k)
+      : points(points), k(k), size(0) {}
+
+    static __forceinline bool compare(const RTCNearestPoint& a, const RTCNearestPoint& b) {
+      return a.distance < b.distance;
+    }
+
+    __forceinline bool full() const { return size == k; }
+
+    /* distance of the farthest point, the query radius can be shrunk to this distance if the heap is full */
+    __forceinline float maxDistance() const { return points[0].distance; }
+
+    /* inserts a point if it is closer than the farthest point found so far */
+    __forceinline bool insert(const RTCNearestPoint& point)
+    {
+      if (size < k) {
+        points[size++] = point;
+        std::push_heap(points, points+size, compare);
+        return true;
+      }
+      if (!compare(point, points[0]))
+        return false;
+      std::pop_heap(points, points+size, compare);
+      points[size-1] = point;
+      std::push_heap(points, points+size, compare);
+      return true;
+    }
+
+    /* sorts the points by increasing distance */
+    __forceinline void finalize() {
+      std::sort_heap(points, points+size, compare);
+    }
+
+    RTCNearestPoint* points;
+    unsigned int k;
+    unsigned int size;
+  };
+
+  /* Collects the primitives found by a box query. Spatial splits and
+   * grids can reference a primitive from multiple leaves, thus the hits
+   * are sorted and duplicates removed before they are returned. */
+  struct BoxQueryHits
+  {
+    __forceinline void reset(const BBox3fa& box)
+    {
+      bounds = box;
+      hits.clear();
+    }
+
+    __forceinline void insert(unsigned int geomID, unsigned int primID, const RTCPointQueryContext* userContext)
+    {
+      RTCBoxQueryHit hit;
+      hit.primID = primID;
+      hit.geomID = geomID;
+      for (unsigned l = 0; l < RTC_MAX_INSTANCE_LEVEL_COUNT; ++l)
+        hit.instID[l] = l < userContext->instStackSize ? userContext->instID[l] : RTC_INVALID_GEOMETRY_ID;
+      hits.push_back(hit);
+    }
+
+    static __forceinline bool compare(const RTCBoxQueryHit& a, const RTCBoxQueryHit& b)
+    {
+      for (unsigned l = 0; l < RTC_MAX_INSTANCE_LEVEL_COUNT; ++l)
+        if (a.instID[l] != b.instID[l]) return a.instID[l] < b.instID[l];
+      if (a.geomID != b.geomID) return a.geomID < b.geomID;
+      return a.primID < b.primID;
+    }
+
+    static __forceinline bool equal(const RTCBoxQueryHit& a, const RTCBoxQueryHit& b) {
+      return !compare(a,b) && !compare(b,a);
+    }
+
+    /* removes duplicates, copies up to maxHits hits and returns the total number of hits */
+    __forceinline unsigned int finalize(unsigned int maxHits, RTCBoxQueryHit* out)
+    {
+      std::sort(hits.begin(), hits.end(), compare);
+      hits.erase(std::unique(hits.begin(), hits.end(), equal), hits.end());
+      std::copy(hits.begin(), hits.begin() + std::min(hits.size(), size_t(maxHits)), out);
+      return (unsigned int) hits.size();
+    }
+
+    BBox3fa bounds; // world space query box
+    std::vector<RTCBoxQueryHit> hits;
+  };
+
   /* Outputs point query to stream */
   template<int K>
   __forceinline embree_ostream operator <<(embree_ostream cout, const PointQueryK<K>& query)
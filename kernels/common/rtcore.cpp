@@ -7,7 +7,12 @@
 #include "device.h"
 #include "scene.h"
 #include "context.h"
+#include "collision_cache.h"
+#include "../builders/bvh_builder_morton.h"
 #include "../geometry/filter.h"
+#include "../../common/algorithms/parallel_for.h"
+#include "../../common/algorithms/parallel_reduce.h"
+#include "../../common/algorithms/parallel_sort.h"
 #include "../../include/embree3/rtcore_ray.h"
 using namespace embree;
 
@@ -293,6 +298,28 @@ RTC_NAMESPACE_BEGIN;
     RTC_CATCH_END2(scene);
   }
 
+  static bool isCollidable(Scene* scene)
+  {
+    const size_t numPrimitives = scene->numPrimitives();
+    return numPrimitives == scene->getNumPrimitives(Geometry::MTY_USER_GEOMETRY,false)
+      ||   numPrimitives == scene->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false);
+  }
+
+  /* the collider of the first scene also interprets the leaves of the
+   * second scene, thus both scenes have to contain the same kind of primitives */
+  static void verifyCollidable(Scene* scene0, Scene* scene1)
+  {
+    if (!isCollidable(scene0) || !isCollidable(scene1))
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes must only contain user geometries or only triangle meshes with a single timestep");
+
+    const size_t numPrimitives0 = scene0->numPrimitives();
+    const size_t numPrimitives1 = scene1->numPrimitives();
+    const bool user0 = numPrimitives0 && numPrimitives0 == scene0->getNumPrimitives(Geometry::MTY_USER_GEOMETRY,false);
+    const bool user1 = numPrimitives1 && numPrimitives1 == scene1->getNumPrimitives(Geometry::MTY_USER_GEOMETRY,false);
+    if (numPrimitives0 && numPrimitives1 && user0 != user1)
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes must both contain user geometries or both contain triangle meshes");
+  }
+
   RTC_API void rtcCollide (RTCScene hscene0, RTCScene hscene1, RTCCollideFunc callback, void* userPtr)
   {
     Scene* scene0 = (Scene*) hscene0;
@@ -305,15 +332,188 @@ RTC_NAMESPACE_BEGIN;
     if (scene0->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
     if (scene1->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
     if (scene0->device != scene1->device) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes are from different devices");
-    auto nUserPrims0 = scene0->getNumPrimitives (Geometry::MTY_USER_GEOMETRY, false);
-    auto nUserPrims1 = scene1->getNumPrimitives (Geometry::MTY_USER_GEOMETRY, false);
-    if (scene0->numPrimitives() != nUserPrims0 && scene1->numPrimitives() != nUserPrims1) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes must only contain user geometries with a single timestep");
 #endif
+    verifyCollidable(scene0,scene1);
     scene0->intersectors.collide(scene0,scene1,callback,userPtr);
     RTC_CATCH_END(scene0->device);
   }
-  
-  inline bool pointQuery(Scene* scene, RTCPointQuery* query, RTCPointQueryContext* userContext, RTCPointQueryFunction queryFunc, void* userPtr)
+
+  RTC_API unsigned int rtcCollideBuffered (RTCScene hscene0, RTCScene hscene1, RTCCollideFlags flags, RTCCollision* collisions, unsigned int maxCollisions)
+  {
+    Scene* scene0 = (Scene*) hscene0;
+    Scene* scene1 = (Scene*) hscene1;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcCollideBuffered);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene0);
+    RTC_VERIFY_HANDLE(hscene1);
+    if (scene0->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (scene1->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (scene0->device != scene1->device) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes are from different devices");
+    if (maxCollisions && collisions == nullptr) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"collision buffer is NULL");
+#endif
+    verifyCollidable(scene0,scene1);
+    if (flags & RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE) {
+      if (scene0->numPrimitives() != scene0->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false) ||
+          scene1->numPrimitives() != scene1->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false))
+        throw_RTCError(RTC_ERROR_INVALID_OPERATION,"triangle narrow phase requires scenes that only contain triangle meshes");
+    }
+    if ((flags & RTC_COLLIDE_FLAG_SELF_COLLISION) && scene0 != scene1)
+      throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"self collision requires to collide a scene with itself");
+    return (unsigned int) scene0->intersectors.collide(scene0,scene1,flags,collisions,maxCollisions);
+    RTC_CATCH_END(scene0->device);
+    return 0;
+  }
+
+  RTC_API RTCCollisionCache rtcNewCollisionCache (RTCScene hscene0, RTCScene hscene1)
+  {
+    Scene* scene0 = (Scene*) hscene0;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcNewCollisionCache);
+    RTC_VERIFY_HANDLE(hscene0);
+    RTC_VERIFY_HANDLE(hscene1);
+    Scene* scene1 = (Scene*) hscene1;
+    if (scene0->device != scene1->device) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes are from different devices");
+    CollisionCache* cache = new CollisionCache(scene0,scene1);
+    return (RTCCollisionCache) cache->refInc();
+    RTC_CATCH_END2(scene0);
+    return nullptr;
+  }
+
+  RTC_API void rtcRetainCollisionCache (RTCCollisionCache hcache)
+  {
+    CollisionCache* cache = (CollisionCache*) hcache;
+    Device* device = cache ? cache->scene0->device : nullptr;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcRetainCollisionCache);
+    RTC_VERIFY_HANDLE(hcache);
+    cache->refInc();
+    RTC_CATCH_END(device);
+  }
+
+  RTC_API void rtcReleaseCollisionCache (RTCCollisionCache hcache)
+  {
+    CollisionCache* cache = (CollisionCache*) hcache;
+    Device* device = cache ? cache->scene0->device : nullptr;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcReleaseCollisionCache);
+    RTC_VERIFY_HANDLE(hcache);
+    cache->refDec();
+    RTC_CATCH_END(device);
+  }
+
+  RTC_API void rtcCollideCached (RTCCollisionCache hcache, RTCCollideFunc callback, void* userPtr)
+  {
+    CollisionCache* cache = (CollisionCache*) hcache;
+    Device* device = cache ? cache->scene0->device : nullptr;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcCollideCached);
+    RTC_VERIFY_HANDLE(hcache);
+    Scene* scene0 = cache->scene0.ptr;
+    Scene* scene1 = cache->scene1.ptr;
+#if defined(DEBUG)
+    if (scene0->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (scene1->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+#endif
+    verifyCollidable(scene0,scene1);
+    scene0->intersectors.collide(scene0,scene1,cache,callback,userPtr,RTC_COLLIDE_FLAG_NONE,nullptr,0);
+    RTC_CATCH_END(device);
+  }
+
+  RTC_API unsigned int rtcCollideCachedBuffered (RTCCollisionCache hcache, RTCCollideFlags flags, RTCCollision* collisions, unsigned int maxCollisions)
+  {
+    CollisionCache* cache = (CollisionCache*) hcache;
+    Device* device = cache ? cache->scene0->device : nullptr;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcCollideCachedBuffered);
+    RTC_VERIFY_HANDLE(hcache);
+    Scene* scene0 = cache->scene0.ptr;
+    Scene* scene1 = cache->scene1.ptr;
+#if defined(DEBUG)
+    if (scene0->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (scene1->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (maxCollisions && collisions == nullptr) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"collision buffer is NULL");
+#endif
+    verifyCollidable(scene0,scene1);
+    if (flags & RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE) {
+      if (scene0->numPrimitives() != scene0->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false) ||
+          scene1->numPrimitives() != scene1->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false))
+        throw_RTCError(RTC_ERROR_INVALID_OPERATION,"triangle narrow phase requires scenes that only contain triangle meshes");
+    }
+    if (flags & RTC_COLLIDE_FLAG_SELF_COLLISION)
+      throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"self collision is not supported by collision caches");
+    return (unsigned int) scene0->intersectors.collide(scene0,scene1,cache,nullptr,nullptr,flags,collisions,maxCollisions);
+    RTC_CATCH_END(device);
+    return 0;
+  }
+
+  static bool isContinuousCollidable(Scene* scene)
+  {
+    const Accel::Collider& collider = scene->intersectors.collider;
+    return collider && collider.collideContinuous;
+  }
+
+  RTC_API unsigned int rtcCollideContinuous (RTCScene hscene0, RTCScene hscene1, float time0, float time1, RTCCollideFlags flags,
+                                             RTCContinuousCollision* collisions, unsigned int maxCollisions)
+  {
+    Scene* scene0 = (Scene*) hscene0;
+    Scene* scene1 = (Scene*) hscene1;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcCollideContinuous);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene0);
+    RTC_VERIFY_HANDLE(hscene1);
+    if (scene0->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (scene1->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (scene0->device != scene1->device) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes are from different devices");
+    if (maxCollisions && collisions == nullptr) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"collision buffer is NULL");
+#endif
+    if (!(0.0f <= time0 && time0 <= time1 && time1 <= 1.0f))
+      throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"invalid time range");
+    if (!isContinuousCollidable(scene0) || !isContinuousCollidable(scene1))
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes must only contain user geometries or only triangle meshes");
+    if (flags & RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE) {
+      if (scene0->numPrimitives() != scene0->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false) + scene0->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,true) ||
+          scene1->numPrimitives() != scene1->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false) + scene1->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,true))
+        throw_RTCError(RTC_ERROR_INVALID_OPERATION,"triangle narrow phase requires scenes that only contain triangle meshes");
+    }
+    if ((flags & RTC_COLLIDE_FLAG_SELF_COLLISION) && scene0 != scene1)
+      throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"self collision requires to collide a scene with itself");
+    return (unsigned int) scene0->intersectors.collide(scene0,scene1,time0,time1,flags,collisions,maxCollisions);
+    RTC_CATCH_END(scene0->device);
+    return 0;
+  }
+
+  RTC_API bool rtcClosestPair (RTCScene hscene0, RTCScene hscene1, float maxDistance, RTCClosestPair* result)
+  {
+    Scene* scene0 = (Scene*) hscene0;
+    Scene* scene1 = (Scene*) hscene1;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcClosestPair);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene0);
+    RTC_VERIFY_HANDLE(hscene1);
+    RTC_VERIFY_HANDLE(result);
+    if (scene0->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (scene1->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (scene0->device != scene1->device) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes are from different devices");
+#endif
+    if (!(maxDistance >= 0.0f)) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"invalid maximal distance");
+    if (scene0->numPrimitives() != scene0->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false) ||
+        scene1->numPrimitives() != scene1->getNumPrimitives(Geometry::MTY_TRIANGLE_MESH,false))
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scenes must only contain triangle meshes with a single timestep");
+    result->geomID0 = result->primID0 = RTC_INVALID_GEOMETRY_ID;
+    result->geomID1 = result->primID1 = RTC_INVALID_GEOMETRY_ID;
+    result->distance = inf;
+    if (scene0->numPrimitives() == 0 || scene1->numPrimitives() == 0) return false;
+    if (!scene0->intersectors.collider || !scene1->intersectors.collider)
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"closest pair queries are not supported for this scene configuration");
+    return scene0->intersectors.closestPair(scene0,scene1,maxDistance,result);
+    RTC_CATCH_END(scene0->device);
+    return false;
+  }
+
+  inline bool pointQuery(Scene* scene, RTCPointQuery* query, RTCPointQueryContext* userContext, RTCPointQueryFunction queryFunc, void* userPtr, RTCClosestPointResult* closestPoint = nullptr, NearestPointsHeap* nearestPoints = nullptr)
   {
     bool changed = false;
     if (userContext->instStackSize > 0)
@@ -332,12 +532,16 @@ RTC_NAMESPACE_BEGIN;
       PointQueryContext context_inst(scene, (PointQuery*)query,
         similtude ? POINT_QUERY_TYPE_SPHERE : POINT_QUERY_TYPE_AABB,
         queryFunc, userContext, similarityScale, userPtr);
+      context_inst.closestPoint = closestPoint;
+      context_inst.nearestPoints = nearestPoints;
       changed = scene->intersectors.pointQuery((PointQuery*)&query_inst, &context_inst);
     }
     else
     {
       PointQueryContext context(scene, (PointQuery*)query, 
         POINT_QUERY_TYPE_SPHERE, queryFunc, userContext, 1.f, userPtr);
+      context.closestPoint = closestPoint;
+      context.nearestPoints = nearestPoints;
       changed = scene->intersectors.pointQuery((PointQuery*)query, &context);
     }
     return changed;
@@ -360,6 +564,90 @@ RTC_NAMESPACE_BEGIN;
     RTC_CATCH_END2_FALSE(scene);
   }
   
+  RTC_API bool rtcClosestPoint(RTCScene hscene, RTCPointQuery* query, RTCPointQueryContext* userContext, RTCClosestPointResult* result)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcClosestPoint);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    RTC_VERIFY_HANDLE(userContext);
+    RTC_VERIFY_HANDLE(result);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (((size_t)query) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "query not aligned to 16 bytes");   
+    if (((size_t)userContext) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "context not aligned to 16 bytes");   
+#endif
+
+    result->x = result->y = result->z = 0.0f;
+    result->u = result->v = 0.0f;
+    result->primID = RTC_INVALID_GEOMETRY_ID;
+    result->geomID = RTC_INVALID_GEOMETRY_ID;
+    for (unsigned l = 0; l < RTC_MAX_INSTANCE_LEVEL_COUNT; ++l)
+      result->instID[l] = RTC_INVALID_GEOMETRY_ID;
+    return pointQuery(scene, query, userContext, nullptr, nullptr, result);
+    RTC_CATCH_END2_FALSE(scene);
+  }
+
+  template<int K>
+  __forceinline bool pointQueryK(const int* valid, Scene* scene, PointQueryK<K>* queryK, RTCPointQueryContext* userContext, RTCPointQueryFunction queryFunc, void** userPtrK)
+  {
+    bool changed = false;
+    PointQuery query1;
+    for (size_t i=0; i<K; i++) {
+      if (!valid[i]) continue;
+      queryK->get(i,query1);
+      changed |= pointQuery(scene, (RTCPointQuery*)&query1, userContext, queryFunc, userPtrK?userPtrK[i]:NULL);
+      queryK->set(i,query1);
+    }
+    return changed;
+  }
+
+  /* processes a stream of point queries, the queries are sorted along a
+   * Morton curve such that consecutive queries traverse similar parts of
+   * the BVH, and the sorted queries are processed as scalar queries in
+   * parallel */
+  static bool pointQueryStream(Scene* scene, RTCPointQuery* queryM, size_t M, size_t byteStride, RTCPointQueryContext* userContext, RTCPointQueryFunction queryFunc, void** userPtrM)
+  {
+    auto getQuery = [&] (size_t i) -> RTCPointQuery& { return *(RTCPointQuery*)((char*)queryM + i*byteStride); };
+
+    /* small streams are processed in input order, the stream does not
+     * guarantee the 16 byte alignment of single queries */
+    if (M <= VSIZEX)
+    {
+      bool changed = false;
+      for (size_t i=0; i<M; i++)
+      {
+        RTCPointQuery query = getQuery(i);
+        changed |= pointQuery(scene, &query, userContext, queryFunc, userPtrM?userPtrM[i]:NULL);
+        getQuery(i).radius = query.radius;
+      }
+      return changed;
+    }
+
+    std::vector<isa::BVHBuilderMorton::BuildPrim> keys;
+    isa::BVHBuilderMorton::sortPoints(M, [&] (size_t i) -> Vec3fa { const RTCPointQuery& q = getQuery(i); return Vec3fa(q.x, q.y, q.z); }, keys);
+
+    /* the instance stack of the context is modified during traversal,
+     * thus every task operates on its own copy of the context */
+    return parallel_reduce(size_t(0), M, size_t(64), false, [&] (const range<size_t>& r) -> bool
+    {
+      RTCPointQueryContext context = *userContext;
+      bool changed = false;
+
+      for (size_t i = r.begin(); i < r.end(); i++)
+      {
+        /* the stream does not guarantee the 16 byte alignment of single queries */
+        const unsigned int index = keys[i].index;
+        RTCPointQuery query = getQuery(index);
+        changed |= pointQuery(scene, &query, &context, queryFunc, userPtrM ? userPtrM[index] : NULL);
+
+        /* the radius might have been shrunk by the callback */
+        getQuery(index).radius = query.radius;
+      }
+      return changed;
+    }, [] (bool a, bool b) { return a || b; });
+  }
+
   RTC_API bool rtcPointQuery4 (const int* valid, RTCScene hscene, RTCPointQuery4* query, struct RTCPointQueryContext* userContext, RTCPointQueryFunction queryFunc, void** userPtrN)
   {
     Scene* scene = (Scene*) hscene;
@@ -375,16 +663,7 @@ RTC_NAMESPACE_BEGIN;
     STAT(size_t cnt=0; for (size_t i=0; i<4; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(point_query.travs,cnt,cnt,cnt);
 
-    bool changed = false;
-    PointQuery4* query4 = (PointQuery4*)query;
-    PointQuery query1; 
-    for (size_t i=0; i<4; i++) {
-      if (!valid[i]) continue;
-      query4->get(i,query1);
-      changed |= pointQuery(scene, (RTCPointQuery*)&query1, userContext, queryFunc, userPtrN?userPtrN[i]:NULL);
-      query4->set(i,query1);
-    }
-    return changed;
+    return pointQueryK(valid, scene, (PointQuery4*)query, userContext, queryFunc, userPtrN);
     RTC_CATCH_END2_FALSE(scene);
   }
   
@@ -403,16 +682,7 @@ RTC_NAMESPACE_BEGIN;
     STAT(size_t cnt=0; for (size_t i=0; i<4; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(point_query.travs,cnt,cnt,cnt);
 
-    bool changed = false;
-    PointQuery8* query8 = (PointQuery8*)query;
-    PointQuery query1; 
-    for (size_t i=0; i<8; i++) {
-      if (!valid[i]) continue;
-      query8->get(i,query1);
-      changed |= pointQuery(scene, (RTCPointQuery*)&query1, userContext, queryFunc, userPtrN?userPtrN[i]:NULL);
-      query8->set(i,query1);
-    }
-    return changed;
+    return pointQueryK(valid, scene, (PointQuery8*)query, userContext, queryFunc, userPtrN);
     RTC_CATCH_END2_FALSE(scene);
   }
 
@@ -431,19 +701,201 @@ RTC_NAMESPACE_BEGIN;
     STAT(size_t cnt=0; for (size_t i=0; i<4; i++) cnt += ((int*)valid)[i] == -1;);
     STAT3(point_query.travs,cnt,cnt,cnt);
 
-    bool changed = false;
-    PointQuery16* query16 = (PointQuery16*)query;
-    PointQuery query1; 
-    for (size_t i=0; i<16; i++) {
-      if (!valid[i]) continue;
-      PointQuery query1; query16->get(i,query1);
-      changed |= pointQuery(scene, (RTCPointQuery*)&query1, userContext, queryFunc, userPtrN?userPtrN[i]:NULL);
-      query16->set(i,query1);
-    }
-    return changed;
+    return pointQueryK(valid, scene, (PointQuery16*)query, userContext, queryFunc, userPtrN);
     RTC_CATCH_END2_FALSE(scene);
   }
 
+  RTC_API bool rtcPointQuery1M (RTCScene hscene, RTCPointQuery* query, unsigned int M, size_t byteStride, struct RTCPointQueryContext* userContext, RTCPointQueryFunction queryFunc, void** userPtrM)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcPointQuery1M);
+
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    RTC_VERIFY_HANDLE(userContext);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (((size_t)query) & 0x03) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "query not aligned to 4 bytes");   
+    if (((size_t)userContext) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "context not aligned to 16 bytes");   
+#endif
+    STAT3(point_query.travs,M,M,M);
+
+    return pointQueryStream(scene, query, M, byteStride, userContext, queryFunc, userPtrM);
+    RTC_CATCH_END2_FALSE(scene);
+  }
+
+  /* finds the k nearest points to the query, sorted by increasing distance */
+  static unsigned int nearestPoints(Scene* scene, RTCPointQuery* query, RTCPointQueryContext* userContext, unsigned int k, RTCNearestPoint* points)
+  {
+    if (k == 0) return 0;
+    NearestPointsHeap heap(points, k);
+    pointQuery(scene, query, userContext, nullptr, nullptr, nullptr, &heap);
+    heap.finalize();
+    return heap.size;
+  }
+
+  RTC_API unsigned int rtcNearestPoints(RTCScene hscene, RTCPointQuery* query, RTCPointQueryContext* userContext, unsigned int k, RTCNearestPoint* points)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcNearestPoints);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    RTC_VERIFY_HANDLE(userContext);
+    if (k) RTC_VERIFY_HANDLE(points);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (((size_t)query) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "query not aligned to 16 bytes");   
+    if (((size_t)userContext) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "context not aligned to 16 bytes");   
+#endif
+    STAT3(point_query.travs,1,1,1);
+
+    return nearestPoints(scene, query, userContext, k, points);
+    RTC_CATCH_END2(scene);
+    return 0;
+  }
+
+  RTC_API void rtcNearestPoints1M(RTCScene hscene, RTCPointQuery* queryM, unsigned int M, size_t byteStride, RTCPointQueryContext* userContext, unsigned int k, RTCNearestPoint* points, unsigned int* numPoints)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcNearestPoints1M);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    RTC_VERIFY_HANDLE(userContext);
+    RTC_VERIFY_HANDLE(numPoints);
+    if (k) RTC_VERIFY_HANDLE(points);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (((size_t)queryM) & 0x03) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "query not aligned to 4 bytes");   
+    if (((size_t)userContext) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "context not aligned to 16 bytes");   
+#endif
+    STAT3(point_query.travs,M,M,M);
+
+    auto getQuery = [&] (size_t i) -> RTCPointQuery* { return (RTCPointQuery*)((char*)queryM + i*byteStride); };
+
+    /* small batches are processed in input order */
+    if (M <= VSIZEX)
+    {
+      for (size_t i=0; i<M; i++) {
+        RTCPointQuery query = *getQuery(i);
+        numPoints[i] = nearestPoints(scene, &query, userContext, k, points + i*k);
+        getQuery(i)->radius = query.radius;
+      }
+      return;
+    }
+
+    /* neighboring queries find mostly the same points, thus the
+     * queries are processed in Morton order to improve cache reuse */
+    std::vector<isa::BVHBuilderMorton::BuildPrim> keys;
+    isa::BVHBuilderMorton::sortPoints(M, [&] (size_t i) -> Vec3fa { const RTCPointQuery* q = getQuery(i); return Vec3fa(q->x, q->y, q->z); }, keys);
+
+    /* the instance stack of the context is modified during traversal,
+     * thus every task operates on its own copy of the context */
+    parallel_for(size_t(0), size_t(M), size_t(64), [&] (const range<size_t>& r)
+    {
+      RTCPointQueryContext context = *userContext;
+      for (size_t i = r.begin(); i < r.end(); i++)
+      {
+        const unsigned int index = keys[i].index;
+        RTCPointQuery query = *getQuery(index);
+        numPoints[index] = nearestPoints(scene, &query, &context, k, points + size_t(index)*k);
+        getQuery(index)->radius = query.radius;
+      }
+    });
+    RTC_CATCH_END2(scene);
+  }
+
+  /* finds the primitives whose bounds overlap the box of the query */
+  static unsigned int boxQuery(Scene* scene, const RTCBoxQuery* query, RTCPointQueryContext* userContext, BoxQueryHits& hits, unsigned int maxHits, RTCBoxQueryHit* out)
+  {
+    hits.reset(BBox3fa(Vec3fa(query->lower_x, query->lower_y, query->lower_z), Vec3fa(query->upper_x, query->upper_y, query->upper_z)));
+    const Vec3fa center = hits.bounds.center();
+    PointQuery query_ws(center, length(0.5f*hits.bounds.size()), query->time);
+    PointQuery query_inst = query_ws;
+    if (userContext->instStackSize > 0) {
+      const AffineSpace3fa transform = AffineSpace3fa_load_unaligned((AffineSpace3fa*)userContext->world2inst[userContext->instStackSize-1]);
+      query_inst.p = xfmPoint(transform, center);
+    }
+
+    /* the box is traversed as an AABB point query with the extent of the box */
+    PointQueryContext context(scene, &query_ws, POINT_QUERY_TYPE_AABB, nullptr, userContext, 0.f, nullptr);
+    context.boxQuery = &hits;
+    context.updateAABB();
+    scene->intersectors.pointQuery(&query_inst, &context);
+    return hits.finalize(maxHits, out);
+  }
+
+  RTC_API unsigned int rtcBoxQuery(RTCScene hscene, RTCBoxQuery* query, RTCPointQueryContext* userContext, unsigned int maxHits, RTCBoxQueryHit* hits)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcBoxQuery);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    RTC_VERIFY_HANDLE(query);
+    RTC_VERIFY_HANDLE(userContext);
+    if (maxHits) RTC_VERIFY_HANDLE(hits);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (((size_t)query) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "query not aligned to 16 bytes");   
+    if (((size_t)userContext) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "context not aligned to 16 bytes");   
+#endif
+    STAT3(point_query.travs,1,1,1);
+
+    BoxQueryHits boxHits;
+    return boxQuery(scene, query, userContext, boxHits, maxHits, hits);
+    RTC_CATCH_END2(scene);
+    return 0;
+  }
+
+  RTC_API void rtcBoxQuery1M(RTCScene hscene, RTCBoxQuery* queryM, unsigned int M, size_t byteStride, RTCPointQueryContext* userContext, unsigned int maxHits, RTCBoxQueryHit* hits, unsigned int* numHits)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcBoxQuery1M);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    RTC_VERIFY_HANDLE(userContext);
+    RTC_VERIFY_HANDLE(numHits);
+    if (maxHits) RTC_VERIFY_HANDLE(hits);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+    if (((size_t)queryM) & 0x03) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "query not aligned to 4 bytes");   
+    if (((size_t)userContext) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "context not aligned to 16 bytes");   
+#endif
+    STAT3(point_query.travs,M,M,M);
+
+    auto getQuery = [&] (size_t i) -> RTCBoxQuery* { return (RTCBoxQuery*)((char*)queryM + i*byteStride); };
+
+    /* small batches are processed in input order */
+    if (M <= VSIZEX)
+    {
+      BoxQueryHits boxHits;
+      for (size_t i=0; i<M; i++) {
+        const RTCBoxQuery query = *getQuery(i);
+        numHits[i] = boxQuery(scene, &query, userContext, boxHits, maxHits, hits + i*maxHits);
+      }
+      return;
+    }
+
+    /* neighboring boxes overlap mostly the same BVH nodes, thus the
+     * queries are processed in Morton order of the box centers */
+    std::vector<isa::BVHBuilderMorton::BuildPrim> keys;
+    isa::BVHBuilderMorton::sortPoints(M, [&] (size_t i) -> Vec3fa { const RTCBoxQuery* q = getQuery(i); return 0.5f*Vec3fa(q->lower_x+q->upper_x, q->lower_y+q->upper_y, q->lower_z+q->upper_z); }, keys);
+
+    /* the instance stack of the context is modified during traversal,
+     * thus every task operates on its own copy of the context */
+    parallel_for(size_t(0), size_t(M), size_t(64), [&] (const range<size_t>& r)
+    {
+      RTCPointQueryContext context = *userContext;
+      BoxQueryHits boxHits;
+      for (size_t i = r.begin(); i < r.end(); i++)
+      {
+        const unsigned int index = keys[i].index;
+        const RTCBoxQuery query = *getQuery(index);
+        numHits[index] = boxQuery(scene, &query, &context, boxHits, maxHits, hits + size_t(index)*maxHits);
+      }
+    });
+    RTC_CATCH_END2(scene);
+  }
+
   RTC_API void rtcIntersect1 (RTCScene hscene, RTCIntersectContext* user_context, RTCRayHit* rayhit) 
   {
     Scene* scene = (Scene*) hscene;
@@ -698,6 +1150,62 @@ RTC_NAMESPACE_BEGIN;
     RTC_CATCH_END2(scene);
   }
   
+  RTC_API void rtcIntersectTile (RTCScene hscene, RTCIntersectContext* user_context, const RTCRayTile* tile, RTCRayHit* rayhit, size_t byteStride) 
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcIntersectTile);
+
+#if defined (EMBREE_RAY_PACKETS)
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene not committed");
+    if (((size_t)tile) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "tile not aligned to 16 bytes");   
+    if (((size_t)rayhit) & 0x0F) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "rayhit not aligned to 16 bytes");   
+    if (byteStride < sizeof(RTCRayHit)) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "byteStride smaller than sizeof(RTCRayHit)");
+#endif
+    STAT3(normal.travs,tile->width*tile->height,tile->width*tile->height,tile->width*tile->height);
+    IntersectContext context(scene,user_context);
+    scene->device->rayStreamFilters.intersectTile(scene,tile,rayhit,byteStride,&context);
+#else
+    throw_RTCError(RTC_ERROR_INVALID_OPERATION,"rtcIntersectTile not supported");
+#endif
+    RTC_CATCH_END2(scene);
+  }
+
+  RTC_API void rtcIntersectSharedDirection (RTCScene hscene, RTCIntersectContext* user_context, const RTCRaySharedDirection* rays, const RTCHitNp* hits, unsigned int N)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcIntersectSharedDirection);
+
+#if defined (EMBREE_RAY_PACKETS)
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene not committed");
+    if (((size_t)rays->org_x ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "org_x not aligned to 4 bytes");   
+    if (((size_t)rays->org_y ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "org_y not aligned to 4 bytes");   
+    if (((size_t)rays->org_z ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "org_z not aligned to 4 bytes");   
+    if (((size_t)rays->tnear ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "tnear not aligned to 4 bytes");   
+    if (((size_t)rays->tfar  ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "tfar not aligned to 4 bytes");   
+    if (((size_t)hits->Ng_x  ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "hits->Ng_x not aligned to 4 bytes");   
+    if (((size_t)hits->Ng_y  ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "hits->Ng_y not aligned to 4 bytes");   
+    if (((size_t)hits->Ng_z  ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "hits->Ng_z not aligned to 4 bytes");   
+    if (((size_t)hits->u     ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "hits->u not aligned to 4 bytes");   
+    if (((size_t)hits->v     ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "hits->v not aligned to 4 bytes");   
+    if (((size_t)hits->geomID) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "hits->geomID not aligned to 4 bytes");   
+    if (((size_t)hits->primID) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "hits->primID not aligned to 4 bytes");   
+    if (((size_t)hits->instID) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "hits->instID not aligned to 4 bytes");   
+#endif
+    STAT3(normal.travs,N,N,N);
+    IntersectContext context(scene,user_context);
+    scene->device->rayStreamFilters.intersectSharedDirection(scene,rays,hits,N,&context);
+#else
+    throw_RTCError(RTC_ERROR_INVALID_OPERATION,"rtcIntersectSharedDirection not supported");
+#endif
+    RTC_CATCH_END2(scene);
+  }
+  
   RTC_API void rtcOccluded1 (RTCScene hscene, RTCIntersectContext* user_context, RTCRay* ray) 
   {
     Scene* scene = (Scene*) hscene;
@@ -941,6 +1449,169 @@ RTC_NAMESPACE_BEGIN;
     RTC_CATCH_END2(scene);
   }
 
+#if defined (EMBREE_RAY_PACKETS)
+
+  /* traces rays with a common origin as pointer SOA streams, the shared ray
+   * components are broadcast into arrays for blocks of rays */
+  static void occludedSharedOrigin(Scene* scene, const RTCRaySharedOrigin* rays, size_t N, IntersectContext* context)
+  {
+    static const size_t blockSize = 256;
+    __aligned(64) float org_x[blockSize], org_y[blockSize], org_z[blockSize], tnear[blockSize], time[blockSize];
+    __aligned(64) unsigned int mask[blockSize], id[blockSize], flags[blockSize];
+    for (size_t j = 0; j < blockSize; j++)
+    {
+      org_x[j] = rays->org_x; org_y[j] = rays->org_y; org_z[j] = rays->org_z;
+      tnear[j] = rays->tnear; time[j] = rays->time;
+      mask[j] = rays->mask; flags[j] = 0;
+    }
+
+    for (size_t i = 0; i < N; i += blockSize)
+    {
+      const size_t M = min(N-i,blockSize);
+      for (size_t j = 0; j < M; j++) id[j] = unsigned(i+j);
+
+      RTCRayNp rayN;
+      rayN.org_x = org_x; rayN.org_y = org_y; rayN.org_z = org_z; rayN.tnear = tnear;
+      rayN.dir_x = rays->dir_x + i; rayN.dir_y = rays->dir_y + i; rayN.dir_z = rays->dir_z + i; rayN.time = time;
+      rayN.tfar = rays->tfar + i; rayN.mask = mask; rayN.id = id; rayN.flags = flags;
+      scene->device->rayStreamFilters.occludedSOP(scene,&rayN,M,context);
+    }
+  }
+
+#endif
+
+  RTC_API void rtcOccludedSharedOrigin(RTCScene hscene, RTCIntersectContext* user_context, const RTCRaySharedOrigin* rays, unsigned int N)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcOccludedSharedOrigin);
+
+#if defined (EMBREE_RAY_PACKETS)
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene not committed");
+    if (((size_t)rays->dir_x) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "dir_x not aligned to 4 bytes");   
+    if (((size_t)rays->dir_y) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "dir_y not aligned to 4 bytes");   
+    if (((size_t)rays->dir_z) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "dir_z not aligned to 4 bytes");   
+    if (((size_t)rays->tfar ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "tfar not aligned to 4 bytes");   
+#endif
+    STAT3(shadow.travs,N,N,N);
+    IntersectContext context(scene,user_context);
+    occludedSharedOrigin(scene,rays,N,&context);
+#else
+    throw_RTCError(RTC_ERROR_INVALID_OPERATION,"rtcOccludedSharedOrigin not supported");
+#endif
+    RTC_CATCH_END2(scene);
+  }
+
+  RTC_API void rtcOccludedSharedDirection(RTCScene hscene, RTCIntersectContext* user_context, const RTCRaySharedDirection* rays, unsigned int N)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcOccludedSharedDirection);
+
+#if defined (EMBREE_RAY_PACKETS)
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene not committed");
+    if (((size_t)rays->org_x) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "org_x not aligned to 4 bytes");   
+    if (((size_t)rays->org_y) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "org_y not aligned to 4 bytes");   
+    if (((size_t)rays->org_z) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "org_z not aligned to 4 bytes");   
+    if (((size_t)rays->tnear) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "tnear not aligned to 4 bytes");   
+    if (((size_t)rays->tfar ) & 0x03 ) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "tfar not aligned to 4 bytes");   
+#endif
+    STAT3(shadow.travs,N,N,N);
+    IntersectContext context(scene,user_context);
+    scene->device->rayStreamFilters.occludedSharedDirection(scene,rays,N,&context);
+#else
+    throw_RTCError(RTC_ERROR_INVALID_OPERATION,"rtcOccludedSharedDirection not supported");
+#endif
+    RTC_CATCH_END2(scene);
+  }
+
+  RTC_API void rtcOccludedMatrix(RTCScene hscene, RTCIntersectContext* user_context, const float* points0, unsigned int N, const float* points1, unsigned int M, size_t byteStride, float epsilon, unsigned int* visibility)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcOccludedMatrix);
+
+#if defined (EMBREE_RAY_PACKETS)
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(hscene);
+    if (scene->isModified()) throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene not committed");
+    if (((size_t)points0) & 0x03) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "points0 not aligned to 4 bytes");
+    if (((size_t)points1) & 0x03) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "points1 not aligned to 4 bytes");
+    if (((size_t)visibility) & 0x03) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "visibility not aligned to 4 bytes");
+#endif
+    if (byteStride < 3*sizeof(float)) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "byte stride smaller than a point");
+    if (epsilon < 0.0f) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "negative epsilon");
+    if (N == 0 || M == 0) return;
+    STAT3(shadow.travs,size_t(N)*M,size_t(N)*M,size_t(N)*M);
+
+    auto getPoint = [&] (const float* points, size_t i) -> Vec3fa {
+      const float* p = (const float*)((const char*)points + i*byteStride);
+      return Vec3fa(p[0], p[1], p[2]);
+    };
+    const size_t rowWords = (size_t(M)+31)/32;
+
+    /* the targets are traced in Morton order, such that neighboring rays
+     * of each shared origin stream end in the same part of the scene */
+    std::vector<isa::BVHBuilderMorton::BuildPrim> keys0, keys1;
+    isa::BVHBuilderMorton::sortPoints(M, [&] (size_t j) { return getPoint(points1, j); }, keys1);
+
+    /* neighboring origins see mostly the same parts of the scene, thus
+     * the rows are processed in Morton order too */
+    isa::BVHBuilderMorton::sortPoints(N, [&] (size_t i) { return getPoint(points0, i); }, keys0);
+
+    /* every row is traced as one stream of rays sharing the origin, the
+     * segments are shortened by epsilon at both ends to not hit the
+     * surfaces the points are located on */
+    parallel_for(size_t(0), size_t(N), size_t(1), [&] (const range<size_t>& r)
+    {
+      std::vector<float> dir_x(M), dir_y(M), dir_z(M), tfar(M);
+
+      /* the instance stack of the context is modified during traversal,
+       * thus every task operates on its own copy of the context */
+      RTCIntersectContext ctx = *user_context;
+      IntersectContext context(scene,&ctx);
+
+      for (size_t i = r.begin(); i < r.end(); i++)
+      {
+        const unsigned int row = keys0[i].index;
+        const Vec3fa org = getPoint(points0, row);
+        for (size_t j = 0; j < M; j++)
+        {
+          const Vec3fa d = getPoint(points1, keys1[j].index) - org;
+          const float len = length(d);
+          const Vec3fa dir = len > 0.0f ? Vec3fa(d.x/len,d.y/len,d.z/len) : Vec3fa(0.0f,0.0f,1.0f);
+          dir_x[j] = dir.x; dir_y[j] = dir.y; dir_z[j] = dir.z;
+          tfar[j] = len - epsilon;
+        }
+
+        RTCRaySharedOrigin rays;
+        rays.org_x = org.x; rays.org_y = org.y; rays.org_z = org.z;
+        rays.tnear = epsilon;
+        rays.time = 0.0f;
+        rays.mask = -1;
+        rays.dir_x = dir_x.data(); rays.dir_y = dir_y.data(); rays.dir_z = dir_z.data();
+        rays.tfar = tfar.data();
+        occludedSharedOrigin(scene,&rays,M,&context);
+
+        /* inactive segments between points closer than 2*epsilon count as visible */
+        unsigned int* bits = visibility + size_t(row)*rowWords;
+        for (size_t k = 0; k < rowWords; k++) bits[k] = 0;
+        for (size_t j = 0; j < M; j++) {
+          const unsigned int col = keys1[j].index;
+          if (tfar[j] != float(neg_inf)) bits[col/32] |= 1u << (col%32);
+        }
+      }
+    });
+#else
+    throw_RTCError(RTC_ERROR_INVALID_OPERATION,"rtcOccludedMatrix not supported");
+#endif
+    RTC_CATCH_END2(scene);
+  }
+
   RTC_API void rtcRetainScene (RTCScene hscene) 
   {
     Scene* scene = (Scene*) hscene;
@@ -1391,6 +2062,40 @@ RTC_NAMESPACE_BEGIN;
     RTC_CATCH_END2(geometry);
   }
 
+  RTC_API void rtcSetGeometryTopologySource(RTCGeometry hgeometry, RTCGeometry hsource)
+  {
+    Geometry* geometry = (Geometry*) hgeometry;
+    Geometry* source = (Geometry*) hsource;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcSetGeometryTopologySource);
+    RTC_VERIFY_HANDLE(hgeometry);
+    geometry->setTopologySource(source);
+    RTC_CATCH_END2(geometry);
+  }
+
+  RTC_API void rtcSaveGeometryDisplacementCache(RTCGeometry hgeometry, const char* filename, unsigned int displacementID)
+  {
+    Geometry* geometry = (Geometry*) hgeometry;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcSaveGeometryDisplacementCache);
+    RTC_VERIFY_HANDLE(hgeometry);
+    RTC_VERIFY_HANDLE(filename);
+    geometry->saveDisplacementCache(filename,displacementID);
+    RTC_CATCH_END2(geometry);
+  }
+
+  RTC_API bool rtcLoadGeometryDisplacementCache(RTCGeometry hgeometry, const char* filename, unsigned int displacementID)
+  {
+    Geometry* geometry = (Geometry*) hgeometry;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcLoadGeometryDisplacementCache);
+    RTC_VERIFY_HANDLE(hgeometry);
+    RTC_VERIFY_HANDLE(filename);
+    return geometry->loadDisplacementCache(filename,displacementID);
+    RTC_CATCH_END2(geometry);
+    return false;
+  }
+
   RTC_API void rtcSetGeometryVertexAttributeTopology(RTCGeometry hgeometry, unsigned int vertexAttributeID, unsigned int topologyID)
   {
     Geometry* geometry = (Geometry*) hgeometry;
@@ -1549,6 +2254,16 @@ RTC_NAMESPACE_BEGIN;
     RTC_CATCH_END2(geometry);
   }
 
+  RTC_API void rtcSetGeometryEdgeLevelFunction (RTCGeometry hgeometry, RTCEdgeLevelFunctionN edgeLevel) 
+  {
+    Geometry* geometry = (Geometry*) hgeometry;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcSetGeometryEdgeLevelFunction);
+    RTC_VERIFY_HANDLE(hgeometry);
+    geometry->setEdgeLevelFunction(edgeLevel);
+    RTC_CATCH_END2(geometry);
+  }
+
   RTC_API void rtcSetGeometryIntersectFunction (RTCGeometry hgeometry, RTCIntersectFunctionN intersect) 
   {
     Geometry* geometry = (Geometry*) hgeometry;
@@ -1673,6 +2388,18 @@ RTC_NAMESPACE_BEGIN;
     RTC_CATCH_END2(geometry);
   }
 
+  RTC_API void rtcInterpolateGrid(const RTCInterpolateGridArguments* const args)
+  {
+    Geometry* geometry = (Geometry*) args->geometry;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcInterpolateGrid);
+#if defined(DEBUG)
+    RTC_VERIFY_HANDLE(args->geometry);
+#endif
+    geometry->interpolateGrid(args);
+    RTC_CATCH_END2(geometry);
+  }
+
   RTC_API void rtcCommitGeometry (RTCGeometry hgeometry)
   {
     Geometry* geometry = (Geometry*) hgeometry;
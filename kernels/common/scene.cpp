@@ -673,6 +673,12 @@ namespace embree
       },
       std::plus<GeometryCounts>()
     );
+
+#if defined(EMBREE_GEOMETRY_SUBDIVISION)
+    /* a tessellation cache that got flushed too often grows when a scene with subdivision geometries gets committed */
+    if (world.numSubdivPatches || world.numMBSubdivPatches)
+      growTessellationCache();
+#endif
     
     /* select acceleration structures to build */
     unsigned int new_enabled_geometry_types = world.enabledGeometryTypesMask();
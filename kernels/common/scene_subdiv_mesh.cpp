@@ -17,15 +17,22 @@ namespace embree
 {
 #if defined(EMBREE_LOWEST_ISA)
 
+  /* topology versions are unique across meshes, thus a new mesh never matches the version of an old one */
+  static std::atomic<unsigned int> g_topology_version(0);
+
   SubdivMesh::SubdivMesh (Device* device)
     : Geometry(device,GTY_SUBDIV_MESH,0,1), 
       displFunc(nullptr),
+      edgeLevelFunc(nullptr),
       tessellationRate(2.0f),
       numHalfEdges(0),
       faceStartEdge(device,0),
       halfEdgeFace(device,0),
+      edgeLevels(device,0),
       invalid_face(device,0),
-      commitCounter(0)
+      commitCounter(0),
+      topologyVersion(0),
+      gridQuantizationStep(0.0f)
   {
     
     vertices.resize(numTimeSteps);
@@ -94,6 +101,27 @@ namespace embree
     for (size_t i = begin; i < topology.size(); i++)
       topology[i] = Topology(this);
   }
+
+  void SubdivMesh::setTopologySource (Geometry* source)
+  {
+    if (source == this)
+      throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"geometry cannot be its own topology source");
+    if (source && source->getType() != GTY_SUBDIV_MESH)
+      throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"topology source has to be a subdivision geometry");
+    if (source && source->device != device)
+      throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"topology source is from a different device");
+
+    /* a cycle of topology sources would keep its geometries alive forever */
+    for (const SubdivMesh* s = (SubdivMesh*) source; s; s = s->topologySource.ptr)
+      if (s->topologySource.ptr == this)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"topology sources cannot form a cycle");
+
+    topologySource = (SubdivMesh*) source;
+
+    /* forces recalculation of the half edges at the next commit */
+    for (auto& t : topology) t.update();
+    Geometry::update();
+  }
   
   void SubdivMesh::setBuffer(RTCBufferType type, unsigned int slot, RTCFormat format, const Ref<Buffer>& buffer, size_t offset, size_t stride, unsigned int num)
   { 
@@ -351,6 +379,15 @@ namespace embree
   void SubdivMesh::setDisplacementFunction (RTCDisplacementFunctionN func) 
   {
     this->displFunc = func;
+    displacementCache.reset(0);
+  }
+
+  void SubdivMesh::setEdgeLevelFunction (RTCEdgeLevelFunctionN func) 
+  {
+    this->edgeLevelFunc = func;
+    edgeLevels.clear();
+    levels.setModified();
+    Geometry::update();
   }
 
   void SubdivMesh::setTessellationRate(float N)
@@ -550,6 +587,75 @@ namespace embree
     });
   }
 
+  bool SubdivMesh::Topology::copyHalfEdges()
+  {
+    const SubdivMesh* source = mesh->topologySource.ptr;
+    if (source == nullptr)
+      return false;
+
+    /* the source has to provide a committed topology of the same size in the same slot */
+    const size_t topologyID = this - mesh->topology.data();
+    if (topologyID >= source->topology.size())
+      return false;
+    
+    const Topology& sourceTopology = source->topology[topologyID];
+    if (source->numFaces() != mesh->numFaces() || source->numHalfEdges != mesh->numHalfEdges)
+      return false;
+    if (sourceTopology.halfEdges.size() != halfEdges.size() || sourceTopology.vertexIndices.size() != vertexIndices.size())
+      return false;
+
+    const size_t blockSize = 4096;
+    const size_t numFaces = mesh->numFaces();
+    std::atomic<bool> mismatch(false);
+
+    /* copy the half edges face by face, edge levels and face validity come from the mesh itself */
+    parallel_for( size_t(0), numFaces, blockSize, [&](const range<size_t>& r) 
+    {
+      for (size_t f=r.begin(); f<r.end(); f++) 
+      {
+        const unsigned N = mesh->faceVertices[f];
+        if (unlikely(N != source->faceVertices[f])) {
+          mismatch = true;
+          return;
+        }
+        
+        const unsigned e = mesh->faceStartEdge[f];
+        for (unsigned de=0; de<N; de++)
+        {
+          /* the connectivity of the half edges is only valid for identical vertex indices */
+          if (unlikely(vertexIndices[e+de] != sourceTopology.vertexIndices[e+de])) {
+            mismatch = true;
+            return;
+          }
+
+          HalfEdge& edge = halfEdges[e+de];
+          edge = sourceTopology.halfEdges[e+de];
+          edge.vtx_index  = vertexIndices[e+de];
+          edge.edge_level = mesh->getEdgeLevel(e+de);
+        }
+      }
+    });
+
+    if (mismatch)
+      return false;
+
+    /* the validity check walks the vertex rings into neighboring faces, thus all faces have to be copied first */
+    if (this == &mesh->topology[0])
+    {
+      parallel_for( size_t(0), numFaces, blockSize, [&](const range<size_t>& r) 
+      {
+        for (size_t f=r.begin(); f<r.end(); f++) 
+        {
+          const unsigned e = mesh->faceStartEdge[f];
+          for (size_t t=0; t<mesh->numTimeSteps; t++)
+            mesh->invalidFace(f,t) = !halfEdges[e].valid(mesh->vertices[t]) || source->holeSet.lookup(unsigned(f));
+        }
+      });
+    }
+    
+    return true;
+  }
+
   void SubdivMesh::Topology::updateHalfEdges()
   {
     /* we always use the geometry topology to lookup creases */
@@ -632,7 +738,9 @@ namespace embree
     update |= mesh->levels.isLocalModified();
 
     /* now either recalculate or update the half edges */
-    if (recalculate) calculateHalfEdges();
+    if (recalculate) {
+      if (!copyHalfEdges()) calculateHalfEdges();
+    }
     else if (update) updateHalfEdges();
    
     /* cleanup some state for static scenes */
@@ -686,9 +794,15 @@ namespace embree
 
       /* calculate face of each half edge */
       halfEdgeFace.resize(numHalfEdges);
-      for (size_t f=0, h=0; f<numFaces(); f++)
-        for (size_t e=0; e<faceVertices[f]; e++)
-          halfEdgeFace[h++] = (unsigned int) f;
+      parallel_for( size_t(0), numFaces(), size_t(4096), [&](const range<size_t>& r) 
+      {
+        for (size_t f=r.begin(); f<r.end(); f++) 
+        {
+          const unsigned int e = faceStartEdge[f];
+          for (size_t de=0; de<faceVertices[f]; de++)
+            halfEdgeFace[e+de] = (unsigned int) f;
+        }
+      });
     }
     
     /* create set with all vertex creases */
@@ -703,6 +817,20 @@ namespace embree
     if (holes.isLocalModified())
       holeSet.init(holes);
 
+    /* query edge levels and only update the half edges if some level changed,
+     * a changed level changes the tessellation and rebuilds all grids of the mesh */
+    if (edgeLevelFunc && calculateEdgeLevels())
+      levels.setModified();
+
+    /* everything except the vertex positions changes the tessellation */
+    bool topologyModified = faceVertices.isLocalModified() || holes.isLocalModified() || levels.isLocalModified();
+    topologyModified |= edge_creases.isLocalModified() || edge_crease_weights.isLocalModified();
+    topologyModified |= vertex_creases.isLocalModified() || vertex_crease_weights.isLocalModified();
+    for (auto& t: topology)
+      topologyModified |= t.vertexIndices.isLocalModified();
+    if (topologyModified)
+      topologyVersion = ++g_topology_version;
+
     /* create topology */
     for (auto& t: topology)
       t.initializeHalfEdgeStructures();
@@ -739,6 +867,74 @@ namespace embree
     }
   }
 
+  bool SubdivMesh::calculateEdgeLevels ()
+  {
+    static const size_t batchSize = 64;
+    const BufferView<unsigned int>& vertexIndices = topology[0].vertexIndices;
+    if (!vertexIndices || numHalfEdges > vertexIndices.size())
+      return false;
+
+    bool changed = edgeLevels.size() != numHalfEdges;
+    if (changed) {
+      edgeLevels.resize(numHalfEdges);
+      for (size_t i=0; i<numHalfEdges; i++) edgeLevels[i] = 0.0f;
+    }
+    std::atomic<bool> modified(changed);
+
+    parallel_for( size_t(0), numFaces(), size_t(1024), [&](const range<size_t>& r) 
+    {
+      __aligned(64) unsigned int edgeID[batchSize];
+      __aligned(64) float v0_x[batchSize], v0_y[batchSize], v0_z[batchSize];
+      __aligned(64) float v1_x[batchSize], v1_y[batchSize], v1_z[batchSize];
+      __aligned(64) float level[batchSize];
+      unsigned int N = 0;
+
+      RTCEdgeLevelFunctionNArguments args;
+      args.geometryUserPtr = userPtr;
+      args.geometry = (RTCGeometry)this;
+      args.edgeID = edgeID;
+      args.v0_x = v0_x; args.v0_y = v0_y; args.v0_z = v0_z;
+      args.v1_x = v1_x; args.v1_y = v1_y; args.v1_z = v1_z;
+      args.level = level;
+
+      auto flush = [&] () {
+        args.N = N;
+        edgeLevelFunc(&args);
+        for (unsigned int i=0; i<N; i++) {
+          if (edgeLevels[edgeID[i]] != level[i]) {
+            edgeLevels[edgeID[i]] = level[i];
+            modified = true;
+          }
+        }
+        N = 0;
+      };
+      
+      for (size_t f=r.begin(); f<r.end(); f++) 
+      {
+        const unsigned int e = faceStartEdge[f];
+        const unsigned int valence = faceVertices[f];
+        for (unsigned int de=0; de<valence; de++)
+        {
+          /* pass the vertices of an edge ordered by index to get the same level for both half edges */
+          unsigned int i0 = vertexIndices[e+de];
+          unsigned int i1 = vertexIndices[e+(de+1)%valence];
+          if (i1 < i0) std::swap(i0,i1);
+          if (unlikely(i1 >= numVertices())) continue;
+          const Vec3fa p0 = vertices[0][i0];
+          const Vec3fa p1 = vertices[0][i1];
+          edgeID[N] = e+de;
+          v0_x[N] = p0.x; v0_y[N] = p0.y; v0_z[N] = p0.z;
+          v1_x[N] = p1.x; v1_y[N] = p1.y; v1_z[N] = p1.z;
+          level[N] = levels ? levels[e+de] : tessellationRate;
+          if (++N == batchSize) flush();
+        }
+      }
+      if (N) flush();
+    });
+
+    return modified;
+  }
+
   bool SubdivMesh::verify () 
   {
     /*! verify consistent size of vertex arrays */
@@ -767,6 +963,17 @@ namespace embree
   void SubdivMesh::commit () 
   {
     initializeHalfEdgeStructures();
+
+    /* displaced positions may depend on any state of the geometry, thus we only reuse them until the next commit */
+    displacementCache.reset(displFunc ? device->displacement_cache_size : 0);
+
+    /* compressed grids store 16 bit offsets on a lattice that resolves the largest coordinate with 16 bits */
+    float maxAbs = 0.0f;
+    for (unsigned int t=0; t<numTimeSteps; t++)
+      for (size_t i=0; i<numVertices(); i++)
+        maxAbs = max(maxAbs,reduce_max(abs(vertices[t][i])));
+    int exponent = 0; frexpf(maxAbs,&exponent);
+    gridQuantizationStep = (maxAbs > 0.0f && std::isfinite(maxAbs)) ? ldexpf(1.0f,exponent-16) : 0.0f;
     Geometry::commit();
   }
 
@@ -812,6 +1019,61 @@ namespace embree
 
     return edgeID + topology[topologyID].halfEdges[edgeID].opposite_half_edge_ofs;
   }
+
+  uint64_t SubdivMesh::hashDisplacementCacheInputs(unsigned int displacementID) const
+  {
+    /* 64 bit FNV-1a hash over 32 bit words */
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto add = [&] (uint32_t v) { hash = (hash ^ v) * 0x100000001B3ull; };
+
+    add(displacementID);
+    add((uint32_t)numTimeSteps);
+    add((uint32_t)numVertices());
+    add((uint32_t)numFaces());
+    add((uint32_t)numHalfEdges);
+
+    for (unsigned int t=0; t<numTimeSteps; t++) {
+      for (size_t i=0; i<numVertices(); i++) {
+        const Vec3fa v = vertices[t][i];
+        add(cast_f2i(v.x)); add(cast_f2i(v.y)); add(cast_f2i(v.z));
+      }
+    }
+
+    for (size_t f=0; f<numFaces(); f++)
+      for (unsigned int t=0; t<numTimeSteps; t++)
+        add(valid(f,t));
+
+    for (size_t i=0; i<numHalfEdges; i++)
+    {
+      const HalfEdge& edge = topology[0].halfEdges[i];
+      add(edge.vtx_index);
+      add(edge.next_half_edge_ofs);
+      add(edge.prev_half_edge_ofs);
+      add(edge.opposite_half_edge_ofs);
+      add(cast_f2i(edge.edge_crease_weight));
+      add(cast_f2i(edge.vertex_crease_weight));
+      add(cast_f2i(edge.edge_level));
+      add(edge.patch_type);
+      add(edge.vertex_type);
+    }
+    return hash;
+  }
+
+  void SubdivMesh::saveDisplacementCache(const char* fileName, unsigned int displacementID)
+  {
+    if (!displacementCache.enabled())
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"displacement cache is disabled");
+    
+    displacementCache.save(fileName,hashDisplacementCacheInputs(displacementID));
+  }
+
+  bool SubdivMesh::loadDisplacementCache(const char* fileName, unsigned int displacementID)
+  {
+    if (!displacementCache.enabled())
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"displacement cache is disabled");
+
+    return displacementCache.load(fileName,hashDisplacementCacheInputs(displacementID));
+  }
   
 #endif
 
@@ -965,5 +1227,69 @@ namespace embree
                        });
       }
     }
+
+    void SubdivMeshISA::interpolateGrid(const RTCInterpolateGridArguments* const args)
+    {
+      unsigned int primID = args->primID;
+      unsigned int subPatchID = args->subPatchID;
+      unsigned int width = args->width;
+      unsigned int height = args->height;
+      RTCBufferType bufferType = args->bufferType;
+      unsigned int bufferSlot = args->bufferSlot;
+      float* P = args->P;
+      float* dPdu = args->dPdu;
+      float* dPdv = args->dPdv;
+      float* ddPdudu = args->ddPdudu;
+      float* ddPdvdv = args->ddPdvdv;
+      float* ddPdudv = args->ddPdudv;
+      unsigned int valueCount = args->valueCount;
+
+      if (width < 2 || height < 2)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"grid width and height have to be at least 2");
+      if (primID >= numPrimitives)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"invalid primitive ID");
+      
+      /* calculate base pointer and stride */
+      assert((bufferType == RTC_BUFFER_TYPE_VERTEX && bufferSlot < RTC_MAX_TIME_STEP_COUNT) ||
+             (bufferType == RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE && bufferSlot < RTC_MAX_USER_VERTEX_BUFFERS));
+      const char* src = nullptr; 
+      size_t stride = 0;
+      std::vector<SharedLazyTessellationCache::CacheEntry>* baseEntry = nullptr;
+      Topology* topo = nullptr;
+      if (bufferType == RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE) {
+        assert(bufferSlot < vertexAttribs.size());
+        src    = vertexAttribs[bufferSlot].getPtr();
+        stride = vertexAttribs[bufferSlot].getStride();
+        baseEntry = &vertex_attrib_buffer_tags[bufferSlot];
+        int topologyID = vertexAttribs[bufferSlot].userData;
+        topo = &topology[topologyID];
+      } else {
+        assert(bufferSlot < numTimeSteps);
+        src    = vertices[bufferSlot].getPtr();
+        stride = vertices[bufferSlot].getStride();
+        baseEntry = &vertex_buffer_tags[bufferSlot];
+        topo = &topology[0];
+      }
+
+      const HalfEdge* edge = topo->getHalfEdge(primID);
+      const unsigned int numSubPatches = edge->numEdges() == 4 ? 1 : min(edge->numEdges(),unsigned(MAX_PATCH_VALENCE));
+      if (subPatchID >= numSubPatches)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"invalid sub-patch ID");
+
+      const size_t N = size_t(width)*size_t(height);
+      for (unsigned int j=0; j<valueCount; j+=4) 
+      {
+        const size_t M = min(4u,valueCount-j);
+        isa::PatchEvalSimd<vbool4,vint4,vfloat4,vfloat4>(baseEntry->at(interpolationSlot(primID,j/4,stride)),commitCounter,
+                                                         edge,src+j*sizeof(float),stride,subPatchID,width,height,
+                                                         P ? P+j*N : nullptr,
+                                                         dPdu ? dPdu+j*N : nullptr,
+                                                         dPdv ? dPdv+j*N : nullptr,
+                                                         ddPdudu ? ddPdudu+j*N : nullptr,
+                                                         ddPdvdv ? ddPdvdv+j*N : nullptr,
+                                                         ddPdudv ? ddPdudv+j*N : nullptr,
+                                                         M);
+      }
+    }
   }
 }
@@ -7,6 +7,7 @@
 #include "buffer.h"
 #include "../subdiv/half_edge.h"
 #include "../subdiv/tessellation_cache.h"
+#include "../subdiv/displacement_cache.h"
 #include "../subdiv/catmullclark_coefficients.h"
 #include "../subdiv/patch.h"
 #include "../../common/algorithms/parallel_map.h"
@@ -57,6 +58,7 @@ namespace embree
     void setNumTimeSteps (unsigned int numTimeSteps);
     void setVertexAttributeCount (unsigned int N);
     void setTopologyCount (unsigned int N);
+    void setTopologySource (Geometry* source);
     void setBuffer(RTCBufferType type, unsigned int slot, RTCFormat format, const Ref<Buffer>& buffer, size_t offset, size_t stride, unsigned int num);
     void* getBuffer(RTCBufferType type, unsigned int slot);
     void updateBuffer(RTCBufferType type, unsigned int slot);
@@ -65,6 +67,9 @@ namespace embree
     void commit();
     void addElementsToCount (GeometryCounts & counts) const;
     void setDisplacementFunction (RTCDisplacementFunctionN func);
+    void setEdgeLevelFunction (RTCEdgeLevelFunctionN func);
+    void saveDisplacementCache (const char* fileName, unsigned int displacementID);
+    bool loadDisplacementCache (const char* fileName, unsigned int displacementID);
     unsigned int getFirstHalfEdge(unsigned int faceID);
     unsigned int getFace(unsigned int edgeID);
     unsigned int getNextHalfEdge(unsigned int edgeID);
@@ -103,11 +108,27 @@ namespace embree
       return topology[0].valid(i) && !invalidFace(i,j);
     }
 
+    /* gets version info of topology, which changes with everything except the vertex positions */
+    unsigned int getTopologyVersion() const {
+      return topologyVersion;
+    }
+
+    /* gets the lattice spacing that compressed grids quantize the positions to, 0 disables compression */
+    float getGridQuantizationStep() const {
+      return gridQuantizationStep;
+    }
+
     /*! prints some statistics */
     void printStatistics();
 
     /*! initializes the half edge data structure */
     void initializeHalfEdgeStructures ();
+
+    /*! invokes the edge level function for all half edges, returns true if some level changed */
+    bool calculateEdgeLevels ();
+
+    /*! hashes the vertices, the half edges, and the valid faces, which determine the grids together with the displacement function */
+    uint64_t hashDisplacementCacheInputs (unsigned int displacementID) const;
  
   public:
 
@@ -119,12 +140,15 @@ namespace embree
     /* returns tessellation level of edge */
     __forceinline float getEdgeLevel(const size_t i) const
     {
+      if (edgeLevelFunc) return clamp(edgeLevels[i],1.0f,4096.0f);
       if (levels) return clamp(levels[i],1.0f,4096.0f); // FIXME: do we want to limit edge level?
       else return clamp(tessellationRate,1.0f,4096.0f); // FIXME: do we want to limit edge level?
     }
 
   public:
     RTCDisplacementFunctionN displFunc;    //!< displacement function
+    RTCEdgeLevelFunctionN edgeLevelFunc;   //!< edge level function
+    mutable DisplacementCache displacementCache; //!< displaced grid positions of this mesh
 
     /*! all buffers in this section are provided by the application */
   public:
@@ -188,6 +212,9 @@ namespace embree
       
       /*! recalculates the half edges */
       void calculateHalfEdges();
+
+      /*! copies the half edges from the topology source, returns false if the topologies do not match */
+      bool copyHalfEdges();
       
       /*! updates half edges when recalculation is not necessary */
       void updateHalfEdges();
@@ -259,6 +286,9 @@ namespace embree
     /*! buffer that marks specific faces as holes */
     BufferView<unsigned> holes;
 
+    /*! mesh with identical connectivity to copy the half edge structures from */
+    Ref<SubdivMesh> topologySource;
+
     /*! all data in this section is generated by initializeHalfEdgeStructures function */
   private:
 
@@ -271,6 +301,9 @@ namespace embree
     /*! fast lookup table to find the face for some half edge */
     mvector<uint32_t> halfEdgeFace;
 
+    /*! edge levels calculated by the edge level function */
+    mvector<float> edgeLevels;
+
     /*! set with all holes */
     parallel_set<uint32_t> holeSet;
 
@@ -308,6 +341,12 @@ namespace embree
     
     /*! counts number of geometry commits */
     size_t commitCounter;
+
+    /*! changes with each commit that changes more than the vertex positions */
+    unsigned int topologyVersion;
+
+    /*! power of two spacing of the lattice shared by all compressed grids of this mesh */
+    float gridQuantizationStep;
   };
 
   namespace isa
@@ -319,6 +358,7 @@ namespace embree
 
       void interpolate(const RTCInterpolateArguments* const args);
       void interpolateN(const RTCInterpolateNArguments* const args);
+      void interpolateGrid(const RTCInterpolateGridArguments* const args);
     };
   }
 
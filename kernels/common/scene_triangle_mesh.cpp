@@ -9,7 +9,7 @@ namespace embree
 #if defined(EMBREE_LOWEST_ISA)
 
   TriangleMesh::TriangleMesh (Device* device)
-    : Geometry(device,GTY_TRIANGLE_MESH,0,1)
+    : Geometry(device,GTY_TRIANGLE_MESH,0,1), opacityMicromaskLevel(0)
   {
     vertices.resize(numTimeSteps);
   }
@@ -75,6 +75,22 @@ namespace embree
       triangles.set(buffer, offset, stride, num, format);
       setNumPrimitives(num);
     }
+    else if (type == RTC_BUFFER_TYPE_OPACITY_MICROMASK)
+    {
+      if (slot != 0)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid buffer slot");
+      if (format != RTC_FORMAT_UCHAR)
+        throw_RTCError(RTC_ERROR_INVALID_OPERATION, "invalid opacity micromask buffer format");
+
+      /* each triangle stores 4^level cells of 2 bits, thus the stride selects the level */
+      unsigned int level = 1;
+      while ((size_t(1) << (2*level)) < 4*stride) level++;
+      if (level > 6 || (size_t(1) << (2*level)) != 4*stride)
+        throw_RTCError(RTC_ERROR_INVALID_OPERATION, "opacity micromask stride has to be 4, 16, 64, 256, or 1024 bytes");
+
+      opacityMicromask.set(buffer, offset, stride, num, format);
+      opacityMicromaskLevel = level;
+    }
     else 
       throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "unknown buffer type");
   }
@@ -99,6 +115,12 @@ namespace embree
         throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid buffer slot");
       return vertexAttribs[slot].getPtr();
     }
+    else if (type == RTC_BUFFER_TYPE_OPACITY_MICROMASK)
+    {
+      if (slot != 0)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid buffer slot");
+      return opacityMicromask.getPtr();
+    }
     else
     {
       throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "unknown buffer type");
@@ -126,6 +148,12 @@ namespace embree
         throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid buffer slot");
       vertexAttribs[slot].setModified();
     }
+    else if (type == RTC_BUFFER_TYPE_OPACITY_MICROMASK)
+    {
+      if (slot != 0)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid buffer slot");
+      opacityMicromask.setModified();
+    }
     else
     {
       throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "unknown buffer type");
@@ -163,6 +191,10 @@ namespace embree
       if (buffer.size() != numVertices())
         return false;
 
+    /*! verify size of opacity micromask array */
+    if (opacityMicromask && opacityMicromask.size() != size())
+      return false;
+
     /*! verify triangle indices */
     for (size_t i=0; i<size(); i++) {     
       if (triangles[i].v[0] >= numVertices()) return false; 
@@ -248,6 +248,23 @@ namespace embree
       return triangles.isModified(otherVersion); // || numPrimitivesChanged;
     }
 
+    /*! returns the opacity state of the micromask cell of triangle primID containing the barycentric coordinates u and v */
+    __forceinline unsigned int opacityState(size_t primID, float u, float v) const
+    {
+      if (likely(!opacityMicromask)) return RTC_OPACITY_STATE_UNKNOWN;
+
+      /* the 4^level cells are enumerated row by row along v, each row
+       * alternates between lower and upper cells along u */
+      const int n = 1 << opacityMicromaskLevel;
+      const float fu = u*float(n), fv = v*float(n);
+      const int j = clamp(int(fv),0,n-1);
+      const int i = clamp(int(fu),0,n-1-j);
+      const int upper = (i+j < n-1) && (fu-float(i)) + (fv-float(j)) > 1.0f;
+      const unsigned int cell = unsigned(j*(2*n-j) + 2*i + upper);
+      const unsigned int state = (opacityMicromask.getPtr(primID)[cell/4] >> (2*(cell%4))) & 3;
+      return state == 3 ? RTC_OPACITY_STATE_UNKNOWN : state;
+    }
+
     /* returns the projected area */
     __forceinline float projectedPrimitiveArea(const size_t i) const {
       const Triangle& tri = triangle(i);
@@ -262,6 +279,8 @@ namespace embree
     BufferView<Vec3fa> vertices0;        //!< fast access to first vertex buffer
     vector<BufferView<Vec3fa>> vertices; //!< vertex array for each timestep
     vector<RawBufferView> vertexAttribs; //!< vertex attributes
+    RawBufferView opacityMicromask;      //!< optional opacity states of the micromask cells of each triangle
+    unsigned int opacityMicromaskLevel;  //!< subdivision level of the opacity micromasks
   };
 
   namespace isa
@@ -0,0 +1,338 @@
+// Copyright 2009-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "primitive.h"
+#include "../common/context.h"
+
+namespace embree
+{
+  namespace isa
+  {
+    /*! Computes the closest points on M triangles to point p, and
+     *  returns the barycentric coordinates u,v of these points. This
+     *  is a branch free variant of the algorithm in Christer Ericson,
+     *  Real-Time Collision Detection, 5.1.5. */
+    template<int M>
+    __forceinline Vec3vf<M> closestPointTriangle(const Vec3vf<M>& p, const Vec3vf<M>& a, const Vec3vf<M>& b, const Vec3vf<M>& c, vfloat<M>& u, vfloat<M>& v)
+    {
+      const Vec3vf<M> ab = b - a;
+      const Vec3vf<M> ac = c - a;
+      const Vec3vf<M> ap = p - a;
+      const Vec3vf<M> bp = p - b;
+      const Vec3vf<M> cp = p - c;
+
+      const vfloat<M> d1 = dot(ab, ap);
+      const vfloat<M> d2 = dot(ac, ap);
+      const vfloat<M> d3 = dot(ab, bp);
+      const vfloat<M> d4 = dot(ac, bp);
+      const vfloat<M> d5 = dot(ab, cp);
+      const vfloat<M> d6 = dot(ac, cp);
+
+      const vfloat<M> va = d3*d6 - d5*d4;
+      const vfloat<M> vb = d5*d2 - d1*d6;
+      const vfloat<M> vc = d1*d4 - d3*d2;
+
+      /* closest point inside the face */
+      const vfloat<M> denom = rcp(va + vb + vc);
+      u = vb * denom;
+      v = vc * denom;
+
+      /* regions are tested in reverse order, such that the earlier tests take precedence */
+      const vbool<M> regionBC = (va <= 0.0f) & (d4 - d3 >= 0.0f) & (d5 - d6 >= 0.0f);
+      const vfloat<M> w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+      u = select(regionBC, 1.0f - w, u);
+      v = select(regionBC, w, v);
+
+      const vbool<M> regionAC = (vb <= 0.0f) & (d2 >= 0.0f) & (d6 <= 0.0f);
+      u = select(regionAC, vfloat<M>(zero), u);
+      v = select(regionAC, d2 / (d2 - d6), v);
+
+      const vbool<M> regionC = (d6 >= 0.0f) & (d5 <= d6);
+      u = select(regionC, vfloat<M>(zero), u);
+      v = select(regionC, vfloat<M>(one), v);
+
+      const vbool<M> regionAB = (vc <= 0.0f) & (d1 >= 0.0f) & (d3 <= 0.0f);
+      u = select(regionAB, d1 / (d1 - d3), u);
+      v = select(regionAB, vfloat<M>(zero), v);
+
+      const vbool<M> regionB = (d3 >= 0.0f) & (d4 <= d3);
+      u = select(regionB, vfloat<M>(one), u);
+      v = select(regionB, vfloat<M>(zero), v);
+
+      const vbool<M> regionA = (d1 <= 0.0f) & (d2 <= 0.0f);
+      u = select(regionA, vfloat<M>(zero), u);
+      v = select(regionA, vfloat<M>(zero), v);
+
+      return a + u*ab + v*ac;
+    }
+
+    /*! maps the barycentric coordinates of the closest point to the
+     *  coordinates reported to the user */
+    template<int M>
+    struct ClosestPointUVIdentity {
+      __forceinline void operator() (vfloat<M>& u, vfloat<M>& v) const {}
+    };
+
+    /*! transforms M points from instance space into world space */
+    template<int M>
+    __forceinline Vec3vf<M> instanceToWorld(const RTCPointQueryContext* userContext, const Vec3vf<M>& p)
+    {
+      const AffineSpace3fa m = AffineSpace3fa_load_unaligned((AffineSpace3fa*)userContext->inst2world[userContext->instStackSize-1]);
+      auto bcast = [] (const Vec3fa& a) { return Vec3vf<M>(vfloat<M>(a.x), vfloat<M>(a.y), vfloat<M>(a.z)); };
+      const AffineSpace3vf<M> inst2world(LinearSpace3<Vec3vf<M>>(bcast(m.l.vx), bcast(m.l.vy), bcast(m.l.vz)), bcast(m.p));
+      return xfmPoint(inst2world, p);
+    }
+
+    /*! shrinks the query domain to the world space radius of the query */
+    __forceinline void shrinkPointQuery(PointQuery* query, PointQueryContext* context, float radius)
+    {
+      context->query_ws->radius = radius;
+      if (context->userContext->instStackSize > 0)
+      {
+        if (context->query_type == POINT_QUERY_TYPE_AABB) {
+          context->updateAABB();
+        } else {
+          assert(context->similarityScale > 0.f);
+          query->radius = radius * context->similarityScale;
+        }
+      }
+    }
+
+    template<int M>
+    struct ClosestPointM
+    {
+      /*! Finds the closest point to the query on M triangles. The
+       *  closest point is computed in world space, thus also non
+       *  similarity instance transformations are supported. */
+      template<typename UVMapper>
+      static __forceinline bool update(PointQuery* query, PointQueryContext* context, const vbool<M>& valid,
+                                       const Vec3vf<M>& v0_i, const Vec3vf<M>& v1_i, const Vec3vf<M>& v2_i,
+                                       const vuint<M>& geomID, const vuint<M>& primID, const UVMapper& mapUV)
+      {
+        Vec3vf<M> v0 = v0_i, v1 = v1_i, v2 = v2_i;
+        RTCPointQueryContext* userContext = context->userContext;
+        if (unlikely(userContext->instStackSize > 0))
+        {
+          v0 = instanceToWorld<M>(userContext, v0);
+          v1 = instanceToWorld<M>(userContext, v1);
+          v2 = instanceToWorld<M>(userContext, v2);
+        }
+
+        const Vec3vf<M> q(context->query_ws->p);
+        vfloat<M> u, v;
+        const Vec3vf<M> p = closestPointTriangle<M>(q, v0, v1, v2, u, v);
+        const vfloat<M> dist2 = dot(p - q, p - q);
+        const float radius = context->query_ws->radius;
+        const vbool<M> vmask = valid & (dist2 < vfloat<M>(radius*radius));
+        if (none(vmask)) return false;
+
+        const size_t i = select_min(vmask, dist2);
+        mapUV(u, v);
+
+        RTCClosestPointResult* result = context->closestPoint;
+        result->x = p.x[i];
+        result->y = p.y[i];
+        result->z = p.z[i];
+        result->u = u[i];
+        result->v = v[i];
+        result->geomID = geomID[i];
+        result->primID = primID[i];
+        for (unsigned l = 0; l < RTC_MAX_INSTANCE_LEVEL_COUNT; ++l)
+          result->instID[l] = l < userContext->instStackSize ? userContext->instID[l] : RTC_INVALID_GEOMETRY_ID;
+
+        shrinkPointQuery(query, context, sqrt(dist2[i]));
+        return true;
+      }
+
+      template<typename UVMapper>
+      static __forceinline bool update(PointQuery* query, PointQueryContext* context, const vbool<M>& valid,
+                                       const Vec3vf<M>& v0, const Vec3vf<M>& v1, const Vec3vf<M>& v2,
+                                       unsigned int geomID, const vuint<M>& primID, const UVMapper& mapUV) {
+        return update(query, context, valid, v0, v1, v2, vuint<M>(geomID), primID, mapUV);
+      }
+
+      /*! Finds the closest point to the query on M triangles. */
+      template<typename GeomID>
+      static __forceinline bool triangles(PointQuery* query, PointQueryContext* context, const vbool<M>& valid,
+                                          const Vec3vf<M>& v0, const Vec3vf<M>& v1, const Vec3vf<M>& v2,
+                                          const GeomID& geomID, const vuint<M>& primID)
+      {
+        STAT3(point_query.trav_prims,1,1,1);
+        return update(query, context, valid, v0, v1, v2, geomID, primID, ClosestPointUVIdentity<M>());
+      }
+
+      /*! Finds the closest point to the query on M quads, which are
+       *  split into the triangles (v0,v1,v3) and (v2,v3,v1). */
+      template<typename GeomID, typename UVMapper = ClosestPointUVIdentity<M>>
+      static __forceinline bool quads(PointQuery* query, PointQueryContext* context, const vbool<M>& valid,
+                                      const Vec3vf<M>& v0, const Vec3vf<M>& v1, const Vec3vf<M>& v2, const Vec3vf<M>& v3,
+                                      const GeomID& geomID, const vuint<M>& primID, const UVMapper& mapUV = UVMapper())
+      {
+        STAT3(point_query.trav_prims,1,1,1);
+        auto mapUVFlip = [&] (vfloat<M>& u, vfloat<M>& v) { u = 1.0f - u; v = 1.0f - v; mapUV(u,v); };
+        bool changed = update(query, context, valid, v0, v1, v3, geomID, primID, mapUV);
+        changed |= update(query, context, valid, v2, v3, v1, geomID, primID, mapUVFlip);
+        return changed;
+      }
+    };
+
+    template<int M>
+    struct NearestPointsM
+    {
+      /*! Inserts the centers of M points into the nearest points heap
+       *  of the query. Distances are measured in world space and the
+       *  query radius shrinks to the k-th nearest distance once k
+       *  points have been found. */
+      static __forceinline bool points(PointQuery* query, PointQueryContext* context, const vbool<M>& valid,
+                                       const Vec4vf<M>& v, const vuint<M>& geomID, const vuint<M>& primID)
+      {
+        STAT3(point_query.trav_prims,1,1,1);
+        RTCPointQueryContext* userContext = context->userContext;
+        Vec3vf<M> p(v.x, v.y, v.z);
+        if (unlikely(userContext->instStackSize > 0))
+          p = instanceToWorld<M>(userContext, p);
+
+        const Vec3vf<M> q(context->query_ws->p);
+        const vfloat<M> dist2 = dot(p - q, p - q);
+        const float radius = context->query_ws->radius;
+        const vbool<M> vmask = valid & (dist2 <= vfloat<M>(radius*radius));
+        if (none(vmask)) return false;
+
+        NearestPointsHeap* heap = context->nearestPoints;
+        bool changed = false;
+        RTCNearestPoint point;
+        for (unsigned l = 0; l < RTC_MAX_INSTANCE_LEVEL_COUNT; ++l)
+          point.instID[l] = l < userContext->instStackSize ? userContext->instID[l] : RTC_INVALID_GEOMETRY_ID;
+
+        size_t mask = movemask(vmask);
+        while (mask)
+        {
+          const size_t i = bscf(mask);
+          point.distance = sqrt(dist2[i]);
+          point.geomID = geomID[i];
+          point.primID = primID[i];
+          changed |= heap->insert(point);
+        }
+
+        if (changed && heap->full() && heap->maxDistance() < context->query_ws->radius)
+          shrinkPointQuery(query, context, heap->maxDistance());
+        return changed;
+      }
+    };
+
+    template<int M>
+    struct BoxQueryM
+    {
+      /*! Reports the primitives whose world space bounds overlap the
+       *  box of the query. */
+      static __forceinline bool report(PointQueryContext* context, const vbool<M>& valid,
+                                       const Vec3vf<M>& lower, const Vec3vf<M>& upper,
+                                       const vuint<M>& geomID, const vuint<M>& primID)
+      {
+        BoxQueryHits* boxQuery = context->boxQuery;
+        const BBox3fa& box = boxQuery->bounds;
+        const vbool<M> vmask = valid
+          & (lower.x <= vfloat<M>(box.upper.x)) & (upper.x >= vfloat<M>(box.lower.x))
+          & (lower.y <= vfloat<M>(box.upper.y)) & (upper.y >= vfloat<M>(box.lower.y))
+          & (lower.z <= vfloat<M>(box.upper.z)) & (upper.z >= vfloat<M>(box.lower.z));
+
+        size_t mask = movemask(vmask);
+        while (mask) {
+          const size_t i = bscf(mask);
+          boxQuery->insert(geomID[i], primID[i], context->userContext);
+        }
+
+        /* box queries never shrink the query domain */
+        return false;
+      }
+
+      template<typename GeomID>
+      static __forceinline bool triangles(PointQueryContext* context, const vbool<M>& valid,
+                                          const Vec3vf<M>& v0_i, const Vec3vf<M>& v1_i, const Vec3vf<M>& v2_i,
+                                          const GeomID& geomID, const vuint<M>& primID)
+      {
+        STAT3(point_query.trav_prims,1,1,1);
+        Vec3vf<M> v0 = v0_i, v1 = v1_i, v2 = v2_i;
+        if (unlikely(context->userContext->instStackSize > 0))
+        {
+          v0 = instanceToWorld<M>(context->userContext, v0);
+          v1 = instanceToWorld<M>(context->userContext, v1);
+          v2 = instanceToWorld<M>(context->userContext, v2);
+        }
+        return report(context, valid, min(v0,v1,v2), max(v0,v1,v2), vuint<M>(geomID), primID);
+      }
+
+      template<typename GeomID>
+      static __forceinline bool quads(PointQueryContext* context, const vbool<M>& valid,
+                                      const Vec3vf<M>& v0_i, const Vec3vf<M>& v1_i, const Vec3vf<M>& v2_i, const Vec3vf<M>& v3_i,
+                                      const GeomID& geomID, const vuint<M>& primID)
+      {
+        STAT3(point_query.trav_prims,1,1,1);
+        Vec3vf<M> v0 = v0_i, v1 = v1_i, v2 = v2_i, v3 = v3_i;
+        if (unlikely(context->userContext->instStackSize > 0))
+        {
+          v0 = instanceToWorld<M>(context->userContext, v0);
+          v1 = instanceToWorld<M>(context->userContext, v1);
+          v2 = instanceToWorld<M>(context->userContext, v2);
+          v3 = instanceToWorld<M>(context->userContext, v3);
+        }
+        return report(context, valid, min(min(v0,v1),min(v2,v3)), max(max(v0,v1),max(v2,v3)), vuint<M>(geomID), primID);
+      }
+
+      /*! The bounds of the points are transformed as boxes into world space. */
+      static __forceinline bool points(PointQueryContext* context, const vbool<M>& valid,
+                                       const Vec4vf<M>& v, const vuint<M>& geomID, const vuint<M>& primID)
+      {
+        STAT3(point_query.trav_prims,1,1,1);
+        Vec3vf<M> center(v.x, v.y, v.z);
+        Vec3vf<M> half(v.w, v.w, v.w);
+        RTCPointQueryContext* userContext = context->userContext;
+        if (unlikely(userContext->instStackSize > 0))
+        {
+          const AffineSpace3fa m = AffineSpace3fa_load_unaligned((AffineSpace3fa*)userContext->inst2world[userContext->instStackSize-1]);
+          center = instanceToWorld<M>(userContext, center);
+          half = Vec3vf<M>(v.w * abs(m.l.vx.x) + v.w * abs(m.l.vy.x) + v.w * abs(m.l.vz.x),
+                           v.w * abs(m.l.vx.y) + v.w * abs(m.l.vy.y) + v.w * abs(m.l.vz.y),
+                           v.w * abs(m.l.vx.z) + v.w * abs(m.l.vy.z) + v.w * abs(m.l.vz.z));
+        }
+        return report(context, valid, center - half, center + half, geomID, primID);
+      }
+    };
+
+    /*! Dispatches the point queries that are evaluated directly on the
+     *  primitives of the leaves without invoking a callback. */
+    template<int M>
+    struct BuiltinPointQueryM
+    {
+      template<typename GeomID>
+      static __forceinline bool triangles(PointQuery* query, PointQueryContext* context, const vbool<M>& valid,
+                                          const Vec3vf<M>& v0, const Vec3vf<M>& v1, const Vec3vf<M>& v2,
+                                          const GeomID& geomID, const vuint<M>& primID)
+      {
+        if (context->boxQuery)
+          return BoxQueryM<M>::triangles(context, valid, v0, v1, v2, geomID, primID);
+        return ClosestPointM<M>::triangles(query, context, valid, v0, v1, v2, geomID, primID);
+      }
+
+      template<typename GeomID, typename UVMapper = ClosestPointUVIdentity<M>>
+      static __forceinline bool quads(PointQuery* query, PointQueryContext* context, const vbool<M>& valid,
+                                      const Vec3vf<M>& v0, const Vec3vf<M>& v1, const Vec3vf<M>& v2, const Vec3vf<M>& v3,
+                                      const GeomID& geomID, const vuint<M>& primID, const UVMapper& mapUV = UVMapper())
+      {
+        if (context->boxQuery)
+          return BoxQueryM<M>::quads(context, valid, v0, v1, v2, v3, geomID, primID);
+        return ClosestPointM<M>::quads(query, context, valid, v0, v1, v2, v3, geomID, primID, mapUV);
+      }
+
+      static __forceinline bool points(PointQuery* query, PointQueryContext* context, const vbool<M>& valid,
+                                       const Vec4vf<M>& v, const vuint<M>& geomID, const vuint<M>& primID)
+      {
+        if (context->boxQuery)
+          return BoxQueryM<M>::points(context, valid, v, geomID, primID);
+        return NearestPointsM<M>::points(query, context, valid, v, geomID, primID);
+      }
+    };
+  }
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "closest_point.h"
 #include "disc_intersector.h"
 #include "intersector_epilog.h"
 #include "pointi.h"
@@ -42,6 +43,18 @@ namespace embree
         return DiscIntersector1<M>::intersect(
           valid, ray, context, geom, pre, v0, Occluded1EpilogM<M, filter>(ray, context, Disc.geomID(), Disc.primID()));
       }
+
+      static __forceinline bool pointQuery(PointQuery* query,
+                                           PointQueryContext* context,
+                                           const Primitive& Disc)
+      {
+        if (context->nearestPoints || context->boxQuery) {
+          const Points* geom = context->scene->get<Points>(Disc.geomID());
+          Vec4vf<M> v0; Disc.gather(v0, geom);
+          return BuiltinPointQueryM<M>::points(query, context, Disc.valid(), v0, vuint<M>(Disc.geomID()), Disc.primID());
+        }
+        return PrimitivePointQuery1<Primitive>::pointQuery(query, context, Disc);
+      }
     };
 
     template<int M, bool filter>
@@ -75,6 +88,18 @@ namespace embree
         return DiscIntersector1<M>::intersect(
           valid, ray, context, geom, pre, v0, Occluded1EpilogM<M, filter>(ray, context, Disc.geomID(), Disc.primID()));
       }
+
+      static __forceinline bool pointQuery(PointQuery* query,
+                                           PointQueryContext* context,
+                                           const Primitive& Disc)
+      {
+        if (context->nearestPoints || context->boxQuery) {
+          const Points* geom = context->scene->get<Points>(Disc.geomID());
+          Vec4vf<M> v0; Disc.gather(v0, geom, query->time);
+          return BuiltinPointQueryM<M>::points(query, context, Disc.valid(), v0, vuint<M>(Disc.geomID()), Disc.primID());
+        }
+        return PrimitivePointQuery1<Primitive>::pointQuery(query, context, Disc);
+      }
     };
 
     template<int M, int K, bool filter>
@@ -171,6 +196,18 @@ namespace embree
         return DiscIntersector1<M>::intersect(
           valid, ray, context, geom, pre, v0, n0, Occluded1EpilogM<M, filter>(ray, context, Disc.geomID(), Disc.primID()));
       }
+
+      static __forceinline bool pointQuery(PointQuery* query,
+                                           PointQueryContext* context,
+                                           const Primitive& Disc)
+      {
+        if (context->nearestPoints || context->boxQuery) {
+          const Points* geom = context->scene->get<Points>(Disc.geomID());
+          Vec4vf<M> v0; Disc.gather(v0, geom);
+          return BuiltinPointQueryM<M>::points(query, context, Disc.valid(), v0, vuint<M>(Disc.geomID()), Disc.primID());
+        }
+        return PrimitivePointQuery1<Primitive>::pointQuery(query, context, Disc);
+      }
     };
 
     template<int M, bool filter>
@@ -206,6 +243,18 @@ namespace embree
         return DiscIntersector1<M>::intersect(
           valid, ray, context, geom, pre, v0, n0, Occluded1EpilogM<M, filter>(ray, context, Disc.geomID(), Disc.primID()));
       }
+
+      static __forceinline bool pointQuery(PointQuery* query,
+                                           PointQueryContext* context,
+                                           const Primitive& Disc)
+      {
+        if (context->nearestPoints || context->boxQuery) {
+          const Points* geom = context->scene->get<Points>(Disc.geomID());
+          Vec4vf<M> v0; Disc.gather(v0, geom, query->time);
+          return BuiltinPointQueryM<M>::points(query, context, Disc.valid(), v0, vuint<M>(Disc.geomID()), Disc.primID());
+        }
+        return PrimitivePointQuery1<Primitive>::pointQuery(query, context, Disc);
+      }
     };
 
     template<int M, int K, bool filter>
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "../common/geometry.h"
+#include "../common/scene_triangle_mesh.h"
 #include "../common/ray.h"
 #include "../common/hit.h"
 #include "../common/context.h"
@@ -12,9 +13,36 @@ namespace embree
 {
   namespace isa
   {
-    __forceinline bool runIntersectionFilter1Helper(RTCFilterFunctionNArguments* args, const Geometry* const geometry, IntersectContext* context)
+    /* returns the state of the opacity micromask cell that contains the hit */
+    __forceinline unsigned int opacityState(const Geometry* const geometry, unsigned int primID, float u, float v)
     {
-      if (geometry->intersectionFilterN)
+      if (likely(geometry->getType() != Geometry::GTY_TRIANGLE_MESH)) return RTC_OPACITY_STATE_UNKNOWN;
+      return ((const TriangleMesh*)geometry)->opacityState(primID,u,v);
+    }
+
+    /* classifies the valid hits by the opacity micromask, transparent hits
+     * get removed from valid, opaque hits get returned */
+    template<int K>
+    __forceinline vbool<K> opacityStates(vbool<K>& valid, const Geometry* const geometry, const HitK<K>& hit)
+    {
+      vbool<K> opaque(false);
+      if (likely(geometry->getType() != Geometry::GTY_TRIANGLE_MESH)) return opaque;
+      const TriangleMesh* mesh = (const TriangleMesh*) geometry;
+      if (likely(!mesh->opacityMicromask)) return opaque;
+
+      for (size_t m=movemask(valid); m!=0; )
+      {
+        const size_t i = bscf(m);
+        const unsigned int state = mesh->opacityState(hit.primID[i],hit.u[i],hit.v[i]);
+        if (state == RTC_OPACITY_STATE_TRANSPARENT) clear(valid,i);
+        else if (state == RTC_OPACITY_STATE_OPAQUE) set(opaque,i);
+      }
+      return opaque;
+    }
+
+    __forceinline bool runIntersectionFilter1Helper(RTCFilterFunctionNArguments* args, const Geometry* const geometry, IntersectContext* context, bool opaque = false)
+    {
+      if (geometry->intersectionFilterN && !opaque)
       {
         assert(context->scene->hasGeometryFilterFunction());
         geometry->intersectionFilterN(args);
@@ -37,6 +65,10 @@ namespace embree
     
     __forceinline bool runIntersectionFilter1(const Geometry* const geometry, RayHit& ray, IntersectContext* context, Hit& hit)
     {
+      const unsigned int state = opacityState(geometry,hit.primID,hit.u,hit.v);
+      if (state == RTC_OPACITY_STATE_TRANSPARENT)
+        return false;
+
       RTCFilterFunctionNArguments args;
       int mask = -1;
       args.valid = &mask;
@@ -45,7 +77,7 @@ namespace embree
       args.ray = (RTCRayN*)&ray;
       args.hit = (RTCHitN*)&hit;
       args.N = 1;
-      return runIntersectionFilter1Helper(&args,geometry,context);
+      return runIntersectionFilter1Helper(&args,geometry,context,state == RTC_OPACITY_STATE_OPAQUE);
     }
 
     __forceinline void reportIntersection1(IntersectFunctionNArguments* args, const RTCFilterFunctionNArguments* filter_args)
@@ -59,9 +91,9 @@ namespace embree
 #endif
     }
     
-    __forceinline bool runOcclusionFilter1Helper(RTCFilterFunctionNArguments* args, const Geometry* const geometry, IntersectContext* context)
+    __forceinline bool runOcclusionFilter1Helper(RTCFilterFunctionNArguments* args, const Geometry* const geometry, IntersectContext* context, bool opaque = false)
     {
-      if (geometry->occlusionFilterN)
+      if (geometry->occlusionFilterN && !opaque)
       {
         assert(context->scene->hasGeometryFilterFunction());
         geometry->occlusionFilterN(args);
@@ -82,6 +114,10 @@ namespace embree
 
     __forceinline bool runOcclusionFilter1(const Geometry* const geometry, Ray& ray, IntersectContext* context, Hit& hit)
     {
+      const unsigned int state = opacityState(geometry,hit.primID,hit.u,hit.v);
+      if (state == RTC_OPACITY_STATE_TRANSPARENT)
+        return false;
+
       RTCFilterFunctionNArguments args;
       int mask = -1;
       args.valid = &mask;
@@ -90,7 +126,7 @@ namespace embree
       args.ray = (RTCRayN*)&ray;
       args.hit = (RTCHitN*)&hit;
       args.N = 1;
-      return runOcclusionFilter1Helper(&args,geometry,context);
+      return runOcclusionFilter1Helper(&args,geometry,context,state == RTC_OPACITY_STATE_OPAQUE);
     }
 
     __forceinline void reportOcclusion1(OccludedFunctionNArguments* args, const RTCFilterFunctionNArguments* filter_args)
@@ -105,13 +141,16 @@ namespace embree
     }
 
     template<int K>
-      __forceinline vbool<K> runIntersectionFilterHelper(RTCFilterFunctionNArguments* args, const Geometry* const geometry, IntersectContext* context)
+      __forceinline vbool<K> runIntersectionFilterHelper(RTCFilterFunctionNArguments* args, const Geometry* const geometry, IntersectContext* context, const vbool<K>& opaque)
     {
       vint<K>* mask = (vint<K>*) args->valid;
-      if (geometry->intersectionFilterN)
+      if (geometry->intersectionFilterN && !all(opaque | (*mask == vint<K>(zero))))
       {
         assert(context->scene->hasGeometryFilterFunction());
+        const vint<K> opaque_mask = select(opaque,*mask,vint<K>(zero));
+        *mask = select(opaque,vint<K>(zero),*mask);
         geometry->intersectionFilterN(args);
+        *mask |= opaque_mask;
       }
 
       vbool<K> valid_o = *mask != vint<K>(zero);
@@ -130,8 +169,12 @@ namespace embree
     }
     
     template<int K>
-    __forceinline vbool<K> runIntersectionFilter(const vbool<K>& valid, const Geometry* const geometry, RayHitK<K>& ray, IntersectContext* context, HitK<K>& hit)
+    __forceinline vbool<K> runIntersectionFilter(const vbool<K>& valid_i, const Geometry* const geometry, RayHitK<K>& ray, IntersectContext* context, HitK<K>& hit)
     {
+      vbool<K> valid = valid_i;
+      const vbool<K> opaque = opacityStates(valid,geometry,hit);
+      if (none(valid)) return valid;
+
       RTCFilterFunctionNArguments args;
       vint<K> mask = valid.mask32();
       args.valid = (int*)&mask;
@@ -140,17 +183,20 @@ namespace embree
       args.ray = (RTCRayN*)&ray;
       args.hit = (RTCHitN*)&hit;
       args.N = K;
-      return runIntersectionFilterHelper<K>(&args,geometry,context);
+      return runIntersectionFilterHelper<K>(&args,geometry,context,opaque);
     }
 
     template<int K>
-      __forceinline vbool<K> runOcclusionFilterHelper(RTCFilterFunctionNArguments* args, const Geometry* const geometry, IntersectContext* context)
+      __forceinline vbool<K> runOcclusionFilterHelper(RTCFilterFunctionNArguments* args, const Geometry* const geometry, IntersectContext* context, const vbool<K>& opaque)
     {
       vint<K>* mask = (vint<K>*) args->valid;
-      if (geometry->occlusionFilterN)
+      if (geometry->occlusionFilterN && !all(opaque | (*mask == vint<K>(zero))))
       {
         assert(context->scene->hasGeometryFilterFunction());
+        const vint<K> opaque_mask = select(opaque,*mask,vint<K>(zero));
+        *mask = select(opaque,vint<K>(zero),*mask);
         geometry->occlusionFilterN(args);
+        *mask |= opaque_mask;
       }
 
       vbool<K> valid_o = *mask != vint<K>(zero);
@@ -170,8 +216,12 @@ namespace embree
     }
 
     template<int K>
-      __forceinline vbool<K> runOcclusionFilter(const vbool<K>& valid, const Geometry* const geometry, RayK<K>& ray, IntersectContext* context, HitK<K>& hit)
+      __forceinline vbool<K> runOcclusionFilter(const vbool<K>& valid_i, const Geometry* const geometry, RayK<K>& ray, IntersectContext* context, HitK<K>& hit)
     {
+      vbool<K> valid = valid_i;
+      const vbool<K> opaque = opacityStates(valid,geometry,hit);
+      if (none(valid)) return valid;
+
       RTCFilterFunctionNArguments args;
       vint<K> mask = valid.mask32();
       args.valid = (int*)&mask;
@@ -180,7 +230,7 @@ namespace embree
       args.ray = (RTCRayN*)&ray;
       args.hit = (RTCHitN*)&hit;
       args.N = K;
-      return runOcclusionFilterHelper<K>(&args,geometry,context);
+      return runOcclusionFilterHelper<K>(&args,geometry,context,opaque);
     }
   }
 }
@@ -12,7 +12,7 @@ namespace embree
                      const SubdivMesh* const geom, const size_t gridOffset, const size_t gridBytes, BBox3fa* bounds_o)
       : troot(BVH4::emptyNode),
         time_steps(time_steps), width(x1-x0+1), height(y1-y0+1), dim_offset(width*height),
-        _geomID(patches->geomID()), _primID(patches->primID()), 
+        _geomID(patches->geomID()), _primID(patches->primID()), compressed(0),
         gridOffset(unsigned(gridOffset)), gridBytes(unsigned(gridBytes)), rootOffset(unsigned(gridOffset+time_steps*gridBytes))
     {
       /* the generate loops need padded arrays, thus first store into these temporary arrays */
@@ -32,11 +32,7 @@ namespace embree
                  local_grid_x,local_grid_y,local_grid_z,local_grid_u,local_grid_v,geom);
         
         /* encode UVs */
-        for (unsigned i=0; i<dim_offset; i+=VSIZEX) {
-          const vintx iu = (vintx) clamp(vfloatx::load(&local_grid_u[i])*(0x10000/8.0f), vfloatx(0.0f), vfloatx(0xFFFF));
-          const vintx iv = (vintx) clamp(vfloatx::load(&local_grid_v[i])*(0x10000/8.0f), vfloatx(0.0f), vfloatx(0xFFFF));
-          vintx::storeu(&local_grid_uv[i], (iv << 16) | iu);
-        }
+        encodeUVs(local_grid_u,local_grid_v,local_grid_uv);
 
         /* copy temporary data to compact grid */
         float* const grid_x  = (float*)(gridData(t) + 0*dim_offset);
@@ -68,6 +64,94 @@ namespace embree
       }
     }
 
+    GridSOA::GridSOA(const SubdivPatch1Base* patch, const unsigned x0, const unsigned x1, const unsigned y0, const unsigned y1,
+                     const size_t gridOffset, const size_t gridBytes,
+                     const float* grid_x, const float* grid_y, const float* grid_z, const float* grid_u, const float* grid_v,
+                     const Quantization* quantization, BBox3fa* bounds_o)
+      : troot(BVH4::emptyNode),
+        time_steps(1), width(x1-x0+1), height(y1-y0+1), dim_offset(width*height),
+        _geomID(patch->geomID()), _primID(patch->primID()), compressed(quantization != nullptr),
+        gridOffset(unsigned(gridOffset)), gridBytes(unsigned(gridBytes)), rootOffset(unsigned(gridOffset+gridBytes))
+    {
+      unsigned temp_size = width*height+VSIZEX;
+      dynamic_large_stack_array(int,local_grid_uv,temp_size,32*32*sizeof(int));
+      encodeUVs(grid_u,grid_v,local_grid_uv);
+
+      if (quantization)
+      {
+        char* const ptr = (char*) gridData(0);
+        *(Quantization*) ptr = *quantization;
+        int* const qgrid_uv = (int*) (ptr + sizeof(Quantization));
+        unsigned short* const qgrid_x = (unsigned short*) (qgrid_uv + dim_offset);
+        unsigned short* const qgrid_y = qgrid_x + dim_offset;
+        unsigned short* const qgrid_z = qgrid_y + dim_offset;
+        
+        for (size_t i=0; i<dim_offset; i++)
+        {
+          qgrid_uv[i] = local_grid_uv[i];
+          qgrid_x[i] = (unsigned short) (quantization->quantize(grid_x[i]) - quantization->base[0]);
+          qgrid_y[i] = (unsigned short) (quantization->quantize(grid_y[i]) - quantization->base[1]);
+          qgrid_z[i] = (unsigned short) (quantization->quantize(grid_z[i]) - quantization->base[2]);
+        }
+
+        /* clear the padding read by the 16 byte loads of the last vertices */
+        char* const end = (char*) (qgrid_z + dim_offset);
+        memset(end,0,ptr+gridBytes-end);
+      }
+      else
+      {
+        float* const fgrid_x  = (float*)(gridData(0) + 0*dim_offset);
+        float* const fgrid_y  = (float*)(gridData(0) + 1*dim_offset);
+        float* const fgrid_z  = (float*)(gridData(0) + 2*dim_offset);
+        int  * const fgrid_uv = (int*  )(gridData(0) + 3*dim_offset);
+
+        for (size_t i=0; i<dim_offset; i++)
+        {
+          fgrid_x[i]  = grid_x[i];
+          fgrid_y[i]  = grid_y[i];
+          fgrid_z[i]  = grid_z[i];
+          fgrid_uv[i] = local_grid_uv[i];
+        }
+      }
+
+      root(0) = buildBVH(bounds_o).first;
+    }
+
+    void GridSOA::encodeUVs(const float* grid_u, const float* grid_v, int* grid_uv) const
+    {
+      for (unsigned i=0; i<dim_offset; i+=VSIZEX) {
+        const vintx iu = (vintx) clamp(vfloatx::load(&grid_u[i])*(0x10000/8.0f), vfloatx(0.0f), vfloatx(0xFFFF));
+        const vintx iv = (vintx) clamp(vfloatx::load(&grid_v[i])*(0x10000/8.0f), vfloatx(0.0f), vfloatx(0xFFFF));
+        vintx::storeu(&grid_uv[i], (iv << 16) | iu);
+      }
+    }
+
+    bool GridSOA::Quantization::init(const float step, const float* x, const float* y, const float* z, const size_t N)
+    {
+      if (step == 0.0f) return false;
+      this->step = step;
+      rcp_step = 1.0f/step;
+      align[0] = align[1] = align[2] = 0;
+
+      /* the lattice coordinates have to be exactly representable as floats and their offsets have to fit into 16 bits */
+      const float* planes[3] = { x, y, z };
+      for (size_t d=0; d<3; d++)
+      {
+        int lower = pos_inf, upper = neg_inf;
+        for (size_t i=0; i<N; i++)
+        {
+          const float v = planes[d][i];
+          if (!(abs(v)*rcp_step < float(1 << 23))) return false;
+          const int q = quantize(v);
+          lower = min(lower,q);
+          upper = max(upper,q);
+        }
+        if (upper-lower > 0xFFFF) return false;
+        base[d] = lower;
+      }
+      return true;
+    }
+
     size_t GridSOA::getBVHBytes(const GridRange& range, const size_t nodeBytes, const size_t leafBytes)
     {
       if (range.hasLeafSize()) 
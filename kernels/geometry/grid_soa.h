@@ -18,11 +18,88 @@ namespace embree
     {
     public:
 
+      /*! Compressed grids store the positions as 16 bit offsets to a
+       *  base point on a lattice shared by all grids of the mesh. As
+       *  equal positions map to equal lattice points, grids that share
+       *  an edge stay watertight. The quantization is stored in front
+       *  of the UV, x, y, and z planes of the grid. */
+      struct Quantization
+      {
+        /*! calculates the base point, returns false if the grid cannot be stored compressed */
+        bool init(const float step, const float* x, const float* y, const float* z, const size_t N);
+
+        /*! returns the lattice coordinate of a position */
+        __forceinline int quantize(const float v) const {
+          return (int) floorf(v*rcp_step + 0.5f);
+        }
+
+        int base[3];  //!< lattice coordinates of the base point
+        float step;   //!< power of two spacing of the lattice
+        float rcp_step;
+        unsigned align[3];
+      };
+
+      /*! vertex planes of a leaf, compressed leaves get decoded into the local block */
+      struct Leaf
+      {
+        enum { LINE_OFFSET = 4, DIM_OFFSET = 3*LINE_OFFSET };
+
+        __forceinline Leaf (GridSOA* grid, size_t t, const void* ptr)
+        {
+          if (likely(!grid->compressed)) {
+            grid_x = grid->decodeLeaf(t,ptr);
+            line_offset = grid->width;
+            dim_offset = grid->dim_offset;
+          } else {
+            grid->decodeCompressedLeaf(ptr,block);
+            grid_x = block;
+            line_offset = LINE_OFFSET;
+            dim_offset = DIM_OFFSET;
+          }
+        }
+
+        const float* grid_x;
+        size_t line_offset;
+        size_t dim_offset;
+        __aligned(16) float block[4*DIM_OFFSET];
+      };
+
       /*! GridSOA constructor */
       GridSOA(const SubdivPatch1Base* patches, const unsigned time_steps,
               const unsigned x0, const unsigned x1, const unsigned y0, const unsigned y1, const unsigned swidth, const unsigned sheight,
               const SubdivMesh* const geom, const size_t totalBvhBytes, const size_t gridBytes, BBox3fa* bounds_o = nullptr);
 
+      /*! GridSOA constructor for a single time step of already evaluated vertices, stores the grid compressed if a quantization is passed */
+      GridSOA(const SubdivPatch1Base* patch, const unsigned x0, const unsigned x1, const unsigned y0, const unsigned y1,
+              const size_t gridOffset, const size_t gridBytes,
+              const float* grid_x, const float* grid_y, const float* grid_z, const float* grid_u, const float* grid_v,
+              const Quantization* quantization, BBox3fa* bounds_o = nullptr);
+
+      /*! evaluates a single time step grid into temporary arrays, and passes them together with the quantization to the closure */
+      template<typename Closure>
+        static __forceinline GridSOA* evalCompressed(const SubdivPatch1Base* patch, unsigned x0, unsigned x1, unsigned y0, unsigned y1,
+                                                     const SubdivMesh* geom, const Closure& closure)
+      {
+        const unsigned N = (x1-x0+1)*(y1-y0+1);
+        const unsigned temp_size = N+VSIZEX;
+        dynamic_large_stack_array(float,local_grid_u,temp_size,32*32*sizeof(float));
+        dynamic_large_stack_array(float,local_grid_v,temp_size,32*32*sizeof(float));
+        dynamic_large_stack_array(float,local_grid_x,temp_size,32*32*sizeof(float));
+        dynamic_large_stack_array(float,local_grid_y,temp_size,32*32*sizeof(float));
+        dynamic_large_stack_array(float,local_grid_z,temp_size,32*32*sizeof(float));
+        evalGrid(*patch,x0,x1,y0,y1,patch->grid_u_res,patch->grid_v_res,
+                 local_grid_x,local_grid_y,local_grid_z,local_grid_u,local_grid_v,geom);
+
+        Quantization quantization;
+        const bool compress = quantization.init(geom->getGridQuantizationStep(),local_grid_x,local_grid_y,local_grid_z,N);
+        return closure(compress ? &quantization : nullptr,local_grid_x,local_grid_y,local_grid_z,local_grid_u,local_grid_v);
+      }
+
+      /*! returns the size of the planes of a compressed grid, including padding for the 16 byte loads of the last vertices */
+      static __forceinline size_t getCompressedGridBytes(size_t N) {
+        return (sizeof(Quantization) + N*sizeof(int) + 3*N*sizeof(unsigned short) + 16 + 7) & ~size_t(7);
+      }
+
       /*! Subgrid creation */
       template<typename Allocator>
         static GridSOA* create(const SubdivPatch1Base* patches, const unsigned time_steps,
@@ -44,9 +121,23 @@ namespace embree
 #if !defined(__64BIT__)
         rootBytes += 4; // We read 2 elements behind the grid. As we store at least 8 root bytes after the grid we are fine in 64 bit mode. But in 32 bit mode we have to do additional padding.
 #endif
+
+        /* compact scenes store static grids compressed when the positions fit into 16 bit offsets */
+        const SubdivMesh* geom = scene->get<SubdivMesh>(patches->geomID());
+        if (time_steps == 1 && scene->isCompactAccel() && geom->getGridQuantizationStep() != 0.0f)
+        {
+          return evalCompressed(patches,x0,x1,y0,y1,geom,[&] (const Quantization* quantization, const float* grid_x, const float* grid_y, const float* grid_z, const float* grid_u, const float* grid_v) -> GridSOA*
+          {
+            const size_t bytes = quantization ? getCompressedGridBytes(size_t(width)*size_t(height)) : gridBytes;
+            void* data = alloc(offsetof(GridSOA,data)+bvhBytes+bytes+rootBytes);
+            assert(data);
+            return new (data) GridSOA(patches,x0,x1,y0,y1,bvhBytes,bytes,grid_x,grid_y,grid_z,grid_u,grid_v,quantization,bounds_o);
+          });
+        }
+        
         void* data = alloc(offsetof(GridSOA,data)+bvhBytes+time_steps*gridBytes+rootBytes);
         assert(data);
-        return new (data) GridSOA(patches,time_steps,x0,x1,y0,y1,patches->grid_u_res,patches->grid_v_res,scene->get<SubdivMesh>(patches->geomID()),bvhBytes,gridBytes,bounds_o);
+        return new (data) GridSOA(patches,time_steps,x0,x1,y0,y1,patches->grid_u_res,patches->grid_v_res,geom,bvhBytes,gridBytes,bounds_o);
       }
 
       /*! Grid creation */
@@ -57,6 +148,28 @@ namespace embree
         return create(patches,time_steps,0,patches->grid_u_res-1,0,patches->grid_v_res-1,scene,alloc,bounds_o);
       }
 
+      /*! Reevaluates a subgrid in place, the size of the subgrid has to be unchanged, returns nullptr if a compressed grid does not fit anymore */
+      static GridSOA* update(GridSOA* grid, const SubdivPatch1Base* patches, const unsigned time_steps,
+                             unsigned x0, unsigned x1, unsigned y0, unsigned y1,
+                             const Scene* scene, BBox3fa* bounds_o = nullptr)
+      {
+        assert(grid->time_steps == time_steps);
+        assert(grid->width == x1-x0+1 && grid->height == y1-y0+1);
+        const size_t bvhBytes = grid->gridOffset;
+        const size_t gridBytes = grid->gridBytes;
+        const SubdivMesh* geom = scene->get<SubdivMesh>(patches->geomID());
+
+        if (unlikely(grid->compressed))
+        {
+          return evalCompressed(patches,x0,x1,y0,y1,geom,[&] (const Quantization* quantization, const float* grid_x, const float* grid_y, const float* grid_z, const float* grid_u, const float* grid_v) -> GridSOA*
+          {
+            if (!quantization) return nullptr;
+            return new (grid) GridSOA(patches,x0,x1,y0,y1,bvhBytes,gridBytes,grid_x,grid_y,grid_z,grid_u,grid_v,quantization,bounds_o);
+          });
+        }
+        return new (grid) GridSOA(patches,time_steps,x0,x1,y0,y1,patches->grid_u_res,patches->grid_v_res,geom,bvhBytes,gridBytes,bounds_o);
+      }
+
        /*! returns reference to root */
       __forceinline       BVH4::NodeRef& root(size_t t = 0)       { return (BVH4::NodeRef&)data[rootOffset + t*sizeof(BVH4::NodeRef)]; }
       __forceinline const BVH4::NodeRef& root(size_t t = 0) const { return (BVH4::NodeRef&)data[rootOffset + t*sizeof(BVH4::NodeRef)]; }
@@ -76,6 +189,54 @@ namespace embree
         return gridData(t) + (((size_t) (ptr) >> 4) - 1);
       }
 
+      /*! returns the quantization and the planes of a compressed grid */
+      __forceinline const Quantization& quantization() const { return *(const Quantization*) gridData(0); }
+      __forceinline const int* compressedUV() const { return (const int*) ((const char*) gridData(0) + sizeof(Quantization)); }
+      __forceinline const unsigned short* compressedX() const { return (const unsigned short*) (compressedUV() + dim_offset); }
+      __forceinline const unsigned short* compressedY() const { return compressedX() + dim_offset; }
+      __forceinline const unsigned short* compressedZ() const { return compressedY() + dim_offset; }
+
+      /*! decodes vertex i of a compressed grid */
+      __forceinline Vec3fa decodeVertex(size_t i) const
+      {
+        const Quantization& q = quantization();
+        return Vec3fa(float(q.base[0]+int(compressedX()[i]))*q.step,
+                      float(q.base[1]+int(compressedY()[i]))*q.step,
+                      float(q.base[2]+int(compressedZ()[i]))*q.step);
+      }
+
+      /*! decodes the 3x3 vertices of a leaf of a compressed grid into 4 planes of 3 lines of 4 floats, lines and columns outside the grid repeat the last one */
+      __forceinline void decodeCompressedLeaf(const void* ptr, float* __restrict__ block) const
+      {
+        const Quantization& q = quantization();
+        const vint4 base_x(q.base[0]), base_y(q.base[1]), base_z(q.base[2]);
+        const vfloat4 step(q.step);
+        const size_t ofs = ((size_t) (ptr) >> 4) - 1;
+
+        for (size_t l=0; l<3; l++)
+        {
+          const size_t i = ofs + min(l,size_t(height-1))*width;
+          vfloat4 x  = vfloat4(vint4::load(compressedX()+i) + base_x) * step;
+          vfloat4 y  = vfloat4(vint4::load(compressedY()+i) + base_y) * step;
+          vfloat4 z  = vfloat4(vint4::load(compressedZ()+i) + base_z) * step;
+          vfloat4 uv = vfloat4::loadu((const float*) compressedUV()+i);
+          if (unlikely(width == 2))
+          {
+            x  = shuffle<0,1,1,1>(x);
+            y  = shuffle<0,1,1,1>(y);
+            z  = shuffle<0,1,1,1>(z);
+            uv = shuffle<0,1,1,1>(uv);
+          }
+          vfloat4::store(&block[0*Leaf::DIM_OFFSET + l*Leaf::LINE_OFFSET],x);
+          vfloat4::store(&block[1*Leaf::DIM_OFFSET + l*Leaf::LINE_OFFSET],y);
+          vfloat4::store(&block[2*Leaf::DIM_OFFSET + l*Leaf::LINE_OFFSET],z);
+          vfloat4::store(&block[3*Leaf::DIM_OFFSET + l*Leaf::LINE_OFFSET],uv);
+        }
+      }
+
+      /*! encodes the UVs of the grid, the input arrays have to be padded to the SIMD width */
+      void encodeUVs(const float* grid_u, const float* grid_v, int* grid_uv) const;
+
       /*! returns the size of the BVH over the grid in bytes */
       static size_t getBVHBytes(const GridRange& range, const size_t nodeBytes, const size_t leafBytes);
 
@@ -85,6 +246,15 @@ namespace embree
       /*! calculates bounding box of grid range */
       __forceinline BBox3fa calculateBounds(size_t time, const GridRange& range) const
       {
+        if (unlikely(compressed))
+        {
+          BBox3fa bounds( empty );
+          for (unsigned v = range.v_start; v<=range.v_end; v++) 
+            for (unsigned u = range.u_start; u<=range.u_end; u++)
+              bounds.extend(decodeVertex(v * width + u));
+          return bounds;
+        }
+        
         const float* const grid_array = gridData(time);
         const float* const grid_x_array = grid_array + 0 * dim_offset;
         const float* const grid_y_array = grid_array + 1 * dim_offset;
@@ -106,6 +276,14 @@ namespace embree
         return bounds;
       }
 
+      /*! returns the bounds of the grid of the first time step */
+      __forceinline BBox3fa bounds() const
+      {
+        const BVH4::NodeRef ref = root(0);
+        if (ref.isAABBNode()) return ref.getAABBNode()->bounds();
+        return calculateBounds(0,GridRange(0,width-1,0,height-1));
+      }
+
       /*! Evaluates grid over patch and builds BVH4 tree over the grid. */
       std::pair<BVH4::NodeRef,BBox3fa> buildBVH(BBox3fa* bounds_o);
       
@@ -264,7 +442,7 @@ namespace embree
       unsigned _geomID;
       unsigned _primID;
 
-      unsigned align2;
+      unsigned compressed;
       unsigned gridOffset;
       unsigned gridBytes;
       unsigned rootOffset;
@@ -81,9 +81,10 @@ namespace embree
       /*! Intersect a ray with the primitive. */
       static __forceinline void intersect(const vbool<K>& valid_i, Precalculations& pre, RayHitK<K>& ray, IntersectContext* context, const Primitive* prim, size_t& lazy_node)
       {
-        const size_t dim_offset    = pre.grid->dim_offset;
-        const size_t line_offset   = pre.grid->width;
-        const float* const grid_x  = pre.grid->decodeLeaf(0,prim);
+        const GridSOA::Leaf leaf(pre.grid,0,prim);
+        const size_t dim_offset    = leaf.dim_offset;
+        const size_t line_offset   = leaf.line_offset;
+        const float* const grid_x  = leaf.grid_x;
         const float* const grid_y  = grid_x + 1 * dim_offset;
         const float* const grid_z  = grid_x + 2 * dim_offset;
         const float* const grid_uv = grid_x + 3 * dim_offset;
@@ -112,9 +113,10 @@ namespace embree
       /*! Test if the ray is occluded by the primitive */
       static __forceinline vbool<K> occluded(const vbool<K>& valid_i, Precalculations& pre, RayK<K>& ray, IntersectContext* context, const Primitive* prim, size_t& lazy_node)
       {
-        const size_t dim_offset    = pre.grid->dim_offset;
-        const size_t line_offset   = pre.grid->width;
-        const float* const grid_x  = pre.grid->decodeLeaf(0,prim);
+        const GridSOA::Leaf leaf(pre.grid,0,prim);
+        const size_t dim_offset    = leaf.dim_offset;
+        const size_t line_offset   = leaf.line_offset;
+        const float* const grid_x  = leaf.grid_x;
         const float* const grid_y  = grid_x + 1 * dim_offset;
         const float* const grid_z  = grid_x + 2 * dim_offset;
         const float* const grid_uv = grid_x + 3 * dim_offset;
@@ -150,10 +152,10 @@ namespace embree
                                             const float* const grid_x,
                                             const size_t line_offset,
                                             const size_t lines,
+                                            const size_t dim_offset,
                                             Precalculations& pre)
       {
         typedef typename Loader::vfloat vfloat;
-        const size_t dim_offset    = pre.grid->dim_offset;
         const float* const grid_y  = grid_x + 1 * dim_offset;
         const float* const grid_z  = grid_x + 2 * dim_offset;
         const float* const grid_uv = grid_x + 3 * dim_offset;
@@ -167,10 +169,10 @@ namespace embree
                                            const float* const grid_x,
                                            const size_t line_offset,
                                            const size_t lines,
+                                           const size_t dim_offset,
                                            Precalculations& pre)
       {
         typedef typename Loader::vfloat vfloat;
-        const size_t dim_offset    = pre.grid->dim_offset;
         const float* const grid_y  = grid_x + 1 * dim_offset;
         const float* const grid_z  = grid_x + 2 * dim_offset;
         const float* const grid_uv = grid_x + 3 * dim_offset;
@@ -181,31 +183,35 @@ namespace embree
       /*! Intersect a ray with the primitive. */
       static __forceinline void intersect(Precalculations& pre, RayHitK<K>& ray, size_t k, IntersectContext* context, const Primitive* prim, size_t& lazy_node)
       {
-        const size_t line_offset   = pre.grid->width;
+        const GridSOA::Leaf leaf(pre.grid,0,prim);
+        const size_t line_offset   = leaf.line_offset;
         const size_t lines         = pre.grid->height;
-        const float* const grid_x  = pre.grid->decodeLeaf(0,prim);
+        const size_t dim_offset    = leaf.dim_offset;
+        const float* const grid_x  = leaf.grid_x;
 #if defined(__AVX__)
-        intersect<GridSOA::Gather3x3>( ray, k, context, grid_x, line_offset, lines, pre);
+        intersect<GridSOA::Gather3x3>( ray, k, context, grid_x, line_offset, lines, dim_offset, pre);
 #else
-        intersect<GridSOA::Gather2x3>(ray, k, context, grid_x            , line_offset, lines, pre);
+        intersect<GridSOA::Gather2x3>(ray, k, context, grid_x            , line_offset, lines, dim_offset, pre);
         if (likely(lines > 2))
-          intersect<GridSOA::Gather2x3>(ray, k, context, grid_x+line_offset, line_offset, lines, pre);
+          intersect<GridSOA::Gather2x3>(ray, k, context, grid_x+line_offset, line_offset, lines, dim_offset, pre);
 #endif
       }
 
       /*! Test if the ray is occluded by the primitive */
       static __forceinline bool occluded(Precalculations& pre, RayK<K>& ray, size_t k, IntersectContext* context, const Primitive* prim, size_t& lazy_node)
       {
-        const size_t line_offset   = pre.grid->width;
+        const GridSOA::Leaf leaf(pre.grid,0,prim);
+        const size_t line_offset   = leaf.line_offset;
         const size_t lines         = pre.grid->height;
-        const float* const grid_x  = pre.grid->decodeLeaf(0,prim);
+        const size_t dim_offset    = leaf.dim_offset;
+        const float* const grid_x  = leaf.grid_x;
 
 #if defined(__AVX__)
-        return occluded<GridSOA::Gather3x3>( ray, k, context, grid_x, line_offset, lines, pre);
+        return occluded<GridSOA::Gather3x3>( ray, k, context, grid_x, line_offset, lines, dim_offset, pre);
 #else
-        if (occluded<GridSOA::Gather2x3>(ray, k, context, grid_x            , line_offset, lines, pre)) return true;
+        if (occluded<GridSOA::Gather2x3>(ray, k, context, grid_x            , line_offset, lines, dim_offset, pre)) return true;
         if (likely(lines > 2))
-          if (occluded<GridSOA::Gather2x3>(ray, k, context, grid_x+line_offset, line_offset, lines, pre)) return true;
+          if (occluded<GridSOA::Gather2x3>(ray, k, context, grid_x+line_offset, line_offset, lines, dim_offset, pre)) return true;
 #endif
         return false;
       }
@@ -125,6 +125,10 @@ namespace embree
           context->userContext,
           similarityScale,
           context->userPtr); 
+        context_inst.closestPoint = context->closestPoint;
+        context_inst.nearestPoints = context->nearestPoints;
+        context_inst.boxQuery = context->boxQuery;
+        if (context->boxQuery) context_inst.updateAABB();
 
         bool changed = instance->object->intersectors.pointQuery(&query_inst, &context_inst);
         popInstance(context->userContext);
@@ -213,6 +217,10 @@ namespace embree
           context->userContext,
           similarityScale,
           context->userPtr); 
+        context_inst.closestPoint = context->closestPoint;
+        context_inst.nearestPoints = context->nearestPoints;
+        context_inst.boxQuery = context->boxQuery;
+        if (context->boxQuery) context_inst.updateAABB();
 
         bool changed = instance->object->intersectors.pointQuery(&query_inst, &context_inst);
         popInstance(context->userContext);
@@ -211,6 +211,36 @@ namespace embree
       }
     };
     
+#if defined(EMBREE_FILTER_FUNCTION)
+    /* sets up a packet that replicates the ray for each valid candidate
+     * hit of a leaf, such that the filter gets invoked only once */
+    template<int M, typename Hit>
+    __forceinline void setupFilterBatch(const vbool<M>& valid, const Ray& ray, IntersectContext* context, const unsigned int geomID, const vuint<M>& primIDs, Hit& hit, RayK<M>& rays, HitK<M>& hits)
+    {
+      rays.org = Vec3vf<M>(ray.org.x,ray.org.y,ray.org.z);
+      rays.dir = Vec3vf<M>(ray.dir.x,ray.dir.y,ray.dir.z);
+      rays.tnear() = ray.tnear();
+      rays.time() = ray.time();
+      rays.tfar = ray.tfar;
+      rays.mask = ray.mask;
+      rays.id = ray.id;
+      rays.flags = ray.flags;
+
+      vfloat<M> u(zero), v(zero);
+      Vec3vf<M> Ng(zero);
+      for (size_t m=movemask(valid); m!=0; )
+      {
+        const size_t i = bscf(m);
+        const Vec2f uv = hit.uv(i);
+        const Vec3fa ng = hit.Ng(i);
+        u[i] = uv.x; v[i] = uv.y;
+        Ng.x[i] = ng.x; Ng.y[i] = ng.y; Ng.z[i] = ng.z;
+        rays.tfar[i] = hit.t(i);
+      }
+      hits = HitK<M>(context->user,vuint<M>(geomID),primIDs,u,v,Ng);
+    }
+#endif
+
     template<int M, bool filter>
     struct Intersect1EpilogM
     {
@@ -236,6 +266,26 @@ namespace embree
 
         /* intersection filter test */
 #if defined(EMBREE_FILTER_FUNCTION) || defined(EMBREE_RAY_MASK)
+#if defined(EMBREE_FILTER_FUNCTION)
+        /* invoke the filter once for all candidates of the same geometry */
+        if (filter && unlikely(context->isBatchFilter()) && none(valid & (geomIDs != vuint<M>(geomID))))
+        {
+          Geometry* geometry = scene->get(geomID);
+#if defined(EMBREE_RAY_MASK)
+          if ((geometry->mask & ray.mask) == 0) return false;
+#endif
+          if (context->hasContextFilter() || geometry->hasIntersectionFilter())
+          {
+            RayHitK<M> rays;
+            HitK<M> hits;
+            setupFilterBatch(valid,ray,context,geomID,primIDs,hit,rays,hits);
+            const vbool<M> accepted = runIntersectionFilter(valid,geometry,rays,context,hits);
+            if (none(accepted)) return false;
+            rays.get(select_min(accepted,rays.tfar),ray);
+            return true;
+          }
+        }
+#endif
         bool foundhit = false;
         goto entry;
         while (true)
@@ -317,6 +367,24 @@ namespace embree
 
         vbool<M> valid = valid_i;
         size_t m=movemask(valid);
+#if defined(EMBREE_FILTER_FUNCTION)
+        /* invoke the filter once for all candidates of the same geometry */
+        const unsigned int geomID0 = geomIDs[bsf(m)];
+        if (filter && unlikely(context->isBatchFilter()) && none(valid & (geomIDs != vuint<M>(geomID0))))
+        {
+          Geometry* geometry = scene->get(geomID0);
+#if defined(EMBREE_RAY_MASK)
+          if ((geometry->mask & ray.mask) == 0) return false;
+#endif
+          if (context->hasContextFilter() || geometry->hasOcclusionFilter())
+          {
+            RayK<M> rays;
+            HitK<M> hits;
+            setupFilterBatch(valid,ray,context,geomID0,primIDs,hit,rays,hits);
+            return any(runOcclusionFilter(valid,geometry,rays,context,hits));
+          }
+        }
+#endif
         goto entry;
         while (true)
         {
@@ -51,11 +51,38 @@ namespace embree
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& prim)
       {
         AccelSet* accel = (AccelSet*)context->scene->get(prim.geomID());
+        if (context->boxQuery) {
+          boxQuery(query, context, accel, prim);
+          return false;
+        }
         context->geomID = prim.geomID();
         context->primID = prim.primID();
         return accel->pointQuery(query, context);
       }
       
+      /*! reports the user geometry if its world space bounds overlap the box of the query */
+      static __forceinline void boxQuery(PointQuery* query, PointQueryContext* context, const AccelSet* accel, const Primitive& prim)
+      {
+        STAT3(point_query.trav_prims,1,1,1);
+        BBox3fa bounds;
+        if (mblur && accel->numTimeSteps > 1) {
+          float ftime;
+          const int itime = accel->timeSegment(query->time, ftime);
+          bounds = lerp(accel->bounds(prim.primID(),itime+0), accel->bounds(prim.primID(),itime+1), ftime);
+        } else {
+          bounds = accel->bounds(prim.primID());
+        }
+
+        RTCPointQueryContext* userContext = context->userContext;
+        if (userContext->instStackSize > 0) {
+          const AffineSpace3fa inst2world = AffineSpace3fa_load_unaligned((AffineSpace3fa*)userContext->inst2world[userContext->instStackSize-1]);
+          bounds = xfmBounds(inst2world, bounds);
+        }
+
+        if (conjoint(bounds, context->boxQuery->bounds))
+          context->boxQuery->insert(prim.geomID(), prim.primID(), userContext);
+      }
+
       template<int K>
       static __forceinline void intersectK(const vbool<K>& valid, /* PrecalculationsK& pre, */ RayHitK<K>& ray, IntersectContext* context, const Primitive* prim, size_t num, size_t& lazy_node)
       {
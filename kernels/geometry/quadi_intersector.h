@@ -6,6 +6,7 @@
 #include "quadi.h"
 #include "quad_intersector_moeller.h"
 #include "quad_intersector_pluecker.h"
+#include "closest_point.h"
 
 namespace embree
 {
@@ -36,6 +37,10 @@ namespace embree
 
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& quad)
       {
+        if (context->closestPoint || context->boxQuery) {
+          Vec3vf<M> v0,v1,v2,v3; quad.gather(v0,v1,v2,v3,context->scene);
+          return BuiltinPointQueryM<M>::quads(query, context, quad.valid(), v0, v1, v2, v3, quad.geomID(), quad.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, quad);
       }
     };
@@ -124,6 +129,10 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& quad)
       {
+        if (context->closestPoint || context->boxQuery) {
+          Vec3vf<M> v0,v1,v2,v3; quad.gather(v0,v1,v2,v3,context->scene);
+          return BuiltinPointQueryM<M>::quads(query, context, quad.valid(), v0, v1, v2, v3, quad.geomID(), quad.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, quad);
       }
     };
@@ -212,6 +221,10 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& quad)
       {
+        if (context->closestPoint || context->boxQuery) {
+          Vec3vf<M> v0,v1,v2,v3; quad.gather(v0,v1,v2,v3,context->scene,query->time);
+          return BuiltinPointQueryM<M>::quads(query, context, quad.valid(), v0, v1, v2, v3, quad.geomID(), quad.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, quad);
       }
     };
@@ -292,6 +305,10 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& quad)
       {
+        if (context->closestPoint || context->boxQuery) {
+          Vec3vf<M> v0,v1,v2,v3; quad.gather(v0,v1,v2,v3,context->scene,query->time);
+          return BuiltinPointQueryM<M>::quads(query, context, quad.valid(), v0, v1, v2, v3, quad.geomID(), quad.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, quad);
       }
     };
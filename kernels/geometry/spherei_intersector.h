@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "closest_point.h"
 #include "intersector_epilog.h"
 #include "pointi.h"
 #include "sphere_intersector.h"
@@ -47,6 +48,11 @@ namespace embree
                                            PointQueryContext* context,
                                            const Primitive& sphere)
       {
+        if (context->nearestPoints || context->boxQuery) {
+          const Points* geom = context->scene->get<Points>(sphere.geomID());
+          Vec4vf<M> v0; sphere.gather(v0, geom);
+          return BuiltinPointQueryM<M>::points(query, context, sphere.valid(), v0, vuint<M>(sphere.geomID()), sphere.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, sphere);
       }
     };
@@ -87,6 +93,11 @@ namespace embree
                                            PointQueryContext* context,
                                            const Primitive& sphere)
       {
+        if (context->nearestPoints || context->boxQuery) {
+          const Points* geom = context->scene->get<Points>(sphere.geomID());
+          Vec4vf<M> v0; sphere.gather(v0, geom, query->time);
+          return BuiltinPointQueryM<M>::points(query, context, sphere.valid(), v0, vuint<M>(sphere.geomID()), sphere.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, sphere);
       }
     };
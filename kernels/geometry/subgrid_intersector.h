@@ -6,11 +6,36 @@
 #include "subgrid.h"
 #include "subgrid_intersector_moeller.h"
 #include "subgrid_intersector_pluecker.h"
+#include "closest_point.h"
 
 namespace embree
 {
   namespace isa
   {
+    /*! Evaluates closest point and box queries on the 2x2 quads of a
+     *  subgrid, u,v are reported across the entire grid. */
+    __forceinline bool builtinPointQuerySubGrid(PointQuery* query, PointQueryContext* context, const SubGrid& subgrid)
+    {
+      const GridMesh* mesh    = context->scene->get<GridMesh>(subgrid.geomID());
+      const GridMesh::Grid &g = mesh->grid(subgrid.primID());
+
+      /* quads outside of the grid are duplicates of valid quads */
+      const vint4 stepX(0,1,1,0);
+      const vint4 stepY(0,0,1,1);
+      const vbool4 valid = ((stepX == vint4(zero)) | vbool4(!subgrid.invalid3x3X())) & ((stepY == vint4(zero)) | vbool4(!subgrid.invalid3x3Y()));
+
+      const vfloat4 sx = vfloat4(vint4((int)subgrid.x()) + stepX);
+      const vfloat4 sy = vfloat4(vint4((int)subgrid.y()) + stepY);
+      const float inv_resX = rcp((float)((int)g.resX-1));
+      const float inv_resY = rcp((float)((int)g.resY-1));
+      auto mapUV = [&] (vfloat4& u, vfloat4& v) {
+        u = (u + sx) * inv_resX;
+        v = (v + sy) * inv_resY;
+      };
+
+      Vec3vf4 v0,v1,v2,v3; subgrid.gather(v0,v1,v2,v3,context->scene);
+      return BuiltinPointQueryM<4>::quads(query, context, valid, v0, v1, v2, v3, subgrid.geomID(), vuint4(subgrid.primID()), mapUV);
+    }
 
     // =======================================================================================
     // =================================== SubGridIntersectors ===============================
@@ -45,6 +70,9 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const SubGrid& subgrid)
       {
+        if (context->closestPoint || context->boxQuery)
+          return builtinPointQuerySubGrid(query, context, subgrid);
+
         STAT3(point_query.trav_prims,1,1,1);
         AccelSet* accel = (AccelSet*)context->scene->get(subgrid.geomID());
         assert(accel);
@@ -148,6 +176,9 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const SubGrid& subgrid)
       {
+        if (context->closestPoint || context->boxQuery)
+          return builtinPointQuerySubGrid(query, context, subgrid);
+
         STAT3(point_query.trav_prims,1,1,1);
         AccelSet* accel = (AccelSet*)context->scene->get(subgrid.geomID());
         context->geomID = subgrid.geomID();
@@ -5,6 +5,7 @@
 
 #include "triangle.h"
 #include "triangle_intersector_moeller.h"
+#include "closest_point.h"
 
 namespace embree
 {
@@ -33,6 +34,8 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& tri)
       {
+        if (context->closestPoint || context->boxQuery)
+          return BuiltinPointQueryM<M>::triangles(query, context, tri.valid(), tri.v0, tri.v0-tri.e1, tri.v0+tri.e2, tri.geomID(), tri.primID());
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, tri);
       }
       
@@ -6,6 +6,7 @@
 #include "trianglei.h"
 #include "triangle_intersector_moeller.h"
 #include "triangle_intersector_pluecker.h"
+#include "closest_point.h"
 
 namespace embree
 {
@@ -34,6 +35,10 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& tri)
       {
+        if (context->closestPoint || context->boxQuery) {
+          Vec3vf<M> v0, v1, v2; tri.gather(v0,v1,v2,context->scene);
+          return BuiltinPointQueryM<M>::triangles(query, context, tri.valid(), v0, v1, v2, tri.geomID(), tri.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, tri);
       }
     };
@@ -115,6 +120,10 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& tri)
       {
+        if (context->closestPoint || context->boxQuery) {
+          Vec3vf<M> v0, v1, v2; tri.gather(v0,v1,v2,context->scene);
+          return BuiltinPointQueryM<M>::triangles(query, context, tri.valid(), v0, v1, v2, tri.geomID(), tri.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, tri);
       }
     };
@@ -198,6 +207,10 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& tri)
       {
+        if (context->closestPoint || context->boxQuery) {
+          Vec3vf<M> v0,v1,v2; tri.gather(v0,v1,v2,context->scene,query->time);
+          return BuiltinPointQueryM<M>::triangles(query, context, tri.valid(), v0, v1, v2, tri.geomID(), tri.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, tri);
       }
     };
@@ -278,6 +291,10 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& tri)
       {
+        if (context->closestPoint || context->boxQuery) {
+          Vec3vf<M> v0,v1,v2; tri.gather(v0,v1,v2,context->scene,query->time);
+          return BuiltinPointQueryM<M>::triangles(query, context, tri.valid(), v0, v1, v2, tri.geomID(), tri.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, tri);
       }
     };
@@ -5,6 +5,7 @@
 
 #include "triangle.h"
 #include "intersector_epilog.h"
+#include "closest_point.h"
 
 namespace embree
 {
@@ -41,6 +42,14 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& tri)
       {
+        if (context->closestPoint || context->boxQuery)
+        {
+          const Vec3vf<M> time(query->time);
+          const Vec3vf<M> v0 = madd(time,Vec3vf<M>(tri.dv0),Vec3vf<M>(tri.v0));
+          const Vec3vf<M> v1 = madd(time,Vec3vf<M>(tri.dv1),Vec3vf<M>(tri.v1));
+          const Vec3vf<M> v2 = madd(time,Vec3vf<M>(tri.dv2),Vec3vf<M>(tri.v2));
+          return BuiltinPointQueryM<M>::triangles(query, context, tri.valid(), v0, v1, v2, tri.geomID(), tri.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, tri);
       }
     };
@@ -140,6 +149,14 @@ namespace embree
       
       static __forceinline bool pointQuery(PointQuery* query, PointQueryContext* context, const Primitive& tri)
       {
+        if (context->closestPoint || context->boxQuery)
+        {
+          const Vec3vf<M> time(query->time);
+          const Vec3vf<M> v0 = madd(time,Vec3vf<M>(tri.dv0),Vec3vf<M>(tri.v0));
+          const Vec3vf<M> v1 = madd(time,Vec3vf<M>(tri.dv1),Vec3vf<M>(tri.v1));
+          const Vec3vf<M> v2 = madd(time,Vec3vf<M>(tri.dv2),Vec3vf<M>(tri.v2));
+          return BuiltinPointQueryM<M>::triangles(query, context, tri.valid(), v0, v1, v2, tri.geomID(), tri.primID());
+        }
         return PrimitivePointQuery1<Primitive>::pointQuery(query, context, tri);
       }
     };
@@ -0,0 +1,224 @@
+// Copyright 2009-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "../common/default.h"
+
+namespace embree
+{
+  /*! Caches the displaced positions of the grids of a subdivision
+   *  mesh, such that rebuilding the grids does not call the
+   *  displacement function again. The cache is a lock free open
+   *  addressing hash table whose entries point into a single
+   *  contiguous arena, that stores the planes of each grid without
+   *  SIMD padding. Entries are never removed, thus once the arena
+   *  or the table is full, further grids are no longer cached until
+   *  the cache gets reset at the next commit of the geometry. */
+  class DisplacementCache
+  {
+  public:
+
+    /*! identifies a grid by its patch, its resolution, and its range */
+    struct Key
+    {
+      __forceinline Key (unsigned primID, unsigned subPatch, unsigned time,
+                         unsigned width, unsigned height,
+                         unsigned x0, unsigned x1, unsigned y0, unsigned y1)
+        : patch((uint64_t(primID) << 32) | (uint64_t(subPatch) << 24) | uint64_t(time)),
+          level((uint64_t(width) << 32) | uint64_t(height)),
+          range((uint64_t(x0) << 48) | (uint64_t(x1) << 32) | (uint64_t(y0) << 16) | uint64_t(y1)) {}
+
+      __forceinline bool operator== (const Key& other) const {
+        return patch == other.patch && level == other.level && range == other.range;
+      }
+
+      __forceinline size_t hash() const {
+        const uint64_t h = patch ^ (level * 0x9E3779B97F4A7C15ull) ^ (range * 0xC2B2AE3D27D4EB4Full);
+        return size_t(h ^ (h >> 29));
+      }
+
+      uint64_t patch;
+      uint64_t level;
+      uint64_t range;
+    };
+
+  private:
+
+    enum { EMPTY = 0, BUSY = 1, READY = 2 };
+    enum { MAX_PROBES = 32 };      //!< maximal number of slots visited by a lookup or insert
+    enum { BYTES_PER_SLOT = 512 }; //!< arena bytes per table slot
+    enum { FILE_VERSION = 1 };
+    static const uint64_t FILE_MAGIC = 0x4C50534944425245ull; //!< file signature
+
+    /*! table slot, all members except the state are only written while the slot is BUSY */
+    struct Slot
+    {
+      std::atomic<unsigned> state;
+      unsigned numPlanes;
+      size_t N;
+      size_t offset;
+      Key key;
+    };
+
+  public:
+
+    DisplacementCache ()
+      : maxBytes(0), ptr(nullptr), slots(nullptr), numSlots(0), arena(nullptr), arenaSize(0), arenaUsed(0) {}
+
+    ~DisplacementCache () {
+      alignedFree(ptr);
+    }
+
+    /*! returns true if the cache is used */
+    __forceinline bool enabled() const {
+      return maxBytes != 0;
+    }
+
+    /*! clears the cache and sets its maximal size in bytes, 0 disables the cache, must not run concurrently to lookups or inserts */
+    void reset(size_t max_bytes)
+    {
+      if (max_bytes != maxBytes)
+      {
+        alignedFree(ptr); ptr = nullptr;
+        slots = nullptr; numSlots = 0;
+        arena = nullptr; arenaSize = 0;
+        maxBytes = 0;
+
+        if (max_bytes >= size_t(BYTES_PER_SLOT))
+        {
+          numSlots = size_t(1) << bsr(max_bytes/BYTES_PER_SLOT);
+          const size_t tableBytes = numSlots*sizeof(Slot);
+          arenaSize = max_bytes > tableBytes ? (max_bytes-tableBytes)/sizeof(float) : 0;
+          ptr = (char*) alignedMalloc(tableBytes+arenaSize*sizeof(float),64);
+          slots = (Slot*) ptr;
+          arena = (float*) (ptr+tableBytes);
+          maxBytes = max_bytes;
+        }
+      }
+
+      for (size_t i=0; i<numSlots; i++)
+        slots[i].state.store(EMPTY,std::memory_order_relaxed);
+      arenaUsed.store(0,std::memory_order_relaxed);
+    }
+
+    /*! copies N cached values into each of the numPlanes planes, returns false if the grid is not cached */
+    bool lookup(const Key& key, float* const planes[], size_t numPlanes, size_t N) const
+    {
+      const size_t h = key.hash();
+      for (size_t i=0; i<min(size_t(MAX_PROBES),numSlots); i++)
+      {
+        const Slot& slot = slots[(h+i) & (numSlots-1)];
+        const unsigned state = slot.state.load(std::memory_order_acquire);
+        if (state == EMPTY) return false;
+        if (state != READY || !(slot.key == key)) continue;
+        if (slot.numPlanes != numPlanes || slot.N != N) return false;
+
+        const float* P = &arena[slot.offset];
+        for (size_t p=0; p<numPlanes; p++)
+          memcpy(planes[p],&P[p*N],N*sizeof(float));
+        return true;
+      }
+      return false;
+    }
+
+    /*! stores N values of each of the numPlanes planes of a grid, does nothing if the cache is full */
+    void insert(const Key& key, const float* const planes[], size_t numPlanes, size_t N)
+    {
+      /* reserve space in the arena */
+      const size_t num = numPlanes*N;
+      size_t offset = arenaUsed.load(std::memory_order_relaxed);
+      do {
+        if (offset+num > arenaSize) return;
+      } while (!arenaUsed.compare_exchange_weak(offset,offset+num,std::memory_order_relaxed));
+
+      float* P = &arena[offset];
+      for (size_t p=0; p<numPlanes; p++)
+        memcpy(&P[p*N],planes[p],N*sizeof(float));
+
+      /* claim a slot and publish the entry */
+      const size_t h = key.hash();
+      for (size_t i=0; i<min(size_t(MAX_PROBES),numSlots); i++)
+      {
+        Slot& slot = slots[(h+i) & (numSlots-1)];
+        unsigned state = slot.state.load(std::memory_order_acquire);
+        if (state == READY && slot.key == key) return;
+        if (state != EMPTY || !slot.state.compare_exchange_strong(state,BUSY,std::memory_order_acquire)) continue;
+
+        slot.numPlanes = unsigned(numPlanes);
+        slot.N = N;
+        slot.offset = offset;
+        slot.key = key;
+        slot.state.store(READY,std::memory_order_release);
+        return;
+      }
+    }
+
+    /*! writes all cached grids to a file, the hash identifies the state the grids were evaluated from */
+    void save(const FileName& fileName, uint64_t hash) const
+    {
+      FILE* file = fopen(fileName.c_str(),"wb");
+      if (!file) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"cannot open file " + fileName.str());
+
+      size_t numEntries = 0;
+      for (size_t i=0; i<numSlots; i++)
+        numEntries += slots[i].state.load(std::memory_order_acquire) == READY;
+
+      bool ok = true;
+      const uint64_t header[4] = { FILE_MAGIC, FILE_VERSION, hash, numEntries };
+      ok &= fwrite(header,sizeof(header),1,file) == 1;
+      for (size_t i=0; i<numSlots && ok; i++)
+      {
+        const Slot& slot = slots[i];
+        if (slot.state.load(std::memory_order_acquire) != READY) continue;
+        const uint64_t entry[5] = { slot.key.patch, slot.key.level, slot.key.range, slot.numPlanes, slot.N };
+        ok &= fwrite(entry,sizeof(entry),1,file) == 1;
+        ok &= fwrite(&arena[slot.offset],sizeof(float),slot.numPlanes*slot.N,file) == slot.numPlanes*slot.N;
+      }
+      ok &= fclose(file) == 0;
+      if (!ok) throw_RTCError(RTC_ERROR_UNKNOWN,"cannot write file " + fileName.str());
+    }
+
+    /*! adds the grids of a file written by save to the cache, returns false if the file does not exist or was written for a different hash */
+    bool load(const FileName& fileName, uint64_t hash)
+    {
+      FILE* file = fopen(fileName.c_str(),"rb");
+      if (!file) return false;
+
+      uint64_t header[4];
+      bool ok = fread(header,sizeof(header),1,file) == 1;
+      ok = ok && header[0] == FILE_MAGIC && header[1] == FILE_VERSION && header[2] == hash;
+
+      std::vector<float> P;
+      for (size_t i=0; ok && i<header[3]; i++)
+      {
+        uint64_t entry[5];
+        ok &= fread(entry,sizeof(entry),1,file) == 1;
+        ok = ok && entry[3] != 0 && entry[3] <= 8 && entry[4] <= arenaSize;
+        if (!ok) break;
+
+        const size_t numPlanes = entry[3], N = entry[4];
+        P.resize(numPlanes*N);
+        ok &= fread(P.data(),sizeof(float),P.size(),file) == P.size();
+        if (!ok) break;
+
+        Key key(0,0,0,0,0,0,0,0,0);
+        key.patch = entry[0]; key.level = entry[1]; key.range = entry[2];
+        const float* planes[8];
+        for (size_t p=0; p<numPlanes; p++) planes[p] = &P[p*N];
+        insert(key,planes,numPlanes,N);
+      }
+      fclose(file);
+      return ok;
+    }
+
+  private:
+    size_t maxBytes;
+    char* ptr;                        //!< single allocation holding the table and the arena
+    Slot* slots;
+    size_t numSlots;
+    float* arena;
+    size_t arenaSize;                 //!< size of the arena in floats
+    std::atomic<size_t> arenaUsed;    //!< number of used floats of the arena
+  };
+}
@@ -46,6 +46,72 @@ namespace embree
           }
         }
         
+        /*! evaluates a regular grid of width x height samples over
+         *  the patch, or over one sub-patch of a non-quad face, with a
+         *  single cache lookup */
+        PatchEvalSimd (SharedLazyTessellationCache::CacheEntry& entry, size_t commitCounter, 
+                       const HalfEdge* edge, const char* vertices, size_t stride, const unsigned subPatch, const unsigned width, const unsigned height,
+                       float* P0, float* dPdu0, float* dPdv0, float* ddPdudu0, float* ddPdvdv0, float* ddPdudv0, const size_t N)
+        : P(nullptr), dPdu(nullptr), dPdv(nullptr), ddPdudu(nullptr), ddPdvdv(nullptr), ddPdudv(nullptr), dstride(vfloat::size), N(N)
+        {
+          assert(width >= 2 && height >= 2);
+          assert(N <= 4);
+          auto time = SharedLazyTessellationCache::sharedLazyTessellationCache.getTime(commitCounter);
+
+          Ref patch = SharedLazyTessellationCache::lookup(entry,commitCounter,[&] () {
+              auto alloc = [](size_t bytes) { return SharedLazyTessellationCache::malloc(bytes); };
+              return Patch::create(alloc,edge,vertices,stride);
+            }, true);
+
+          auto curTime = SharedLazyTessellationCache::sharedLazyTessellationCache.getTime(commitCounter);
+          const bool allAllocationsValid = SharedLazyTessellationCache::validTime(time,curTime);
+          
+          patch = allAllocationsValid ? patch : nullptr;
+
+          /* the patch evaluation stores full SIMD vectors, thus we evaluate into aligned temporary arrays */
+          float* const dst[6] = { P0, dPdu0, dPdv0, ddPdudu0, ddPdvdv0, ddPdudv0 };
+          __aligned(64) float tmp[6][4*vfloat::size];
+          float** const ptrs[6] = { &P, &dPdu, &dPdv, &ddPdudu, &ddPdvdv, &ddPdudv };
+          for (size_t k=0; k<6; k++) *ptrs[k] = dst[k] ? tmp[k] : nullptr;
+
+          /* sub-patches of non-quad faces are encoded into the u/v range */
+          Vec2f uv0(zero);
+          if (edge->numEdges() != 4) uv0 = Vec2f(2.0f*float(subPatch&3)+0.5f,2.0f*float(subPatch>>2)+0.5f);
+          const float rcp_width  = 1.0f/float(width-1);
+          const float rcp_height = 1.0f/float(height-1);
+          const size_t samples = size_t(width)*size_t(height);
+
+          for (size_t i=0; i<samples; i+=vfloat::size)
+          {
+            const size_t lanes = min(size_t(vfloat::size),samples-i);
+            __aligned(64) float su[vfloat::size];
+            __aligned(64) float sv[vfloat::size];
+            for (size_t l=0; l<vfloat::size; l++) {
+              const size_t j = i+min(l,lanes-1);
+              const size_t x = j%width, y = j/width;
+              su[l] = x == width -1 ? 1.0f : float(x)*rcp_width;
+              sv[l] = y == height-1 ? 1.0f : float(y)*rcp_height;
+            }
+            const vfloat u = uv0.x + vfloat::load(su);
+            const vfloat v = uv0.y + vfloat::load(sv);
+            const vbool valid0 = vint(step) < vint(int(lanes));
+
+            const vbool valid1 = patch ? eval(valid0,patch,u,v,1.0f,0) : vbool(false);
+            const vbool valid2 = valid0 & !valid1;
+            if (any(valid2)) {
+              FeatureAdaptiveEvalSimd<vbool,vint,vfloat,Vertex,Vertex_t>(edge,vertices,stride,valid2,u,v,P,dPdu,dPdv,ddPdudu,ddPdvdv,ddPdudv,dstride,N);
+            }
+
+            for (size_t k=0; k<6; k++) {
+              if (!dst[k]) continue;
+              for (size_t n=0; n<N; n++)
+                for (size_t l=0; l<lanes; l++)
+                  dst[k][n*samples+i+l] = tmp[k][n*dstride+l];
+            }
+          }
+          SharedLazyTessellationCache::unlock();
+        }
+        
         vbool eval_quad(const vbool& valid, const typename Patch::SubdividedQuadPatch* This, const vfloat& u, const vfloat& v, const float dscale, const size_t depth)
         {
           vbool ret = false;
@@ -114,12 +180,12 @@ namespace embree
         }
 
       private:
-        float* const P;
-        float* const dPdu;
-        float* const dPdv;
-        float* const ddPdudu;
-        float* const ddPdvdv;
-        float* const ddPdudv;
+        float* P;
+        float* dPdu;
+        float* dPdv;
+        float* ddPdudu;
+        float* ddPdvdv;
+        float* ddPdudv;
         const size_t dstride;
         const size_t N;
       };
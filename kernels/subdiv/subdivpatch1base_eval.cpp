@@ -78,68 +78,80 @@ namespace embree
       const unsigned M = dwidth*dheight+VSIZEX;
       const unsigned grid_size_simd_blocks = (M-1)/VSIZEX;
 
+      /* displaced positions of this grid may be cached from a previous build */
+      const bool cacheDispl = geom->displFunc && geom->displacementCache.enabled();
+      const DisplacementCache::Key key(patch.primID(),patch.subPatch(),patch.time(),swidth,sheight,x0,x1,y0,y1);
+
       if (unlikely(patch.type == SubdivPatch1Base::EVAL_PATCH))
       {
-        const bool displ = geom->displFunc;
+        /* cached grids store the displaced positions and the patch UVs, thus neither the patch nor the displacement get evaluated */
+        float* const planes[5] = { grid_x, grid_y, grid_z, grid_u, grid_v };
+        const bool cached = cacheDispl && geom->displacementCache.lookup(key,planes,5,dwidth*dheight);
+        
+        const bool displ = geom->displFunc && !cached;
         const unsigned N = displ ? M : 0;
         dynamic_large_stack_array(float,grid_Ng_x,N,32*32*sizeof(float));
         dynamic_large_stack_array(float,grid_Ng_y,N,32*32*sizeof(float));
         dynamic_large_stack_array(float,grid_Ng_z,N,32*32*sizeof(float));
         
-        if (geom->patch_eval_trees.size())
-        {
-          feature_adaptive_eval_grid<PatchEvalGrid> 
-            (geom->patch_eval_trees[geom->numTimeSteps*patch.primID()+patch.time()], patch.subPatch(), patch.needsStitching() ? patch.level : nullptr,
-             x0,x1,y0,y1,swidth,sheight,
-             grid_x,grid_y,grid_z,grid_u,grid_v,
-             displ ? (float*)grid_Ng_x : nullptr, displ ? (float*)grid_Ng_y : nullptr, displ ? (float*)grid_Ng_z : nullptr,
-             dwidth,dheight);
-        }
-        else 
+        if (likely(!cached))
         {
-          GeneralCatmullClarkPatch3fa ccpatch(patch.edge(),geom->getVertexBuffer(patch.time()));
+          if (geom->patch_eval_trees.size())
+          {
+            feature_adaptive_eval_grid<PatchEvalGrid> 
+              (geom->patch_eval_trees[geom->numTimeSteps*patch.primID()+patch.time()], patch.subPatch(), patch.needsStitching() ? patch.level : nullptr,
+               x0,x1,y0,y1,swidth,sheight,
+               grid_x,grid_y,grid_z,grid_u,grid_v,
+               displ ? (float*)grid_Ng_x : nullptr, displ ? (float*)grid_Ng_y : nullptr, displ ? (float*)grid_Ng_z : nullptr,
+               dwidth,dheight);
+          }
+          else 
+          {
+            GeneralCatmullClarkPatch3fa ccpatch(patch.edge(),geom->getVertexBuffer(patch.time()));
           
-          feature_adaptive_eval_grid<FeatureAdaptiveEvalGrid,GeneralCatmullClarkPatch3fa> 
-            (ccpatch, patch.subPatch(), patch.needsStitching() ? patch.level : nullptr,
-            x0,x1,y0,y1,swidth,sheight,
-            grid_x,grid_y,grid_z,grid_u,grid_v,
-            displ ? (float*)grid_Ng_x : nullptr, displ ? (float*)grid_Ng_y : nullptr, displ ? (float*)grid_Ng_z : nullptr,
-            dwidth,dheight);
-        }
+            feature_adaptive_eval_grid<FeatureAdaptiveEvalGrid,GeneralCatmullClarkPatch3fa> 
+              (ccpatch, patch.subPatch(), patch.needsStitching() ? patch.level : nullptr,
+              x0,x1,y0,y1,swidth,sheight,
+              grid_x,grid_y,grid_z,grid_u,grid_v,
+              displ ? (float*)grid_Ng_x : nullptr, displ ? (float*)grid_Ng_y : nullptr, displ ? (float*)grid_Ng_z : nullptr,
+              dwidth,dheight);
+          }
 
-        /* convert sub-patch UVs to patch UVs*/
-        const Vec2f uv0 = patch.getUV(0);
-        const Vec2f uv1 = patch.getUV(1);
-        const Vec2f uv2 = patch.getUV(2);
-        const Vec2f uv3 = patch.getUV(3);
-        for (unsigned i=0; i<grid_size_simd_blocks; i++)
-        {
-          const vfloatx u = vfloatx::load(&grid_u[i*VSIZEX]);
-          const vfloatx v = vfloatx::load(&grid_v[i*VSIZEX]);
-          const vfloatx patch_u = lerp2(uv0.x,uv1.x,uv3.x,uv2.x,u,v);
-          const vfloatx patch_v = lerp2(uv0.y,uv1.y,uv3.y,uv2.y,u,v);
-          vfloatx::store(&grid_u[i*VSIZEX],patch_u);
-          vfloatx::store(&grid_v[i*VSIZEX],patch_v);
-        }
+          /* convert sub-patch UVs to patch UVs*/
+          const Vec2f uv0 = patch.getUV(0);
+          const Vec2f uv1 = patch.getUV(1);
+          const Vec2f uv2 = patch.getUV(2);
+          const Vec2f uv3 = patch.getUV(3);
+          for (unsigned i=0; i<grid_size_simd_blocks; i++)
+          {
+            const vfloatx u = vfloatx::load(&grid_u[i*VSIZEX]);
+            const vfloatx v = vfloatx::load(&grid_v[i*VSIZEX]);
+            const vfloatx patch_u = lerp2(uv0.x,uv1.x,uv3.x,uv2.x,u,v);
+            const vfloatx patch_v = lerp2(uv0.y,uv1.y,uv3.y,uv2.y,u,v);
+            vfloatx::store(&grid_u[i*VSIZEX],patch_u);
+            vfloatx::store(&grid_v[i*VSIZEX],patch_v);
+          }
 
-        /* call displacement shader */
-        if (unlikely(geom->displFunc)) {
-          RTCDisplacementFunctionNArguments args;
-          args.geometryUserPtr = geom->userPtr;
-          args.geometry = (RTCGeometry)geom;
-          //args.geomID = patch.geomID();
-          args.primID = patch.primID();
-          args.timeStep = patch.time();
-          args.u = grid_u;
-          args.v = grid_v;
-          args.Ng_x = grid_Ng_x;
-          args.Ng_y = grid_Ng_y;
-          args.Ng_z = grid_Ng_z;
-          args.P_x = grid_x;
-          args.P_y = grid_y;
-          args.P_z = grid_z;
-          args.N = dwidth*dheight;
-          geom->displFunc(&args);
+          /* call displacement shader */
+          if (unlikely(geom->displFunc)) {
+            RTCDisplacementFunctionNArguments args;
+            args.geometryUserPtr = geom->userPtr;
+            args.geometry = (RTCGeometry)geom;
+            //args.geomID = patch.geomID();
+            args.primID = patch.primID();
+            args.timeStep = patch.time();
+            args.u = grid_u;
+            args.v = grid_v;
+            args.Ng_x = grid_Ng_x;
+            args.Ng_y = grid_Ng_y;
+            args.Ng_z = grid_Ng_z;
+            args.P_x = grid_x;
+            args.P_y = grid_y;
+            args.P_z = grid_z;
+            args.N = dwidth*dheight;
+            geom->displFunc(&args);
+            if (cacheDispl) geom->displacementCache.insert(key,planes,5,dwidth*dheight);
+          }
         }
 
         /* set last elements in u,v array to 1.0f */
@@ -173,6 +185,21 @@ namespace embree
         /* stitch edges if necessary */
         if (unlikely(patch.needsStitching()))
           stitchUVGrid(patch.level,swidth,sheight,x0,y0,dwidth,dheight,grid_u,grid_v);
+
+        /* skip evaluation and displacement if the positions are cached, the padding repeats the last valid point */
+        float* const planes[3] = { grid_x, grid_y, grid_z };
+        if (unlikely(cacheDispl) && geom->displacementCache.lookup(key,planes,3,dwidth*dheight))
+        {
+          const float last_x = grid_x[dwidth*dheight-1];
+          const float last_y = grid_y[dwidth*dheight-1];
+          const float last_z = grid_z[dwidth*dheight-1];
+          for (unsigned i=dwidth*dheight;i<grid_size_simd_blocks*VSIZEX;i++) {
+            grid_x[i] = last_x;
+            grid_y[i] = last_y;
+            grid_z[i] = last_z;
+          }
+          return;
+        }
       
         /* iterates over all grid points */
         for (unsigned i=0; i<grid_size_simd_blocks; i++)
@@ -207,6 +234,9 @@ namespace embree
           vfloatx::store(&grid_y[i*VSIZEX],vtx.y);
           vfloatx::store(&grid_z[i*VSIZEX],vtx.z);
         }
+
+        if (unlikely(cacheDispl))
+          geom->displacementCache.insert(key,planes,3,dwidth*dheight);
       }
     }
 
@@ -18,6 +18,18 @@ namespace embree
       SharedLazyTessellationCache::sharedLazyTessellationCache.realloc(new_size);    
   }
 
+  void resizeTessellationCacheMaxSize(size_t max_size)
+  {
+    if (max_size >= SharedLazyTessellationCache::MAX_TESSELLATION_CACHE_SIZE)
+      max_size = SharedLazyTessellationCache::MAX_TESSELLATION_CACHE_SIZE;
+    SharedLazyTessellationCache::sharedLazyTessellationCache.setMaxSize(max_size);
+  }
+
+  void growTessellationCache()
+  {
+    SharedLazyTessellationCache::sharedLazyTessellationCache.grow();
+  }
+
   void resetTessellationCache()
   {
     //SharedLazyTessellationCache::sharedLazyTessellationCache.addCurrentIndex(SharedLazyTessellationCache::NUM_CACHE_SEGMENTS);
@@ -33,12 +45,19 @@ namespace embree
     localTime              = NUM_CACHE_SEGMENTS;
     next_block             = 0;
     numRenderThreads       = 0;
+    segmentEpoch           = 0;
 #if FORCE_SIMPLE_FLUSH == 1
     switch_block_threshold = maxBlocks;
 #else
     switch_block_threshold = maxBlocks/NUM_CACHE_SEGMENTS;
 #endif
     threadWorkState     = new ThreadWorkState[NUM_PREALLOC_THREAD_WORK_STATES];
+    maxSize                = 0;
+    growSize               = 0;
+    flushesSinceCheck      = 0;
+    hitsAtCheck            = 0;
+    missesAtCheck          = 0;
+    flushes                = 0;
 
     //reset_state.reset();
     //linkedlist_mtx.reset();
@@ -96,10 +115,15 @@ namespace embree
           if (lockThread(t,THREAD_BLOCK_ATOMIC_ADD) != 0)
             waitForUsersLessEqual(t,THREAD_BLOCK_ATOMIC_ADD);
         
+        /* the cache grows at the next commit if it gets flushed too
+         * often, as the calling thread may still use the current data */
+        if (growRequired())
+          growSize = min(2*size,maxSize);
+
         /* switch to the next segment */
         addCurrentIndex();
         CACHE_STATS(PRINT("RESET TESS CACHE"));
-        
+
 #if FORCE_SIMPLE_FLUSH == 1
         next_block = 0;
         switch_block_threshold = maxBlocks;
@@ -109,7 +133,9 @@ namespace embree
         switch_block_threshold = next_block + (maxBlocks/NUM_CACHE_SEGMENTS);
         assert( switch_block_threshold <= maxBlocks );
 #endif
+        segmentEpoch++;
         
+        flushes++;
         CACHE_STATS(SharedTessellationCacheStats::cache_flushes++);
         
         /* release all blocked threads */
@@ -153,6 +179,7 @@ namespace embree
 
     /* reset local time */
     localTime = NUM_CACHE_SEGMENTS;
+    segmentEpoch++;
 
     /* release all blocked threads */
     for (ThreadWorkState *t=current_t_state;t!=nullptr;t=t->next)
@@ -178,12 +205,81 @@ namespace embree
       if (lockThread(t,THREAD_BLOCK_ATOMIC_ADD) != 0)
         waitForUsersLessEqual(t,THREAD_BLOCK_ATOMIC_ADD);
 
+    resize(new_size);
+
+    /* release all blocked threads */
+    for (ThreadWorkState *t=current_t_state;t!=nullptr;t=t->next)
+      unlockThread(t,-THREAD_BLOCK_ATOMIC_ADD);
+
+    /* unlock the linked list of thread states */
+    linkedlist_mtx.unlock();	    
+
+    /* unlock the reset_state */
+    reset_state.unlock();
+  }
+
+
+  void SharedLazyTessellationCache::grow()
+  {
+    const size_t new_size = growSize.exchange(0);
+    if (new_size <= size) return;
+
+    /* allocate before blocking the threads, the cache keeps its size if the allocation fails */
+    bool new_hugepages = false;
+    float* new_data = nullptr;
+    try {
+      new_data = (float*)os_malloc(new_size,new_hugepages);
+    } catch (...) {
+      return;
+    }
+
+    /* lock the reset_state */
+    reset_state.lock();
+
+    /* lock the linked list of thread states */
+    linkedlist_mtx.lock();
+
+    /* block all threads */
+    for (ThreadWorkState *t=current_t_state;t!=nullptr;t=t->next)
+      if (lockThread(t,THREAD_BLOCK_ATOMIC_ADD) != 0)
+        waitForUsersLessEqual(t,THREAD_BLOCK_ATOMIC_ADD);
+
+    float* old_data = data;
+    const size_t old_size = size;
+    const bool old_hugepages = hugepages;
+    data = new_data;
+    size = new_size;
+    hugepages = new_hugepages;
+    initSegments();
+
+    /* release all blocked threads */
+    for (ThreadWorkState *t=current_t_state;t!=nullptr;t=t->next)
+      unlockThread(t,-THREAD_BLOCK_ATOMIC_ADD);
+
+    /* unlock the linked list of thread states */
+    linkedlist_mtx.unlock();
+
+    /* unlock the reset_state */
+    reset_state.unlock();
+
+    if (old_data) os_free(old_data,old_size,old_hugepages);
+  }
+
+  void SharedLazyTessellationCache::resize(const size_t new_size)
+  {
+    /* all threads have to be blocked by the caller */
+
     /* reallocate data */
     if (data) os_free(data,size,hugepages);
     size      = new_size;
     data      = nullptr;
     if (size) data = (float*)os_malloc(size,hugepages);
-    maxBlocks = size/BLOCK_SIZE;    
+    initSegments();
+  }
+
+  void SharedLazyTessellationCache::initSegments()
+  {
+    maxBlocks = size/BLOCK_SIZE;
 
     /* invalidate entire cache */
     localTime += NUM_CACHE_SEGMENTS; 
@@ -198,18 +294,75 @@ namespace embree
     switch_block_threshold = next_block + (maxBlocks/NUM_CACHE_SEGMENTS);
     assert( switch_block_threshold <= maxBlocks );
 #endif
+    segmentEpoch++;
 
-    /* release all blocked threads */
+    flushesSinceCheck = 0;
+  }
+
+  void SharedLazyTessellationCache::setMaxSize(const size_t new_max_size)
+  {
+    linkedlist_mtx.lock();
+    maxSize = new_max_size;
+    flushesSinceCheck = 0;
+    linkedlist_mtx.unlock();
+  }
+
+  bool SharedLazyTessellationCache::growRequired()
+  {
+    /* the linked list of thread states has to be locked by the caller */
+    if (maxSize <= size || size == 0) return false;
+
+    /* the hit rate is checked each time the entire cache got replaced */
+    if (++flushesSinceCheck < NUM_CACHE_SEGMENTS) return false;
+    flushesSinceCheck = 0;
+
+    const size_t hits   = sumStats(&ThreadWorkState::hits);
+    const size_t misses = sumStats(&ThreadWorkState::misses);
+    const size_t deltaHits   = hits   - hitsAtCheck;
+    const size_t deltaMisses = misses - missesAtCheck;
+    hitsAtCheck   = hits;
+    missesAtCheck = misses;
+
+    /* grow if more than 10% of the lookups missed while the cache cycled once */
+    return 10*deltaMisses > deltaHits+deltaMisses;
+  }
+
+  size_t SharedLazyTessellationCache::sumStats(std::atomic<size_t> ThreadWorkState::*counter)
+  {
+    size_t sum = 0;
     for (ThreadWorkState *t=current_t_state;t!=nullptr;t=t->next)
-      unlockThread(t,-THREAD_BLOCK_ATOMIC_ADD);
+      sum += (t->*counter).load(std::memory_order_relaxed);
+    return sum;
+  }
 
-    /* unlock the linked list of thread states */
-    linkedlist_mtx.unlock();	    
+  size_t SharedLazyTessellationCache::getHits()
+  {
+    linkedlist_mtx.lock();
+    const size_t hits = sumStats(&ThreadWorkState::hits);
+    linkedlist_mtx.unlock();
+    return hits;
+  }
 
-    /* unlock the reset_state */
-    reset_state.unlock();
+  size_t SharedLazyTessellationCache::getMisses()
+  {
+    linkedlist_mtx.lock();
+    const size_t misses = sumStats(&ThreadWorkState::misses);
+    linkedlist_mtx.unlock();
+    return misses;
   }
 
+  void SharedLazyTessellationCache::resetStats()
+  {
+    /* counters of threads doing lookups concurrently may miss the reset */
+    linkedlist_mtx.lock();
+    for (ThreadWorkState *t=current_t_state;t!=nullptr;t=t->next) {
+      t->hits.store(0, std::memory_order_relaxed);
+      t->misses.store(0, std::memory_order_relaxed);
+    }
+    hitsAtCheck = missesAtCheck = 0;
+    flushes = 0;
+    linkedlist_mtx.unlock();
+  }
 
   ////////////////////////////////////////////////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////////////////////////////////////////////////
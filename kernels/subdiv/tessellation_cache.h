@@ -35,6 +35,8 @@ namespace embree
   };
   
   void resizeTessellationCache(size_t new_size);
+  void resizeTessellationCacheMaxSize(size_t max_size);
+  void growTessellationCache();
   void resetTessellationCache();
   
  ////////////////////////////////////////////////////////////////////////////////
@@ -49,8 +51,18 @@ namespace embree
    ThreadWorkState* next;
    bool allocated;
 
+   /* cache statistics, only written by the owning thread */
+   std::atomic<size_t> hits;
+   std::atomic<size_t> misses;
+
+   /* range of blocks reserved by the thread in the current segment */
+   size_t allocBegin;
+   size_t allocEnd;
+   size_t allocEpoch;
+
    __forceinline ThreadWorkState(bool allocated = false) 
-     : counter(0), next(nullptr), allocated(allocated) 
+     : counter(0), next(nullptr), allocated(allocated), hits(0), misses(0),
+       allocBegin(0), allocEnd(0), allocEpoch(-1)
    {
      assert( ((size_t)this % 64) == 0 ); 
    }   
@@ -70,6 +82,7 @@ namespace embree
 #endif
    static const size_t MAX_TESSELLATION_CACHE_SIZE     = REF_TAG_MASK+1;
    static const size_t BLOCK_SIZE                      = 64;
+   static const size_t MAX_THREAD_ALLOC_BLOCKS         = 256;
    
 
     /*! Per thread tessellation ref cache */
@@ -132,6 +145,15 @@ namespace embree
    size_t size;
    size_t maxBlocks;
    ThreadWorkState *threadWorkState;
+
+   /* auto sizing, the cache grows up to maxSize if it gets flushed
+    * too often, a maxSize not larger than size disables auto sizing */
+   size_t maxSize;
+   std::atomic<size_t> growSize;
+   size_t flushesSinceCheck;
+   size_t hitsAtCheck;
+   size_t missesAtCheck;
+   std::atomic<size_t> flushes;
       
    __aligned(64) std::atomic<size_t> localTime;
    __aligned(64) std::atomic<size_t> next_block;
@@ -139,6 +161,7 @@ namespace embree
    __aligned(64) SpinLock   linkedlist_mtx;
    __aligned(64) std::atomic<size_t> switch_block_threshold;
    __aligned(64) std::atomic<size_t> numRenderThreads;
+   __aligned(64) std::atomic<size_t> segmentEpoch;
 
 
  public:
@@ -176,6 +199,11 @@ namespace embree
      return sharedLazyTessellationCache.getTime(globalTime);
    }
 
+   /* counts an event of the calling thread without a locked instruction */
+   static __forceinline void count(std::atomic<size_t>& counter) {
+     counter.store(counter.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+   }
+
    /* per thread lock */
    __forceinline void lockThreadLoop (ThreadWorkState *const t_state) 
    { 
@@ -222,12 +250,16 @@ namespace embree
      {
        sharedLazyTessellationCache.lockThreadLoop(t_state);
        void* patch = SharedLazyTessellationCache::lookup(entry,globalTime);
-       if (patch) return (decltype(constructor())) patch;
+       if (patch) {
+         count(t_state->hits);
+         return (decltype(constructor())) patch;
+       }
        
        if (entry.mutex.try_lock())
        {
          if (!validTag(entry.tag,globalTime)) 
          {
+           count(t_state->misses);
            auto timeBefore = sharedLazyTessellationCache.getTime(globalTime);
            auto ret = constructor(); // thread is locked here!
            assert(ret);
@@ -283,13 +315,51 @@ namespace embree
      return index;
    }
 
+   /* number of blocks a thread reserves at once, small enough that the
+    * unused ends of the reserved ranges waste at most 1/4 of a segment */
+   __forceinline size_t threadAllocBlocks() const {
+     return min(MAX_THREAD_ALLOC_BLOCKS,maxBlocks/(4*NUM_CACHE_SEGMENTS*max(size_t(1),size_t(numRenderThreads))));
+   }
+
+   /* allocates from the range reserved by the thread, such that only
+    * every few allocations touch the shared block counter */
+   __forceinline size_t allocThread(ThreadWorkState *const t_state, const size_t blocks)
+   {
+     if (likely(t_state->allocEpoch == segmentEpoch && t_state->allocBegin+blocks <= t_state->allocEnd))
+     {
+       const size_t index = t_state->allocBegin;
+       t_state->allocBegin += blocks;
+       return index;
+     }
+
+     const size_t reserveBlocks = threadAllocBlocks();
+     if (blocks >= reserveBlocks)
+       return alloc(blocks);
+
+     /* near the end of the segment the thread reserves only the remaining
+      * blocks, such that the segment gets switched only once the requested
+      * blocks do not fit anymore */
+     const size_t threshold = switch_block_threshold;
+     size_t index = next_block.load();
+     size_t numBlocks = 0;
+     do {
+       if (unlikely(index + blocks >= threshold)) return (size_t)-1;
+       numBlocks = min(reserveBlocks,threshold-1-index);
+     } while (!next_block.compare_exchange_weak(index,index+numBlocks));
+
+     t_state->allocEpoch = segmentEpoch;
+     t_state->allocBegin = index+blocks;
+     t_state->allocEnd   = index+numBlocks;
+     return index;
+   }
+
    static __forceinline void* malloc(const size_t bytes)
    {
      size_t block_index = -1;
      ThreadWorkState *const t_state = threadState();
      while (true)
      {
-       block_index = sharedLazyTessellationCache.alloc((bytes+BLOCK_SIZE-1)/BLOCK_SIZE);
+       block_index = sharedLazyTessellationCache.allocThread(t_state,(bytes+BLOCK_SIZE-1)/BLOCK_SIZE);
        if (block_index == (size_t)-1)
        {
          sharedLazyTessellationCache.unlockThread(t_state);		  
@@ -317,9 +387,27 @@ namespace embree
 
    void allocNextSegment();
    void realloc(const size_t newSize);
+   void setMaxSize(const size_t newMaxSize);
+
+   /* grows the cache if requested by a flush, all threads using the cache get blocked */
+   void grow();
 
    void reset();
 
+   /* statistics summed over all threads */
+   size_t getHits();
+   size_t getMisses();
+   size_t getFlushes() { return flushes; }
+   void resetStats();
+
+ private:
+   size_t sumStats(std::atomic<size_t> ThreadWorkState::*counter);
+   bool growRequired();
+   void resize(const size_t newSize);
+   void initSegments();
+
+ public:
+
    static SharedLazyTessellationCache sharedLazyTessellationCache;
  };
 }
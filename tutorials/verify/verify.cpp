@@ -12,6 +12,7 @@
 #include "../../kernels/common/context.h"
 #include "../../kernels/common/geometry.h"
 #include "../../kernels/common/scene.h"
+#include "../../kernels/geometry/triangle_triangle_intersector.h"
 #include <regex>
 #include <stack>
 
@@ -2130,39 +2131,81 @@ namespace embree
     }
   };
 
-  struct InterpolateTrianglesTest : public VerifyApplication::Test
+  struct TessellationCacheStatsTest : public VerifyApplication::Test
   {
-    size_t N;
-    
-    InterpolateTrianglesTest (std::string name, int isa, size_t N)
-      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), N(N) {}
-    
-    bool checkTriangleInterpolation(RTCGeometry geom, int primID, float u, float v, int v0, int v1, int v2, RTCBufferType bufferType, unsigned int bufferSlot, float* data, size_t N, size_t N_total)
+    TessellationCacheStatsTest (std::string name, int isa)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS) {}
+
+    void interpolateAll(RTCGeometry geom, unsigned int numFaces)
     {
-      assert(N<256);
-      bool passed = true;
-      float P[256], dPdu[256], dPdv[256];
-      rtcInterpolate1(geom,primID,u,v,bufferType,bufferSlot,P,dPdu,dPdv,(unsigned int)N);
-      
-      for (size_t i=0; i<N; i++) {
-        float p0 = data[v0*N_total+i];
-        float p1 = data[v1*N_total+i];
-        float p2 = data[v2*N_total+i];
-        float p = (1.0f-u-v)*p0 + u*p1 + v*p2;
-        passed &= fabs(p-P[i]) < 1E-4f;
-      }
-      return passed;
+      float P[3];
+      for (unsigned int i=0; i<numFaces; i++)
+        rtcInterpolate0(geom,i,0.5f,0.5f,RTC_BUFFER_TYPE_VERTEX,0,P,3);
     }
     
-    bool checkTriangleInterpolation(RTCGeometry geom, RTCBufferType bufferType, unsigned int bufferSlot, float* vertices0, size_t N, size_t N_total)
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
-      bool passed = true;
-      passed &= checkTriangleInterpolation(geom,0,0.0f,0.0f,0,1,5,bufferType,bufferSlot,vertices0,N,N_total);
-      passed &= checkTriangleInterpolation(geom,0,0.5f,0.5f,0,1,5,bufferType,bufferSlot,vertices0,N,N_total);
-      passed &= checkTriangleInterpolation(geom,17,0.0f,0.0f,10,15,14,bufferType,bufferSlot,vertices0,N,N_total);
-      passed &= checkTriangleInterpolation(geom,17,0.5f,0.5f,10,15,14,bufferType,bufferSlot,vertices0,N,N_total);
-      return passed;
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MAX_SIZE,256*1024*1024);
+      AssertNoError(device);
+      if (rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MAX_SIZE) != 256*1024*1024)
+        return VerifyApplication::FAILED;
+      if (rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_SIZE) == 0)
+        return VerifyApplication::FAILED;
+      
+      VerifyScene scene(device,SceneFlags(RTC_SCENE_FLAG_NONE,RTC_BUILD_QUALITY_MEDIUM));
+      Ref<SceneGraph::SubdivMeshNode> mesh = SceneGraph::createSubdivSphere(zero,1.0f,8,4).dynamicCast<SceneGraph::SubdivMeshNode>();
+      unsigned int geomID = scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,mesh.dynamicCast<SceneGraph::Node>());
+      rtcCommitScene(scene);
+      AssertNoError(device);
+      RTCGeometry geom = rtcGetGeometry(scene,geomID);
+      const unsigned int numFaces = (unsigned int) mesh->verticesPerFace.size();
+
+      /* the first pass tessellates all patches, the second pass finds them in the cache */
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_HITS,0);
+      AssertNoError(device);
+      interpolateAll(geom,numFaces);
+      const ssize_t misses = rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MISSES);
+      interpolateAll(geom,numFaces);
+      const ssize_t hits = rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_HITS);
+      AssertNoError(device);
+      if (misses == 0 || hits < (ssize_t)numFaces)
+        return VerifyApplication::FAILED;
+
+      /* resetting the statistics zeros all counters */
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_FLUSHES,0);
+      AssertNoError(device);
+      if (rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_HITS) != 0 ||
+          rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MISSES) != 0 ||
+          rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_FLUSHES) != 0)
+        return VerifyApplication::FAILED;
+
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_HITS,1);
+      AssertError(device,RTC_ERROR_INVALID_ARGUMENT);
+      
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_TESSELLATION_CACHE_MAX_SIZE,0);
+      AssertNoError(device);
+      return VerifyApplication::PASSED;
     }
+  };
+
+  /* creates a subdivision geometry that shares the positions and the topology of the mesh */
+  RTCGeometry createSubdivGeometry(RTCDevice device, Ref<SceneGraph::SubdivMeshNode> mesh, avector<Vec3fa>& positions)
+  {
+    RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_SUBDIVISION);
+    rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, positions.data(), 0, sizeof(Vec3fa), positions.size());
+    rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX,  0, RTC_FORMAT_UINT,   mesh->position_indices.data(), 0, sizeof(unsigned int), mesh->position_indices.size());
+    rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_FACE,   0, RTC_FORMAT_UINT,   mesh->verticesPerFace.data(), 0, sizeof(unsigned int), mesh->verticesPerFace.size());
+    return geom;
+  }
+
+  struct TopologySourceTest : public VerifyApplication::Test
+  {
+    TopologySourceTest (std::string name, int isa)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS) {}
 
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
@@ -2170,180 +2213,246 @@ namespace embree
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
 
-      size_t M = num_interpolation_vertices*N+16; // pads the arrays with some valid data
-      
-      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
+      Ref<SceneGraph::SubdivMeshNode> mesh = SceneGraph::createSubdivSphere(zero,1.0f,8,4).dynamicCast<SceneGraph::SubdivMeshNode>();
+      const unsigned int numFaces = (unsigned int) mesh->verticesPerFace.size();
+      const unsigned int numEdges = (unsigned int) mesh->position_indices.size();
+      avector<Vec3fa> positions0 = mesh->positions[0];
+      avector<Vec3fa> positions1 = mesh->positions[0];
+      for (auto& p : positions1) p = 2.0f*p;
+
+      RTCGeometry geom0 = createSubdivGeometry(device,mesh,positions0);
+      rtcCommitGeometry(geom0);
       AssertNoError(device);
-      rtcSetGeometryVertexAttributeCount(geom,2);
-      
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, interpolation_triangle_indices, 0, 3*sizeof(unsigned int), num_interpolation_triangle_faces*3);
+
+      /* the second geometry copies the half edges of the first one */
+      RTCGeometry geom1 = createSubdivGeometry(device,mesh,positions1);
+      rtcSetGeometryTopologySource(geom1,geom0);
+      rtcCommitGeometry(geom1);
       AssertNoError(device);
+
+      bool passed = true;
+      for (unsigned int e=0; e<numEdges; e++)
+        passed &= rtcGetGeometryOppositeHalfEdge(geom0,0,e) == rtcGetGeometryOppositeHalfEdge(geom1,0,e);
       
-      std::vector<float> vertices0(M);
-      for (size_t i=0; i<M; i++) vertices0[i] = random_float();
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices0.data(), 0, N*sizeof(float), num_interpolation_vertices);
+      for (unsigned int f=0; f<numFaces; f++)
+      {
+        Vec3fa P0 = zero, P1 = zero;
+        rtcInterpolate0(geom0,f,0.25f,0.75f,RTC_BUFFER_TYPE_VERTEX,0,&P0.x,3);
+        rtcInterpolate0(geom1,f,0.25f,0.75f,RTC_BUFFER_TYPE_VERTEX,0,&P1.x,3);
+        passed &= length(2.0f*P0-P1) < 1E-4f;
+      }
       AssertNoError(device);
       
-      /*std::vector<float> vertices1(M);
-        for (size_t i=0; i<M; i++) vertices1[i] = random_float();
-        rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 1, RTC_FORMAT_FLOAT3, vertices1.data(), 0, N*sizeof(float), num_interpolation_vertices);
-        AssertNoError(device);*/
-      
-      std::vector<float> user_vertices0(M);
-      for (size_t i=0; i<M; i++) user_vertices0[i] = random_float();
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 0, RTCFormat(RTC_FORMAT_FLOAT+N), user_vertices0.data(), 0, N*sizeof(float), num_interpolation_vertices);
+      /* only subdivision geometries can be a topology source */
+      RTCGeometry tris = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
+      rtcSetGeometryTopologySource(geom1,tris);
+      AssertError(device,RTC_ERROR_INVALID_ARGUMENT);
+      rtcSetGeometryTopologySource(geom1,nullptr);
       AssertNoError(device);
-      
-      std::vector<float> user_vertices1(M);
-      for (size_t i=0; i<M; i++) user_vertices1[i] = random_float();
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 1, RTCFormat(RTC_FORMAT_FLOAT+N), user_vertices1.data(), 0, N*sizeof(float), num_interpolation_vertices);
+
+      /* topology sources must not form a cycle */
+      rtcSetGeometryTopologySource(geom1,geom0);
+      rtcSetGeometryTopologySource(geom0,geom1);
+      AssertError(device,RTC_ERROR_INVALID_ARGUMENT);
+      rtcSetGeometryTopologySource(geom0,geom0);
+      AssertError(device,RTC_ERROR_INVALID_ARGUMENT);
+
+      /* a source with different vertex indices is not copied, reversing the faces changes the opposite half edges */
+      std::vector<unsigned int> reversed = mesh->position_indices;
+      for (unsigned int f=0, e=0; f<numFaces; e+=mesh->verticesPerFace[f++])
+        std::reverse(reversed.begin()+e,reversed.begin()+e+mesh->verticesPerFace[f]);
+      RTCGeometry geom2 = createSubdivGeometry(device,mesh,positions0);
+      rtcSetSharedGeometryBuffer(geom2, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT, reversed.data(), 0, sizeof(unsigned int), reversed.size());
+      rtcSetGeometryTopologySource(geom2,geom0);
+      rtcCommitGeometry(geom2);
+      RTCGeometry geom3 = createSubdivGeometry(device,mesh,positions0);
+      rtcSetSharedGeometryBuffer(geom3, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT, reversed.data(), 0, sizeof(unsigned int), reversed.size());
+      rtcCommitGeometry(geom3);
       AssertNoError(device);
+      for (unsigned int e=0; e<numEdges; e++)
+        passed &= rtcGetGeometryOppositeHalfEdge(geom2,0,e) == rtcGetGeometryOppositeHalfEdge(geom3,0,e);
       
-      rtcDisableGeometry(geom);
+      rtcReleaseGeometry(geom3);
+      rtcReleaseGeometry(geom2);
+      rtcReleaseGeometry(tris);
+      rtcReleaseGeometry(geom1);
+      rtcReleaseGeometry(geom0);
       AssertNoError(device);
+      return (VerifyApplication::TestReturnValue) passed;
+    }
+  };
+
+  struct EdgeLevelFunctionTest : public VerifyApplication::Test
+  {
+    EdgeLevelFunctionTest (std::string name, int isa)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS) {}
+
+    /* level only depends on the first vertex, records the level of each half edge */
+    static void edgeLevelFunction(const RTCEdgeLevelFunctionNArguments* args)
+    {
+      std::vector<float>* levels = (std::vector<float>*) args->geometryUserPtr;
+      for (unsigned int i=0; i<args->N; i++) {
+        args->level[i] = 2.0f + 8.0f*fabsf(args->v0_x[i]);
+        (*levels)[args->edgeID[i]] = args->level[i];
+      }
+    }
+    
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      Ref<SceneGraph::SubdivMeshNode> mesh = SceneGraph::createSubdivSphere(zero,1.0f,8,4).dynamicCast<SceneGraph::SubdivMeshNode>();
+      const unsigned int numEdges = (unsigned int) mesh->position_indices.size();
+      std::vector<float> levels(numEdges,0.0f);
+
+      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_SUBDIVISION);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, mesh->positions[0].data(), 0, sizeof(Vec3fa), mesh->positions[0].size());
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX,  0, RTC_FORMAT_UINT,   mesh->position_indices.data(), 0, sizeof(unsigned int), numEdges);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_FACE,   0, RTC_FORMAT_UINT,   mesh->verticesPerFace.data(), 0, sizeof(unsigned int), mesh->verticesPerFace.size());
+      rtcSetGeometryUserData(geom,&levels);
+      rtcSetGeometryEdgeLevelFunction(geom,edgeLevelFunction);
       rtcCommitGeometry(geom);
       AssertNoError(device);
-      
+
+      /* every half edge got a level, and both half edges of an edge got the same level */
       bool passed = true;
-      if (N >= 3) {
-        passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,vertices0.data(),3,N);
-        //passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,1,vertices1.data(),3,N);
+      for (unsigned int e=0; e<numEdges; e++) {
+        const unsigned int opposite = rtcGetGeometryOppositeHalfEdge(geom,0,e);
+        passed &= levels[e] >= 2.0f;
+        passed &= levels[e] == levels[opposite];
       }
-      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,user_vertices0.data(),N,N);
-      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,1,user_vertices1.data(),N,N);
-      
-      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,vertices0.data(),1,N);
-      //passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,1,vertices1.data(),1,N);
-      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,user_vertices0.data(),1,N);
-      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,1,user_vertices1.data(),1,N);
 
+      VerifyScene scene(device,SceneFlags(RTC_SCENE_FLAG_NONE,RTC_BUILD_QUALITY_MEDIUM));
+      rtcAttachGeometry(scene,geom);
+      rtcCommitScene(scene);
+      AssertNoError(device);
+      
       rtcReleaseGeometry(geom);
       AssertNoError(device);
-
       return (VerifyApplication::TestReturnValue) passed;
     }
   };
 
-  __aligned(16) RTCGrid interpolation_grids[1];
-  
-  struct InterpolateGridTest : public VerifyApplication::Test
+  struct InterpolateSubdivGridTest : public VerifyApplication::Test
   {
-    size_t N;
+    unsigned int N;
     
-    InterpolateGridTest (std::string name, int isa, size_t N)
+    InterpolateSubdivGridTest (std::string name, int isa, unsigned int N)
       : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), N(N) {}
-    
-    bool checkGridInterpolation(RTCGeometry geom, int primID, float u, float v, RTCBufferType bufferType, unsigned int bufferSlot, size_t N)
+
+    /* compares the grid against single interpolations at the same u/v locations */
+    bool checkGrid(RTCGeometry geom, unsigned int primID, unsigned int subPatchID, unsigned int numEdges, RTCBufferType bufferType, unsigned int bufferSlot, unsigned int N)
     {
-      assert(N<256);
+      const unsigned int width = 5, height = 3, M = width*height;
+      std::vector<float> P(N*M), dPdu(N*M), dPdv(N*M);
+      
+      RTCInterpolateGridArguments args;
+      args.geometry = geom;
+      args.primID = primID;
+      args.subPatchID = subPatchID;
+      args.width = width;
+      args.height = height;
+      args.bufferType = bufferType;
+      args.bufferSlot = bufferSlot;
+      args.P = P.data();
+      args.dPdu = dPdu.data();
+      args.dPdv = dPdv.data();
+      args.ddPdudu = nullptr;
+      args.ddPdvdv = nullptr;
+      args.ddPdudv = nullptr;
+      args.valueCount = N;
+      rtcInterpolateGrid(&args);
+
       bool passed = true;
-      float P[256], dPdu[256], dPdv[256];
-      rtcInterpolate1(geom,primID,u,v,bufferType,bufferSlot,P,dPdu,dPdv,(unsigned int)N);
-      
-      for (size_t i=0; i<N; i++)
+      for (unsigned int y=0; y<height; y++)
       {
-        float p = (2.0f*u+3.0f*v)+float(i);
-        passed &= fabs(p-P[i]) < 1E-4f;
+        for (unsigned int x=0; x<width; x++)
+        {
+          float u = float(x)/float(width-1);
+          float v = float(y)/float(height-1);
+          if (numEdges != 4) {
+            u += 2.0f*float(subPatchID%4)+0.5f;
+            v += 2.0f*float(subPatchID/4)+0.5f;
+          }
+          float P1[256], dPdu1[256], dPdv1[256];
+          rtcInterpolate1(geom,primID,u,v,bufferType,bufferSlot,P1,dPdu1,dPdv1,N);
+          
+          for (unsigned int i=0; i<N; i++) {
+            const unsigned int j = i*M+y*width+x;
+            passed &= fabsf(P[j]-P1[i]) < 1E-3f;
+            passed &= fabsf(dPdu[j]-dPdu1[i]) < 1E-2f*max(1.0f,fabsf(dPdu1[i]));
+            passed &= fabsf(dPdv[j]-dPdv1[i]) < 1E-2f*max(1.0f,fabsf(dPdv1[i]));
+          }
+        }
       }
       return passed;
     }
     
-    bool checkGridInterpolation(RTCGeometry geom, RTCBufferType bufferType, unsigned int bufferSlot, size_t N)
-    {
-      bool passed = true;
-      for (size_t i=0; i<100; i++) {
-        const float u = random_float();
-        const float v = random_float();
-        passed &= checkGridInterpolation(geom,0,u,v,bufferType,bufferSlot,N);
-      }
-      return passed;
-    }
-
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
-
-      size_t M = 16*N+16; // pads the arrays with some valid data
-      
-      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_GRID);
-      AssertNoError(device);
-
-      interpolation_grids[0].startVertexID = 0;
-      interpolation_grids[0].stride = 4;
-      interpolation_grids[0].width = 4;
-      interpolation_grids[0].height = 4;
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_GRID, 0, RTC_FORMAT_GRID, interpolation_grids, 0, sizeof(RTCGrid), 1);
-      AssertNoError(device);
-      
-      std::vector<float> vertices0(M);
-      for (size_t y=0; y<4; y++)
-        for (size_t x=0; x<4; x++)
-          for (size_t i=0; i<N; i++)
-            vertices0[(y*4+x)*N+i] = (2.0f*float(x)/3.0f + 3.0f*y/3.0f)+float(i);
       
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices0.data(), 0, N*sizeof(float), 4*4);
-      AssertNoError(device);
+      Ref<SceneGraph::SubdivMeshNode> mesh = SceneGraph::createSubdivSphere(zero,1.0f,4,4).dynamicCast<SceneGraph::SubdivMeshNode>();
+      const size_t numVertices = mesh->positions[0].size();
+      std::vector<float> attribs(numVertices*N);
+      for (auto& a : attribs) a = random_float();
       
+      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_SUBDIVISION);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, mesh->positions[0].data(), 0, sizeof(Vec3fa), numVertices);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX,  0, RTC_FORMAT_UINT,   mesh->position_indices.data(), 0, sizeof(unsigned int), mesh->position_indices.size());
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_FACE,   0, RTC_FORMAT_UINT,   mesh->verticesPerFace.data(), 0, sizeof(unsigned int), mesh->verticesPerFace.size());
+      rtcSetGeometryVertexAttributeCount(geom,1);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 0, RTC_FORMAT_FLOAT, attribs.data(), 0, N*sizeof(float), numVertices);
       rtcCommitGeometry(geom);
       AssertNoError(device);
-      
+
       bool passed = true;
-      passed &= checkGridInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,N);
-      rtcReleaseGeometry(geom);
+      for (unsigned int f=0; f<mesh->verticesPerFace.size(); f++)
+      {
+        const unsigned int numEdges = mesh->verticesPerFace[f];
+        const unsigned int numSubPatches = numEdges == 4 ? 1 : numEdges;
+        for (unsigned int i=0; i<numSubPatches; i++) {
+          passed &= checkGrid(geom,f,i,numEdges,RTC_BUFFER_TYPE_VERTEX,0,3);
+          passed &= checkGrid(geom,f,i,numEdges,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,N);
+        }
+      }
       AssertNoError(device);
 
+      /* grids need at least 2x2 samples */
+      float P[4];
+      RTCInterpolateGridArguments args;
+      memset(&args,0,sizeof(args));
+      args.geometry = geom;
+      args.width = 1;
+      args.height = 1;
+      args.bufferType = RTC_BUFFER_TYPE_VERTEX;
+      args.P = P;
+      args.valueCount = 3;
+      rtcInterpolateGrid(&args);
+      AssertError(device,RTC_ERROR_INVALID_ARGUMENT);
+      
+      rtcReleaseGeometry(geom);
+      AssertNoError(device);
       return (VerifyApplication::TestReturnValue) passed;
     }
   };
-  
-  const size_t num_interpolation_hair_vertices = 13;
-  const size_t num_interpolation_hairs = 4;
-
-  __aligned(16) int interpolation_hair_indices[num_interpolation_hairs] = {
-    0, 3, 6, 9
-  };
 
-  struct InterpolateHairTest : public VerifyApplication::Test
+  struct SubdivPositionUpdateTest : public VerifyApplication::Test
   {
-    size_t N;
-    
-    InterpolateHairTest (std::string name, int isa, size_t N)
-      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), N(N) {}
-    
-    bool checkHairInterpolation(RTCGeometry geom, int primID, float u, float v, int v0, RTCBufferType bufferType, unsigned int bufferSlot, float* data, size_t N, size_t N_total)
-    {
-      assert(N<256);
-      bool passed = true;
-      float P[256], dPdu[256], dPdv[256];
-      rtcInterpolate1(geom,primID,u,v,bufferType,bufferSlot,P,dPdu,dPdv,(unsigned int)N);
-      
-      for (size_t i=0; i<N; i++) {
-        const float p00 = data[(v0+0)*N_total+i];
-        const float p01 = data[(v0+1)*N_total+i];
-        const float p02 = data[(v0+2)*N_total+i];
-        const float p03 = data[(v0+3)*N_total+i];
-        const float t0 = 1.0f - u, t1 = u;
-        const float p10 = p00 * t0 + p01 * t1;
-        const float p11 = p01 * t0 + p02 * t1;
-        const float p12 = p02 * t0 + p03 * t1;
-        const float p20 = p10 * t0 + p11 * t1;
-        const float p21 = p11 * t0 + p12 * t1;
-        const float p30 = p20 * t0 + p21 * t1;
-        passed &= fabs(p30-P[i]) < 1E-4f;
-      }
-      return passed;
-    }
-    
-    bool checkHairInterpolation(RTCGeometry geom, RTCBufferType bufferType, unsigned int bufferSlot, float* vertices0, size_t N, size_t N_total)
+    SubdivPositionUpdateTest (std::string name, int isa)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS) {}
+
+    float intersect(RTCScene scene, const Vec3fa& org)
     {
-      bool passed = true;
-      passed &= checkHairInterpolation(geom,0,0.0f,0.0f,0,bufferType,bufferSlot,vertices0,N,N_total);
-      passed &= checkHairInterpolation(geom,1,0.5f,0.0f,3,bufferType,bufferSlot,vertices0,N,N_total);
-      passed &= checkHairInterpolation(geom,2,0.0f,0.0f,6,bufferType,bufferSlot,vertices0,N,N_total);
-      passed &= checkHairInterpolation(geom,3,0.2f,0.0f,9,bufferType,bufferSlot,vertices0,N,N_total);
-      return passed;
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      RTCRayHit ray = makeRay(org,normalize(-org));
+      rtcIntersect1(scene,&context,&ray);
+      return ray.ray.tfar;
     }
     
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
@@ -2352,386 +2461,502 @@ namespace embree
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
 
-      size_t M = num_interpolation_hair_vertices*N+16; // pads the arrays with some valid data
-      
-      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_ROUND_BEZIER_CURVE);
+      Ref<SceneGraph::SubdivMeshNode> mesh = SceneGraph::createSubdivSphere(zero,1.0f,8,4).dynamicCast<SceneGraph::SubdivMeshNode>();
+      avector<Vec3fa> positions = mesh->positions[0];
+      avector<Vec3fa> scaled = mesh->positions[0];
+      for (auto& p : scaled) p = 2.0f*p;
+
+      /* the dynamic scene only updates the vertex positions */
+      RTCSceneRef scene0 = rtcNewScene(device);
+      rtcSetSceneFlags(scene0,RTC_SCENE_FLAG_DYNAMIC);
+      RTCGeometry geom0 = createSubdivGeometry(device,mesh,positions);
+      rtcSetGeometryTessellationRate(geom0,4.0f);
+      rtcCommitGeometry(geom0);
+      rtcAttachGeometry(scene0,geom0);
+      rtcCommitScene(scene0);
       AssertNoError(device);
-      rtcSetGeometryVertexAttributeCount(geom,2);
       
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT, interpolation_hair_indices, 0, sizeof(unsigned int), num_interpolation_hairs);
+      /* the first build creates the grids, the second one updates them in place */
+      bool passed = rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES) == 0;
+      for (size_t i=0; i<positions.size(); i++) positions[i] = scaled[i];
+      rtcUpdateGeometryBuffer(geom0,RTC_BUFFER_TYPE_VERTEX,0);
+      rtcCommitGeometry(geom0);
+      rtcCommitScene(scene0);
       AssertNoError(device);
-      
-      std::vector<float> vertices0(M);
-      for (size_t i=0; i<M; i++) vertices0[i] = random_float();
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, vertices0.data(), 0, N*sizeof(float), num_interpolation_hair_vertices);
+      const ssize_t numUpdates = rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES);
+      passed &= numUpdates > 0;
+
+      /* the reference scene gets built from the scaled positions */
+      RTCSceneRef scene1 = rtcNewScene(device);
+      RTCGeometry geom1 = createSubdivGeometry(device,mesh,scaled);
+      rtcSetGeometryTessellationRate(geom1,4.0f);
+      rtcCommitGeometry(geom1);
+      rtcAttachGeometry(scene1,geom1);
+      rtcCommitScene(scene1);
       AssertNoError(device);
-      
-      /*std::vector<float> vertices1(M);
-        for (size_t i=0; i<M; i++) vertices1[i] = random_float();
-        rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 1, RTC_FORMAT_FLOAT4, vertices1.data(), 0, N*sizeof(float), num_interpolation_hair_vertices);
-        AssertNoError(device);*/
-      
-      std::vector<float> user_vertices0(M);
-      for (size_t i=0; i<M; i++) user_vertices0[i] = random_float();
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 0, RTCFormat(RTC_FORMAT_FLOAT+N), user_vertices0.data(), 0, N*sizeof(float), num_interpolation_hair_vertices);
-      AssertNoError(device);
-      
-      std::vector<float> user_vertices1(M);
-      for (size_t i=0; i<M; i++) user_vertices1[i] = random_float();
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 1, RTCFormat(RTC_FORMAT_FLOAT+N), user_vertices1.data(), 0, N*sizeof(float), num_interpolation_hair_vertices);
-      AssertNoError(device);
-      
-      rtcDisableGeometry(geom);
-      AssertNoError(device);
-      rtcCommitGeometry(geom);
-      AssertNoError(device);
-      
-      bool passed = true;
-      if (N >= 4) {
-        passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,vertices0.data(),4,N);
-        //passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,1,vertices1.data(),4,N);
+
+      RTCBounds bounds0, bounds1;
+      rtcGetSceneBounds(scene0,&bounds0);
+      rtcGetSceneBounds(scene1,&bounds1);
+      passed &= fabsf(bounds0.upper_x-bounds1.upper_x) < 1E-4f && fabsf(bounds0.lower_x-bounds1.lower_x) < 1E-4f;
+
+      for (size_t i=0; i<16; i++) {
+        const Vec3fa org = 5.0f*normalize(Vec3fa(2.0f*random_float()-1.0f,2.0f*random_float()-1.0f,2.0f*random_float()-1.0f));
+        passed &= fabsf(intersect(scene0,org)-intersect(scene1,org)) < 1E-4f;
       }
-      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,user_vertices0.data(),N,N);
-      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,1,user_vertices1.data(),N,N);
-      
-      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,vertices0.data(),1,N);
-      //passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,1,vertices1.data(),1,N);
-      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,user_vertices0.data(),1,N);
-      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,1,user_vertices1.data(),1,N);
+      AssertNoError(device);
 
-      rtcReleaseGeometry(geom);
+      /* changing the tessellation rate rebuilds the grids */
+      rtcSetGeometryTessellationRate(geom0,5.0f);
+      rtcCommitGeometry(geom0);
+      rtcCommitScene(scene0);
       AssertNoError(device);
+      passed &= rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES) == numUpdates;
 
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES,0);
+      AssertNoError(device);
+      passed &= rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_SUBDIVISION_GRID_UPDATES) == 0;
+      
+      rtcReleaseGeometry(geom0);
+      rtcReleaseGeometry(geom1);
       return (VerifyApplication::TestReturnValue) passed;
     }
   };
 
-  /////////////////////////////////////////////////////////////////////////////////
-  /////////////////////////////////////////////////////////////////////////////////
-  /////////////////////////////////////////////////////////////////////////////////
-  /////////////////////////////////////////////////////////////////////////////////
-
-  struct TriangleHitTest : public VerifyApplication::IntersectTest
+  struct DisplacementCacheTest : public VerifyApplication::Test
   {
-    SceneFlags sflags; 
-    RTCBuildQuality quality; 
+    DisplacementCacheTest (std::string name, int isa)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS) {}
 
-    TriangleHitTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
-      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
+    static void displacementFunction(const RTCDisplacementFunctionNArguments* args)
+    {
+      std::atomic<size_t>* numCalls = (std::atomic<size_t>*) args->geometryUserPtr;
+      numCalls->fetch_add(1);
+      for (unsigned int i=0; i<args->N; i++) {
+        const float d = 0.1f*sinf(10.0f*args->u[i])*cosf(10.0f*args->v[i]);
+        args->P_x[i] += d*args->Ng_x[i];
+        args->P_y[i] += d*args->Ng_y[i];
+        args->P_z[i] += d*args->Ng_z[i];
+      }
+    }
 
-    inline Vec3fa uniformSampleTriangle(const Vec3fa &a, const Vec3fa &b, const Vec3fa &c, float &u, float& v)
+    float intersect(RTCScene scene, const Vec3fa& org)
     {
-      const float su = sqrtf(u);
-      v *= su;
-      u = 1.0f-su;
-      if (u < 0.001f || v < 0.001f || (u+v) > 0.999f) { u = 0.333f; v = 0.333f; } // avoid hitting edges
-      return c + u * (a-c) + v * (b-c);
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      RTCRayHit ray = makeRay(org,normalize(-org));
+      rtcIntersect1(scene,&context,&ray);
+      return ray.ray.tfar;
     }
 
+    /* moves the triangle, which rebuilds the scene without changing the subdivision geometry */
+    void moveTriangle(RTCScene scene, RTCGeometry triangle, Vec3fa* vertices, float x)
+    {
+      vertices[0] = Vec3fa(x+10.0f,0.0f,0.0f);
+      vertices[1] = Vec3fa(x+11.0f,0.0f,0.0f);
+      vertices[2] = Vec3fa(x+10.0f,1.0f,0.0f);
+      rtcUpdateGeometryBuffer(triangle,RTC_BUFFER_TYPE_VERTEX,0);
+      rtcCommitGeometry(triangle);
+      rtcCommitScene(scene);
+    }
+    
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
-      if (!supportsIntersectMode(device,imode))
-        return VerifyApplication::SKIPPED;
-     
-      Vec3f vertices[4] = {
-        Vec3f(0.0f,0.0f,0.0f),
-        Vec3f(1.0f,0.0f,0.0f),
-        Vec3f(0.0f,1.0f,0.0f),
-        Vec3f(zero) // dummy vertex for 16 byte padding
-      };
-      Triangle triangles[1] = {
-        Triangle(0,1,2)
-      };
+
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_DISPLACEMENT_CACHE_SIZE,64*1024*1024);
+      AssertNoError(device);
+      if (rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_DISPLACEMENT_CACHE_SIZE) != 64*1024*1024)
+        return VerifyApplication::FAILED;
+
       RTCSceneRef scene = rtcNewScene(device);
-      rtcSetSceneFlags(scene,sflags.sflags);
-      rtcSetSceneBuildQuality(scene,sflags.qflags);
-      
-      RTCGeometry geom = rtcNewGeometry (device, RTC_GEOMETRY_TYPE_TRIANGLE);
-      rtcSetGeometryBuildQuality(geom,quality);
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices , 0, sizeof(Vec3f), 3);
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX , 0, RTC_FORMAT_UINT3,  triangles, 0, sizeof(Triangle), 1);
-      rtcCommitGeometry(geom);
-      rtcAttachGeometry(scene,geom);
-      rtcReleaseGeometry(geom);
-      rtcCommitScene (scene);
+      rtcSetSceneFlags(scene,RTC_SCENE_FLAG_DYNAMIC);
+
+      std::atomic<size_t> numCalls(0);
+      Ref<SceneGraph::SubdivMeshNode> mesh = SceneGraph::createSubdivSphere(zero,1.0f,8,4).dynamicCast<SceneGraph::SubdivMeshNode>();
+      RTCGeometry subdiv = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_SUBDIVISION);
+      rtcSetSharedGeometryBuffer(subdiv, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, mesh->positions[0].data(), 0, sizeof(Vec3fa), mesh->positions[0].size());
+      rtcSetSharedGeometryBuffer(subdiv, RTC_BUFFER_TYPE_INDEX,  0, RTC_FORMAT_UINT,   mesh->position_indices.data(), 0, sizeof(unsigned int), mesh->position_indices.size());
+      rtcSetSharedGeometryBuffer(subdiv, RTC_BUFFER_TYPE_FACE,   0, RTC_FORMAT_UINT,   mesh->verticesPerFace.data(), 0, sizeof(unsigned int), mesh->verticesPerFace.size());
+      rtcSetGeometryTessellationRate(subdiv,8.0f);
+      rtcSetGeometryUserData(subdiv,&numCalls);
+      rtcSetGeometryDisplacementFunction(subdiv,displacementFunction);
+      rtcCommitGeometry(subdiv);
+      rtcAttachGeometry(scene,subdiv);
+
+      RTCGeometry triangle = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
+      Vec3fa* vertices = (Vec3fa*) rtcSetNewGeometryBuffer(triangle, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, sizeof(Vec3fa), 3);
+      unsigned int* indices = (unsigned int*) rtcSetNewGeometryBuffer(triangle, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, 3*sizeof(unsigned int), 1);
+      indices[0] = 0; indices[1] = 1; indices[2] = 2;
+      rtcAttachGeometry(scene,triangle);
+      moveTriangle(scene,triangle,vertices,0.0f);
       AssertNoError(device);
 
-      float u[256], v[256];
-      RTCRayHit rays[256];
-      for (size_t i=0; i<256; i++)
-      {
-        u[i] = random_float(); 
-        v[i] = random_float();
-        Vec3fa from(0.0f,0.0f,-1.0f);
-        Vec3fa to = uniformSampleTriangle(vertices[1],vertices[2],vertices[0],u[i],v[i]);
-        rays[i] = makeRay(from,to-from);
+      std::vector<Vec3fa> orgs;
+      std::vector<float> dist;
+      for (size_t i=0; i<16; i++) {
+        orgs.push_back(5.0f*normalize(Vec3fa(2.0f*random_float()-1.0f,2.0f*random_float()-1.0f,2.0f*random_float()-1.0f)));
+        dist.push_back(intersect(scene,orgs.back()));
       }
-      IntersectWithMode(imode,ivariant,scene,rays,256);
-
-      for (size_t i=0; i<256; i++)
-      {
-        
-        if (!(ivariant & VARIANT_INTERSECT)) 
-        {
-          if (rays[i].ray.tfar != float(neg_inf)) return VerifyApplication::FAILED;          
-          continue;
-        }
-
+      
+      /* rebuilding the scene reuses all displaced positions */
+      const size_t numCalls0 = numCalls;
+      moveTriangle(scene,triangle,vertices,1.0f);
+      AssertNoError(device);
+      bool passed = numCalls0 != 0 && numCalls == numCalls0;
+      for (size_t i=0; i<orgs.size(); i++)
+        passed &= fabsf(intersect(scene,orgs[i])-dist[i]) < 1E-4f;
 
-        if (rays[i].hit.geomID != 0) return VerifyApplication::FAILED;
-        if (rays[i].hit.primID != 0) return VerifyApplication::FAILED;
-        if (abs(rays[i].hit.u - u[i]) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-        if (abs(rays[i].hit.v - v[i]) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-        if (abs(rays[i].ray.tfar - 1.0f) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-        const Vec3fa org(rays[i].ray.org_x,rays[i].ray.org_y,rays[i].ray.org_z);
-        const Vec3fa dir(rays[i].ray.dir_x,rays[i].ray.dir_y,rays[i].ray.dir_z);
-        const Vec3fa ht  = org + rays[i].ray.tfar*dir;
-        const Vec3fa huv = vertices[0] + rays[i].hit.u*(vertices[1]-vertices[0]) + rays[i].hit.v*(vertices[2]-vertices[0]);
-        if (reduce_max(abs(ht-huv)) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-        const Vec3fa Ng = Vec3fa(rays[i].hit.Ng_x,rays[i].hit.Ng_y,rays[i].hit.Ng_z);
-        if (reduce_max(abs(Ng - Vec3fa(0.0f,0.0f,1.0f))) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-      }
+      /* committing the subdivision geometry clears its cache */
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_DISPLACEMENT_CACHE_SIZE,0);
+      rtcCommitGeometry(subdiv);
+      rtcCommitScene(scene);
       AssertNoError(device);
+      const size_t numCalls1 = numCalls;
+      passed &= numCalls1 > numCalls0;
 
-      return VerifyApplication::PASSED;
+      /* without cache the rebuild calls the displacement function again */
+      moveTriangle(scene,triangle,vertices,2.0f);
+      AssertNoError(device);
+      passed &= numCalls > numCalls1;
+      for (size_t i=0; i<orgs.size(); i++)
+        passed &= fabsf(intersect(scene,orgs[i])-dist[i]) < 1E-4f;
+      
+      rtcReleaseGeometry(subdiv);
+      rtcReleaseGeometry(triangle);
+      return (VerifyApplication::TestReturnValue) passed;
     }
   };
 
-  struct QuadHitTest : public VerifyApplication::IntersectTest
+  struct DisplacementCacheFileTest : public VerifyApplication::Test
   {
-    SceneFlags sflags; 
-    RTCBuildQuality quality; 
-
-    QuadHitTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
-      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
+    DisplacementCacheFileTest (std::string name, int isa)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS) {}
 
+    float intersect(RTCScene scene, const Vec3fa& org)
+    {
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      RTCRayHit ray = makeRay(org,normalize(-org));
+      rtcIntersect1(scene,&context,&ray);
+      return ray.ray.tfar;
+    }
+    
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
-      if (!supportsIntersectMode(device,imode))
-        return VerifyApplication::SKIPPED;
-     
-      Vec3f vertices[5] = {
-        Vec3f(0.0f,0.0f,0.0f),
-        Vec3f(1.0f,0.0f,0.0f),
-        Vec3f(1.0f,1.0f,0.0f),
-        Vec3f(0.0f,1.0f,0.0f),
-        Vec3f(zero) // dummy vertex for 16 byte padding
-      };
-      int quads[4] = {
-        0,1,2,3
-      };
-      RTCSceneRef scene = rtcNewScene(device);
-      rtcSetSceneFlags(scene,sflags.sflags);
-      rtcSetSceneBuildQuality(scene,sflags.qflags);
+      const std::string filename = "displacement_cache_" + stringOfISA(isa) + ".bin";
+      
+      /* without displacement cache the file cannot get written */
+      std::atomic<size_t> numCalls(0);
+      Ref<SceneGraph::SubdivMeshNode> mesh = SceneGraph::createSubdivSphere(zero,1.0f,8,4).dynamicCast<SceneGraph::SubdivMeshNode>();
+      avector<Vec3fa> positions = mesh->positions[0];
+      RTCGeometry geom0 = createSubdivGeometry(device,mesh,positions);
+      rtcSetGeometryTessellationRate(geom0,8.0f);
+      rtcSetGeometryUserData(geom0,&numCalls);
+      rtcSetGeometryDisplacementFunction(geom0,DisplacementCacheTest::displacementFunction);
+      rtcCommitGeometry(geom0);
+      rtcSaveGeometryDisplacementCache(geom0,filename.c_str(),1);
+      AssertError(device,RTC_ERROR_INVALID_OPERATION);
+
+      /* the first run evaluates the displacement and writes the cache */
+      rtcSetDeviceProperty(device,RTC_DEVICE_PROPERTY_DISPLACEMENT_CACHE_SIZE,64*1024*1024);
+      rtcCommitGeometry(geom0);
+      RTCSceneRef scene0 = rtcNewScene(device);
+      rtcAttachGeometry(scene0,geom0);
+      rtcCommitScene(scene0);
+      rtcSaveGeometryDisplacementCache(geom0,filename.c_str(),1);
+      AssertNoError(device);
+      bool passed = numCalls != 0;
+
+      std::vector<Vec3fa> orgs;
+      std::vector<float> dist;
+      for (size_t i=0; i<16; i++) {
+        orgs.push_back(5.0f*normalize(Vec3fa(2.0f*random_float()-1.0f,2.0f*random_float()-1.0f,2.0f*random_float()-1.0f)));
+        dist.push_back(intersect(scene0,orgs.back()));
+      }
+
+      /* the second run reads the cache and does not evaluate the displacement */
+      const size_t numCalls0 = numCalls;
+      RTCGeometry geom1 = createSubdivGeometry(device,mesh,positions);
+      rtcSetGeometryTessellationRate(geom1,8.0f);
+      rtcSetGeometryUserData(geom1,&numCalls);
+      rtcSetGeometryDisplacementFunction(geom1,DisplacementCacheTest::displacementFunction);
+      rtcCommitGeometry(geom1);
+      passed &= !rtcLoadGeometryDisplacementCache(geom1,filename.c_str(),2);
+      passed &= rtcLoadGeometryDisplacementCache(geom1,filename.c_str(),1);
+      RTCSceneRef scene1 = rtcNewScene(device);
+      rtcAttachGeometry(scene1,geom1);
+      rtcCommitScene(scene1);
+      AssertNoError(device);
+      passed &= numCalls == numCalls0;
+      for (size_t i=0; i<orgs.size(); i++)
+        passed &= fabsf(intersect(scene1,orgs[i])-dist[i]) < 1E-4f;
+
+      /* files written for other positions or tessellation rates are not read */
+      rtcSetGeometryTessellationRate(geom1,4.0f);
+      rtcCommitGeometry(geom1);
+      passed &= !rtcLoadGeometryDisplacementCache(geom1,filename.c_str(),1);
+      rtcSetGeometryTessellationRate(geom1,8.0f);
+      positions[0] = 1.1f*positions[0];
+      rtcUpdateGeometryBuffer(geom1,RTC_BUFFER_TYPE_VERTEX,0);
+      rtcCommitGeometry(geom1);
+      passed &= !rtcLoadGeometryDisplacementCache(geom1,filename.c_str(),1);
+      passed &= !rtcLoadGeometryDisplacementCache(geom1,"missing_displacement_cache.bin",1);
+      AssertNoError(device);
       
-      RTCGeometry geom = rtcNewGeometry (device, RTC_GEOMETRY_TYPE_QUAD);
-      rtcSetGeometryBuildQuality(geom, quality);
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices , 0, sizeof(Vec3f), 4);
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX , 0, RTC_FORMAT_UINT4,  quads, 0, 4*sizeof(int), 1);
+      remove(filename.c_str());
+      rtcReleaseGeometry(geom0);
+      rtcReleaseGeometry(geom1);
+      return (VerifyApplication::TestReturnValue) passed;
+    }
+  };
+
+  struct CompressedGridTest : public VerifyApplication::Test
+  {
+    CompressedGridTest (std::string name, int isa)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS) {}
+
+    static bool memoryMonitor(void* userPtr, ssize_t bytes, bool post)
+    {
+      std::atomic<ssize_t>* bytesUsed = (std::atomic<ssize_t>*) userPtr;
+      *bytesUsed += bytes;
+      return true;
+    }
+
+    /* returns the number of bytes the build of the scene allocates */
+    ssize_t commitScene(RTCScene scene, std::atomic<ssize_t>& bytesUsed)
+    {
+      const ssize_t bytes0 = bytesUsed;
+      rtcCommitScene(scene);
+      return bytesUsed-bytes0;
+    }
+
+    RTCScene createScene(RTCDevice device, RTCSceneFlags flags, Ref<SceneGraph::SubdivMeshNode> mesh, avector<Vec3fa>& positions)
+    {
+      RTCScene scene = rtcNewScene(device);
+      rtcSetSceneFlags(scene,flags);
+      RTCGeometry geom = createSubdivGeometry(device,mesh,positions);
+      rtcSetGeometryTessellationRate(geom,32.0f);
+      rtcSetGeometryDisplacementFunction(geom,DisplacementCacheTest::displacementFunction);
+      std::atomic<size_t>* numCalls = new std::atomic<size_t>(0);
+      rtcSetGeometryUserData(geom,numCalls);
       rtcCommitGeometry(geom);
       rtcAttachGeometry(scene,geom);
       rtcReleaseGeometry(geom);
-      rtcCommitScene (scene);
-      AssertNoError(device);
-
-      float u[256], v[256];
-      RTCRayHit rays[256];
-      for (size_t i=0; i<256; i++)
-      {
-        u[i] = random_float(); 
-        v[i] = random_float();
-        if (u[i] < 0.001f || v[i] < 0.001f || u[i] > 0.999f || v[i] > 0.999f) { u[i] = 0.333f; v[i] = 0.333f; } // avoid hitting edges
-        Vec3fa from(0.0f,0.0f,-1.0f);
-        Vec3fa to = vertices[0] + u[i]*(vertices[1]-vertices[0]) + v[i]*(vertices[3]-vertices[0]);
-        rays[i] = makeRay(from,to-from);
-      }
-      IntersectWithMode(imode,ivariant,scene,rays,256);
+      return scene;
+    }
 
-      for (size_t i=0; i<256; i++)
+    /* compares the hits of single rays and ray packets in both scenes */
+    bool compareHits(RTCScene scene0, RTCScene scene1)
+    {
+      bool passed = true;
+      for (size_t i=0; i<16; i++)
       {
-        if (!(ivariant & VARIANT_INTERSECT))
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        RTCRayHit ray[4];
+        RTCRayHit4 ray4;
+        for (size_t j=0; j<4; j++) {
+          const Vec3fa org = 5.0f*normalize(Vec3fa(2.0f*random_float()-1.0f,2.0f*random_float()-1.0f,2.0f*random_float()-1.0f));
+          ray[j] = makeRay(org,normalize(-org));
+          setRay(ray4,j,ray[j]);
+        }
+        __aligned(16) int valid4[4] = { -1,-1,-1,-1 };
+        rtcIntersect4(valid4,scene0,&context,&ray4);
+        for (size_t j=0; j<4; j++)
         {
-          if (rays[i].ray.tfar != float(neg_inf)) return VerifyApplication::FAILED;          
-          continue;
+          RTCRayHit ray0 = ray[j];
+          rtcIntersect1(scene0,&context,&ray0);
+          rtcIntersect1(scene1,&context,&ray[j]);
+          passed &= ray0.hit.geomID != RTC_INVALID_GEOMETRY_ID && ray0.hit.primID == ray[j].hit.primID;
+          passed &= fabsf(ray0.ray.tfar-ray[j].ray.tfar) < 1E-3f;
+          passed &= ray4.hit.primID[j] == ray[j].hit.primID && fabsf(ray4.ray.tfar[j]-ray[j].ray.tfar) < 1E-3f;
         }
-        if (rays[i].hit.primID != 0) return VerifyApplication::FAILED;
-        if (abs(rays[i].hit.u - u[i]) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-        if (abs(rays[i].hit.v - v[i]) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-        if (abs(rays[i].ray.tfar - 1.0f) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-
-        const Vec3fa org(rays[i].ray.org_x,rays[i].ray.org_y,rays[i].ray.org_z);
-        const Vec3fa dir(rays[i].ray.dir_x,rays[i].ray.dir_y,rays[i].ray.dir_z);
-        const Vec3fa ht  = org + rays[i].ray.tfar*dir;
-        const Vec3fa huv = vertices[0] + rays[i].hit.u*(vertices[1]-vertices[0]) + rays[i].hit.v*(vertices[3]-vertices[0]);
-        if (reduce_max(abs(ht-huv)) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
-        const Vec3fa Ng = Vec3fa(rays[i].hit.Ng_x,rays[i].hit.Ng_y,rays[i].hit.Ng_z);
-        if (reduce_max(abs(Ng - Vec3fa(0.0f,0.0f,1.0f))) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
       }
-      AssertNoError(device);
-      
-      return VerifyApplication::PASSED;
+      return passed;
     }
-  };
-  
-  struct RayMasksTest : public VerifyApplication::IntersectTest
-  {
-    SceneFlags sflags; 
-    RTCBuildQuality quality; 
-
-    RayMasksTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
-      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
 
+    void releaseScene(RTCScene scene)
+    {
+      RTCGeometry geom = rtcGetGeometry(scene,0);
+      delete (std::atomic<size_t>*) rtcGetGeometryUserData(geom);
+      rtcReleaseScene(scene);
+    }
+    
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
-      if (!supportsIntersectMode(device,imode))
-        return VerifyApplication::SKIPPED;
+      std::atomic<ssize_t> bytesUsed(0);
+      rtcSetDeviceMemoryMonitorFunction(device,memoryMonitor,&bytesUsed);
+
+      Ref<SceneGraph::SubdivMeshNode> mesh = SceneGraph::createSubdivSphere(zero,1.0f,16,8).dynamicCast<SceneGraph::SubdivMeshNode>();
+      avector<Vec3fa> positions0 = mesh->positions[0];
+      avector<Vec3fa> positions1 = mesh->positions[0];
+
+      /* compact scenes store the grids compressed, which hits the same primitives at nearly the same distances */
+      RTCScene scene0 = createScene(device,RTCSceneFlags(RTC_SCENE_FLAG_COMPACT | RTC_SCENE_FLAG_DYNAMIC),mesh,positions0);
+      RTCScene scene1 = createScene(device,RTC_SCENE_FLAG_DYNAMIC,mesh,positions1);
+      const ssize_t bytes0 = commitScene(scene0,bytesUsed);
+      const ssize_t bytes1 = commitScene(scene1,bytesUsed);
+      AssertNoError(device);
+      bool passed = bytes0 < ssize_t(0.9*double(bytes1));
+      passed &= compareHits(scene0,scene1);
+
+      /* the compressed grids get requantized when the positions change */
+      for (size_t i=0; i<positions0.size(); i++) {
+        positions0[i] = 2.0f*positions0[i];
+        positions1[i] = 2.0f*positions1[i];
+      }
+      rtcUpdateGeometryBuffer(rtcGetGeometry(scene0,0),RTC_BUFFER_TYPE_VERTEX,0);
+      rtcCommitGeometry(rtcGetGeometry(scene0,0));
+      rtcCommitScene(scene0);
+      rtcUpdateGeometryBuffer(rtcGetGeometry(scene1,0),RTC_BUFFER_TYPE_VERTEX,0);
+      rtcCommitGeometry(rtcGetGeometry(scene1,0));
+      rtcCommitScene(scene1);
+      AssertNoError(device);
+      passed &= compareHits(scene0,scene1);
+
+      releaseScene(scene0);
+      releaseScene(scene1);
+      rtcSetDeviceMemoryMonitorFunction(device,nullptr,nullptr);
+      return (VerifyApplication::TestReturnValue) passed;
+    }
+  };
 
+  struct InterpolateTrianglesTest : public VerifyApplication::Test
+  {
+    size_t N;
+    
+    InterpolateTrianglesTest (std::string name, int isa, size_t N)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), N(N) {}
+    
+    bool checkTriangleInterpolation(RTCGeometry geom, int primID, float u, float v, int v0, int v1, int v2, RTCBufferType bufferType, unsigned int bufferSlot, float* data, size_t N, size_t N_total)
+    {
+      assert(N<256);
       bool passed = true;
-      Vec3fa pos0 = Vec3fa(-10,0,-10);
-      Vec3fa pos1 = Vec3fa(-10,0,+10);
-      Vec3fa pos2 = Vec3fa(+10,0,-10);
-      Vec3fa pos3 = Vec3fa(+10,0,+10);
-      
-      VerifyScene scene(device,sflags);
-      unsigned int geom0 = scene.addSphere      (sampler,quality,pos0,1.0f,50).first;
-      unsigned int geom1 = scene.addQuadSphere  (sampler,quality,pos1,1.0f,50).first; 
-      unsigned int geom2 = scene.addSubdivSphere(sampler,quality,pos2,1.0f,5,4).first;
-      unsigned int geom3 = scene.addHair        (sampler,quality,pos3,1.0f,1.0f,1).first;
-      RTCGeometry hgeom0 = rtcGetGeometry(scene,geom0);
-      RTCGeometry hgeom1 = rtcGetGeometry(scene,geom1);
-      RTCGeometry hgeom2 = rtcGetGeometry(scene,geom2);
-      RTCGeometry hgeom3 = rtcGetGeometry(scene,geom3);
-      rtcSetGeometryMask(hgeom0,1);
-      rtcSetGeometryMask(hgeom1,2);
-      rtcSetGeometryMask(hgeom2,4);
-      rtcSetGeometryMask(hgeom3,8);
-      rtcCommitScene (scene);
-      AssertNoError(device);
+      float P[256], dPdu[256], dPdv[256];
+      rtcInterpolate1(geom,primID,u,v,bufferType,bufferSlot,P,dPdu,dPdv,(unsigned int)N);
       
-      for (unsigned i=0; i<16; i++) 
-      {
-        unsigned mask0 = i;
-        unsigned mask1 = i+1;
-        unsigned mask2 = i+2;
-        unsigned mask3 = i+3;
-        unsigned masks[4] = { mask0, mask1, mask2, mask3 };
-        RTCRayHit ray0 = makeRay(pos0+Vec3fa(0,10,0),Vec3fa(0,-1,0)); ray0.ray.mask = mask0;
-        RTCRayHit ray1 = makeRay(pos1+Vec3fa(0,10,0),Vec3fa(0,-1,0)); ray1.ray.mask = mask1;
-        RTCRayHit ray2 = makeRay(pos2+Vec3fa(0,10,0),Vec3fa(0,-1,0)); ray2.ray.mask = mask2;
-        RTCRayHit ray3 = makeRay(pos3+Vec3fa(0,10,0),Vec3fa(0,-1,0)); ray3.ray.mask = mask3;
-        RTCRayHit rays[4] = { ray0, ray1, ray2, ray3 };
-        IntersectWithMode(imode,ivariant,scene,rays,4);
-        for (size_t j=0; j<4; j++)
-          passed &= masks[j] & (1<<j) ? rays[j].hit.geomID != RTC_INVALID_GEOMETRY_ID : rays[j].hit.geomID == RTC_INVALID_GEOMETRY_ID;
+      for (size_t i=0; i<N; i++) {
+        float p0 = data[v0*N_total+i];
+        float p1 = data[v1*N_total+i];
+        float p2 = data[v2*N_total+i];
+        float p = (1.0f-u-v)*p0 + u*p1 + v*p2;
+        passed &= fabs(p-P[i]) < 1E-4f;
       }
-      AssertNoError(device);
-
-      return (VerifyApplication::TestReturnValue) passed;
+      return passed;
     }
-  };
-
-  struct BackfaceCullingTest : public VerifyApplication::IntersectTest
-  {
-    SceneFlags sflags;
-    RTCBuildQuality quality;
-    GeometryType gtype;
-
-    BackfaceCullingTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, GeometryType gtype, IntersectMode imode, IntersectVariant ivariant)
-      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality), gtype(gtype) {}
     
+    bool checkTriangleInterpolation(RTCGeometry geom, RTCBufferType bufferType, unsigned int bufferSlot, float* vertices0, size_t N, size_t N_total)
+    {
+      bool passed = true;
+      passed &= checkTriangleInterpolation(geom,0,0.0f,0.0f,0,1,5,bufferType,bufferSlot,vertices0,N,N_total);
+      passed &= checkTriangleInterpolation(geom,0,0.5f,0.5f,0,1,5,bufferType,bufferSlot,vertices0,N,N_total);
+      passed &= checkTriangleInterpolation(geom,17,0.0f,0.0f,10,15,14,bufferType,bufferSlot,vertices0,N,N_total);
+      passed &= checkTriangleInterpolation(geom,17,0.5f,0.5f,10,15,14,bufferType,bufferSlot,vertices0,N,N_total);
+      return passed;
+    }
+
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
-      if (!supportsIntersectMode(device,imode))
-        return VerifyApplication::SKIPPED;
-       
-      /* create triangle that is front facing for a right handed 
-         coordinate system if looking along the z direction */
-      VerifyScene scene(device,sflags);
+
+      size_t M = num_interpolation_vertices*N+16; // pads the arrays with some valid data
+      
+      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
       AssertNoError(device);
-      const Vec3fa p0 = Vec3fa(0.0f);
-      const Vec3fa dx = Vec3fa(0.0f,1.0f,0.0f);
-      const Vec3fa dy = Vec3fa(1.0f,0.0f,0.0f);
-      switch (gtype) {
-      case TRIANGLE_MESH:    scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane(p0,dx,dy,1,1)); break;
-      case TRIANGLE_MESH_MB: scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane(p0,dx,dy,1,1)->set_motion_vector(zero)); break;
-      case QUAD_MESH:        scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadPlane(p0,dx,dy,1,1)); break;
-      case QUAD_MESH_MB:     scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadPlane(p0,dx,dy,1,1)->set_motion_vector(zero)); break;
-      case GRID_MESH:        scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridPlane(p0,dx,dy,1,1)); break;
-      case GRID_MESH_MB:     scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridPlane(p0,dx,dy,1,1)->set_motion_vector(zero)); break;
-      case SUBDIV_MESH:      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivPlane(p0,dx,dy,1,1,4.0f)); break;
-      case SUBDIV_MESH_MB:   scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivPlane(p0,dx,dy,1,1,4.0f)->set_motion_vector(zero)); break;
-      default:               throw std::runtime_error("unsupported geometry type: "+to_string(gtype)); 
-      }
+      rtcSetGeometryVertexAttributeCount(geom,2);
       
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, interpolation_triangle_indices, 0, 3*sizeof(unsigned int), num_interpolation_triangle_faces*3);
       AssertNoError(device);
-      rtcCommitScene (scene);
+      
+      std::vector<float> vertices0(M);
+      for (size_t i=0; i<M; i++) vertices0[i] = random_float();
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices0.data(), 0, N*sizeof(float), num_interpolation_vertices);
       AssertNoError(device);
-
-      const size_t numRays = 1000;
-      RTCRayHit rays[numRays];
-      bool passed = true;
-
-      for (size_t i=0; i<numRays; i++) {
-        const float rx = random_float();
-        const float ry = random_float();
-        if (i%2) rays[i] = makeRay(Vec3fa(rx,ry,+1),Vec3fa(0,0,-1)); 
-        else     rays[i] = makeRay(Vec3fa(rx,ry,-1),Vec3fa(0,0,+1)); 
-      }
       
-      IntersectWithMode(imode,ivariant,scene,rays,numRays);
+      /*std::vector<float> vertices1(M);
+        for (size_t i=0; i<M; i++) vertices1[i] = random_float();
+        rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 1, RTC_FORMAT_FLOAT3, vertices1.data(), 0, N*sizeof(float), num_interpolation_vertices);
+        AssertNoError(device);*/
       
-      for (size_t i=0; i<numRays; i++) 
-      {
-        Vec3fa dir(rays[i].ray.dir_x,rays[i].ray.dir_y,rays[i].ray.dir_z);
-        Vec3fa Ng (rays[i].hit.Ng_x, rays[i].hit.Ng_y, rays[i].hit.Ng_z);
-        if (i%2) passed &= rays[i].hit.geomID == RTC_INVALID_GEOMETRY_ID;
-        else {
-          passed &= rays[i].hit.geomID == 0;
-          if (ivariant & VARIANT_INTERSECT)
-            passed &= dot(dir,Ng) < 0.0f;
-        }
+      std::vector<float> user_vertices0(M);
+      for (size_t i=0; i<M; i++) user_vertices0[i] = random_float();
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 0, RTCFormat(RTC_FORMAT_FLOAT+N), user_vertices0.data(), 0, N*sizeof(float), num_interpolation_vertices);
+      AssertNoError(device);
+      
+      std::vector<float> user_vertices1(M);
+      for (size_t i=0; i<M; i++) user_vertices1[i] = random_float();
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 1, RTCFormat(RTC_FORMAT_FLOAT+N), user_vertices1.data(), 0, N*sizeof(float), num_interpolation_vertices);
+      AssertNoError(device);
+      
+      rtcDisableGeometry(geom);
+      AssertNoError(device);
+      rtcCommitGeometry(geom);
+      AssertNoError(device);
+      
+      bool passed = true;
+      if (N >= 3) {
+        passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,vertices0.data(),3,N);
+        //passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,1,vertices1.data(),3,N);
       }
+      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,user_vertices0.data(),N,N);
+      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,1,user_vertices1.data(),N,N);
+      
+      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,vertices0.data(),1,N);
+      //passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,1,vertices1.data(),1,N);
+      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,user_vertices0.data(),1,N);
+      passed &= checkTriangleInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,1,user_vertices1.data(),1,N);
+
+      rtcReleaseGeometry(geom);
       AssertNoError(device);
 
       return (VerifyApplication::TestReturnValue) passed;
     }
   };
 
-  struct IntersectionFilterTest : public VerifyApplication::IntersectTest
+  __aligned(16) RTCGrid interpolation_grids[1];
+  
+  struct InterpolateGridTest : public VerifyApplication::Test
   {
-    SceneFlags sflags;
-    RTCBuildQuality quality;
-    bool subdiv;
-
-    IntersectionFilterTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, bool subdiv, IntersectMode imode, IntersectVariant ivariant)
-      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality), subdiv(subdiv) {}
+    size_t N;
     
-    static void intersectionFilterN(const RTCFilterFunctionNArguments* const args)
+    InterpolateGridTest (std::string name, int isa, size_t N)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), N(N) {}
+    
+    bool checkGridInterpolation(RTCGeometry geom, int primID, float u, float v, RTCBufferType bufferType, unsigned int bufferSlot, size_t N)
     {
-      if ((size_t)args->geometryUserPtr != 123) 
-        return;
-
-      for (unsigned int i=0; i<args->N; i++)
+      assert(N<256);
+      bool passed = true;
+      float P[256], dPdu[256], dPdv[256];
+      rtcInterpolate1(geom,primID,u,v,bufferType,bufferSlot,P,dPdu,dPdv,(unsigned int)N);
+      
+      for (size_t i=0; i<N; i++)
       {
-	if (args->valid[i] != -1) continue;
-
-        /* reject hit */
-        if (RTCHitN_primID(args->hit,args->N,i) & 2) {
-          args->valid[i] = 0;
-        }
+        float p = (2.0f*u+3.0f*v)+float(i);
+        passed &= fabs(p-P[i]) < 1E-4f;
+      }
+      return passed;
+    }
+    
+    bool checkGridInterpolation(RTCGeometry geom, RTCBufferType bufferType, unsigned int bufferSlot, size_t N)
+    {
+      bool passed = true;
+      for (size_t i=0; i<100; i++) {
+        const float u = random_float();
+        const float v = random_float();
+        passed &= checkGridInterpolation(geom,0,u,v,bufferType,bufferSlot,N);
       }
+      return passed;
     }
 
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
@@ -2739,165 +2964,170 @@ namespace embree
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
-      if (!supportsIntersectMode(device,imode))
-        return VerifyApplication::SKIPPED;
 
-      VerifyScene scene(device,sflags);
-      Vec3fa p0(-0.75f,-0.25f,-10.0f), dx(4,0,0), dy(0,4,0);
-      unsigned int geomID0 = 0;
-      if (subdiv) geomID0 = scene.addSubdivPlane (sampler,quality, 4, p0, dx, dy).first;
-      else        geomID0 = scene.addPlane       (sampler,quality, 4, p0, dx, dy).first;
-      RTCGeometry geom0 = rtcGetGeometry(scene,geomID0);
-      rtcSetGeometryUserData(geom0,(void*)123);
-      rtcSetGeometryIntersectFilterFunction (geom0,intersectionFilterN);
-      rtcSetGeometryOccludedFilterFunction (geom0,intersectionFilterN);
-      rtcCommitScene (scene);
+      size_t M = 16*N+16; // pads the arrays with some valid data
+      
+      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_GRID);
+      AssertNoError(device);
+
+      interpolation_grids[0].startVertexID = 0;
+      interpolation_grids[0].stride = 4;
+      interpolation_grids[0].width = 4;
+      interpolation_grids[0].height = 4;
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_GRID, 0, RTC_FORMAT_GRID, interpolation_grids, 0, sizeof(RTCGrid), 1);
       AssertNoError(device);
       
-      RTCRayHit rays[16];
-      for (unsigned int iy=0; iy<4; iy++) 
-      {
-        for (unsigned int ix=0; ix<4; ix++) 
-        {
-          unsigned int primID = iy*4+ix;
-          if (!subdiv) primID *= 2;
-          rays[iy*4+ix] = makeRay(Vec3fa(float(ix),float(iy),0.0f),Vec3fa(0,0,-1));
-        }
-      }
-      IntersectWithMode(imode,ivariant,scene,rays,16);
+      std::vector<float> vertices0(M);
+      for (size_t y=0; y<4; y++)
+        for (size_t x=0; x<4; x++)
+          for (size_t i=0; i<N; i++)
+            vertices0[(y*4+x)*N+i] = (2.0f*float(x)/3.0f + 3.0f*y/3.0f)+float(i);
       
-      bool passed = true;
-      for (unsigned int iy=0; iy<4; iy++) 
-      {
-        for (unsigned int ix=0; ix<4; ix++) 
-        {
-          unsigned int primID = iy*4+ix;
-          if (!subdiv) primID *= 2;
-          RTCRayHit& ray = rays[iy*4+ix];
-          bool ok = true;
-          if (ivariant & VARIANT_INTERSECT)
-            ok = (primID & 2) ? (ray.hit.geomID == RTC_INVALID_GEOMETRY_ID) : (ray.hit.geomID == 0);
-          else
-            ok = ((primID & 2) != 0) == (ray.ray.tfar != float(neg_inf));
-          if (!ok) passed = false;
-        }
-      }
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices0.data(), 0, N*sizeof(float), 4*4);
+      AssertNoError(device);
+      
+      rtcCommitGeometry(geom);
+      AssertNoError(device);
+      
+      bool passed = true;
+      passed &= checkGridInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,N);
+      rtcReleaseGeometry(geom);
       AssertNoError(device);
 
-      return (VerifyApplication::TestReturnValue) passed;
-    }
-  };
-
-  struct InstancingTest : public VerifyApplication::IntersectTest
-  {
-    SceneFlags sflags;
-    RTCBuildQuality quality;
-    bool subdiv;
-
-    InstancingTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, bool subdiv, IntersectMode imode, IntersectVariant ivariant)
-      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality), subdiv(subdiv) {
-      }
+      return (VerifyApplication::TestReturnValue) passed;
+    }
+  };
+  
+  const size_t num_interpolation_hair_vertices = 13;
+  const size_t num_interpolation_hairs = 4;
 
-    struct IntersectContext {
-      RTCIntersectContext context;
-      int numHits[16];
-    };
+  __aligned(16) int interpolation_hair_indices[num_interpolation_hairs] = {
+    0, 3, 6, 9
+  };
+
+  struct InterpolateHairTest : public VerifyApplication::Test
+  {
+    size_t N;
     
-    static void intersectFilter(const RTCFilterFunctionNArguments* args)
+    InterpolateHairTest (std::string name, int isa, size_t N)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), N(N) {}
+    
+    bool checkHairInterpolation(RTCGeometry geom, int primID, float u, float v, int v0, RTCBufferType bufferType, unsigned int bufferSlot, float* data, size_t N, size_t N_total)
     {
-      assert(args);
-      assert(args->context);
-
-      IntersectContext* context = (IntersectContext*)(args->context);
-
-      for (unsigned int i=0; i<args->N; i++) 
-      {
-        const unsigned int rayId = RTCRayN_id(args->ray, args->N, i);
-        if(args->valid[i] && rayId >= 16)
-          throw std::runtime_error("Invalid ray id in intersection filter.");
-        if (args->valid[i])
-        {
-          assert(rayId < 16);
-          context->numHits[rayId] += 1;
-        }
+      assert(N<256);
+      bool passed = true;
+      float P[256], dPdu[256], dPdv[256];
+      rtcInterpolate1(geom,primID,u,v,bufferType,bufferSlot,P,dPdu,dPdv,(unsigned int)N);
+      
+      for (size_t i=0; i<N; i++) {
+        const float p00 = data[(v0+0)*N_total+i];
+        const float p01 = data[(v0+1)*N_total+i];
+        const float p02 = data[(v0+2)*N_total+i];
+        const float p03 = data[(v0+3)*N_total+i];
+        const float t0 = 1.0f - u, t1 = u;
+        const float p10 = p00 * t0 + p01 * t1;
+        const float p11 = p01 * t0 + p02 * t1;
+        const float p12 = p02 * t0 + p03 * t1;
+        const float p20 = p10 * t0 + p11 * t1;
+        const float p21 = p11 * t0 + p12 * t1;
+        const float p30 = p20 * t0 + p21 * t1;
+        passed &= fabs(p30-P[i]) < 1E-4f;
       }
+      return passed;
     }
-
+    
+    bool checkHairInterpolation(RTCGeometry geom, RTCBufferType bufferType, unsigned int bufferSlot, float* vertices0, size_t N, size_t N_total)
+    {
+      bool passed = true;
+      passed &= checkHairInterpolation(geom,0,0.0f,0.0f,0,bufferType,bufferSlot,vertices0,N,N_total);
+      passed &= checkHairInterpolation(geom,1,0.5f,0.0f,3,bufferType,bufferSlot,vertices0,N,N_total);
+      passed &= checkHairInterpolation(geom,2,0.0f,0.0f,6,bufferType,bufferSlot,vertices0,N,N_total);
+      passed &= checkHairInterpolation(geom,3,0.2f,0.0f,9,bufferType,bufferSlot,vertices0,N,N_total);
+      return passed;
+    }
+    
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
-      if (!supportsIntersectMode(device,imode))
-        return VerifyApplication::SKIPPED;
-
-      Ref<SceneGraph::Node> child;
-      Ref<SceneGraph::Node> parent;
-      if (subdiv)
-        child = SceneGraph::createSubdivSphere(Vec3fa(0.f), 1.f, 32, 2.f);
-      else
-        child = SceneGraph::createQuadSphere(Vec3fa(0.f), 1.f, 32);
-
-      for (int i = 0; i < RTC_MAX_INSTANCE_LEVEL_COUNT; ++i)
-      { 
-        parent = new SceneGraph::TransformNode(AffineSpace3fa(one), child);
-        child = parent;
-      }
-
-      sflags.sflags = sflags.sflags | RTC_SCENE_FLAG_CONTEXT_FILTER_FUNCTION;
-      IntersectContext ctx;
-      rtcInitIntersectContext(&ctx.context);
-      ctx.context.filter = intersectFilter;
 
-      VerifyScene scene(device, sflags);
-      scene.addGeometry(quality, parent);
-      rtcCommitScene(scene);
+      size_t M = num_interpolation_hair_vertices*N+16; // pads the arrays with some valid data
+      
+      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_ROUND_BEZIER_CURVE);
       AssertNoError(device);
-
-      RTCRayHit rays[16];
-      for (unsigned int iy=0; iy<4; iy++) 
-      {
-        for (unsigned int ix=0; ix<4; ix++) 
-        {
-          const int id = iy*4+ix;
-          rays[id] = makeRay(Vec3fa(float(ix)/10.f,float(iy)/10.f,-2.0f),Vec3fa(0,0,1));
-          rays[id].ray.id = id;
-          ctx.numHits[id] = 0;
-        }
-      }
-      IntersectWithMode(imode,ivariant,scene,rays,16,&ctx.context);
+      rtcSetGeometryVertexAttributeCount(geom,2);
+      
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT, interpolation_hair_indices, 0, sizeof(unsigned int), num_interpolation_hairs);
+      AssertNoError(device);
+      
+      std::vector<float> vertices0(M);
+      for (size_t i=0; i<M; i++) vertices0[i] = random_float();
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, vertices0.data(), 0, N*sizeof(float), num_interpolation_hair_vertices);
+      AssertNoError(device);
+      
+      /*std::vector<float> vertices1(M);
+        for (size_t i=0; i<M; i++) vertices1[i] = random_float();
+        rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 1, RTC_FORMAT_FLOAT4, vertices1.data(), 0, N*sizeof(float), num_interpolation_hair_vertices);
+        AssertNoError(device);*/
+      
+      std::vector<float> user_vertices0(M);
+      for (size_t i=0; i<M; i++) user_vertices0[i] = random_float();
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 0, RTCFormat(RTC_FORMAT_FLOAT+N), user_vertices0.data(), 0, N*sizeof(float), num_interpolation_hair_vertices);
+      AssertNoError(device);
+      
+      std::vector<float> user_vertices1(M);
+      for (size_t i=0; i<M; i++) user_vertices1[i] = random_float();
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 1, RTCFormat(RTC_FORMAT_FLOAT+N), user_vertices1.data(), 0, N*sizeof(float), num_interpolation_hair_vertices);
+      AssertNoError(device);
+      
+      rtcDisableGeometry(geom);
+      AssertNoError(device);
+      rtcCommitGeometry(geom);
+      AssertNoError(device);
+      
       bool passed = true;
-      for (unsigned int iy=0; iy<4; iy++) 
-      {
-        for (unsigned int ix=0; ix<4; ix++) 
-        {
-          const unsigned id = iy*4+ix;
-          passed &= (ctx.numHits[id] > 0);
-          RTCRayHit& ray = rays[id];
-          if (ivariant & VARIANT_INTERSECT)
-            passed &= (ray.hit.geomID != RTC_INVALID_GEOMETRY_ID);
-          else
-            passed &= (ray.ray.tfar == (float)neg_inf);
-        }
+      if (N >= 4) {
+        passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,vertices0.data(),4,N);
+        //passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,1,vertices1.data(),4,N);
       }
-      assert(passed);
+      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,user_vertices0.data(),N,N);
+      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,1,user_vertices1.data(),N,N);
+      
+      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,0,vertices0.data(),1,N);
+      //passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX,1,vertices1.data(),1,N);
+      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,0,user_vertices0.data(),1,N);
+      passed &= checkHairInterpolation(geom,RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE,1,user_vertices1.data(),1,N);
+
+      rtcReleaseGeometry(geom);
       AssertNoError(device);
 
       return (VerifyApplication::TestReturnValue) passed;
     }
   };
-    
-  struct InactiveRaysTest : public VerifyApplication::IntersectTest
+
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+
+  struct TriangleHitTest : public VerifyApplication::IntersectTest
   {
-    SceneFlags sflags;
-    RTCBuildQuality quality;
+    SceneFlags sflags; 
+    RTCBuildQuality quality; 
 
-    static const size_t N = 10;
-    static const size_t maxStreamSize = 100;
-    
-    InactiveRaysTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
+    TriangleHitTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
       : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
-   
+
+    inline Vec3fa uniformSampleTriangle(const Vec3fa &a, const Vec3fa &b, const Vec3fa &c, float &u, float& v)
+    {
+      const float su = sqrtf(u);
+      v *= su;
+      u = 1.0f-su;
+      if (u < 0.001f || v < 0.001f || (u+v) > 0.999f) { u = 0.333f; v = 0.333f; } // avoid hitting edges
+      return c + u * (a-c) + v * (b-c);
+    }
+
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
@@ -2905,60 +3135,79 @@ namespace embree
       errorHandler(nullptr,rtcGetDeviceError(device));
       if (!supportsIntersectMode(device,imode))
         return VerifyApplication::SKIPPED;
-
-      Vec3fa pos = zero;
-      VerifyScene scene(device,sflags);
-      scene.addSphere(sampler,RTC_BUILD_QUALITY_MEDIUM,pos,2.0f,50); // FIXME: use different geometries too
+     
+      Vec3f vertices[4] = {
+        Vec3f(0.0f,0.0f,0.0f),
+        Vec3f(1.0f,0.0f,0.0f),
+        Vec3f(0.0f,1.0f,0.0f),
+        Vec3f(zero) // dummy vertex for 16 byte padding
+      };
+      Triangle triangles[1] = {
+        Triangle(0,1,2)
+      };
+      RTCSceneRef scene = rtcNewScene(device);
+      rtcSetSceneFlags(scene,sflags.sflags);
+      rtcSetSceneBuildQuality(scene,sflags.qflags);
+      
+      RTCGeometry geom = rtcNewGeometry (device, RTC_GEOMETRY_TYPE_TRIANGLE);
+      rtcSetGeometryBuildQuality(geom,quality);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices , 0, sizeof(Vec3f), 3);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX , 0, RTC_FORMAT_UINT3,  triangles, 0, sizeof(Triangle), 1);
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(scene,geom);
+      rtcReleaseGeometry(geom);
       rtcCommitScene (scene);
       AssertNoError(device);
 
-      RTCRayHit invalid_ray; clearRay(invalid_ray);
-      invalid_ray.ray.tnear = pos_inf;
-      invalid_ray.ray.tfar  = 0.0f;
-      
-      size_t numFailures = 0;
-      for (size_t i=0; i<size_t(N*state->intensity); i++) 
+      float u[256], v[256];
+      RTCRayHit rays[256];
+      for (size_t i=0; i<256; i++)
       {
-        for (unsigned int M=1; M<maxStreamSize; M++)
+        u[i] = random_float(); 
+        v[i] = random_float();
+        Vec3fa from(0.0f,0.0f,-1.0f);
+        Vec3fa to = uniformSampleTriangle(vertices[1],vertices[2],vertices[0],u[i],v[i]);
+        rays[i] = makeRay(from,to-from);
+      }
+      IntersectWithMode(imode,ivariant,scene,rays,256);
+
+      for (size_t i=0; i<256; i++)
+      {
+        
+        if (!(ivariant & VARIANT_INTERSECT)) 
         {
-          bool valid[maxStreamSize];
-          __aligned(16) RTCRayHit rays[maxStreamSize];
-          for (unsigned int j=0; j<M; j++) 
-          {
-            if (rand()%2) {
-              valid[j] = true;
-              Vec3fa org = 2.0f*random_Vec3fa()-Vec3fa(1.0f);
-              Vec3fa dir = 2.0f*random_Vec3fa()-Vec3fa(1.0f);
-              rays[j] = makeRay(pos+org,dir); 
-            } else {
-              valid[j] = false;
-              rays[j] = invalid_ray;
-            }
-          }
-          IntersectWithMode(imode,ivariant,scene,rays,M);
-          for (size_t j=0; j<M; j++) {
-            if (valid[j]) continue;
-            numFailures += neq_ray_special(rays[j],invalid_ray);
-          }
+          if (rays[i].ray.tfar != float(neg_inf)) return VerifyApplication::FAILED;          
+          continue;
         }
+
+
+        if (rays[i].hit.geomID != 0) return VerifyApplication::FAILED;
+        if (rays[i].hit.primID != 0) return VerifyApplication::FAILED;
+        if (abs(rays[i].hit.u - u[i]) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
+        if (abs(rays[i].hit.v - v[i]) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
+        if (abs(rays[i].ray.tfar - 1.0f) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
+        const Vec3fa org(rays[i].ray.org_x,rays[i].ray.org_y,rays[i].ray.org_z);
+        const Vec3fa dir(rays[i].ray.dir_x,rays[i].ray.dir_y,rays[i].ray.dir_z);
+        const Vec3fa ht  = org + rays[i].ray.tfar*dir;
+        const Vec3fa huv = vertices[0] + rays[i].hit.u*(vertices[1]-vertices[0]) + rays[i].hit.v*(vertices[2]-vertices[0]);
+        if (reduce_max(abs(ht-huv)) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
+        const Vec3fa Ng = Vec3fa(rays[i].hit.Ng_x,rays[i].hit.Ng_y,rays[i].hit.Ng_z);
+        if (reduce_max(abs(Ng - Vec3fa(0.0f,0.0f,1.0f))) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
       }
       AssertNoError(device);
-      return (VerifyApplication::TestReturnValue) (numFailures == 0);
+
+      return VerifyApplication::PASSED;
     }
   };
 
-  struct WatertightTest : public VerifyApplication::IntersectTest
+  struct QuadHitTest : public VerifyApplication::IntersectTest
   {
-    ALIGNED_STRUCT_(16);
-    SceneFlags sflags;
-    std::string model;
-    Vec3fa pos;
-    static const size_t N = 10;
-    static const size_t maxStreamSize = 100;
-    
-    WatertightTest (std::string name, int isa, SceneFlags sflags, IntersectMode imode, std::string model, const Vec3fa& pos)
-      : VerifyApplication::IntersectTest(name,isa,imode,VARIANT_INTERSECT,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), model(model), pos(pos) {}
-    
+    SceneFlags sflags; 
+    RTCBuildQuality quality; 
+
+    QuadHitTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
+
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
@@ -2966,82 +3215,78 @@ namespace embree
       errorHandler(nullptr,rtcGetDeviceError(device));
       if (!supportsIntersectMode(device,imode))
         return VerifyApplication::SKIPPED;
-
-      avector<Vec3fa> motion_vector;
-      motion_vector.push_back(Vec3fa(0.0f));
-      motion_vector.push_back(Vec3fa(0.0f));
-
-      VerifyScene scene(device,sflags);
-      size_t size = state->intensity < 1.0f ? 50 : 500;
-      if      (model == "sphere.triangles") scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(pos,2.0f,size));
-      else if (model == "sphere.quads"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (pos,2.0f,size));
-      else if (model == "sphere.grids"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridSphere    (pos,2.0f,size));
-      else if (model == "sphere.subdiv"   ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivSphere  (pos,2.0f,4,64));
-      else if (model == "plane.triangles" ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size));
-      else if (model == "plane.quads"     ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadPlane     (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size));
-      else if (model == "plane.grids"     ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridPlane     (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size));
-      else if (model == "plane.subdiv"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivPlane   (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size,2));
-      else if (model == "sphere.triangles_mb") scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(pos,2.0f,size)->set_motion_vector(motion_vector));
-      else if (model == "sphere.quads_mb"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (pos,2.0f,size)->set_motion_vector(motion_vector));
-      else if (model == "sphere.grids_mb"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridSphere    (pos,2.0f,size)->set_motion_vector(motion_vector));
-      else if (model == "plane.triangles_mb" ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size)->set_motion_vector(motion_vector));
-      else if (model == "plane.quads_mb"     ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadPlane     (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size)->set_motion_vector(motion_vector));
-      else if (model == "plane.grids_mb"     ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridPlane     (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size)->set_motion_vector(motion_vector));
-      else throw std::runtime_error("unsupported mode "+model); 
-      bool plane = model.compare(0,5,"plane") == 0;
+     
+      Vec3f vertices[5] = {
+        Vec3f(0.0f,0.0f,0.0f),
+        Vec3f(1.0f,0.0f,0.0f),
+        Vec3f(1.0f,1.0f,0.0f),
+        Vec3f(0.0f,1.0f,0.0f),
+        Vec3f(zero) // dummy vertex for 16 byte padding
+      };
+      int quads[4] = {
+        0,1,2,3
+      };
+      RTCSceneRef scene = rtcNewScene(device);
+      rtcSetSceneFlags(scene,sflags.sflags);
+      rtcSetSceneBuildQuality(scene,sflags.qflags);
+      
+      RTCGeometry geom = rtcNewGeometry (device, RTC_GEOMETRY_TYPE_QUAD);
+      rtcSetGeometryBuildQuality(geom, quality);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices , 0, sizeof(Vec3f), 4);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX , 0, RTC_FORMAT_UINT4,  quads, 0, 4*sizeof(int), 1);
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(scene,geom);
+      rtcReleaseGeometry(geom);
       rtcCommitScene (scene);
       AssertNoError(device);
-      
-      size_t numTests = 0;
-      size_t numFailures = 0;
-      for (auto ivariant : state->intersectVariants)
-      for (size_t i=0; i<size_t(N*state->intensity); i++) 
+
+      float u[256], v[256];
+      RTCRayHit rays[256];
+      for (size_t i=0; i<256; i++)
       {
-        for (unsigned int M=1; M<maxStreamSize; M++)
+        u[i] = random_float(); 
+        v[i] = random_float();
+        if (u[i] < 0.001f || v[i] < 0.001f || u[i] > 0.999f || v[i] > 0.999f) { u[i] = 0.333f; v[i] = 0.333f; } // avoid hitting edges
+        Vec3fa from(0.0f,0.0f,-1.0f);
+        Vec3fa to = vertices[0] + u[i]*(vertices[1]-vertices[0]) + v[i]*(vertices[3]-vertices[0]);
+        rays[i] = makeRay(from,to-from);
+      }
+      IntersectWithMode(imode,ivariant,scene,rays,256);
+
+      for (size_t i=0; i<256; i++)
+      {
+        if (!(ivariant & VARIANT_INTERSECT))
         {
-          __aligned(16) RTCRayHit rays[maxStreamSize];
-          for (size_t j=0; j<M; j++) 
-          {
-            if (plane) {
-              Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f); dir.x = 1.0f;
-              rays[j] = makeRay(Vec3fa(pos.x-3.0f,0.0f,0.0f),dir); 
-            } else {
-              Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-              Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-              rays[j] = makeRay(pos+org,dir); 
-            }
-          }
-          IntersectWithMode(imode,ivariant,scene,rays,M);
-          for (unsigned int j=0; j<M; j++) {
-            numTests++;
-            if (ivariant & VARIANT_INTERSECT)
-              numFailures += rays[j].hit.geomID == RTC_INVALID_GEOMETRY_ID;
-            else
-              numFailures += rays[j].ray.tfar != float(neg_inf);
-          }
+          if (rays[i].ray.tfar != float(neg_inf)) return VerifyApplication::FAILED;          
+          continue;
         }
+        if (rays[i].hit.primID != 0) return VerifyApplication::FAILED;
+        if (abs(rays[i].hit.u - u[i]) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
+        if (abs(rays[i].hit.v - v[i]) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
+        if (abs(rays[i].ray.tfar - 1.0f) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
+
+        const Vec3fa org(rays[i].ray.org_x,rays[i].ray.org_y,rays[i].ray.org_z);
+        const Vec3fa dir(rays[i].ray.dir_x,rays[i].ray.dir_y,rays[i].ray.dir_z);
+        const Vec3fa ht  = org + rays[i].ray.tfar*dir;
+        const Vec3fa huv = vertices[0] + rays[i].hit.u*(vertices[1]-vertices[0]) + rays[i].hit.v*(vertices[3]-vertices[0]);
+        if (reduce_max(abs(ht-huv)) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
+        const Vec3fa Ng = Vec3fa(rays[i].hit.Ng_x,rays[i].hit.Ng_y,rays[i].hit.Ng_z);
+        if (reduce_max(abs(Ng - Vec3fa(0.0f,0.0f,1.0f))) > 16.0f*float(ulp)) return VerifyApplication::FAILED;
       }
       AssertNoError(device);
-
-      double failRate = double(numFailures) / double(max(size_t(1),numTests));
-      bool failed = failRate > 0.00002;
-      if (!silent) { printf(" (%f%%)", 100.0f*failRate); fflush(stdout); }
-      return (VerifyApplication::TestReturnValue)(!failed);
+      
+      return VerifyApplication::PASSED;
     }
   };
-
-  struct SmallTriangleHitTest : public VerifyApplication::IntersectTest
+  
+  struct RayMasksTest : public VerifyApplication::IntersectTest
   {
-    ALIGNED_STRUCT_(16);
-    SceneFlags sflags;
-    Vec3fa pos;
-    float radius;
-    static const size_t N = 10000;
-    static const size_t maxStreamSize = 100;
-    
-    SmallTriangleHitTest (std::string name, int isa, SceneFlags sflags, IntersectMode imode, const Vec3fa& pos, const float radius)
-      : VerifyApplication::IntersectTest(name,isa,imode,VARIANT_INTERSECT,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), pos(pos), radius(radius) {}
-    
+    SceneFlags sflags; 
+    RTCBuildQuality quality; 
+
+    RayMasksTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
+
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
@@ -3050,65 +3295,58 @@ namespace embree
       if (!supportsIntersectMode(device,imode))
         return VerifyApplication::SKIPPED;
 
+      bool passed = true;
+      Vec3fa pos0 = Vec3fa(-10,0,-10);
+      Vec3fa pos1 = Vec3fa(-10,0,+10);
+      Vec3fa pos2 = Vec3fa(+10,0,-10);
+      Vec3fa pos3 = Vec3fa(+10,0,+10);
+      
       VerifyScene scene(device,sflags);
-      LinearSpace3fa space(Vec3fa(1.0f,0.0f,0.0f),Vec3fa(0.0f,1.0f,0.0f),Vec3fa(0.0f,0.0f,1.0f));
-      space *= LinearSpace3fa::rotate(Vec3fa(4.0f,7.0f,-1.0f),4.34f);
-      const Vec3fa dx = 100.0f*normalize(space.vx);
-      const Vec3fa dy = 100.0f*normalize(space.vy);
-      const Vec3fa p = pos-0.5f*(dx+dy);
-      Ref<SceneGraph::TriangleMeshNode> plane = SceneGraph::createTrianglePlane (p,dx,dy,100,100).dynamicCast<SceneGraph::TriangleMeshNode>();
-      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,plane.dynamicCast<SceneGraph::Node>());
+      unsigned int geom0 = scene.addSphere      (sampler,quality,pos0,1.0f,50).first;
+      unsigned int geom1 = scene.addQuadSphere  (sampler,quality,pos1,1.0f,50).first; 
+      unsigned int geom2 = scene.addSubdivSphere(sampler,quality,pos2,1.0f,5,4).first;
+      unsigned int geom3 = scene.addHair        (sampler,quality,pos3,1.0f,1.0f,1).first;
+      RTCGeometry hgeom0 = rtcGetGeometry(scene,geom0);
+      RTCGeometry hgeom1 = rtcGetGeometry(scene,geom1);
+      RTCGeometry hgeom2 = rtcGetGeometry(scene,geom2);
+      RTCGeometry hgeom3 = rtcGetGeometry(scene,geom3);
+      rtcSetGeometryMask(hgeom0,1);
+      rtcSetGeometryMask(hgeom1,2);
+      rtcSetGeometryMask(hgeom2,4);
+      rtcSetGeometryMask(hgeom3,8);
       rtcCommitScene (scene);
       AssertNoError(device);
       
-      size_t numTests = 0;
-      size_t numFailures = 0;
-      //for (auto ivariant : state->intersectVariants)
-      IntersectVariant ivariant = VARIANT_INTERSECT_INCOHERENT;
-      size_t numRays = size_t(N*state->intensity);
-      for (size_t i=0; i<numRays; i+=maxStreamSize) 
+      for (unsigned i=0; i<16; i++) 
       {
-        unsigned int M = (unsigned int)min(maxStreamSize,numRays-i);
-        unsigned int primIDs[maxStreamSize];
-        __aligned(16) RTCRayHit rays[maxStreamSize];
-        for (size_t j=0; j<M; j++) 
-        {
-          Vec3fa org = pos + radius*(2.0f*random_Vec3fa() - Vec3fa(1.0f));
-          unsigned int primID = random_int() % plane->triangles.size();
-          Vec3fa v0 = plane->positions[0][plane->triangles[primID].v0];
-          Vec3fa v1 = plane->positions[0][plane->triangles[primID].v1];
-          Vec3fa v2 = plane->positions[0][plane->triangles[primID].v2];
-          Vec3fa c = (v0+v1+v2)/3.0f;
-          primIDs[j] = primID;
-          rays[j] = makeRay(org,c-org); 
-        }
-        IntersectWithMode(imode,ivariant,scene,rays,M);
-        for (size_t j=0; j<M; j++) {
-          Vec3fa dir(rays[j].ray.dir_x,rays[j].ray.dir_y,rays[j].ray.dir_z);
-          //if (abs(dot(normalize(dir),space.vz)) < 0.9f) continue;
-          numTests++;
-          numFailures += rays[j].hit.primID != primIDs[j];
-        }
+        unsigned mask0 = i;
+        unsigned mask1 = i+1;
+        unsigned mask2 = i+2;
+        unsigned mask3 = i+3;
+        unsigned masks[4] = { mask0, mask1, mask2, mask3 };
+        RTCRayHit ray0 = makeRay(pos0+Vec3fa(0,10,0),Vec3fa(0,-1,0)); ray0.ray.mask = mask0;
+        RTCRayHit ray1 = makeRay(pos1+Vec3fa(0,10,0),Vec3fa(0,-1,0)); ray1.ray.mask = mask1;
+        RTCRayHit ray2 = makeRay(pos2+Vec3fa(0,10,0),Vec3fa(0,-1,0)); ray2.ray.mask = mask2;
+        RTCRayHit ray3 = makeRay(pos3+Vec3fa(0,10,0),Vec3fa(0,-1,0)); ray3.ray.mask = mask3;
+        RTCRayHit rays[4] = { ray0, ray1, ray2, ray3 };
+        IntersectWithMode(imode,ivariant,scene,rays,4);
+        for (size_t j=0; j<4; j++)
+          passed &= masks[j] & (1<<j) ? rays[j].hit.geomID != RTC_INVALID_GEOMETRY_ID : rays[j].hit.geomID == RTC_INVALID_GEOMETRY_ID;
       }
       AssertNoError(device);
 
-      double failRate = double(numFailures) / double(max(size_t(1),numTests));
-      bool failed = failRate > 0.00002;
-      if (!silent) { printf(" (%f%%)", 100.0f*failRate); fflush(stdout); }
-      return (VerifyApplication::TestReturnValue)(!failed);
+      return (VerifyApplication::TestReturnValue) passed;
     }
   };
 
-  struct RayAlignmentTest : public VerifyApplication::IntersectTest
+  struct BackfaceCullingTest : public VerifyApplication::IntersectTest
   {
-    ALIGNED_STRUCT_(16);
     SceneFlags sflags;
-    std::string model;
-    static const size_t N = 10;
-    static const size_t maxStreamSize = 100;
-    
-    RayAlignmentTest (std::string name, int isa, SceneFlags sflags, IntersectMode imode, std::string model)
-      : VerifyApplication::IntersectTest(name,isa,imode,VARIANT_INTERSECT,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), model(model) {}
+    RTCBuildQuality quality;
+    GeometryType gtype;
+
+    BackfaceCullingTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, GeometryType gtype, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality), gtype(gtype) {}
     
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
@@ -3117,47 +3355,85 @@ namespace embree
       errorHandler(nullptr,rtcGetDeviceError(device));
       if (!supportsIntersectMode(device,imode))
         return VerifyApplication::SKIPPED;
-
+       
+      /* create triangle that is front facing for a right handed 
+         coordinate system if looking along the z direction */
       VerifyScene scene(device,sflags);
-      if      (model == "sphere.triangles") scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(zero,2.0f,50));
-      else if (model == "sphere.quads"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (zero,2.0f,50));
-      else if (model == "sphere.grids"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridSphere    (zero,2.0f,50));
-      else if (model == "sphere.subdiv"   ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivSphere  (zero,2.0f,4,4));
-      // FIXME: test more geometry types
+      AssertNoError(device);
+      const Vec3fa p0 = Vec3fa(0.0f);
+      const Vec3fa dx = Vec3fa(0.0f,1.0f,0.0f);
+      const Vec3fa dy = Vec3fa(1.0f,0.0f,0.0f);
+      switch (gtype) {
+      case TRIANGLE_MESH:    scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane(p0,dx,dy,1,1)); break;
+      case TRIANGLE_MESH_MB: scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane(p0,dx,dy,1,1)->set_motion_vector(zero)); break;
+      case QUAD_MESH:        scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadPlane(p0,dx,dy,1,1)); break;
+      case QUAD_MESH_MB:     scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadPlane(p0,dx,dy,1,1)->set_motion_vector(zero)); break;
+      case GRID_MESH:        scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridPlane(p0,dx,dy,1,1)); break;
+      case GRID_MESH_MB:     scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridPlane(p0,dx,dy,1,1)->set_motion_vector(zero)); break;
+      case SUBDIV_MESH:      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivPlane(p0,dx,dy,1,1,4.0f)); break;
+      case SUBDIV_MESH_MB:   scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivPlane(p0,dx,dy,1,1,4.0f)->set_motion_vector(zero)); break;
+      default:               throw std::runtime_error("unsupported geometry type: "+to_string(gtype)); 
+      }
+      
+      AssertNoError(device);
       rtcCommitScene (scene);
       AssertNoError(device);
+
+      const size_t numRays = 1000;
+      RTCRayHit rays[numRays];
+      bool passed = true;
+
+      for (size_t i=0; i<numRays; i++) {
+        const float rx = random_float();
+        const float ry = random_float();
+        if (i%2) rays[i] = makeRay(Vec3fa(rx,ry,+1),Vec3fa(0,0,-1)); 
+        else     rays[i] = makeRay(Vec3fa(rx,ry,-1),Vec3fa(0,0,+1)); 
+      }
       
-      for (auto ivariant : state->intersectVariants)
-      for (size_t i=0; i<size_t(N*state->intensity); i++) 
+      IntersectWithMode(imode,ivariant,scene,rays,numRays);
+      
+      for (size_t i=0; i<numRays; i++) 
       {
-        for (unsigned int M=1; M<maxStreamSize; M++)
-        {
-          size_t alignment = alignment_of(imode);
-          __aligned(64) char data[maxStreamSize*sizeof(RTCRayHit)]; 
-          RTCRayHit* rays = (RTCRayHit*) &data[alignment];
-          for (size_t j=0; j<M; j++) 
-          {
-            Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-            Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-            rays[j] = makeRay(org,dir); 
-          }
-          IntersectWithMode(imode,ivariant,scene,rays,M);
+        Vec3fa dir(rays[i].ray.dir_x,rays[i].ray.dir_y,rays[i].ray.dir_z);
+        Vec3fa Ng (rays[i].hit.Ng_x, rays[i].hit.Ng_y, rays[i].hit.Ng_z);
+        if (i%2) passed &= rays[i].hit.geomID == RTC_INVALID_GEOMETRY_ID;
+        else {
+          passed &= rays[i].hit.geomID == 0;
+          if (ivariant & VARIANT_INTERSECT)
+            passed &= dot(dir,Ng) < 0.0f;
         }
       }
       AssertNoError(device);
 
-      return VerifyApplication::PASSED;
+      return (VerifyApplication::TestReturnValue) passed;
     }
   };
-  
-  struct NaNTest : public VerifyApplication::IntersectTest
+
+  struct IntersectionFilterTest : public VerifyApplication::IntersectTest
   {
     SceneFlags sflags;
     RTCBuildQuality quality;
+    bool subdiv;
+
+    IntersectionFilterTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, bool subdiv, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality), subdiv(subdiv) {}
     
-    NaNTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
-      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality)  {}
-    
+    static void intersectionFilterN(const RTCFilterFunctionNArguments* const args)
+    {
+      if ((size_t)args->geometryUserPtr != 123) 
+        return;
+
+      for (unsigned int i=0; i<args->N; i++)
+      {
+	if (args->valid[i] != -1) continue;
+
+        /* reject hit */
+        if (RTCHitN_primID(args->hit,args->N,i) & 2) {
+          args->valid[i] = 0;
+        }
+      }
+    }
+
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
@@ -3166,71 +3442,79 @@ namespace embree
       if (!supportsIntersectMode(device,imode))
         return VerifyApplication::SKIPPED;
 
-      bool ok = false;
-      for (size_t i=0; i<10 && !ok; i++)
+      VerifyScene scene(device,sflags);
+      Vec3fa p0(-0.75f,-0.25f,-10.0f), dx(4,0,0), dy(0,4,0);
+      unsigned int geomID0 = 0;
+      if (subdiv) geomID0 = scene.addSubdivPlane (sampler,quality, 4, p0, dx, dy).first;
+      else        geomID0 = scene.addPlane       (sampler,quality, 4, p0, dx, dy).first;
+      RTCGeometry geom0 = rtcGetGeometry(scene,geomID0);
+      rtcSetGeometryUserData(geom0,(void*)123);
+      rtcSetGeometryIntersectFilterFunction (geom0,intersectionFilterN);
+      rtcSetGeometryOccludedFilterFunction (geom0,intersectionFilterN);
+      rtcCommitScene (scene);
+      AssertNoError(device);
+      
+      RTCRayHit rays[16];
+      for (unsigned int iy=0; iy<4; iy++) 
       {
-        const size_t numRays = 1000;
-        RTCRayHit rays[numRays];
-        VerifyScene scene(device,sflags);
-        scene.addSphere(sampler,quality,zero,2.0f,100);
-        scene.addHair  (sampler,quality,zero,1.0f,1.0f,100);
-        rtcCommitScene (scene);
-        
-        double c0 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org,dir); 
-        }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c1 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org+Vec3fa(nan),dir); 
-        }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c2 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org+Vec3fa(nan),dir+Vec3fa(nan)); 
+        for (unsigned int ix=0; ix<4; ix++) 
+        {
+          unsigned int primID = iy*4+ix;
+          if (!subdiv) primID *= 2;
+          rays[iy*4+ix] = makeRay(Vec3fa(float(ix),float(iy),0.0f),Vec3fa(0,0,-1));
         }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c3 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org,dir,nan,nan); 
+      }
+      IntersectWithMode(imode,ivariant,scene,rays,16);
+      
+      bool passed = true;
+      for (unsigned int iy=0; iy<4; iy++) 
+      {
+        for (unsigned int ix=0; ix<4; ix++) 
+        {
+          unsigned int primID = iy*4+ix;
+          if (!subdiv) primID *= 2;
+          RTCRayHit& ray = rays[iy*4+ix];
+          bool ok = true;
+          if (ivariant & VARIANT_INTERSECT)
+            ok = (primID & 2) ? (ray.hit.geomID == RTC_INVALID_GEOMETRY_ID) : (ray.hit.geomID == 0);
+          else
+            ok = ((primID & 2) != 0) == (ray.ray.tfar != float(neg_inf));
+          if (!ok) passed = false;
         }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c4 = getSeconds();
-        double d1 = c1-c0;
-        double d2 = c2-c1;
-        double d3 = c3-c2;
-        double d4 = c4-c3;
-        AssertNoError(device);        
-        
-        ok = (d2 < 2.5*d1) && (d3 < 2.5*d1) && (d4 < 2.5*d1);
-        double f = max(d2/d1,d3/d1,d4/d1);
-        if (!silent) { printf(" (%3.2fx)",f); fflush(stdout); }
       }
-      return (VerifyApplication::TestReturnValue) ok;
+      AssertNoError(device);
+
+      return (VerifyApplication::TestReturnValue) passed;
     }
   };
-    
-  struct InfTest : public VerifyApplication::IntersectTest
+
+  struct OpacityMicromaskTest : public VerifyApplication::IntersectTest
   {
     SceneFlags sflags;
-    RTCBuildQuality quality;
-    
-    InfTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
-      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
-   
+    static const size_t numRays = 256;
+    static const unsigned int level = 2;
+
+    OpacityMicromaskTest (std::string name, int isa, SceneFlags sflags, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags) {}
+
+    /* counts the hits passed to the filter */
+    static void countingFilterN(const RTCFilterFunctionNArguments* const args)
+    {
+      size_t* numFilterCalls = (size_t*) args->geometryUserPtr;
+      for (unsigned int i=0; i<args->N; i++)
+        if (args->valid[i] == -1) (*numFilterCalls)++;
+    }
+
+    /* cells of the micromask are enumerated row by row along v */
+    static unsigned int cellState(float u, float v)
+    {
+      const int n = 1 << level;
+      const int j = int(v*n), i = int(u*n);
+      const int upper = (u*n-i) + (v*n-j) > 1.0f;
+      const unsigned int cell = j*(2*n-j) + 2*i + upper;
+      return cell%3;
+    }
+
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
       std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
@@ -3239,357 +3523,2325 @@ namespace embree
       if (!supportsIntersectMode(device,imode))
         return VerifyApplication::SKIPPED;
 
-      const size_t numRays = 1000;
-      RTCRayHit rays[numRays];
       VerifyScene scene(device,sflags);
-      scene.addSphere(sampler,quality,zero,2.0f,100);
-      scene.addHair  (sampler,quality,zero,1.0f,1.0f,100);
-      rtcCommitScene (scene);
+      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
+      Vec3fa* vertices = (Vec3fa*) rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, sizeof(Vec3fa), 3);
+      vertices[0] = Vec3fa(0.0f,0.0f,0.0f);
+      vertices[1] = Vec3fa(1.0f,0.0f,0.0f);
+      vertices[2] = Vec3fa(0.0f,1.0f,0.0f);
+      unsigned int* indices = (unsigned int*) rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, 3*sizeof(unsigned int), 1);
+      indices[0] = 0; indices[1] = 1; indices[2] = 2;
+
+      /* the cells cycle through the transparent, opaque, and unknown states */
+      unsigned char* micromask = (unsigned char*) rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_OPACITY_MICROMASK, 0, RTC_FORMAT_UCHAR, 4, 1);
+      for (unsigned int cell=0; cell<16; cell++) {
+        if (cell%4 == 0) micromask[cell/4] = 0;
+        micromask[cell/4] |= (cell%3) << (2*(cell%4));
+      }
+
+      size_t numFilterCalls = 0;
+      rtcSetGeometryUserData(geom,&numFilterCalls);
+      rtcSetGeometryIntersectFilterFunction(geom,countingFilterN);
+      rtcSetGeometryOccludedFilterFunction(geom,countingFilterN);
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(scene,geom);
+      rtcReleaseGeometry(geom);
+      rtcCommitScene(scene);
       AssertNoError(device);
 
-      bool ok = false;
-      for (size_t i=0; i<10 && !ok; i++)
+      /* samples close to cell boundaries are skipped */
+      RTCRayHit rays[numRays];
+      unsigned int states[numRays];
+      const float n = float(1 << level);
+      auto nearBoundary = [&] (float x) { return std::abs(x*n - std::round(x*n)) < 0.01f; };
+      for (size_t i=0; i<numRays; )
       {
-        double c0 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org,dir); 
-        }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c1 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org+Vec3fa(inf),dir); 
-        }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c2 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org,dir+Vec3fa(inf)); 
-        }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c3 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org+Vec3fa(inf),dir+Vec3fa(inf)); 
+        const float u = random_float(), v = random_float();
+        if (u+v >= 1.0f || nearBoundary(u) || nearBoundary(v) || nearBoundary(u+v)) continue;
+        rays[i] = makeRay(Vec3fa(u,v,1.0f),Vec3fa(0.0f,0.0f,-1.0f));
+        states[i++] = cellState(u,v);
+      }
+
+      IntersectWithMode(imode,ivariant,scene,rays,numRays);
+      AssertNoError(device);
+
+      size_t numUnknown = 0;
+      for (size_t i=0; i<numRays; i++)
+      {
+        const bool visible = states[i] != RTC_OPACITY_STATE_TRANSPARENT;
+        numUnknown += states[i] == RTC_OPACITY_STATE_UNKNOWN;
+        if (ivariant & VARIANT_INTERSECT) {
+          if (visible != (rays[i].hit.geomID != RTC_INVALID_GEOMETRY_ID))
+            return VerifyApplication::FAILED;
+        } else {
+          if (visible != (rays[i].ray.tfar == float(neg_inf)))
+            return VerifyApplication::FAILED;
         }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c4 = getSeconds();
-        for (size_t i=0; i<numRays; i++) {
-          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
-          rays[i] = makeRay(org,dir,-0.0f,inf); 
-        }
-        IntersectWithMode(imode,ivariant,scene,rays,numRays);
-        
-        double c5 = getSeconds();      
-        double d1 = c1-c0;
-        double d2 = c2-c1;
-        double d3 = c3-c2;
-        double d4 = c4-c3;
-        double d5 = c5-c4;
-        AssertNoError(device);
-        
-        ok = (d2 < 2.5*d1) && (d3 < 2.5*d1) && (d4 < 2.5*d1) && (d5 < 2.5*d1);
-        double f = max(d2/d1,d3/d1,d4/d1,d5/d1);
-        if (!silent) { printf(" (%3.2fx)",f); fflush(stdout); }
       }
-      return (VerifyApplication::TestReturnValue) ok;
+
+      /* the combined variant traces every ray once with intersect and once with occluded */
+      const size_t numTraces = (ivariant & VARIANT_INTERSECT_OCCLUDED) == VARIANT_INTERSECT_OCCLUDED ? 2 : 1;
+      return numFilterCalls == numTraces*numUnknown ? VerifyApplication::PASSED : VerifyApplication::FAILED;
     }
   };
 
-  /////////////////////////////////////////////////////////////////////////////////
-  /////////////////////////////////////////////////////////////////////////////////
-  /////////////////////////////////////////////////////////////////////////////////
-  /////////////////////////////////////////////////////////////////////////////////
-  
-  struct PointQueryAPICallsTest : public VerifyApplication::Test
+  struct BatchFilterTest : public VerifyApplication::Test
   {
-    SceneFlags sflags; 
+    SceneFlags sflags;
+    static const size_t numLayers = 64;
+    static const size_t numRays = 100;
 
-    PointQueryAPICallsTest (std::string name, int isa, SceneFlags sflags)
+    BatchFilterTest (std::string name, int isa, SceneFlags sflags)
       : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags) {}
 
-    VerifyApplication::TestReturnValue run(VerifyApplication *state, bool silent)
+    /* accepts only every 4th layer and counts the filter invocations */
+    static void layerFilterN(const RTCFilterFunctionNArguments* const args)
     {
-      // This test assures that the expected internal point query calls are made
-      // for supported primitive/geometry types
-      
-      std::string cfg = state->rtcore + ",isa=" + stringOfISA(isa);
-
-      auto queryFunc = [](RTCPointQueryFunctionArguments* args) -> bool
+      size_t* numFilterCalls = (size_t*) args->geometryUserPtr;
+      (*numFilterCalls)++;
+      for (unsigned int i=0; i<args->N; i++)
       {
-        assert(args->userPtr);
-        //printf("query callback called for geomID %u and primID %u\n", args->geomID, args->primID);
-        uint32_t *numCalls = (uint32_t*)args->userPtr;
-        (*numCalls)++;
-        return false;
-      };
-      RTCPointQuery query;
-      query.x = query.y = query.z = query.time = 0.f;
-      query.radius = inf;
+        if (args->valid[i] != -1) continue;
+        if ((RTCHitN_primID(args->hit,args->N,i)/2)%4 != 3)
+          args->valid[i] = 0;
+      }
+    }
 
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
-      errorHandler(nullptr, rtcGetDeviceError(device));
-      
-      // triangle mesh
-      if (1) {
-        RTCSceneRef scene = rtcNewScene(device);
-        rtcSetSceneFlags(scene, sflags.sflags);
-        rtcSetSceneBuildQuality(scene, sflags.qflags);
+      errorHandler(nullptr,rtcGetDeviceError(device));
 
-        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
-        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+      /* stack of unit squares at z = -1, -2, ... made of two triangles each */
+      VerifyScene scene(device,sflags);
+      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
+      Vec3fa* vertices = (Vec3fa*) rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, sizeof(Vec3fa), 4*numLayers);
+      unsigned int* indices = (unsigned int*) rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, 3*sizeof(unsigned int), 2*numLayers);
+      for (unsigned int k=0; k<numLayers; k++)
+      {
+        const float z = -float(k+1);
+        vertices[4*k+0] = Vec3fa(0.0f,0.0f,z);
+        vertices[4*k+1] = Vec3fa(1.0f,0.0f,z);
+        vertices[4*k+2] = Vec3fa(1.0f,1.0f,z);
+        vertices[4*k+3] = Vec3fa(0.0f,1.0f,z);
+        indices[6*k+0] = 4*k+0; indices[6*k+1] = 4*k+1; indices[6*k+2] = 4*k+2;
+        indices[6*k+3] = 4*k+0; indices[6*k+4] = 4*k+2; indices[6*k+5] = 4*k+3;
+      }
+      size_t numFilterCalls = 0;
+      rtcSetGeometryUserData(geom,&numFilterCalls);
+      rtcSetGeometryIntersectFilterFunction(geom,layerFilterN);
+      rtcSetGeometryOccludedFilterFunction(geom,layerFilterN);
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(scene,geom);
+      rtcReleaseGeometry(geom);
+      rtcCommitScene(scene);
+      AssertNoError(device);
 
-        Vec3f *vertices = (Vec3f *)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, sizeof(Vec3f), 3);
-        Triangle *triangles = (Triangle *)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, sizeof(Triangle), 1);
-        vertices[0] = Vec3f(-1.0f, 0.0f, -1.0f);
-        vertices[1] = Vec3f(+1.0f, 0.0f, -1.0f);
-        vertices[2] = Vec3f(+0.0f, 0.0f, +1.0f);
-        triangles[0] = Triangle(0, 1, 2);
+      size_t numCalls[2] = { 0, 0 };
+      RTCRayHit rays[2][numRays];
+      RTCRay shadows[2][numRays];
+      for (size_t i=0; i<numRays; i++) {
+        rays[0][i] = rays[1][i] = makeRay(Vec3fa(0.01f+0.98f*random_float(),0.01f+0.98f*random_float(),0.0f),Vec3fa(0.0f,0.0f,-1.0f));
+        shadows[0][i] = shadows[1][i] = rays[0][i].ray;
+      }
 
-        rtcCommitGeometry(geom);
-        rtcAttachGeometry(scene, geom);
-        rtcReleaseGeometry(geom);
-        rtcCommitScene(scene);
-        AssertNoError(device);
+      for (size_t batch=0; batch<2; batch++)
+      {
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        if (batch) context.flags = RTC_INTERSECT_CONTEXT_FLAG_BATCH_FILTER;
+        numFilterCalls = 0;
+        for (size_t i=0; i<numRays; i++) {
+          rtcIntersect1(scene,&context,&rays[batch][i]);
+          rtcOccluded1(scene,&context,&shadows[batch][i]);
+        }
+        numCalls[batch] = numFilterCalls;
+      }
+      AssertNoError(device);
 
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        uint32_t numCalls = 0;
-        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
-        if (numCalls != 1)
-          return VerifyApplication::FAILED;
-        AssertNoError(device);
+      for (size_t i=0; i<numRays; i++)
+      {
+        if (rays[0][i].hit.primID/2 != 3 || fabsf(rays[0][i].ray.tfar-4.0f) > 1E-4f) return VerifyApplication::FAILED;
+        if (rays[1][i].hit.primID != rays[0][i].hit.primID) return VerifyApplication::FAILED;
+        if (rays[1][i].ray.tfar != rays[0][i].ray.tfar) return VerifyApplication::FAILED;
+        if (shadows[0][i].tfar != float(neg_inf) || shadows[1][i].tfar != float(neg_inf)) return VerifyApplication::FAILED;
       }
-      
-      // flat linear curve
-      if (1) {
-        RTCSceneRef scene = rtcNewScene(device);
-        rtcSetSceneFlags(scene, sflags.sflags);
-        rtcSetSceneBuildQuality(scene, sflags.qflags);
+      return numCalls[1] < numCalls[0] ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
 
-        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE);
-        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+  struct InstancingTest : public VerifyApplication::IntersectTest
+  {
+    SceneFlags sflags;
+    RTCBuildQuality quality;
+    bool subdiv;
 
-        Vec4f *vertices = (Vec4f *)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, sizeof(Vec4f), 3);
-        uint32_t *indices = (uint32_t*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT, sizeof(uint32_t), 2);
-        vertices[0] = Vec4f(-1.0f, 0.0f, 0.0f, 0.1f);
-        vertices[1] = Vec4f(+0.0f, 0.0f, 0.0f, 0.1f);
-        vertices[2] = Vec4f(+1.0f, 0.0f, 0.0f, 0.1f);
-        indices[0] = 0;
-        indices[1] = 1;
+    InstancingTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, bool subdiv, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality), subdiv(subdiv) {
+      }
 
-        rtcCommitGeometry(geom);
-        rtcAttachGeometry(scene, geom);
-        rtcReleaseGeometry(geom);
-        rtcCommitScene(scene);
-        AssertNoError(device);
+    struct IntersectContext {
+      RTCIntersectContext context;
+      int numHits[16];
+    };
+    
+    static void intersectFilter(const RTCFilterFunctionNArguments* args)
+    {
+      assert(args);
+      assert(args->context);
 
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        uint32_t numCalls = 0;
-        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
-        if (numCalls != 0)
+      IntersectContext* context = (IntersectContext*)(args->context);
+
+      for (unsigned int i=0; i<args->N; i++) 
+      {
+        const unsigned int rayId = RTCRayN_id(args->ray, args->N, i);
+        if(args->valid[i] && rayId >= 16)
+          throw std::runtime_error("Invalid ray id in intersection filter.");
+        if (args->valid[i])
         {
-          return VerifyApplication::FAILED;
+          assert(rayId < 16);
+          context->numHits[rayId] += 1;
         }
-        AssertNoError(device);
       }
-      
-      // flat bezier curve
-      if (1) {
-        RTCSceneRef scene = rtcNewScene(device);
-        rtcSetSceneFlags(scene, sflags.sflags);
-        rtcSetSceneBuildQuality(scene, sflags.qflags);
-
-        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE);
-        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+    }
 
-        Vec4f *vertices = (Vec4f *)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, sizeof(Vec4f), 4);
-        uint32_t *indices = (uint32_t*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT, sizeof(uint32_t), 1);
-        vertices[0] = Vec4f(-1.0f, 0.0f, 0.0f, 0.1f);
-        vertices[1] = Vec4f(-1.0f, 0.0f, 1.0f, 0.1f);
-        vertices[2] = Vec4f(+1.0f, 0.0f, 1.0f, 0.1f);
-        vertices[3] = Vec4f(+1.0f, 0.0f, 0.0f, 0.1f);
-        indices[0] = 0;
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!supportsIntersectMode(device,imode))
+        return VerifyApplication::SKIPPED;
 
-        rtcCommitGeometry(geom);
-        rtcAttachGeometry(scene, geom);
-        rtcReleaseGeometry(geom);
-        rtcCommitScene(scene);
-        AssertNoError(device);
+      Ref<SceneGraph::Node> child;
+      Ref<SceneGraph::Node> parent;
+      if (subdiv)
+        child = SceneGraph::createSubdivSphere(Vec3fa(0.f), 1.f, 32, 2.f);
+      else
+        child = SceneGraph::createQuadSphere(Vec3fa(0.f), 1.f, 32);
 
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        uint32_t numCalls = 0;
-        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
-        if (numCalls != 0)
-        {
-          return VerifyApplication::FAILED;
-        }
-        AssertNoError(device);
+      for (int i = 0; i < RTC_MAX_INSTANCE_LEVEL_COUNT; ++i)
+      { 
+        parent = new SceneGraph::TransformNode(AffineSpace3fa(one), child);
+        child = parent;
       }
-      
-      // grid geometry
-      if (1) {
-        RTCSceneRef scene = rtcNewScene(device);
-        rtcSetSceneFlags(scene, sflags.sflags);
-        rtcSetSceneBuildQuality(scene, sflags.qflags);
 
-        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_GRID);
-        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+      sflags.sflags = sflags.sflags | RTC_SCENE_FLAG_CONTEXT_FILTER_FUNCTION;
+      IntersectContext ctx;
+      rtcInitIntersectContext(&ctx.context);
+      ctx.context.filter = intersectFilter;
 
-        RTCGrid* grid = (RTCGrid*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_GRID, 0, RTC_FORMAT_GRID, sizeof(RTCGrid), 2);
-        grid[0].startVertexID = 0;
-        grid[0].stride        = 3;
-        grid[0].width         = 3;
-        grid[0].height        = 3;
-        grid[1].startVertexID = 9;
-        grid[1].stride        = 2;
-        grid[1].width         = 2;
-        grid[1].height        = 2;
+      VerifyScene scene(device, sflags);
+      scene.addGeometry(quality, parent);
+      rtcCommitScene(scene);
+      AssertNoError(device);
 
-        /* set vertices */
-        Vec3f* vertices = (Vec3f*) rtcSetNewGeometryBuffer(geom,RTC_BUFFER_TYPE_VERTEX,0,RTC_FORMAT_FLOAT3,sizeof(Vec3f),13);
-        for (int j = 0; j < 3; ++j)
-        for (int i = 0; i < 3; ++i)
+      RTCRayHit rays[16];
+      for (unsigned int iy=0; iy<4; iy++) 
+      {
+        for (unsigned int ix=0; ix<4; ix++) 
         {
-          vertices[j * 3 + i] = Vec3f(float(i), (j == 1) ? 0.5f : 1.f, 2.f-float(j));
+          const int id = iy*4+ix;
+          rays[id] = makeRay(Vec3fa(float(ix)/10.f,float(iy)/10.f,-2.0f),Vec3fa(0,0,1));
+          rays[id].ray.id = id;
+          ctx.numHits[id] = 0;
         }
-        vertices[ 9] = Vec3f(0.f, 2.f, 1.f);
-        vertices[10] = Vec3f(1.f, 2.f, 1.f);
-        vertices[11] = Vec3f(1.f, 2.f, 0.f);
-        vertices[12] = Vec3f(0.f, 2.f, 0.f);
-
-        rtcCommitGeometry(geom);
-        rtcAttachGeometry(scene, geom);
-        rtcReleaseGeometry(geom);
-        rtcCommitScene(scene);
-        AssertNoError(device);
-
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        uint32_t numCalls = 0;
-        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
+      }
+      IntersectWithMode(imode,ivariant,scene,rays,16,&ctx.context);
+      bool passed = true;
+      for (unsigned int iy=0; iy<4; iy++) 
+      {
+        for (unsigned int ix=0; ix<4; ix++) 
+        {
+          const unsigned id = iy*4+ix;
+          passed &= (ctx.numHits[id] > 0);
+          RTCRayHit& ray = rays[id];
+          if (ivariant & VARIANT_INTERSECT)
+            passed &= (ray.hit.geomID != RTC_INVALID_GEOMETRY_ID);
+          else
+            passed &= (ray.ray.tfar == (float)neg_inf);
+        }
+      }
+      assert(passed);
+      AssertNoError(device);
+
+      return (VerifyApplication::TestReturnValue) passed;
+    }
+  };
+    
+  struct InactiveRaysTest : public VerifyApplication::IntersectTest
+  {
+    SceneFlags sflags;
+    RTCBuildQuality quality;
+
+    static const size_t N = 10;
+    static const size_t maxStreamSize = 100;
+    
+    InactiveRaysTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
+   
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!supportsIntersectMode(device,imode))
+        return VerifyApplication::SKIPPED;
+
+      Vec3fa pos = zero;
+      VerifyScene scene(device,sflags);
+      scene.addSphere(sampler,RTC_BUILD_QUALITY_MEDIUM,pos,2.0f,50); // FIXME: use different geometries too
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      RTCRayHit invalid_ray; clearRay(invalid_ray);
+      invalid_ray.ray.tnear = pos_inf;
+      invalid_ray.ray.tfar  = 0.0f;
+      
+      size_t numFailures = 0;
+      for (size_t i=0; i<size_t(N*state->intensity); i++) 
+      {
+        for (unsigned int M=1; M<maxStreamSize; M++)
+        {
+          bool valid[maxStreamSize];
+          __aligned(16) RTCRayHit rays[maxStreamSize];
+          for (unsigned int j=0; j<M; j++) 
+          {
+            if (rand()%2) {
+              valid[j] = true;
+              Vec3fa org = 2.0f*random_Vec3fa()-Vec3fa(1.0f);
+              Vec3fa dir = 2.0f*random_Vec3fa()-Vec3fa(1.0f);
+              rays[j] = makeRay(pos+org,dir); 
+            } else {
+              valid[j] = false;
+              rays[j] = invalid_ray;
+            }
+          }
+          IntersectWithMode(imode,ivariant,scene,rays,M);
+          for (size_t j=0; j<M; j++) {
+            if (valid[j]) continue;
+            numFailures += neq_ray_special(rays[j],invalid_ray);
+          }
+        }
+      }
+      AssertNoError(device);
+      return (VerifyApplication::TestReturnValue) (numFailures == 0);
+    }
+  };
+
+  struct WatertightTest : public VerifyApplication::IntersectTest
+  {
+    ALIGNED_STRUCT_(16);
+    SceneFlags sflags;
+    std::string model;
+    Vec3fa pos;
+    static const size_t N = 10;
+    static const size_t maxStreamSize = 100;
+    
+    WatertightTest (std::string name, int isa, SceneFlags sflags, IntersectMode imode, std::string model, const Vec3fa& pos)
+      : VerifyApplication::IntersectTest(name,isa,imode,VARIANT_INTERSECT,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), model(model), pos(pos) {}
+    
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!supportsIntersectMode(device,imode))
+        return VerifyApplication::SKIPPED;
+
+      avector<Vec3fa> motion_vector;
+      motion_vector.push_back(Vec3fa(0.0f));
+      motion_vector.push_back(Vec3fa(0.0f));
+
+      VerifyScene scene(device,sflags);
+      size_t size = state->intensity < 1.0f ? 50 : 500;
+      if      (model == "sphere.triangles") scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(pos,2.0f,size));
+      else if (model == "sphere.quads"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (pos,2.0f,size));
+      else if (model == "sphere.grids"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridSphere    (pos,2.0f,size));
+      else if (model == "sphere.subdiv"   ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivSphere  (pos,2.0f,4,64));
+      else if (model == "plane.triangles" ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size));
+      else if (model == "plane.quads"     ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadPlane     (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size));
+      else if (model == "plane.grids"     ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridPlane     (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size));
+      else if (model == "plane.subdiv"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivPlane   (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size,2));
+      else if (model == "sphere.triangles_mb") scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(pos,2.0f,size)->set_motion_vector(motion_vector));
+      else if (model == "sphere.quads_mb"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (pos,2.0f,size)->set_motion_vector(motion_vector));
+      else if (model == "sphere.grids_mb"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridSphere    (pos,2.0f,size)->set_motion_vector(motion_vector));
+      else if (model == "plane.triangles_mb" ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size)->set_motion_vector(motion_vector));
+      else if (model == "plane.quads_mb"     ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadPlane     (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size)->set_motion_vector(motion_vector));
+      else if (model == "plane.grids_mb"     ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridPlane     (Vec3fa(pos.x,-6.0f,-6.0f),Vec3fa(0.0f,0.0f,12.0f),Vec3fa(0.0f,12.0f,0.0f),size,size)->set_motion_vector(motion_vector));
+      else throw std::runtime_error("unsupported mode "+model); 
+      bool plane = model.compare(0,5,"plane") == 0;
+      rtcCommitScene (scene);
+      AssertNoError(device);
+      
+      size_t numTests = 0;
+      size_t numFailures = 0;
+      for (auto ivariant : state->intersectVariants)
+      for (size_t i=0; i<size_t(N*state->intensity); i++) 
+      {
+        for (unsigned int M=1; M<maxStreamSize; M++)
+        {
+          __aligned(16) RTCRayHit rays[maxStreamSize];
+          for (size_t j=0; j<M; j++) 
+          {
+            if (plane) {
+              Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f); dir.x = 1.0f;
+              rays[j] = makeRay(Vec3fa(pos.x-3.0f,0.0f,0.0f),dir); 
+            } else {
+              Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+              Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+              rays[j] = makeRay(pos+org,dir); 
+            }
+          }
+          IntersectWithMode(imode,ivariant,scene,rays,M);
+          for (unsigned int j=0; j<M; j++) {
+            numTests++;
+            if (ivariant & VARIANT_INTERSECT)
+              numFailures += rays[j].hit.geomID == RTC_INVALID_GEOMETRY_ID;
+            else
+              numFailures += rays[j].ray.tfar != float(neg_inf);
+          }
+        }
+      }
+      AssertNoError(device);
+
+      double failRate = double(numFailures) / double(max(size_t(1),numTests));
+      bool failed = failRate > 0.00002;
+      if (!silent) { printf(" (%f%%)", 100.0f*failRate); fflush(stdout); }
+      return (VerifyApplication::TestReturnValue)(!failed);
+    }
+  };
+
+  struct SmallTriangleHitTest : public VerifyApplication::IntersectTest
+  {
+    ALIGNED_STRUCT_(16);
+    SceneFlags sflags;
+    Vec3fa pos;
+    float radius;
+    static const size_t N = 10000;
+    static const size_t maxStreamSize = 100;
+    
+    SmallTriangleHitTest (std::string name, int isa, SceneFlags sflags, IntersectMode imode, const Vec3fa& pos, const float radius)
+      : VerifyApplication::IntersectTest(name,isa,imode,VARIANT_INTERSECT,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), pos(pos), radius(radius) {}
+    
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!supportsIntersectMode(device,imode))
+        return VerifyApplication::SKIPPED;
+
+      VerifyScene scene(device,sflags);
+      LinearSpace3fa space(Vec3fa(1.0f,0.0f,0.0f),Vec3fa(0.0f,1.0f,0.0f),Vec3fa(0.0f,0.0f,1.0f));
+      space *= LinearSpace3fa::rotate(Vec3fa(4.0f,7.0f,-1.0f),4.34f);
+      const Vec3fa dx = 100.0f*normalize(space.vx);
+      const Vec3fa dy = 100.0f*normalize(space.vy);
+      const Vec3fa p = pos-0.5f*(dx+dy);
+      Ref<SceneGraph::TriangleMeshNode> plane = SceneGraph::createTrianglePlane (p,dx,dy,100,100).dynamicCast<SceneGraph::TriangleMeshNode>();
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,plane.dynamicCast<SceneGraph::Node>());
+      rtcCommitScene (scene);
+      AssertNoError(device);
+      
+      size_t numTests = 0;
+      size_t numFailures = 0;
+      //for (auto ivariant : state->intersectVariants)
+      IntersectVariant ivariant = VARIANT_INTERSECT_INCOHERENT;
+      size_t numRays = size_t(N*state->intensity);
+      for (size_t i=0; i<numRays; i+=maxStreamSize) 
+      {
+        unsigned int M = (unsigned int)min(maxStreamSize,numRays-i);
+        unsigned int primIDs[maxStreamSize];
+        __aligned(16) RTCRayHit rays[maxStreamSize];
+        for (size_t j=0; j<M; j++) 
+        {
+          Vec3fa org = pos + radius*(2.0f*random_Vec3fa() - Vec3fa(1.0f));
+          unsigned int primID = random_int() % plane->triangles.size();
+          Vec3fa v0 = plane->positions[0][plane->triangles[primID].v0];
+          Vec3fa v1 = plane->positions[0][plane->triangles[primID].v1];
+          Vec3fa v2 = plane->positions[0][plane->triangles[primID].v2];
+          Vec3fa c = (v0+v1+v2)/3.0f;
+          primIDs[j] = primID;
+          rays[j] = makeRay(org,c-org); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,M);
+        for (size_t j=0; j<M; j++) {
+          Vec3fa dir(rays[j].ray.dir_x,rays[j].ray.dir_y,rays[j].ray.dir_z);
+          //if (abs(dot(normalize(dir),space.vz)) < 0.9f) continue;
+          numTests++;
+          numFailures += rays[j].hit.primID != primIDs[j];
+        }
+      }
+      AssertNoError(device);
+
+      double failRate = double(numFailures) / double(max(size_t(1),numTests));
+      bool failed = failRate > 0.00002;
+      if (!silent) { printf(" (%f%%)", 100.0f*failRate); fflush(stdout); }
+      return (VerifyApplication::TestReturnValue)(!failed);
+    }
+  };
+
+  struct RayAlignmentTest : public VerifyApplication::IntersectTest
+  {
+    ALIGNED_STRUCT_(16);
+    SceneFlags sflags;
+    std::string model;
+    static const size_t N = 10;
+    static const size_t maxStreamSize = 100;
+    
+    RayAlignmentTest (std::string name, int isa, SceneFlags sflags, IntersectMode imode, std::string model)
+      : VerifyApplication::IntersectTest(name,isa,imode,VARIANT_INTERSECT,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), model(model) {}
+    
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!supportsIntersectMode(device,imode))
+        return VerifyApplication::SKIPPED;
+
+      VerifyScene scene(device,sflags);
+      if      (model == "sphere.triangles") scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(zero,2.0f,50));
+      else if (model == "sphere.quads"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (zero,2.0f,50));
+      else if (model == "sphere.grids"    ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createGridSphere    (zero,2.0f,50));
+      else if (model == "sphere.subdiv"   ) scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createSubdivSphere  (zero,2.0f,4,4));
+      // FIXME: test more geometry types
+      rtcCommitScene (scene);
+      AssertNoError(device);
+      
+      for (auto ivariant : state->intersectVariants)
+      for (size_t i=0; i<size_t(N*state->intensity); i++) 
+      {
+        for (unsigned int M=1; M<maxStreamSize; M++)
+        {
+          size_t alignment = alignment_of(imode);
+          __aligned(64) char data[maxStreamSize*sizeof(RTCRayHit)]; 
+          RTCRayHit* rays = (RTCRayHit*) &data[alignment];
+          for (size_t j=0; j<M; j++) 
+          {
+            Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+            Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+            rays[j] = makeRay(org,dir); 
+          }
+          IntersectWithMode(imode,ivariant,scene,rays,M);
+        }
+      }
+      AssertNoError(device);
+
+      return VerifyApplication::PASSED;
+    }
+  };
+  
+  struct RayTileTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+    RTCIntersectContextFlags iflags;
+    
+    RayTileTest (std::string name, int isa, SceneFlags sflags, RTCIntersectContextFlags iflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), iflags(iflags) {}
+    
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_RAY_STREAM_SUPPORTED))
+        return VerifyApplication::SKIPPED;
+
+      VerifyScene scene(device,sflags);
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(Vec3fa(-1.0f,0.0f,0.0f),1.5f,50));
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (Vec3fa(+1.5f,0.5f,0.0f),1.0f,50));
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      const unsigned int tileSizes[][2] = { {1,1}, {8,4}, {13,7}, {32,17} };
+      size_t numHits = 0;
+      
+      for (auto tileSize : tileSizes)
+      {
+        __aligned(16) RTCRayTile tile;
+        tile.org_x = 0.0f; tile.org_y = 0.0f; tile.org_z = -8.0f;
+        tile.tnear = 0.0f; tile.tfar = inf; tile.time = 0.0f; tile.mask = 0xFFFFFFFF;
+        tile.dir_x = -0.4f; tile.dir_y = -0.4f; tile.dir_z = 1.0f;
+        tile.du_x  = 0.01f; tile.du_y  = 0.0f;  tile.du_z  = 0.0f;
+        tile.dv_x  = 0.0f;  tile.dv_y  = 0.01f; tile.dv_z  = 0.0f;
+        tile.x0 = 23; tile.y0 = 37;
+        tile.width = tileSize[0]; tile.height = tileSize[1];
+
+        avector<RTCRayHit> rayhits(tile.width*tile.height);
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        context.flags = iflags;
+        rtcIntersectTile(scene,&context,&tile,rayhits.data(),sizeof(RTCRayHit));
+        AssertNoError(device);
+
+        for (unsigned int y=0; y<tile.height; y++)
+        {
+          for (unsigned int x=0; x<tile.width; x++)
+          {
+            const RTCRayHit& rayhit = rayhits[y*tile.width+x];
+            const Vec3fa org(tile.org_x,tile.org_y,tile.org_z);
+            const Vec3fa dir = Vec3fa(tile.dir_x,tile.dir_y,tile.dir_z)
+              + float(tile.x0+x)*Vec3fa(tile.du_x,tile.du_y,tile.du_z)
+              + float(tile.y0+y)*Vec3fa(tile.dv_x,tile.dv_y,tile.dv_z);
+            if (reduce_max(abs(Vec3fa(rayhit.ray.dir_x,rayhit.ray.dir_y,rayhit.ray.dir_z)-dir)) > 1E-5f)
+              return VerifyApplication::FAILED;
+
+            /* compare against single ray traversal of the generated ray */
+            RTCRayHit ref = makeRay(org,Vec3fa(rayhit.ray.dir_x,rayhit.ray.dir_y,rayhit.ray.dir_z));
+            RTCIntersectContext context1;
+            rtcInitIntersectContext(&context1);
+            rtcIntersect1(scene,&context1,&ref);
+            if (ref.hit.geomID != rayhit.hit.geomID)
+              return VerifyApplication::FAILED;
+            if (ref.hit.geomID == RTC_INVALID_GEOMETRY_ID)
+              continue;
+            if (ref.hit.primID != rayhit.hit.primID || abs(ref.ray.tfar-rayhit.ray.tfar) > 1E-4f)
+              return VerifyApplication::FAILED;
+            numHits++;
+          }
+        }
+      }
+      AssertNoError(device);
+
+      return numHits ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+  
+  struct SharedOriginOcclusionTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+    RTCIntersectContextFlags iflags;
+    static const size_t N = 1000;
+    
+    SharedOriginOcclusionTest (std::string name, int isa, SceneFlags sflags, RTCIntersectContextFlags iflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), iflags(iflags) {}
+    
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_RAY_STREAM_SUPPORTED))
+        return VerifyApplication::SKIPPED;
+
+      VerifyScene scene(device,sflags);
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(Vec3fa(-1.0f,0.0f,0.0f),1.0f,50));
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (Vec3fa(+1.5f,0.5f,0.0f),0.5f,50));
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane (Vec3fa(-4.0f,-1.0f,-4.0f),Vec3fa(8.0f,0.0f,0.0f),Vec3fa(0.0f,0.0f,8.0f),16,16));
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      avector<float> dir_x(N), dir_y(N), dir_z(N), tfar(N), tfar_ref(N);
+      RTCRaySharedOrigin rays;
+      rays.org_x = 0.1f; rays.org_y = 0.0f; rays.org_z = -0.1f;
+      rays.tnear = 0.0f; rays.time = 0.0f; rays.mask = 0xFFFFFFFF;
+      rays.dir_x = dir_x.data(); rays.dir_y = dir_y.data(); rays.dir_z = dir_z.data(); rays.tfar = tfar.data();
+      
+      for (size_t i=0; i<N; i++)
+      {
+        const Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+        dir_x[i] = dir.x; dir_y[i] = dir.y; dir_z[i] = dir.z;
+        tfar[i] = (i%7 == 0) ? -1.0f : 10.0f*random_float(); // also test inactive rays
+
+        RTCRayHit ray = makeRay(Vec3fa(rays.org_x,rays.org_y,rays.org_z),dir,rays.tnear,tfar[i]);
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        if (ray.ray.tnear <= ray.ray.tfar)
+          rtcOccluded1(scene,&context,&ray.ray);
+        tfar_ref[i] = ray.ray.tfar;
+      }
+
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      context.flags = iflags;
+      rtcOccludedSharedOrigin(scene,&context,&rays,(unsigned int)N);
+      AssertNoError(device);
+
+      size_t numOccluded = 0;
+      for (size_t i=0; i<N; i++)
+      {
+        if (tfar[i] != tfar_ref[i])
+          return VerifyApplication::FAILED;
+        numOccluded += tfar[i] == float(neg_inf);
+      }
+
+      return (numOccluded > 0 && numOccluded < N) ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+
+  struct VisibilityMatrixTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+    RTCIntersectContextFlags iflags;
+    static const size_t N = 37;
+    static const size_t M = 70;
+
+    VisibilityMatrixTest (std::string name, int isa, SceneFlags sflags, RTCIntersectContextFlags iflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), iflags(iflags) {}
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_RAY_STREAM_SUPPORTED))
+        return VerifyApplication::SKIPPED;
+
+      VerifyScene scene(device,sflags);
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(Vec3fa(-1.0f,0.0f,0.0f),1.0f,50));
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (Vec3fa(+1.5f,0.5f,0.0f),0.5f,50));
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane (Vec3fa(-4.0f,-1.0f,-4.0f),Vec3fa(8.0f,0.0f,0.0f),Vec3fa(0.0f,0.0f,8.0f),16,16));
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      /* the points of the first set are stored with a padding float */
+      std::vector<Vec3fa> points0(N);
+      std::vector<Vec3fa> points1(M);
+      for (size_t i=0; i<N; i++) points0[i] = Vec3fa(6.0f*random_float()-3.0f,3.0f*random_float()-0.5f,6.0f*random_float()-3.0f);
+      for (size_t j=0; j<M; j++) points1[j] = Vec3fa(6.0f*random_float()-3.0f,3.0f*random_float()-0.5f,6.0f*random_float()-3.0f);
+      points1[M-1] = points1[0]; // coinciding points are visible
+      points0[N-1] = points1[0];
+
+      const float epsilon = 1E-3f;
+      const size_t rowWords = (M+31)/32;
+      std::vector<unsigned int> visibility(N*rowWords,0xFFFFFFFF);
+
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      context.flags = iflags;
+      rtcOccludedMatrix(scene,&context,(float*)points0.data(),N,(float*)points1.data(),M,sizeof(Vec3fa),epsilon,visibility.data());
+      AssertNoError(device);
+
+      size_t numVisible = 0;
+      for (size_t i=0; i<N; i++)
+      {
+        for (size_t j=0; j<rowWords*32; j++)
+        {
+          const bool visible = (visibility[i*rowWords+j/32] >> (j%32)) & 1;
+          if (j >= M) {
+            if (visible) return VerifyApplication::FAILED;
+            continue;
+          }
+
+          const Vec3fa d = points1[j]-points0[i];
+          const float len = length(d);
+          bool visible_ref = true;
+          if (epsilon <= len-epsilon)
+          {
+            RTCRayHit ray = makeRay(points0[i],Vec3fa(d.x/len,d.y/len,d.z/len),epsilon,len-epsilon);
+            RTCIntersectContext context1;
+            rtcInitIntersectContext(&context1);
+            rtcOccluded1(scene,&context1,&ray.ray);
+            visible_ref = ray.ray.tfar != float(neg_inf);
+          }
+          if (visible != visible_ref)
+            return VerifyApplication::FAILED;
+          numVisible += visible;
+        }
+      }
+
+      return (numVisible > 0 && numVisible < N*M) ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+
+  struct SharedDirectionTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+    RTCIntersectContextFlags iflags;
+    static const size_t N = 1000;
+    
+    SharedDirectionTest (std::string name, int isa, SceneFlags sflags, RTCIntersectContextFlags iflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), iflags(iflags) {}
+    
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_RAY_STREAM_SUPPORTED))
+        return VerifyApplication::SKIPPED;
+
+      VerifyScene scene(device,sflags);
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(Vec3fa(-1.0f,0.0f,0.0f),1.0f,50));
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere    (Vec3fa(+1.5f,0.5f,0.0f),0.5f,50));
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTrianglePlane (Vec3fa(-4.0f,-1.0f,-4.0f),Vec3fa(8.0f,0.0f,0.0f),Vec3fa(0.0f,0.0f,8.0f),16,16));
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      avector<float> org_x(N), org_y(N), org_z(N), tnear(N), tfar(N), Ng_x(N), Ng_y(N), Ng_z(N), u(N), v(N);
+      avector<unsigned int> geomID(N), primID(N), instID(N);
+      avector<RTCRayHit> ref(N);
+      avector<float> ref_tfar(N);
+      RTCRaySharedDirection rays;
+      rays.dir_x = 0.1f; rays.dir_y = -2.0f; rays.dir_z = 0.05f;
+      rays.time = 0.0f; rays.mask = 0xFFFFFFFF;
+      rays.org_x = org_x.data(); rays.org_y = org_y.data(); rays.org_z = org_z.data(); 
+      rays.tnear = tnear.data(); rays.tfar = tfar.data();
+      RTCHitNp hits;
+      hits.Ng_x = Ng_x.data(); hits.Ng_y = Ng_y.data(); hits.Ng_z = Ng_z.data(); hits.u = u.data(); hits.v = v.data();
+      hits.geomID = geomID.data(); hits.primID = primID.data(); hits.instID[0] = instID.data();
+
+      for (size_t i=0; i<N; i++)
+      {
+        const Vec3fa org(6.0f*random_float()-3.0f, 2.0f, 6.0f*random_float()-3.0f);
+        ref[i] = makeRay(org,Vec3fa(rays.dir_x,rays.dir_y,rays.dir_z),0.0f,(i%7 == 0) ? -1.0f : 10.0f*random_float()); // also test inactive rays
+        ref_tfar[i] = ref[i].ray.tfar;
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        if (ref[i].ray.tnear <= ref[i].ray.tfar)
+          rtcIntersect1(scene,&context,&ref[i]);
+      }
+
+      for (bool intersect : { true, false })
+      {
+        for (size_t i=0; i<N; i++)
+        {
+          org_x[i] = ref[i].ray.org_x; org_y[i] = ref[i].ray.org_y; org_z[i] = ref[i].ray.org_z; 
+          tnear[i] = ref[i].ray.tnear; tfar[i] = ref_tfar[i];
+          geomID[i] = RTC_INVALID_GEOMETRY_ID;
+        }
+        if (!intersect) { /* occlusion rays end just behind or well before the reference hits */
+          for (size_t i=0; i<N; i++)
+            if (i%7 != 0 && ref[i].hit.geomID != RTC_INVALID_GEOMETRY_ID) tfar[i] = ref[i].ray.tfar*((i%3 == 0) ? 0.5f : 1.01f);
+        }
+          
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        context.flags = iflags;
+        if (intersect) rtcIntersectSharedDirection(scene,&context,&rays,&hits,(unsigned int)N);
+        else           rtcOccludedSharedDirection (scene,&context,&rays,(unsigned int)N);
+        AssertNoError(device);
+
+        for (size_t i=0; i<N; i++)
+        {
+          if (i%7 == 0) {
+            if (tfar[i] != -1.0f) return VerifyApplication::FAILED;
+          }
+          else if (intersect) {
+            if (geomID[i] != ref[i].hit.geomID) return VerifyApplication::FAILED;
+            if (geomID[i] == RTC_INVALID_GEOMETRY_ID) continue;
+            if (primID[i] != ref[i].hit.primID || abs(tfar[i]-ref[i].ray.tfar) > 1E-4f) return VerifyApplication::FAILED;
+          }
+          else {
+            const bool occluded = tfar[i] == float(neg_inf);
+            if (occluded != (ref[i].hit.geomID != RTC_INVALID_GEOMETRY_ID && i%3 != 0)) return VerifyApplication::FAILED;
+          }
+        }
+      }
+
+      return VerifyApplication::PASSED;
+    }
+  };
+
+  struct NaNTest : public VerifyApplication::IntersectTest
+  {
+    SceneFlags sflags;
+    RTCBuildQuality quality;
+    
+    NaNTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality)  {}
+    
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!supportsIntersectMode(device,imode))
+        return VerifyApplication::SKIPPED;
+
+      bool ok = false;
+      for (size_t i=0; i<10 && !ok; i++)
+      {
+        const size_t numRays = 1000;
+        RTCRayHit rays[numRays];
+        VerifyScene scene(device,sflags);
+        scene.addSphere(sampler,quality,zero,2.0f,100);
+        scene.addHair  (sampler,quality,zero,1.0f,1.0f,100);
+        rtcCommitScene (scene);
+        
+        double c0 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org,dir); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c1 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org+Vec3fa(nan),dir); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c2 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org+Vec3fa(nan),dir+Vec3fa(nan)); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c3 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org,dir,nan,nan); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c4 = getSeconds();
+        double d1 = c1-c0;
+        double d2 = c2-c1;
+        double d3 = c3-c2;
+        double d4 = c4-c3;
+        AssertNoError(device);        
+        
+        ok = (d2 < 2.5*d1) && (d3 < 2.5*d1) && (d4 < 2.5*d1);
+        double f = max(d2/d1,d3/d1,d4/d1);
+        if (!silent) { printf(" (%3.2fx)",f); fflush(stdout); }
+      }
+      return (VerifyApplication::TestReturnValue) ok;
+    }
+  };
+    
+  struct InfTest : public VerifyApplication::IntersectTest
+  {
+    SceneFlags sflags;
+    RTCBuildQuality quality;
+    
+    InfTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, IntersectMode imode, IntersectVariant ivariant)
+      : VerifyApplication::IntersectTest(name,isa,imode,ivariant,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality) {}
+   
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      if (!supportsIntersectMode(device,imode))
+        return VerifyApplication::SKIPPED;
+
+      const size_t numRays = 1000;
+      RTCRayHit rays[numRays];
+      VerifyScene scene(device,sflags);
+      scene.addSphere(sampler,quality,zero,2.0f,100);
+      scene.addHair  (sampler,quality,zero,1.0f,1.0f,100);
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      bool ok = false;
+      for (size_t i=0; i<10 && !ok; i++)
+      {
+        double c0 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org,dir); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c1 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org+Vec3fa(inf),dir); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c2 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org,dir+Vec3fa(inf)); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c3 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org+Vec3fa(inf),dir+Vec3fa(inf)); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c4 = getSeconds();
+        for (size_t i=0; i<numRays; i++) {
+          Vec3fa org = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          Vec3fa dir = 2.0f*random_Vec3fa() - Vec3fa(1.0f);
+          rays[i] = makeRay(org,dir,-0.0f,inf); 
+        }
+        IntersectWithMode(imode,ivariant,scene,rays,numRays);
+        
+        double c5 = getSeconds();      
+        double d1 = c1-c0;
+        double d2 = c2-c1;
+        double d3 = c3-c2;
+        double d4 = c4-c3;
+        double d5 = c5-c4;
+        AssertNoError(device);
+        
+        ok = (d2 < 2.5*d1) && (d3 < 2.5*d1) && (d4 < 2.5*d1) && (d5 < 2.5*d1);
+        double f = max(d2/d1,d3/d1,d4/d1,d5/d1);
+        if (!silent) { printf(" (%3.2fx)",f); fflush(stdout); }
+      }
+      return (VerifyApplication::TestReturnValue) ok;
+    }
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+  
+  struct PointQueryAPICallsTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags; 
+
+    PointQueryAPICallsTest (std::string name, int isa, SceneFlags sflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags) {}
+
+    VerifyApplication::TestReturnValue run(VerifyApplication *state, bool silent)
+    {
+      // This test assures that the expected internal point query calls are made
+      // for supported primitive/geometry types
+      
+      std::string cfg = state->rtcore + ",isa=" + stringOfISA(isa);
+
+      auto queryFunc = [](RTCPointQueryFunctionArguments* args) -> bool
+      {
+        assert(args->userPtr);
+        //printf("query callback called for geomID %u and primID %u\n", args->geomID, args->primID);
+        uint32_t *numCalls = (uint32_t*)args->userPtr;
+        (*numCalls)++;
+        return false;
+      };
+      RTCPointQuery query;
+      query.x = query.y = query.z = query.time = 0.f;
+      query.radius = inf;
+
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr, rtcGetDeviceError(device));
+      
+      // triangle mesh
+      if (1) {
+        RTCSceneRef scene = rtcNewScene(device);
+        rtcSetSceneFlags(scene, sflags.sflags);
+        rtcSetSceneBuildQuality(scene, sflags.qflags);
+
+        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
+        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+
+        Vec3f *vertices = (Vec3f *)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, sizeof(Vec3f), 3);
+        Triangle *triangles = (Triangle *)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, sizeof(Triangle), 1);
+        vertices[0] = Vec3f(-1.0f, 0.0f, -1.0f);
+        vertices[1] = Vec3f(+1.0f, 0.0f, -1.0f);
+        vertices[2] = Vec3f(+0.0f, 0.0f, +1.0f);
+        triangles[0] = Triangle(0, 1, 2);
+
+        rtcCommitGeometry(geom);
+        rtcAttachGeometry(scene, geom);
+        rtcReleaseGeometry(geom);
+        rtcCommitScene(scene);
+        AssertNoError(device);
+
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        uint32_t numCalls = 0;
+        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
+        if (numCalls != 1)
+          return VerifyApplication::FAILED;
+        AssertNoError(device);
+      }
+      
+      // flat linear curve
+      if (1) {
+        RTCSceneRef scene = rtcNewScene(device);
+        rtcSetSceneFlags(scene, sflags.sflags);
+        rtcSetSceneBuildQuality(scene, sflags.qflags);
+
+        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE);
+        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+
+        Vec4f *vertices = (Vec4f *)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, sizeof(Vec4f), 3);
+        uint32_t *indices = (uint32_t*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT, sizeof(uint32_t), 2);
+        vertices[0] = Vec4f(-1.0f, 0.0f, 0.0f, 0.1f);
+        vertices[1] = Vec4f(+0.0f, 0.0f, 0.0f, 0.1f);
+        vertices[2] = Vec4f(+1.0f, 0.0f, 0.0f, 0.1f);
+        indices[0] = 0;
+        indices[1] = 1;
+
+        rtcCommitGeometry(geom);
+        rtcAttachGeometry(scene, geom);
+        rtcReleaseGeometry(geom);
+        rtcCommitScene(scene);
+        AssertNoError(device);
+
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        uint32_t numCalls = 0;
+        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
+        if (numCalls != 0)
+        {
+          return VerifyApplication::FAILED;
+        }
+        AssertNoError(device);
+      }
+      
+      // flat bezier curve
+      if (1) {
+        RTCSceneRef scene = rtcNewScene(device);
+        rtcSetSceneFlags(scene, sflags.sflags);
+        rtcSetSceneBuildQuality(scene, sflags.qflags);
+
+        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE);
+        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+
+        Vec4f *vertices = (Vec4f *)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, sizeof(Vec4f), 4);
+        uint32_t *indices = (uint32_t*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT, sizeof(uint32_t), 1);
+        vertices[0] = Vec4f(-1.0f, 0.0f, 0.0f, 0.1f);
+        vertices[1] = Vec4f(-1.0f, 0.0f, 1.0f, 0.1f);
+        vertices[2] = Vec4f(+1.0f, 0.0f, 1.0f, 0.1f);
+        vertices[3] = Vec4f(+1.0f, 0.0f, 0.0f, 0.1f);
+        indices[0] = 0;
+
+        rtcCommitGeometry(geom);
+        rtcAttachGeometry(scene, geom);
+        rtcReleaseGeometry(geom);
+        rtcCommitScene(scene);
+        AssertNoError(device);
+
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        uint32_t numCalls = 0;
+        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
+        if (numCalls != 0)
+        {
+          return VerifyApplication::FAILED;
+        }
+        AssertNoError(device);
+      }
+      
+      // grid geometry
+      if (1) {
+        RTCSceneRef scene = rtcNewScene(device);
+        rtcSetSceneFlags(scene, sflags.sflags);
+        rtcSetSceneBuildQuality(scene, sflags.qflags);
+
+        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_GRID);
+        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+
+        RTCGrid* grid = (RTCGrid*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_GRID, 0, RTC_FORMAT_GRID, sizeof(RTCGrid), 2);
+        grid[0].startVertexID = 0;
+        grid[0].stride        = 3;
+        grid[0].width         = 3;
+        grid[0].height        = 3;
+        grid[1].startVertexID = 9;
+        grid[1].stride        = 2;
+        grid[1].width         = 2;
+        grid[1].height        = 2;
+
+        /* set vertices */
+        Vec3f* vertices = (Vec3f*) rtcSetNewGeometryBuffer(geom,RTC_BUFFER_TYPE_VERTEX,0,RTC_FORMAT_FLOAT3,sizeof(Vec3f),13);
+        for (int j = 0; j < 3; ++j)
+        for (int i = 0; i < 3; ++i)
+        {
+          vertices[j * 3 + i] = Vec3f(float(i), (j == 1) ? 0.5f : 1.f, 2.f-float(j));
+        }
+        vertices[ 9] = Vec3f(0.f, 2.f, 1.f);
+        vertices[10] = Vec3f(1.f, 2.f, 1.f);
+        vertices[11] = Vec3f(1.f, 2.f, 0.f);
+        vertices[12] = Vec3f(0.f, 2.f, 0.f);
+
+        rtcCommitGeometry(geom);
+        rtcAttachGeometry(scene, geom);
+        rtcReleaseGeometry(geom);
+        rtcCommitScene(scene);
+        AssertNoError(device);
+
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        uint32_t numCalls = 0;
+        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
+        if (numCalls != 2)
+        {
+          return VerifyApplication::FAILED;
+        }
+        AssertNoError(device);
+      }
+
+      // user geometry
+      if (1) {
+        RTCSceneRef scene = rtcNewScene(device);
+        rtcSetSceneFlags(scene, sflags.sflags);
+        rtcSetSceneBuildQuality(scene, sflags.qflags);
+
+        auto boundsFunc = [](const struct RTCBoundsFunctionArguments* args)
+        {
+          const Vec4f* spheres = (const Vec4f*) args->geometryUserPtr;
+          RTCBounds* bounds_o = args->bounds_o;
+          const Vec4f& sphere = spheres[args->primID];
+          bounds_o->lower_x = sphere.x-sphere.w;
+          bounds_o->lower_y = sphere.y-sphere.w;
+          bounds_o->lower_z = sphere.z-sphere.w;
+          bounds_o->upper_x = sphere.x+sphere.w;
+          bounds_o->upper_y = sphere.y+sphere.w;
+          bounds_o->upper_z = sphere.z+sphere.w;
+        };
+        auto intersectFunc = [](const RTCIntersectFunctionNArguments* args) {};
+        auto occludedFunc  = [](const RTCOccludedFunctionNArguments* args)  {};
+        
+        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_USER);
+        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+
+        Vec4f* spheres = (Vec4f*) alignedMalloc(2*sizeof(Vec4f),16);
+        spheres[0] = Vec4f(0.f, 0.f, 0.f, 1.f);
+        spheres[1] = Vec4f(2.f, 0.f, 0.f, 1.f);
+        rtcSetGeometryUserPrimitiveCount(geom, 2);
+        rtcSetGeometryUserData(geom, spheres);
+        rtcSetGeometryBoundsFunction(geom, boundsFunc, nullptr);
+        rtcSetGeometryIntersectFunction(geom, intersectFunc);
+        rtcSetGeometryOccludedFunction (geom, occludedFunc);
+        rtcCommitGeometry(geom);
+        rtcAttachGeometry(scene, geom);
+        rtcReleaseGeometry(geom);
+        rtcCommitScene(scene);
+        AssertNoError(device);
+
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        uint32_t numCalls = 0;
+        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
         if (numCalls != 2)
         {
           return VerifyApplication::FAILED;
         }
-        AssertNoError(device);
+        AssertNoError(device);
+        alignedFree(spheres);
+      }
+      
+      // point geometry
+      if (1) {
+        RTCSceneRef scene = rtcNewScene(device);
+        rtcSetSceneFlags(scene, sflags.sflags);
+        rtcSetSceneBuildQuality(scene, sflags.qflags);
+
+        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_SPHERE_POINT);
+        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+
+        Vec4f* vertices = (Vec4f*) rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, sizeof(Vec4f), 10);
+        for (int i = 0; i < 10; ++i)
+          vertices[i] = Vec4f((float)i, 0.f, 0.f, 0.1f);
+
+        rtcCommitGeometry(geom);
+        rtcAttachGeometry(scene, geom);
+        rtcReleaseGeometry(geom);
+        rtcCommitScene(scene);
+        AssertNoError(device);
+
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        uint32_t numCalls = 0;
+        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
+        if (numCalls != 0)
+        {
+          return VerifyApplication::FAILED;
+        }
+        AssertNoError(device);
+      }
+
+      return VerifyApplication::PASSED;
+    }
+  };
+  
+  struct PointQueryTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags; 
+    std::string tri_accel;
+
+    PointQueryTest (std::string name, int isa, SceneFlags sflags, std::string tri_accel = "")
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), tri_accel(tri_accel) {}
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa) + ((tri_accel != "") ? ",tri_accel="+tri_accel : "");
+      //printf("run test %s\n", cfg.c_str());
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+     
+      RTCSceneRef scene = rtcNewScene(device);
+      rtcSetSceneFlags(scene,sflags.sflags);
+      rtcSetSceneBuildQuality(scene,sflags.qflags);
+      
+      RTCGeometry geom = rtcNewGeometry (device, RTC_GEOMETRY_TYPE_TRIANGLE);
+      rtcSetGeometryBuildQuality(geom,sflags.qflags);
+
+      Vec3f* vertices = (Vec3f*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, sizeof(Vec3f), 3*32);
+      Triangle* triangles = (Triangle*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX , 0, RTC_FORMAT_UINT3, sizeof(Triangle), 32);
+      for (int i = 0; i < 32; ++i) {
+        float xi = random_float();
+        vertices[3*i+0] = Vec3f(0.0f,          0.0f,          (float)i);
+        vertices[3*i+1] = Vec3f(1.0f + 5.f*xi, 0.0f,          (float)i);
+        vertices[3*i+2] = Vec3f(0.0f,          1.0f + 5.f*xi, (float)i);
+        triangles[i] = Triangle(3*i+0, 3*i+1, 3*i+2);
+      };
+
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(scene,geom);
+      rtcReleaseGeometry(geom);
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      struct UserData
+      {
+        Vec3f* vertices;
+        Triangle* triangles;
+        Vec3f result;
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+      };
+
+      for (int i = 0; i < 64; ++i)
+      {
+        RTCPointQuery query;
+        query.x = 0.25f;
+        query.y = 0.75f;
+        query.z = -0.25f + i * 0.5f;
+        query.time = 0.f;
+        query.radius = inf;
+
+        UserData data;
+        data.vertices  = vertices;
+        data.triangles = triangles;
+
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query, &context, [](RTCPointQueryFunctionArguments* args) -> bool
+        {
+          UserData* data = (UserData*)args->userPtr;
+          // get triangle info
+          Triangle const& t = data->triangles[args->primID];
+          Vec3f const& v0 = data->vertices[t.v0];
+          Vec3f const& v1 = data->vertices[t.v1];
+          Vec3f const& v2 = data->vertices[t.v2];
+          
+          // determine closest point on triangle
+          const Vec3f q(args->query->x, args->query->y, args->query->z);
+          const Vec3f p = closestPointTriangle(q, v0, v1, v2);
+          const float d = distance(q, p);
+
+          if (d < args->query->radius) {
+            args->query->radius = d;
+            data->result = p;
+            data->primID = args->primID;
+            return true;
+          }
+          return false; 
+        }, &data);
+
+        if ((int)data.primID != i/2) return VerifyApplication::FAILED;
+        if (abs(data.result.x- 0.25f) > 1e-4f)        return VerifyApplication::FAILED;
+        if (abs(data.result.y- 0.75f) > 1e-4f)        return VerifyApplication::FAILED;
+        if (abs(data.result.z- (float)(i/2)) > 1e-4f) return VerifyApplication::FAILED;
+        AssertNoError(device);
+      }
+
+      return VerifyApplication::PASSED;
+    }
+  };
+
+  struct PointQueryMotionBlurTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags; 
+    std::string tri_accel;
+
+    PointQueryMotionBlurTest (std::string name, int isa, SceneFlags sflags, std::string tri_accel = "")
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), tri_accel(tri_accel) {}
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa) + (tri_accel != "" ? ",tri_accel="+tri_accel : "");
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+     
+      Vec3f vertices_t0[4] = { 
+        Vec3f(-1.f, -1.f, -1.f), 
+        Vec3f( 1.f, -1.f, -1.f), 
+        Vec3f( 0.f,  1.f, -1.f), 
+        Vec3f(0.f) // 16 byte padding
+      };
+      Vec3f vertices_t1[4] = { 
+        Vec3f(-1.f, -1.f, 1.f), 
+        Vec3f( 1.f, -1.f, 1.f), 
+        Vec3f( 0.f,  1.f, 1.f), 
+        Vec3f(0.f) // 16 byte padding
+      };
+
+      // duplicate triangle to make sure the bvh is not only a leaf node
+      Triangle triangles[64];
+      for (int i = 0; i < 64; ++i)
+        triangles[i] = Triangle(0, 1, 2);
+
+      RTCSceneRef scene = rtcNewScene(device);
+      rtcSetSceneFlags(scene,sflags.sflags);
+      rtcSetSceneBuildQuality(scene,sflags.qflags);
+      
+      RTCGeometry geom = rtcNewGeometry (device, RTC_GEOMETRY_TYPE_TRIANGLE);
+      rtcSetGeometryBuildQuality(geom,sflags.qflags);
+      rtcSetGeometryTimeStepCount(geom,2);
+      rtcSetGeometryPointQueryFunction(geom, [](RTCPointQueryFunctionArguments* args) -> bool
+      {
+        // set primID (userPtr) to something != RTC_INVALID_GEOMETRY_ID to signal that 
+        // the query overlapped some geometry
+        *((unsigned int*)args->userPtr) = 0;
+        return true;
+      });
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices_t0, 0, sizeof(Vec3f),     3);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 1, RTC_FORMAT_FLOAT3, vertices_t1, 0, sizeof(Vec3f),     3);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX , 0, RTC_FORMAT_UINT3,  triangles,   0, sizeof(Triangle), 64);
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(scene,geom);
+      rtcReleaseGeometry(geom);
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      RTCPointQuery query0;
+      query0.x      =  0.0f;
+      query0.y      =  0.0f;
+      query0.z      = -1.0f;
+      query0.radius =  0.1f;
+      
+      RTCPointQuery query1;
+      query1.x      =  0.0f;
+      query1.y      =  0.0f;
+      query1.z      =  0.0f;
+      query1.radius =  0.1f;
+      
+      RTCPointQuery query2;
+      query2.x      =  0.0f;
+      query2.y      =  0.0f;
+      query2.z      =  1.0f;
+      query2.radius =  0.1f;
+
+      // time t = 0, only query0 should overlap
+      query0.time = query1.time = query2.time = 0.f;
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query0, &context, nullptr, &primID);
+        if (primID == RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query1, &context, nullptr, &primID);
+        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query2, &context, nullptr, &primID);
+        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+
+      // time t = 0.5, only query1 should overlap
+      query0.time = query1.time = query2.time = 0.5f;
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query0, &context, nullptr, &primID);
+        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query1, &context, nullptr, &primID);
+        if (primID == RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query2, &context, nullptr, &primID);
+        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+      
+      // time t = 1.0, only query2 should overlap
+      query0.time = query1.time = query2.time = 1.f;
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query0, &context, nullptr, &primID);
+        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query1, &context, nullptr, &primID);
+        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+      {
+        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        rtcPointQuery(scene, &query2, &context, nullptr, &primID);
+        if (primID == RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      }
+
+      return VerifyApplication::PASSED;
+    }
+  };
+
+  struct ClosestPointTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+    bool instancing;
+
+    ClosestPointTest (std::string name, int isa, SceneFlags sflags, bool instancing)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), instancing(instancing) {}
+
+    struct RefTriangle
+    {
+      Vec3fa v0, v1, v2;
+      unsigned int geomID;
+    };
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      const AffineSpace3fa space = instancing ? AffineSpace3fa::translate(Vec3fa(0.0f,1.0f,2.0f)) * AffineSpace3fa::rotate(Vec3fa(1.0f,1.0f,0.0f),1.0f) * AffineSpace3fa::scale(Vec3fa(2.0f,1.0f,1.5f)) : AffineSpace3fa(one);
+      Ref<SceneGraph::Node> nodes[3] = {
+        SceneGraph::createTriangleSphere(Vec3fa(-3.0f,0.0f,0.0f),1.0f,10),
+        SceneGraph::createQuadSphere(Vec3fa(0.0f,0.0f,0.0f),1.0f,10),
+        SceneGraph::createGridSphere(Vec3fa(3.0f,0.0f,0.0f),1.0f,6)
+      };
+
+      VerifyScene scene(device,sflags);
+      std::vector<RefTriangle> triangles;
+      for (unsigned int i = 0; i < 3; i++)
+      {
+        const unsigned int geomID = instancing ? scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,new SceneGraph::TransformNode(space,nodes[i])) : scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,nodes[i]);
+
+        Ref<SceneGraph::Node> node = nodes[i];
+        if (node.dynamicCast<SceneGraph::GridMeshNode>())
+          node = SceneGraph::convert_grids_to_quads(node);
+
+        if (Ref<SceneGraph::TriangleMeshNode> mesh = node.dynamicCast<SceneGraph::TriangleMeshNode>()) {
+          for (auto& tri : mesh->triangles)
+            triangles.push_back({ mesh->positions[0][tri.v0], mesh->positions[0][tri.v1], mesh->positions[0][tri.v2], geomID });
+        }
+        else if (Ref<SceneGraph::QuadMeshNode> mesh = node.dynamicCast<SceneGraph::QuadMeshNode>()) {
+          for (auto& quad : mesh->quads) {
+            triangles.push_back({ mesh->positions[0][quad.v0], mesh->positions[0][quad.v1], mesh->positions[0][quad.v3], geomID });
+            triangles.push_back({ mesh->positions[0][quad.v2], mesh->positions[0][quad.v3], mesh->positions[0][quad.v1], geomID });
+          }
+        }
+      }
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      for (auto& tri : triangles) {
+        tri.v0 = xfmPoint(space,tri.v0);
+        tri.v1 = xfmPoint(space,tri.v1);
+        tri.v2 = xfmPoint(space,tri.v2);
+      }
+
+      for (size_t i = 0; i < 256; i++)
+      {
+        const Vec3fa q = xfmPoint(space,Vec3fa(8.0f*random_float()-4.0f, 4.0f*random_float()-2.0f, 4.0f*random_float()-2.0f));
+
+        /* brute force reference */
+        float refDist = inf;
+        for (auto& tri : triangles) {
+          /* degenerate triangles at the poles of the spheres have no well defined closest point */
+          const float dist = distance(q, closestPointTriangle(q, tri.v0, tri.v1, tri.v2));
+          if (std::isfinite(dist)) refDist = min(refDist, dist);
+        }
+
+        RTCPointQuery query;
+        query.x = q.x;
+        query.y = q.y;
+        query.z = q.z;
+        query.time = 0.0f;
+        query.radius = inf;
+
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        RTCClosestPointResult result;
+        if (!rtcClosestPoint(scene, &query, &context, &result))
+          return VerifyApplication::FAILED;
+        AssertNoError(device);
+
+        const Vec3fa p(result.x, result.y, result.z);
+        if (abs(query.radius - refDist) > 1E-4f) return VerifyApplication::FAILED;
+        if (abs(distance(p, q) - refDist) > 1E-4f) return VerifyApplication::FAILED;
+        if (result.u < -1E-4f || result.u > 1.0f+1E-4f) return VerifyApplication::FAILED;
+        if (result.v < -1E-4f || result.v > 1.0f+1E-4f) return VerifyApplication::FAILED;
+        if (result.primID == RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+        if (instancing) {
+          if (result.geomID != 0 || result.instID[0] > 2) return VerifyApplication::FAILED;
+        } else {
+          if (result.geomID > 2 || result.instID[0] != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+        }
+      }
+
+      /* a query radius that does not reach the geometry returns no closest point */
+      RTCPointQuery query;
+      query.x = query.y = query.z = 100.0f;
+      query.time = 0.0f;
+      query.radius = 1.0f;
+      RTCPointQueryContext context;
+      rtcInitPointQueryContext(&context);
+      RTCClosestPointResult result;
+      if (rtcClosestPoint(scene, &query, &context, &result)) return VerifyApplication::FAILED;
+      if (result.geomID != RTC_INVALID_GEOMETRY_ID || result.primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
+      if (result.x != 0.0f || result.y != 0.0f || result.z != 0.0f) return VerifyApplication::FAILED;
+      AssertNoError(device);
+
+      return VerifyApplication::PASSED;
+    }
+  };
+
+  struct NearestPointsTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+    bool instancing;
+
+    NearestPointsTest (std::string name, int isa, SceneFlags sflags, bool instancing)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), instancing(instancing) {}
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      const AffineSpace3fa space = instancing ? AffineSpace3fa::translate(Vec3fa(0.0f,1.0f,2.0f)) * AffineSpace3fa::rotate(Vec3fa(1.0f,1.0f,0.0f),1.0f) * AffineSpace3fa::scale(Vec3fa(2.0f,1.0f,1.5f)) : AffineSpace3fa(one);
+      const RTCGeometryType types[2] = { RTC_GEOMETRY_TYPE_SPHERE_POINT, RTC_GEOMETRY_TYPE_DISC_POINT };
+
+      VerifyScene scene(device,sflags);
+      std::vector<std::pair<Vec3fa,unsigned int>> points;
+      for (unsigned int i = 0; i < 2; i++)
+      {
+        avector<SceneGraph::PointSetNode::Vertex> positions(1000);
+        for (auto& p : positions)
+          p = SceneGraph::PointSetNode::Vertex(4.0f*random_float()-2.0f, 4.0f*random_float()-2.0f, 4.0f*random_float()-2.0f, 0.01f);
+        Ref<SceneGraph::Node> node = new SceneGraph::PointSetNode(positions,nullptr,types[i]);
+        const unsigned int geomID = instancing ? scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,new SceneGraph::TransformNode(space,node)) : scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,node);
+        for (auto& p : positions)
+          points.push_back(std::make_pair(xfmPoint(space,Vec3fa(p.x,p.y,p.z)),geomID));
+      }
+
+      /* other geometry types are ignored by nearest points queries */
+      scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(Vec3fa(0.0f,0.0f,0.0f),1.0f,10));
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      const unsigned int K = 8;
+      const size_t M = 256;
+      std::vector<RTCPointQuery> queries(M);
+      std::vector<std::vector<float>> refDists(M);
+      for (size_t i = 0; i < M; i++)
+      {
+        const Vec3fa q = xfmPoint(space,Vec3fa(4.0f*random_float()-2.0f, 4.0f*random_float()-2.0f, 4.0f*random_float()-2.0f));
+        queries[i].x = q.x;
+        queries[i].y = q.y;
+        queries[i].z = q.z;
+        queries[i].time = 0.0f;
+        queries[i].radius = i%4 == 0 ? 0.2f : float(inf);
+
+        /* brute force reference */
+        for (auto& p : points) {
+          const float d = distance(q, p.first);
+          if (d <= queries[i].radius) refDists[i].push_back(d);
+        }
+        std::sort(refDists[i].begin(), refDists[i].end());
+        refDists[i].resize(min(refDists[i].size(),size_t(K)));
+      }
+
+      auto check = [&] (size_t i, unsigned int num, const RTCNearestPoint* result) -> bool
+      {
+        if (num != refDists[i].size()) return false;
+        for (unsigned int j = 0; j < num; j++)
+        {
+          if (abs(result[j].distance - refDists[i][j]) > 1E-4f) return false;
+          if (j > 0 && result[j].distance < result[j-1].distance) return false;
+          if (result[j].primID >= 1000) return false;
+          if (instancing) {
+            if (result[j].geomID != 0 || result[j].instID[0] > 1) return false;
+          } else {
+            if (result[j].geomID > 1 || result[j].instID[0] != RTC_INVALID_GEOMETRY_ID) return false;
+          }
+          const unsigned int geomID = instancing ? result[j].instID[0] : result[j].geomID;
+          const std::pair<Vec3fa,unsigned int>& p = points[1000*geomID+result[j].primID];
+          if (abs(distance(Vec3fa(queries[i].x,queries[i].y,queries[i].z),p.first) - result[j].distance) > 1E-4f) return false;
+        }
+        return true;
+      };
+
+      for (size_t i = 0; i < M; i++)
+      {
+        RTCPointQuery query = queries[i];
+        RTCPointQueryContext context;
+        rtcInitPointQueryContext(&context);
+        RTCNearestPoint result[K];
+        const unsigned int num = rtcNearestPoints(scene, &query, &context, K, result);
+        AssertNoError(device);
+        if (!check(i, num, result)) return VerifyApplication::FAILED;
+      }
+
+      /* batched queries */
+      RTCPointQueryContext context;
+      rtcInitPointQueryContext(&context);
+      std::vector<RTCNearestPoint> results(M*K);
+      std::vector<unsigned int> numPoints(M);
+      rtcNearestPoints1M(scene, queries.data(), (unsigned int)M, sizeof(RTCPointQuery), &context, K, results.data(), numPoints.data());
+      AssertNoError(device);
+      for (size_t i = 0; i < M; i++) {
+        if (!check(i, numPoints[i], &results[i*K])) return VerifyApplication::FAILED;
+      }
+
+      return VerifyApplication::PASSED;
+    }
+  };
+
+  struct BoxQueryTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+    bool instancing;
+
+    BoxQueryTest (std::string name, int isa, SceneFlags sflags, bool instancing)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), instancing(instancing) {}
+
+    struct RefPrim
+    {
+      std::vector<BBox3fa> bounds; // the grid cells for grids
+      unsigned int geomID;
+      unsigned int primID;
+    };
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      const AffineSpace3fa space = instancing ? AffineSpace3fa::translate(Vec3fa(0.0f,1.0f,2.0f)) * AffineSpace3fa::rotate(Vec3fa(1.0f,1.0f,0.0f),1.0f) * AffineSpace3fa::scale(Vec3fa(2.0f,1.0f,1.5f)) : AffineSpace3fa(one);
+      auto bounds = [&] (const std::vector<Vec3fa>& vertices) {
+        BBox3fa b(empty);
+        for (auto& v : vertices) b.extend(xfmPoint(space,v));
+        return b;
+      };
+
+      avector<SceneGraph::PointSetNode::Vertex> positions(500);
+      for (auto& p : positions)
+        p = SceneGraph::PointSetNode::Vertex(2.0f*random_float()-1.0f, 2.0f*random_float()-1.0f, 2.0f*random_float()-1.0f, 0.05f);
+
+      Ref<SceneGraph::Node> nodes[4] = {
+        SceneGraph::createTriangleSphere(Vec3fa(-3.0f,0.0f,0.0f),1.0f,10),
+        SceneGraph::createQuadSphere(Vec3fa(0.0f,0.0f,0.0f),1.0f,10),
+        SceneGraph::createGridSphere(Vec3fa(3.0f,0.0f,0.0f),1.0f,6),
+        new SceneGraph::PointSetNode(positions,nullptr,RTC_GEOMETRY_TYPE_SPHERE_POINT)
+      };
+
+      VerifyScene scene(device,sflags);
+      std::vector<RefPrim> prims;
+      for (unsigned int i = 0; i < 4; i++)
+      {
+        const unsigned int geomID = instancing ? scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,new SceneGraph::TransformNode(space,nodes[i])) : scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,nodes[i]);
+
+        if (Ref<SceneGraph::TriangleMeshNode> mesh = nodes[i].dynamicCast<SceneGraph::TriangleMeshNode>()) {
+          for (unsigned int j = 0; j < mesh->triangles.size(); j++) {
+            auto& tri = mesh->triangles[j];
+            prims.push_back({ { bounds({ mesh->positions[0][tri.v0], mesh->positions[0][tri.v1], mesh->positions[0][tri.v2] }) }, geomID, j });
+          }
+        }
+        else if (Ref<SceneGraph::QuadMeshNode> mesh = nodes[i].dynamicCast<SceneGraph::QuadMeshNode>()) {
+          for (unsigned int j = 0; j < mesh->quads.size(); j++) {
+            auto& quad = mesh->quads[j];
+            prims.push_back({ { bounds({ mesh->positions[0][quad.v0], mesh->positions[0][quad.v1], mesh->positions[0][quad.v2], mesh->positions[0][quad.v3] }) }, geomID, j });
+          }
+        }
+        else if (Ref<SceneGraph::GridMeshNode> mesh = nodes[i].dynamicCast<SceneGraph::GridMeshNode>()) {
+          for (unsigned int j = 0; j < mesh->grids.size(); j++)
+          {
+            auto& grid = mesh->grids[j];
+            RefPrim prim = { {}, geomID, j };
+            for (unsigned int y = 0; y+1 < grid.resY; y++) {
+              for (unsigned int x = 0; x+1 < grid.resX; x++) {
+                auto vertex = [&] (unsigned int x, unsigned int y) { return mesh->positions[0][grid.startVtx + y*grid.lineStride + x]; };
+                prim.bounds.push_back(bounds({ vertex(x,y), vertex(x+1,y), vertex(x+1,y+1), vertex(x,y+1) }));
+              }
+            }
+            prims.push_back(prim);
+          }
+        }
+        else {
+          for (unsigned int j = 0; j < positions.size(); j++) {
+            const Vec3fa p(positions[j].x, positions[j].y, positions[j].z);
+            const BBox3fa b(p-Vec3fa(positions[j].w), p+Vec3fa(positions[j].w));
+            prims.push_back({ { xfmBounds(space,b) }, geomID, j });
+          }
+        }
       }
+      rtcCommitScene (scene);
+      AssertNoError(device);
 
-      // user geometry
-      if (1) {
-        RTCSceneRef scene = rtcNewScene(device);
-        rtcSetSceneFlags(scene, sflags.sflags);
-        rtcSetSceneBuildQuality(scene, sflags.qflags);
+      const size_t M = 64;
+      std::vector<RTCBoxQuery> queries(M);
+      std::vector<std::vector<std::pair<unsigned int,unsigned int>>> refHits(M);
+      for (size_t i = 0; i < M; i++)
+      {
+        const Vec3fa center = xfmPoint(space,Vec3fa(8.0f*random_float()-4.0f, 3.0f*random_float()-1.5f, 3.0f*random_float()-1.5f));
+        const Vec3fa half(0.5f*random_float(), 0.5f*random_float(), 0.5f*random_float());
+        const BBox3fa box(center-half, center+half);
+        queries[i].lower_x = box.lower.x; queries[i].lower_y = box.lower.y; queries[i].lower_z = box.lower.z;
+        queries[i].upper_x = box.upper.x; queries[i].upper_y = box.upper.y; queries[i].upper_z = box.upper.z;
+        queries[i].time = 0.0f;
+
+        /* brute force reference */
+        for (auto& prim : prims) {
+          for (auto& b : prim.bounds) {
+            if (conjoint(b, box)) {
+              refHits[i].push_back(std::make_pair(prim.geomID, prim.primID));
+              break;
+            }
+          }
+        }
+        std::sort(refHits[i].begin(), refHits[i].end());
+      }
 
-        auto boundsFunc = [](const struct RTCBoundsFunctionArguments* args)
+      auto check = [&] (size_t i, unsigned int num, const RTCBoxQueryHit* hits, unsigned int maxHits) -> bool
+      {
+        if (num != refHits[i].size()) return false;
+        std::vector<std::pair<unsigned int,unsigned int>> found;
+        for (unsigned int j = 0; j < min(num,maxHits); j++)
         {
-          const Vec4f* spheres = (const Vec4f*) args->geometryUserPtr;
-          RTCBounds* bounds_o = args->bounds_o;
-          const Vec4f& sphere = spheres[args->primID];
-          bounds_o->lower_x = sphere.x-sphere.w;
-          bounds_o->lower_y = sphere.y-sphere.w;
-          bounds_o->lower_z = sphere.z-sphere.w;
-          bounds_o->upper_x = sphere.x+sphere.w;
-          bounds_o->upper_y = sphere.y+sphere.w;
-          bounds_o->upper_z = sphere.z+sphere.w;
-        };
-        auto intersectFunc = [](const RTCIntersectFunctionNArguments* args) {};
-        auto occludedFunc  = [](const RTCOccludedFunctionNArguments* args)  {};
-        
-        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_USER);
-        rtcSetGeometryBuildQuality(geom, sflags.qflags);
-
-        Vec4f* spheres = (Vec4f*) alignedMalloc(2*sizeof(Vec4f),16);
-        spheres[0] = Vec4f(0.f, 0.f, 0.f, 1.f);
-        spheres[1] = Vec4f(2.f, 0.f, 0.f, 1.f);
-        rtcSetGeometryUserPrimitiveCount(geom, 2);
-        rtcSetGeometryUserData(geom, spheres);
-        rtcSetGeometryBoundsFunction(geom, boundsFunc, nullptr);
-        rtcSetGeometryIntersectFunction(geom, intersectFunc);
-        rtcSetGeometryOccludedFunction (geom, occludedFunc);
-        rtcCommitGeometry(geom);
-        rtcAttachGeometry(scene, geom);
-        rtcReleaseGeometry(geom);
-        rtcCommitScene(scene);
-        AssertNoError(device);
+          if (instancing) {
+            if (hits[j].geomID != 0) return false;
+            found.push_back(std::make_pair(hits[j].instID[0], hits[j].primID));
+          } else {
+            if (hits[j].instID[0] != RTC_INVALID_GEOMETRY_ID) return false;
+            found.push_back(std::make_pair(hits[j].geomID, hits[j].primID));
+          }
+        }
+        std::sort(found.begin(), found.end());
+        if (num <= maxHits) return found == refHits[i];
+        return std::includes(refHits[i].begin(), refHits[i].end(), found.begin(), found.end());
+      };
 
+      const unsigned int maxHits = 4096;
+      std::vector<RTCBoxQueryHit> hits(M*maxHits);
+      for (size_t i = 0; i < M; i++)
+      {
         RTCPointQueryContext context;
         rtcInitPointQueryContext(&context);
-        uint32_t numCalls = 0;
-        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
-        if (numCalls != 2)
-        {
-          return VerifyApplication::FAILED;
-        }
+        const unsigned int num = rtcBoxQuery(scene, &queries[i], &context, maxHits, hits.data());
         AssertNoError(device);
-        alignedFree(spheres);
+        if (!check(i, num, hits.data(), maxHits)) return VerifyApplication::FAILED;
+
+        /* a too small output buffer still reports the number of hits */
+        const unsigned int num2 = rtcBoxQuery(scene, &queries[i], &context, 2, hits.data());
+        AssertNoError(device);
+        if (!check(i, num2, hits.data(), 2)) return VerifyApplication::FAILED;
       }
-      
-      // point geometry
-      if (1) {
-        RTCSceneRef scene = rtcNewScene(device);
-        rtcSetSceneFlags(scene, sflags.sflags);
-        rtcSetSceneBuildQuality(scene, sflags.qflags);
 
-        RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_SPHERE_POINT);
-        rtcSetGeometryBuildQuality(geom, sflags.qflags);
+      /* batched queries */
+      RTCPointQueryContext context;
+      rtcInitPointQueryContext(&context);
+      std::vector<unsigned int> numHits(M);
+      rtcBoxQuery1M(scene, queries.data(), (unsigned int)M, sizeof(RTCBoxQuery), &context, maxHits, hits.data(), numHits.data());
+      AssertNoError(device);
+      for (size_t i = 0; i < M; i++) {
+        if (!check(i, numHits[i], &hits[i*maxHits], maxHits)) return VerifyApplication::FAILED;
+      }
 
-        Vec4f* vertices = (Vec4f*) rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, sizeof(Vec4f), 10);
-        for (int i = 0; i < 10; ++i)
-          vertices[i] = Vec4f((float)i, 0.f, 0.f, 0.1f);
+      return VerifyApplication::PASSED;
+    }
+  };
 
-        rtcCommitGeometry(geom);
-        rtcAttachGeometry(scene, geom);
-        rtcReleaseGeometry(geom);
-        rtcCommitScene(scene);
-        AssertNoError(device);
+  struct CollideBufferedTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
 
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        uint32_t numCalls = 0;
-        rtcPointQuery(scene, &query, &context, queryFunc, (void*)&numCalls);
-        if (numCalls != 0)
-        {
+    CollideBufferedTest (std::string name, int isa, SceneFlags sflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags) {}
+
+    typedef std::tuple<unsigned int,unsigned int,unsigned int,unsigned int> Pair;
+
+    static std::vector<Pair> toPairs(const RTCCollision* collisions, size_t num, bool unique)
+    {
+      std::vector<Pair> pairs;
+      for (size_t i = 0; i < num; i++)
+        pairs.push_back(std::make_tuple(collisions[i].geomID0, collisions[i].primID0, collisions[i].geomID1, collisions[i].primID1));
+      std::sort(pairs.begin(), pairs.end());
+      if (unique) pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+      return pairs;
+    }
+
+    struct CallbackData
+    {
+      SpinLock mutex;
+      std::vector<RTCCollision> collisions;
+    };
+
+    static void collideFunc(void* userPtr, RTCCollision* collisions, unsigned int num_collisions)
+    {
+      CallbackData* data = (CallbackData*) userPtr;
+      Lock<SpinLock> lock(data->mutex);
+      data->collisions.insert(data->collisions.end(), collisions, collisions+num_collisions);
+    }
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      Ref<SceneGraph::TriangleMeshNode> mesh0 = SceneGraph::createTriangleSphere(Vec3fa(0.0f,0.0f,0.0f),1.0f,10).dynamicCast<SceneGraph::TriangleMeshNode>();
+      Ref<SceneGraph::TriangleMeshNode> mesh1 = SceneGraph::createTriangleSphere(Vec3fa(0.5f,0.3f,0.1f),1.0f,12).dynamicCast<SceneGraph::TriangleMeshNode>();
+
+      VerifyScene scene0(device,sflags);
+      VerifyScene scene1(device,sflags);
+      scene0.addGeometry(RTC_BUILD_QUALITY_MEDIUM,mesh0.dynamicCast<SceneGraph::Node>());
+      scene1.addGeometry(RTC_BUILD_QUALITY_MEDIUM,mesh1.dynamicCast<SceneGraph::Node>());
+      rtcCommitScene (scene0);
+      rtcCommitScene (scene1);
+      AssertNoError(device);
+
+      /* brute force reference of the narrow phase */
+      auto triangle = [] (const Ref<SceneGraph::TriangleMeshNode>& mesh, unsigned int primID, Vec3fa v[3]) {
+        const SceneGraph::TriangleMeshNode::Triangle& tri = mesh->triangles[primID];
+        v[0] = mesh->positions[0][tri.v0]; v[1] = mesh->positions[0][tri.v1]; v[2] = mesh->positions[0][tri.v2];
+      };
+      std::vector<Pair> refPairs;
+      for (unsigned int i = 0; i < mesh0->triangles.size(); i++) {
+        for (unsigned int j = 0; j < mesh1->triangles.size(); j++) {
+          Vec3fa a[3]; triangle(mesh0,i,a);
+          Vec3fa b[3]; triangle(mesh1,j,b);
+          if (isa::TriangleTriangleIntersector::intersect_triangle_triangle(a[0],a[1],a[2],b[0],b[1],b[2]))
+            refPairs.push_back(std::make_tuple(0,i,0,j));
+        }
+      }
+      if (refPairs.empty()) return VerifyApplication::FAILED;
+
+      /* candidate pairs have to match the pairs reported through the callback */
+      const unsigned int numCandidates = rtcCollideBuffered(scene0, scene1, RTC_COLLIDE_FLAG_NONE, nullptr, 0);
+      AssertNoError(device);
+      std::vector<RTCCollision> candidates(numCandidates);
+      if (rtcCollideBuffered(scene0, scene1, RTC_COLLIDE_FLAG_NONE, candidates.data(), numCandidates) != numCandidates)
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+
+      CallbackData callbackData;
+      rtcCollide(scene0, scene1, collideFunc, &callbackData);
+      AssertNoError(device);
+      if (toPairs(candidates.data(),candidates.size(),false) != toPairs(callbackData.collisions.data(),callbackData.collisions.size(),false))
+        return VerifyApplication::FAILED;
+
+      /* the candidate pairs have to include all intersecting pairs */
+      const std::vector<Pair> candidatePairs = toPairs(candidates.data(),candidates.size(),true);
+      if (!std::includes(candidatePairs.begin(), candidatePairs.end(), refPairs.begin(), refPairs.end()))
+        return VerifyApplication::FAILED;
+
+      /* the narrow phase has to report exactly the intersecting pairs */
+      std::vector<RTCCollision> collisions(numCandidates);
+      const unsigned int numCollisions = rtcCollideBuffered(scene0, scene1, RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE, collisions.data(), numCandidates);
+      AssertNoError(device);
+      if (toPairs(collisions.data(),min(numCollisions,numCandidates),true) != refPairs)
+        return VerifyApplication::FAILED;
+
+      /* a too small buffer still reports the total number of collisions and gets filled with a prefix of all collisions */
+      std::vector<RTCCollision> prefix(3);
+      if (rtcCollideBuffered(scene0, scene1, RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE, prefix.data(), 3) != numCollisions)
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+      for (size_t i = 0; i < 3; i++) {
+        if (toPairs(&prefix[i],1,false) != toPairs(&collisions[i],1,false))
           return VerifyApplication::FAILED;
+      }
+
+      /* self collision must not report identical or neighboring triangles */
+      const unsigned int numSelf = rtcCollideBuffered(scene0, scene0, RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE, collisions.data(), numCandidates);
+      AssertNoError(device);
+      for (unsigned int i = 0; i < min(numSelf,numCandidates); i++)
+      {
+        const SceneGraph::TriangleMeshNode::Triangle& tri0 = mesh0->triangles[collisions[i].primID0];
+        const SceneGraph::TriangleMeshNode::Triangle& tri1 = mesh0->triangles[collisions[i].primID1];
+        for (unsigned int v : { tri1.v0, tri1.v1, tri1.v2 })
+          if (v == tri0.v0 || v == tri0.v1 || v == tri0.v2) return VerifyApplication::FAILED;
+      }
+
+      /* the self collision mode reports each pair of the full self collision once and skips neighboring triangles */
+      auto neighbors = [&] (unsigned int primID0, unsigned int primID1) {
+        const SceneGraph::TriangleMeshNode::Triangle& tri0 = mesh0->triangles[primID0];
+        const SceneGraph::TriangleMeshNode::Triangle& tri1 = mesh0->triangles[primID1];
+        for (unsigned int v : { tri1.v0, tri1.v1, tri1.v2 })
+          if (v == tri0.v0 || v == tri0.v1 || v == tri0.v2) return true;
+        return false;
+      };
+      auto toUnorderedPairs = [&] (std::vector<RTCCollision> collisions, bool unique) {
+        for (auto& c : collisions) {
+          if (c.primID0 > c.primID1) std::swap(c.primID0,c.primID1);
+        }
+        return toPairs(collisions.data(),collisions.size(),unique);
+      };
+      auto collideSelf = [&] (RTCCollideFlags flags) {
+        std::vector<RTCCollision> collisions(rtcCollideBuffered(scene0, scene0, flags, nullptr, 0));
+        rtcCollideBuffered(scene0, scene0, flags, collisions.data(), (unsigned int)collisions.size());
+        return collisions;
+      };
+      std::vector<RTCCollision> full;
+      for (const RTCCollision& c : collideSelf(RTC_COLLIDE_FLAG_NONE))
+        if (!neighbors(c.primID0,c.primID1)) full.push_back(c);
+      if (toUnorderedPairs(collideSelf(RTC_COLLIDE_FLAG_SELF_COLLISION),false) != toUnorderedPairs(full,true))
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+
+      if (toUnorderedPairs(collideSelf(RTC_COLLIDE_FLAG_SELF_COLLISION | RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE),false) != toUnorderedPairs(collideSelf(RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE),true))
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+
+      /* colliding triangles with user geometries is an error */
+      auto boundsFunc = [] (const RTCBoundsFunctionArguments* args) {
+        RTCBounds* bounds_o = args->bounds_o;
+        bounds_o->lower_x = bounds_o->lower_y = bounds_o->lower_z = -1.0f;
+        bounds_o->upper_x = bounds_o->upper_y = bounds_o->upper_z = +1.0f;
+      };
+      VerifyScene userScene(device,sflags);
+      RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_USER);
+      rtcSetGeometryUserPrimitiveCount(geom, 1);
+      rtcSetGeometryBoundsFunction(geom, boundsFunc, nullptr);
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(userScene, geom);
+      rtcReleaseGeometry(geom);
+      rtcCommitScene(userScene);
+      AssertNoError(device);
+
+      rtcCollideBuffered(scene0, userScene, RTC_COLLIDE_FLAG_NONE, collisions.data(), numCandidates);
+      AssertError(device,RTC_ERROR_INVALID_OPERATION);
+      rtcCollide(userScene, scene0, collideFunc, &callbackData);
+      AssertError(device,RTC_ERROR_INVALID_OPERATION);
+
+      return VerifyApplication::PASSED;
+    }
+  };
+
+  struct CollideCachedTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+
+    CollideCachedTest (std::string name, int isa, SceneFlags sflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags) {}
+
+    typedef CollideBufferedTest::Pair Pair;
+
+    static std::vector<Pair> collide(RTCScene scene0, RTCScene scene1)
+    {
+      CollideBufferedTest::CallbackData data;
+      rtcCollide(scene0, scene1, CollideBufferedTest::collideFunc, &data);
+      return CollideBufferedTest::toPairs(data.collisions.data(),data.collisions.size(),false);
+    }
+
+    static std::vector<Pair> collideCached(RTCCollisionCache cache)
+    {
+      CollideBufferedTest::CallbackData data;
+      rtcCollideCached(cache, CollideBufferedTest::collideFunc, &data);
+      return CollideBufferedTest::toPairs(data.collisions.data(),data.collisions.size(),false);
+    }
+
+    static std::vector<Pair> collideCachedBuffered(RTCCollisionCache cache, RTCCollideFlags flags)
+    {
+      const unsigned int num = rtcCollideCachedBuffered(cache, flags, nullptr, 0);
+      std::vector<RTCCollision> collisions(num);
+      if (rtcCollideCachedBuffered(cache, flags, collisions.data(), num) != num) collisions.clear();
+      return CollideBufferedTest::toPairs(collisions.data(),collisions.size(),false);
+    }
+
+    static std::vector<Pair> collideBuffered(RTCScene scene0, RTCScene scene1, RTCCollideFlags flags)
+    {
+      const unsigned int num = rtcCollideBuffered(scene0, scene1, flags, nullptr, 0);
+      std::vector<RTCCollision> collisions(num);
+      rtcCollideBuffered(scene0, scene1, flags, collisions.data(), num);
+      return CollideBufferedTest::toPairs(collisions.data(),collisions.size(),false);
+    }
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      Ref<SceneGraph::TriangleMeshNode> mesh0 = SceneGraph::createTriangleSphere(Vec3fa(0.0f,0.0f,0.0f),1.0f,10).dynamicCast<SceneGraph::TriangleMeshNode>();
+      Ref<SceneGraph::TriangleMeshNode> mesh1 = SceneGraph::createTriangleSphere(Vec3fa(0.5f,0.3f,0.1f),1.0f,12).dynamicCast<SceneGraph::TriangleMeshNode>();
+
+      VerifyScene scene0(device,sflags);
+      VerifyScene scene1(device,sflags);
+      scene0.addGeometry(RTC_BUILD_QUALITY_REFIT,mesh0.dynamicCast<SceneGraph::Node>());
+      unsigned int geomID1 = scene1.addGeometry(RTC_BUILD_QUALITY_REFIT,mesh1.dynamicCast<SceneGraph::Node>());
+      RTCGeometry geom1 = rtcGetGeometry(scene1,geomID1);
+      rtcCommitScene (scene0);
+      rtcCommitScene (scene1);
+      AssertNoError(device);
+
+      RTCCollisionCache cache = rtcNewCollisionCache(scene0, scene1);
+      RTCCollisionCache selfCache = rtcNewCollisionCache(scene0, scene0);
+      AssertNoError(device);
+
+      /* move the second sphere through the first one and back, such that the front has to move down and up again */
+      bool passed = true;
+      for (size_t step = 0; step < 24 && passed; step++)
+      {
+        if (step > 0)
+        {
+          const float dx = step <= 12 ? 0.25f : -0.25f;
+          for (auto& p : mesh1->positions[0]) p.x += dx;
+          rtcUpdateGeometryBuffer(geom1,RTC_BUFFER_TYPE_VERTEX,0);
+          rtcCommitGeometry(geom1);
+          rtcCommitScene (scene1);
+          AssertNoError(device);
         }
+
+        passed &= collideCached(cache) == collide(scene0,scene1);
+        passed &= collideCachedBuffered(cache,RTC_COLLIDE_FLAG_NONE) == collide(scene0,scene1);
+        passed &= collideCachedBuffered(cache,RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE) == collideBuffered(scene0,scene1,RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE);
+        passed &= collideCachedBuffered(selfCache,RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE) == collideBuffered(scene0,scene0,RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE);
         AssertNoError(device);
       }
 
+      rtcReleaseCollisionCache(cache);
+      rtcReleaseCollisionCache(selfCache);
+      AssertNoError(device);
+      return passed ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+
+  struct CollideContinuousTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+
+    CollideContinuousTest (std::string name, int isa, SceneFlags sflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags) {}
+
+    static std::vector<RTCContinuousCollision> collide(RTCScene scene0, RTCScene scene1, float time0, float time1, RTCCollideFlags flags)
+    {
+      std::vector<RTCContinuousCollision> collisions(rtcCollideContinuous(scene0, scene1, time0, time1, flags, nullptr, 0));
+      if (rtcCollideContinuous(scene0, scene1, time0, time1, flags, collisions.data(), (unsigned int)collisions.size()) != collisions.size()) collisions.clear();
+      return collisions;
+    }
+
+    static std::vector<CollideBufferedTest::Pair> toPairs(const std::vector<RTCContinuousCollision>& collisions)
+    {
+      std::vector<CollideBufferedTest::Pair> pairs;
+      for (const RTCContinuousCollision& c : collisions)
+        pairs.push_back(std::make_tuple(c.geomID0, c.primID0, c.geomID1, c.primID1));
+      return pairs;
+    }
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      /* a small sphere passes through a static sphere, without touching it at the start and end of the motion */
+      Ref<SceneGraph::TriangleMeshNode> mesh0 = SceneGraph::createTriangleSphere(Vec3fa(0.0f,0.0f,0.0f),1.0f,10).dynamicCast<SceneGraph::TriangleMeshNode>();
+      Ref<SceneGraph::TriangleMeshNode> mesh1 = SceneGraph::createTriangleSphere(Vec3fa(-4.0f,0.1f,0.2f),0.3f,6).dynamicCast<SceneGraph::TriangleMeshNode>();
+      mesh1->set_motion_vector(Vec3fa(8.0f,0.0f,0.0f));
+
+      VerifyScene scene0(device,sflags);
+      VerifyScene scene1(device,sflags);
+      scene0.addGeometry(RTC_BUILD_QUALITY_MEDIUM,mesh0.dynamicCast<SceneGraph::Node>());
+      scene1.addGeometry(RTC_BUILD_QUALITY_MEDIUM,mesh1.dynamicCast<SceneGraph::Node>());
+      rtcCommitScene (scene0);
+      rtcCommitScene (scene1);
+      AssertNoError(device);
+
+      /* reference of all pairs intersecting at some sampled time */
+      auto triangle = [] (const Ref<SceneGraph::TriangleMeshNode>& mesh, unsigned int primID, float time, Vec3fa v[3]) {
+        const SceneGraph::TriangleMeshNode::Triangle& tri = mesh->triangles[primID];
+        const size_t itime = mesh->numTimeSteps()-1;
+        v[0] = lerp(mesh->positions[0][tri.v0],mesh->positions[itime][tri.v0],time);
+        v[1] = lerp(mesh->positions[0][tri.v1],mesh->positions[itime][tri.v1],time);
+        v[2] = lerp(mesh->positions[0][tri.v2],mesh->positions[itime][tri.v2],time);
+      };
+      std::map<CollideBufferedTest::Pair,float> refPairs;
+      for (size_t k = 0; k <= 64; k++) {
+        const float time = float(k)/64.0f;
+        for (unsigned int i = 0; i < mesh0->triangles.size(); i++) {
+          for (unsigned int j = 0; j < mesh1->triangles.size(); j++) {
+            Vec3fa a[3]; triangle(mesh0,i,time,a);
+            Vec3fa b[3]; triangle(mesh1,j,time,b);
+            if (isa::TriangleTriangleIntersector::intersect_triangle_triangle(a[0],a[1],a[2],b[0],b[1],b[2]))
+              refPairs.insert(std::make_pair(std::make_tuple(0,i,0,j),time));
+          }
+        }
+      }
+      if (refPairs.empty()) return VerifyApplication::FAILED;
+
+      /* the narrow phase has to find all sampled pairs no later than they got sampled */
+      const std::vector<RTCContinuousCollision> collisions = collide(scene0,scene1,0.0f,1.0f,RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE);
+      AssertNoError(device);
+      std::map<CollideBufferedTest::Pair,float> pairs;
+      for (const RTCContinuousCollision& c : collisions) {
+        if (c.time < 0.0f || c.time > 1.0f) return VerifyApplication::FAILED;
+        pairs[std::make_tuple(c.geomID0,c.primID0,c.geomID1,c.primID1)] = c.time;
+      }
+      if (pairs.size() != collisions.size()) return VerifyApplication::FAILED;
+      for (const auto& ref : refPairs) {
+        auto pair = pairs.find(ref.first);
+        if (pair == pairs.end() || pair->second > ref.second + 1E-4f) return VerifyApplication::FAILED;
+      }
+
+      /* the candidate pairs have to include all colliding pairs */
+      const std::vector<CollideBufferedTest::Pair> candidates = toPairs(collide(scene0,scene1,0.0f,1.0f,RTC_COLLIDE_FLAG_NONE));
+      AssertNoError(device);
+      const std::vector<CollideBufferedTest::Pair> collisionPairs = toPairs(collisions);
+      if (!std::includes(candidates.begin(), candidates.end(), collisionPairs.begin(), collisionPairs.end()))
+        return VerifyApplication::FAILED;
+
+      /* the spheres are apart during the start of the motion */
+      if (!collide(scene0,scene1,0.0f,0.1f,RTC_COLLIDE_FLAG_NONE).empty())
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+
+      /* a rigidly moving sphere never collides with itself */
+      if (!collide(scene1,scene1,0.0f,1.0f,RTC_COLLIDE_FLAG_TRIANGLE_NARROW_PHASE | RTC_COLLIDE_FLAG_SELF_COLLISION).empty())
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+
+      return VerifyApplication::PASSED;
+    }
+  };
+
+  struct ClosestPairTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+
+    ClosestPairTest (std::string name, int isa, SceneFlags sflags)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags) {}
+
+    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      /* the tessellated spheres lie inside the spheres, thus they are at least 0.5 apart */
+      Ref<SceneGraph::TriangleMeshNode> mesh0 = SceneGraph::createTriangleSphere(Vec3fa(0.0f,0.0f,0.0f),1.0f,10).dynamicCast<SceneGraph::TriangleMeshNode>();
+      Ref<SceneGraph::TriangleMeshNode> mesh1 = SceneGraph::createTriangleSphere(Vec3fa(2.3f,0.8f,0.4f),1.0f,12).dynamicCast<SceneGraph::TriangleMeshNode>();
+      const float minDist = length(Vec3fa(2.3f,0.8f,0.4f))-2.0f;
+
+      VerifyScene scene0(device,sflags);
+      VerifyScene scene1(device,sflags);
+      scene0.addGeometry(RTC_BUILD_QUALITY_MEDIUM,mesh0.dynamicCast<SceneGraph::Node>());
+      scene1.addGeometry(RTC_BUILD_QUALITY_MEDIUM,mesh1.dynamicCast<SceneGraph::Node>());
+      rtcCommitScene (scene0);
+      rtcCommitScene (scene1);
+      AssertNoError(device);
+
+      /* the vertex to triangle distances are an upper bound of the distance of the meshes */
+      auto vertexDistance = [] (const Ref<SceneGraph::TriangleMeshNode>& meshA, const Ref<SceneGraph::TriangleMeshNode>& meshB) {
+        float dist = inf;
+        for (const Vec3fa& q : meshA->positions[0]) {
+          for (const SceneGraph::TriangleMeshNode::Triangle& tri : meshB->triangles) {
+            const float d = distance(q, closestPointTriangle(q, meshB->positions[0][tri.v0], meshB->positions[0][tri.v1], meshB->positions[0][tri.v2]));
+            if (std::isfinite(d)) dist = min(dist, d);
+          }
+        }
+        return dist;
+      };
+      const float maxDist = min(vertexDistance(mesh0,mesh1),vertexDistance(mesh1,mesh0));
+
+      RTCClosestPair pair;
+      if (!rtcClosestPair(scene0, scene1, inf, &pair)) return VerifyApplication::FAILED;
+      AssertNoError(device);
+      if (pair.distance < minDist-1E-4f || pair.distance > maxDist+1E-4f)
+        return VerifyApplication::FAILED;
+
+      /* the closest points lie on the reported triangles and are the reported distance apart */
+      const Vec3fa p0(pair.p0[0],pair.p0[1],pair.p0[2]);
+      const Vec3fa p1(pair.p1[0],pair.p1[1],pair.p1[2]);
+      if (abs(distance(p0,p1)-pair.distance) > 1E-4f) return VerifyApplication::FAILED;
+      const SceneGraph::TriangleMeshNode::Triangle& tri0 = mesh0->triangles[pair.primID0];
+      const SceneGraph::TriangleMeshNode::Triangle& tri1 = mesh1->triangles[pair.primID1];
+      if (distance(p0, closestPointTriangle(p0, mesh0->positions[0][tri0.v0], mesh0->positions[0][tri0.v1], mesh0->positions[0][tri0.v2])) > 1E-4f) return VerifyApplication::FAILED;
+      if (distance(p1, closestPointTriangle(p1, mesh1->positions[0][tri1.v0], mesh1->positions[0][tri1.v1], mesh1->positions[0][tri1.v2])) > 1E-4f) return VerifyApplication::FAILED;
+
+      /* the query is symmetric */
+      RTCClosestPair pair1;
+      if (!rtcClosestPair(scene1, scene0, inf, &pair1) || abs(pair1.distance-pair.distance) > 1E-5f)
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+
+      /* no pair is closer than the minimal distance */
+      if (rtcClosestPair(scene0, scene1, minDist-1E-3f, &pair1) || pair1.geomID0 != RTC_INVALID_GEOMETRY_ID)
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+
+      /* neighboring triangles are ignored when querying a scene with itself */
+      if (!rtcClosestPair(scene0, scene0, inf, &pair1) || pair1.distance <= 0.0f)
+        return VerifyApplication::FAILED;
+      AssertNoError(device);
+
       return VerifyApplication::PASSED;
     }
   };
-  
-  struct PointQueryTest : public VerifyApplication::Test
+
+  struct PointQueryStreamTest : public VerifyApplication::Test
   {
-    SceneFlags sflags; 
-    std::string tri_accel;
+    SceneFlags sflags;
+    size_t N;
 
-    PointQueryTest (std::string name, int isa, SceneFlags sflags, std::string tri_accel = "")
-      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), tri_accel(tri_accel) {}
+    PointQueryStreamTest (std::string name, int isa, SceneFlags sflags, size_t N)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), N(N) {}
+
+    struct UserData
+    {
+      Vec3f* vertices;
+      Triangle* triangles;
+      Vec3f result;
+      unsigned int primID = RTC_INVALID_GEOMETRY_ID;
+    };
+
+    static bool queryFunc(RTCPointQueryFunctionArguments* args)
+    {
+      UserData* data = (UserData*)args->userPtr;
+      Triangle const& t = data->triangles[args->primID];
+      const Vec3f q(args->query->x, args->query->y, args->query->z);
+      const Vec3f p = closestPointTriangle(q, data->vertices[t.v0], data->vertices[t.v1], data->vertices[t.v2]);
+      const float d = distance(q, p);
+
+      if (d < args->query->radius) {
+        args->query->radius = d;
+        data->result = p;
+        data->primID = args->primID;
+        return true;
+      }
+      return false;
+    }
 
     VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
     {
-      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa) + ((tri_accel != "") ? ",tri_accel="+tri_accel : "");
-      //printf("run test %s\n", cfg.c_str());
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
       RTCDeviceRef device = rtcNewDevice(cfg.c_str());
       errorHandler(nullptr,rtcGetDeviceError(device));
-     
+
       RTCSceneRef scene = rtcNewScene(device);
       rtcSetSceneFlags(scene,sflags.sflags);
       rtcSetSceneBuildQuality(scene,sflags.qflags);
-      
+
       RTCGeometry geom = rtcNewGeometry (device, RTC_GEOMETRY_TYPE_TRIANGLE);
       rtcSetGeometryBuildQuality(geom,sflags.qflags);
 
@@ -3609,208 +5861,48 @@ namespace embree
       rtcCommitScene (scene);
       AssertNoError(device);
 
-      struct UserData
+      avector<RTCPointQuery> queries(N);
+      std::vector<UserData> data(N);
+      std::vector<void*> userPtrs(N);
+      for (size_t i = 0; i < N; ++i)
       {
-        Vec3f* vertices;
-        Triangle* triangles;
-        Vec3f result;
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-      };
+        queries[i].x = 2.0f*random_float();
+        queries[i].y = 2.0f*random_float();
+        queries[i].z = 33.0f*random_float() - 0.5f;
+        queries[i].time = 0.f;
+        queries[i].radius = inf;
+        data[i].vertices = vertices;
+        data[i].triangles = triangles;
+        userPtrs[i] = &data[i];
+      }
+
+      RTCPointQueryContext context;
+      rtcInitPointQueryContext(&context);
+      rtcPointQuery1M(scene, queries.data(), (unsigned int)N, sizeof(RTCPointQuery), &context, queryFunc, userPtrs.data());
+      AssertNoError(device);
 
-      for (int i = 0; i < 64; ++i)
+      /* compare against single point queries */
+      for (size_t i = 0; i < N; ++i)
       {
-        RTCPointQuery query;
-        query.x = 0.25f;
-        query.y = 0.75f;
-        query.z = -0.25f + i * 0.5f;
-        query.time = 0.f;
+        RTCPointQuery query = queries[i];
         query.radius = inf;
 
-        UserData data;
-        data.vertices  = vertices;
-        data.triangles = triangles;
-
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query, &context, [](RTCPointQueryFunctionArguments* args) -> bool
-        {
-          UserData* data = (UserData*)args->userPtr;
-          // get triangle info
-          Triangle const& t = data->triangles[args->primID];
-          Vec3f const& v0 = data->vertices[t.v0];
-          Vec3f const& v1 = data->vertices[t.v1];
-          Vec3f const& v2 = data->vertices[t.v2];
-          
-          // determine closest point on triangle
-          const Vec3f q(args->query->x, args->query->y, args->query->z);
-          const Vec3f p = closestPointTriangle(q, v0, v1, v2);
-          const float d = distance(q, p);
+        UserData ref;
+        ref.vertices  = vertices;
+        ref.triangles = triangles;
 
-          if (d < args->query->radius) {
-            args->query->radius = d;
-            data->result = p;
-            data->primID = args->primID;
-            return true;
-          }
-          return false; 
-        }, &data);
+        RTCPointQueryContext context1;
+        rtcInitPointQueryContext(&context1);
+        rtcPointQuery(scene, &query, &context1, queryFunc, &ref);
 
-        if ((int)data.primID != i/2) return VerifyApplication::FAILED;
-        if (abs(data.result.x- 0.25f) > 1e-4f)        return VerifyApplication::FAILED;
-        if (abs(data.result.y- 0.75f) > 1e-4f)        return VerifyApplication::FAILED;
-        if (abs(data.result.z- (float)(i/2)) > 1e-4f) return VerifyApplication::FAILED;
-        AssertNoError(device);
+        if (data[i].primID != ref.primID) return VerifyApplication::FAILED;
+        if (queries[i].radius != query.radius) return VerifyApplication::FAILED;
+        if (abs(data[i].result.x-ref.result.x) > 1e-4f) return VerifyApplication::FAILED;
+        if (abs(data[i].result.y-ref.result.y) > 1e-4f) return VerifyApplication::FAILED;
+        if (abs(data[i].result.z-ref.result.z) > 1e-4f) return VerifyApplication::FAILED;
       }
-
-      return VerifyApplication::PASSED;
-    }
-  };
-
-  struct PointQueryMotionBlurTest : public VerifyApplication::Test
-  {
-    SceneFlags sflags; 
-    std::string tri_accel;
-
-    PointQueryMotionBlurTest (std::string name, int isa, SceneFlags sflags, std::string tri_accel = "")
-      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), tri_accel(tri_accel) {}
-
-    VerifyApplication::TestReturnValue run(VerifyApplication* state, bool silent)
-    {
-      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa) + (tri_accel != "" ? ",tri_accel="+tri_accel : "");
-      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
-      errorHandler(nullptr,rtcGetDeviceError(device));
-     
-      Vec3f vertices_t0[4] = { 
-        Vec3f(-1.f, -1.f, -1.f), 
-        Vec3f( 1.f, -1.f, -1.f), 
-        Vec3f( 0.f,  1.f, -1.f), 
-        Vec3f(0.f) // 16 byte padding
-      };
-      Vec3f vertices_t1[4] = { 
-        Vec3f(-1.f, -1.f, 1.f), 
-        Vec3f( 1.f, -1.f, 1.f), 
-        Vec3f( 0.f,  1.f, 1.f), 
-        Vec3f(0.f) // 16 byte padding
-      };
-
-      // duplicate triangle to make sure the bvh is not only a leaf node
-      Triangle triangles[64];
-      for (int i = 0; i < 64; ++i)
-        triangles[i] = Triangle(0, 1, 2);
-
-      RTCSceneRef scene = rtcNewScene(device);
-      rtcSetSceneFlags(scene,sflags.sflags);
-      rtcSetSceneBuildQuality(scene,sflags.qflags);
-      
-      RTCGeometry geom = rtcNewGeometry (device, RTC_GEOMETRY_TYPE_TRIANGLE);
-      rtcSetGeometryBuildQuality(geom,sflags.qflags);
-      rtcSetGeometryTimeStepCount(geom,2);
-      rtcSetGeometryPointQueryFunction(geom, [](RTCPointQueryFunctionArguments* args) -> bool
-      {
-        // set primID (userPtr) to something != RTC_INVALID_GEOMETRY_ID to signal that 
-        // the query overlapped some geometry
-        *((unsigned int*)args->userPtr) = 0;
-        return true;
-      });
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertices_t0, 0, sizeof(Vec3f),     3);
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 1, RTC_FORMAT_FLOAT3, vertices_t1, 0, sizeof(Vec3f),     3);
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX , 0, RTC_FORMAT_UINT3,  triangles,   0, sizeof(Triangle), 64);
-      rtcCommitGeometry(geom);
-      rtcAttachGeometry(scene,geom);
-      rtcReleaseGeometry(geom);
-      rtcCommitScene (scene);
       AssertNoError(device);
 
-      RTCPointQuery query0;
-      query0.x      =  0.0f;
-      query0.y      =  0.0f;
-      query0.z      = -1.0f;
-      query0.radius =  0.1f;
-      
-      RTCPointQuery query1;
-      query1.x      =  0.0f;
-      query1.y      =  0.0f;
-      query1.z      =  0.0f;
-      query1.radius =  0.1f;
-      
-      RTCPointQuery query2;
-      query2.x      =  0.0f;
-      query2.y      =  0.0f;
-      query2.z      =  1.0f;
-      query2.radius =  0.1f;
-
-      // time t = 0, only query0 should overlap
-      query0.time = query1.time = query2.time = 0.f;
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query0, &context, nullptr, &primID);
-        if (primID == RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query1, &context, nullptr, &primID);
-        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query2, &context, nullptr, &primID);
-        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-
-      // time t = 0.5, only query1 should overlap
-      query0.time = query1.time = query2.time = 0.5f;
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query0, &context, nullptr, &primID);
-        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query1, &context, nullptr, &primID);
-        if (primID == RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query2, &context, nullptr, &primID);
-        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-      
-      // time t = 1.0, only query2 should overlap
-      query0.time = query1.time = query2.time = 1.f;
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query0, &context, nullptr, &primID);
-        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query1, &context, nullptr, &primID);
-        if (primID != RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-      {
-        unsigned int primID = RTC_INVALID_GEOMETRY_ID;
-        RTCPointQueryContext context;
-        rtcInitPointQueryContext(&context);
-        rtcPointQuery(scene, &query2, &context, nullptr, &primID);
-        if (primID == RTC_INVALID_GEOMETRY_ID) return VerifyApplication::FAILED;
-      }
-
       return VerifyApplication::PASSED;
     }
   };
@@ -5330,6 +7422,13 @@ namespace embree
       groups.pop();
       
       groups.top()->add(new GetUserDataTest("get_user_data",isa));
+      groups.top()->add(new TessellationCacheStatsTest("tessellation_cache_stats",isa));
+      groups.top()->add(new TopologySourceTest("topology_source",isa));
+      groups.top()->add(new EdgeLevelFunctionTest("edge_level_function",isa));
+      groups.top()->add(new SubdivPositionUpdateTest("subdiv_position_update",isa));
+      groups.top()->add(new DisplacementCacheTest("displacement_cache",isa));
+      groups.top()->add(new DisplacementCacheFileTest("displacement_cache_file",isa));
+      groups.top()->add(new CompressedGridTest("compressed_grids",isa));
 
       push(new TestGroup("buffer_stride",true,true));
       for (auto gtype : gtypes)
@@ -5441,6 +7540,11 @@ namespace embree
       for (auto s : interpolateTests)
         groups.top()->add(new InterpolateSubdivTest(std::to_string((long long)(s)),isa,s));
       groups.pop();
+
+      push(new TestGroup("subdiv_grid",true,true));
+      for (auto s : interpolateTests)
+        groups.top()->add(new InterpolateSubdivGridTest(std::to_string((long long)(s)),isa,s));
+      groups.pop();
         
       push(new TestGroup("hair",true,true));
       for (auto s : interpolateTests) 
@@ -5507,6 +7611,15 @@ namespace embree
             for (auto ivariant : intersectVariants)
               if (has_variant(imode,ivariant))
                   groups.top()->add(new IntersectionFilterTest("subdiv."+to_string(sflags,imode,ivariant),isa,sflags,RTC_BUILD_QUALITY_MEDIUM,true,imode,ivariant));
+
+        for (auto sflags : sceneFlags)
+          for (auto imode : intersectModes)
+            for (auto ivariant : intersectVariants)
+              if (has_variant(imode,ivariant))
+                groups.top()->add(new OpacityMicromaskTest("micromask."+to_string(sflags,imode,ivariant),isa,sflags,imode,ivariant));
+
+        for (auto sflags : sceneFlags)
+          groups.top()->add(new BatchFilterTest("batch."+to_string(sflags),isa,sflags));
       }
       groups.pop();
 
@@ -5611,6 +7724,38 @@ namespace embree
         groups.pop();
         }*/
       
+      push(new TestGroup("ray_tile_test",true,true)); {
+        for (auto sflags : sceneFlags) {
+          groups.top()->add(new RayTileTest(to_string(sflags)+".incoherent",isa,sflags,RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT));
+          groups.top()->add(new RayTileTest(to_string(sflags)+".coherent",  isa,sflags,RTC_INTERSECT_CONTEXT_FLAG_COHERENT));
+        }
+        groups.pop();
+      }
+
+      push(new TestGroup("shared_origin_occlusion_test",true,true)); {
+        for (auto sflags : sceneFlags) {
+          groups.top()->add(new SharedOriginOcclusionTest(to_string(sflags)+".incoherent",isa,sflags,RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT));
+          groups.top()->add(new SharedOriginOcclusionTest(to_string(sflags)+".coherent",  isa,sflags,RTC_INTERSECT_CONTEXT_FLAG_COHERENT));
+        }
+        groups.pop();
+      }
+
+      push(new TestGroup("shared_direction_test",true,true)); {
+        for (auto sflags : sceneFlags) {
+          groups.top()->add(new SharedDirectionTest(to_string(sflags)+".incoherent",isa,sflags,RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT));
+          groups.top()->add(new SharedDirectionTest(to_string(sflags)+".coherent",  isa,sflags,RTC_INTERSECT_CONTEXT_FLAG_COHERENT));
+        }
+        groups.pop();
+      }
+
+      push(new TestGroup("visibility_matrix_test",true,true)); {
+        for (auto sflags : sceneFlags) {
+          groups.top()->add(new VisibilityMatrixTest(to_string(sflags)+".incoherent",isa,sflags,RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT));
+          groups.top()->add(new VisibilityMatrixTest(to_string(sflags)+".coherent",  isa,sflags,RTC_INTERSECT_CONTEXT_FLAG_COHERENT));
+        }
+        groups.pop();
+      }
+
       push(new TestGroup("ray_alignment_test",true,true)); {
         std::string watertightModels [] = {"sphere.triangles", "sphere.quads", "sphere.grids", "sphere.subdiv" };
         for (auto sflags : sceneFlagsRobust) 
@@ -5658,12 +7803,35 @@ namespace embree
           groups.top()->add(new PointQueryTest(to_string(sflags),isa,sflags,"qbvh8.triangle4i"));
         }
         groups.top()->add(new PointQueryTest(to_string(sflags),isa,sflags));
+        groups.top()->add(new PointQueryStreamTest("point_query_stream_small."+to_string(sflags),isa,sflags,7));
+        groups.top()->add(new PointQueryStreamTest("point_query_stream_large."+to_string(sflags),isa,sflags,10000));
+        groups.top()->add(new ClosestPointTest("closest_point."+to_string(sflags),isa,sflags,false));
+        groups.top()->add(new ClosestPointTest("closest_point_instancing."+to_string(sflags),isa,sflags,true));
+        groups.top()->add(new NearestPointsTest("nearest_points."+to_string(sflags),isa,sflags,false));
+        groups.top()->add(new NearestPointsTest("nearest_points_instancing."+to_string(sflags),isa,sflags,true));
+        groups.top()->add(new BoxQueryTest("box_query."+to_string(sflags),isa,sflags,false));
+        groups.top()->add(new BoxQueryTest("box_query_instancing."+to_string(sflags),isa,sflags,true));
       }
 
       groups.top()->add(new PointQueryMotionBlurTest("point_query_motion_blur_aligned_node",isa,SceneFlags(RTC_SCENE_FLAG_NONE,RTC_BUILD_QUALITY_MEDIUM),"bvh4.triangle4i"));
       groups.top()->add(new PointQueryMotionBlurTest("point_query_motion_blur_quantized_node",isa,SceneFlags(RTC_SCENE_FLAG_NONE,RTC_BUILD_QUALITY_MEDIUM),"qbvh4.triangle4i"));
       groups.top()->add(new PointQueryMotionBlurTest("point_query_motion_blur_quantized_node",isa,SceneFlags(RTC_SCENE_FLAG_NONE,RTC_BUILD_QUALITY_MEDIUM)));
       groups.pop();
+
+      /**************************************************************************/
+      /*                           Collision Tests                              */
+      /**************************************************************************/
+
+      push(new TestGroup("collide",true,true));
+      for (auto sflags : sceneFlags)
+        groups.top()->add(new CollideBufferedTest("collide_buffered."+to_string(sflags),isa,sflags));
+      for (auto sflags : sceneFlags)
+        groups.top()->add(new CollideCachedTest("collide_cached."+to_string(sflags),isa,sflags));
+      for (auto sflags : sceneFlags)
+        groups.top()->add(new CollideContinuousTest("collide_continuous."+to_string(sflags),isa,sflags));
+      for (auto sflags : sceneFlags)
+        groups.top()->add(new ClosestPairTest("closest_pair."+to_string(sflags),isa,sflags));
+      groups.pop();
     
       /**************************************************************************/
       /*                  Randomized Stress Testing                             */